@@ -1,7 +1,10 @@
 #include "AudioShift432Effect.h"
-#include <audio_432hz.h>
-#include <audio_pipeline.h>
+#include <effect_backend.h>
+#include <effect_command.h>
+#include <hardware/audio_effect_432hz.h>
+#include <stats_page.h>
 #include <utils/Log.h>
+#include <unistd.h>
 #include <cstring>
 #include <cerrno>
 
@@ -9,38 +12,58 @@
 
 namespace android {
 
-using audioshift::dsp::Audio432HzConverter;
-using audioshift::dsp::AudioPipeline;
+using audioshift::dsp::Interpolator;
+using audioshift::dsp::MemoryUsage;
+using audioshift::dsp::ProcessingProfile;
+using audioshift::dsp::StatsPage;
 
-// Effect context structure
+// Effect context structure. Settings, format and the process loop live in
+// the shared effect core; the backend is picked at build time (Android.bp)
 struct AudioShift432EffectContext {
     effect_interface_t itfe;
-    Audio432HzConverter* converter;
-    bool enabled;
     effect_config_t config;
+    audioshift::dsp::Effect core;
 };
 
+// Process-wide statistics page, shared with PATH-C's layout and read by
+// audioshift_stats; mapped by the first effect_create(). nullptr if no
+// shared memory could be had at all
+static StatsPage* statsPage() {
+    static StatsPage* const page = [] {
+        StatsPage* p = StatsPage::create();
+        if (!p) {
+            ALOGW("Stats page unavailable");
+        } else if (!p->isFileBacked()) {
+            ALOGI("Stats page in memfd: /proc/%d/fd/%d", getpid(), p->fd());
+        }
+        return p;
+    }();
+    return page;
+}
+
+// Flags of both descriptors, the same as PATH-C's. AudioFlinger only sends
+// EFFECT_CMD_SET_DEVICE, which sets the sink latency, with DEVICE_IND, and
+// EFFECT_CMD_SET_AUDIO_MODE, which switches calls to the voice profile,
+// with AUDIO_MODE_IND
+static constexpr uint32_t kEffectFlags = EFFECT_FLAG_TYPE_INSERT | EFFECT_FLAG_INSERT_LAST |
+                                         EFFECT_FLAG_DEVICE_IND | EFFECT_FLAG_AUDIO_MODE_IND;
+static_assert((kEffectFlags & EFFECT_FLAG_DEVICE_IND) != 0,
+              "without DEVICE_IND the device-based latency retune never runs");
+static_assert((kEffectFlags & EFFECT_FLAG_AUDIO_MODE_IND) != 0,
+              "without AUDIO_MODE_IND calls never get the voice profile");
+
 // Effect processing interface
 static int effect_process(effect_handle_t self,
                           audio_buffer_t* inBuffer,
                           audio_buffer_t* outBuffer) {
     auto* ctx = reinterpret_cast<AudioShift432EffectContext*>(self);
-    if (!ctx || !ctx->enabled || !ctx->converter) {
+    if (!ctx || !inBuffer) {
         return -EINVAL;
     }
-
-    // In-place processing
-    int16_t* buffer = reinterpret_cast<int16_t*>(inBuffer->raw);
-    uint32_t frameCount = inBuffer->frameCount;
-    uint32_t channels = ctx->config.inputCfg.channels == AUDIO_CHANNEL_OUT_STEREO ? 2 : 1;
-
-    if (outBuffer) {
-        memcpy(outBuffer->raw, inBuffer->raw, frameCount * channels * sizeof(int16_t));
-        buffer = reinterpret_cast<int16_t*>(outBuffer->raw);
-    }
-
-    ctx->converter->process(buffer, frameCount * channels);
-    return 0;
+    // Out-of-place when AudioFlinger hands a separate output buffer; the
+    // samples are in the format negotiated at EFFECT_CMD_SET_CONFIG
+    void* out = outBuffer ? outBuffer->raw : inBuffer->raw;
+    return ctx->core.process(inBuffer->raw, out, static_cast<int>(inBuffer->frameCount));
 }
 
 // Effect command handler
@@ -55,52 +78,76 @@ static int effect_command(effect_handle_t self,
         return -EINVAL;
     }
 
+    // Life-cycle, format and device commands are shared with PATH-C
+    int result = 0;
+    if (audioshift::dsp::handleEffectCommand(ctx->core, ctx->config, cmdCode, cmdSize,
+                                             pCmdData, replySize, pReplyData, result)) {
+        ALOGI("effect command %u: status %d", cmdCode, result);
+        return result;
+    }
+
     switch (cmdCode) {
-        case EFFECT_CMD_INIT:
-            ALOGI("EFFECT_CMD_INIT");
-            if (!ctx->converter) {
-                int sr = ctx->config.inputCfg.samplingRate > 0 ?
-                         ctx->config.inputCfg.samplingRate : 48000;
-                int ch = 2;
-                ctx->converter = new Audio432HzConverter(sr, ch);
+        case EFFECT_CMD_SET_PARAM: {
+            ALOGI("EFFECT_CMD_SET_PARAM");
+            if (!pCmdData || cmdSize < sizeof(effect_param_t) + 2 * sizeof(int32_t) ||
+                !pReplyData || !replySize || *replySize < sizeof(int32_t)) {
+                return -EINVAL;
             }
-            break;
-
-        case EFFECT_CMD_ENABLE:
-            ALOGI("EFFECT_CMD_ENABLE");
-            ctx->enabled = true;
-            break;
-
-        case EFFECT_CMD_DISABLE:
-            ALOGI("EFFECT_CMD_DISABLE");
-            ctx->enabled = false;
-            break;
-
-        case EFFECT_CMD_SET_CONFIG:
-            ALOGI("EFFECT_CMD_SET_CONFIG");
-            if (pCmdData && cmdSize == sizeof(effect_config_t)) {
-                memcpy(&ctx->config, pCmdData, sizeof(effect_config_t));
-                if (ctx->converter) {
-                    ctx->converter->setSampleRate(ctx->config.inputCfg.samplingRate);
+            auto* param = static_cast<effect_param_t*>(pCmdData);
+            int32_t status = -EINVAL;
+            if (param->psize == sizeof(int32_t) && param->vsize == sizeof(int32_t)) {
+                const int32_t id = *reinterpret_cast<const int32_t*>(param->data);
+                const int32_t value = *reinterpret_cast<const int32_t*>(param->data + sizeof(int32_t));
+                const audioshift::dsp::EffectSettings& settings = ctx->core.settings();
+                if (id == AUDIOSHIFT_PARAM_INTERPOLATOR) {
+                    status = ctx->core.setInterpolator(static_cast<Interpolator>(value));
+                } else if (id == AUDIOSHIFT_PARAM_PROFILE) {
+                    status = ctx->core.setProfile(static_cast<ProcessingProfile>(value));
+                } else if (id == AUDIOSHIFT_PARAM_SINK_LATENCY_MS && value >= 0) {
+                    status = ctx->core.setLatencyBudget(static_cast<float>(value),
+                                                        settings.latencyBudgetMs);
+                } else if (id == AUDIOSHIFT_PARAM_LATENCY_BUDGET_MS && value >= 0) {
+                    status = ctx->core.setLatencyBudget(-1.0f, static_cast<float>(value));
+                } else if (id == AUDIOSHIFT_PARAM_SHRINK_TO_FIT) {
+                    ctx->core.shrinkToFit();
+                    status = 0;
                 }
             }
+            *static_cast<int32_t*>(pReplyData) = status;
             break;
+        }
 
-        case EFFECT_CMD_RESET:
-            ALOGI("EFFECT_CMD_RESET");
-            if (ctx->converter) {
-                int sr = ctx->config.inputCfg.samplingRate > 0 ?
-                         ctx->config.inputCfg.samplingRate : 48000;
-                ctx->converter->setSampleRate(sr);
-            }
-            break;
-
-        case EFFECT_CMD_GET_PARAM:
+        case EFFECT_CMD_GET_PARAM: {
             ALOGI("EFFECT_CMD_GET_PARAM");
-            if (pReplyData && replySize) {
-                *replySize = 0;
+            // Reply: the request's header and parameter, followed by the value
+            const uint32_t valueSize = 3 * sizeof(int32_t);
+            const uint32_t replyNeeded = sizeof(effect_param_t) + sizeof(int32_t) + valueSize;
+            if (!pCmdData || cmdSize < sizeof(effect_param_t) + sizeof(int32_t) ||
+                !pReplyData || !replySize || *replySize < sizeof(effect_param_t) + sizeof(int32_t)) {
+                return -EINVAL;
+            }
+            auto* reply = static_cast<effect_param_t*>(pReplyData);
+            memcpy(reply, pCmdData, sizeof(effect_param_t) + sizeof(int32_t));
+            const int32_t id = *reinterpret_cast<const int32_t*>(reply->data);
+            reply->status = -EINVAL;
+            reply->vsize = 0;
+            if (reply->psize == sizeof(int32_t) && id == AUDIOSHIFT_PARAM_MEMORY &&
+                *replySize >= replyNeeded) {
+                // Before the first enable only the context exists
+                MemoryUsage usage = ctx->core.memoryUsage();
+                usage.allocatedBytes += sizeof(*ctx);
+                usage.usedBytes += sizeof(*ctx);
+                usage.peakUsedBytes += sizeof(*ctx);
+                auto* value = reinterpret_cast<int32_t*>(reply->data + sizeof(int32_t));
+                value[0] = static_cast<int32_t>(usage.allocatedBytes);
+                value[1] = static_cast<int32_t>(usage.usedBytes);
+                value[2] = static_cast<int32_t>(usage.peakUsedBytes);
+                reply->status = 0;
+                reply->vsize = valueSize;
             }
+            *replySize = sizeof(effect_param_t) + sizeof(int32_t) + reply->vsize;
             break;
+        }
 
         default:
             ALOGW("Unknown command: %u", cmdCode);
@@ -130,9 +177,9 @@ static int effect_get_descriptor(effect_handle_t self,
     memcpy(&pDesc->type, &kTypeUUID, sizeof(effect_uuid_t));
     memcpy(&pDesc->uuid, &kImplUUID, sizeof(effect_uuid_t));
     pDesc->apiVersion = EFFECT_CONTROL_API_VERSION;
-    pDesc->flags = EFFECT_FLAG_TYPE_INSERT | EFFECT_FLAG_INSERT_LAST;
+    pDesc->flags = kEffectFlags;
     pDesc->cpuLoad = 500;   // 5% CPU estimate
-    pDesc->memoryUsage = 64; // 64KB
+    pDesc->memoryUsage = 256; // KB, enabled stereo 48 kHz; see AUDIOSHIFT_PARAM_MEMORY
     strncpy(pDesc->name, "AudioShift 432Hz", EFFECT_STRING_LEN_MAX);
     strncpy(pDesc->implementor, "AudioShift Project", EFFECT_STRING_LEN_MAX);
 
@@ -160,15 +207,17 @@ static int effect_create(const effect_uuid_t* uuid,
         return -ENOMEM;
     }
 
+    // The core starts at 48 kHz stereo with the converter built on the
+    // first EFFECT_CMD_ENABLE; content already at A4 = 432 is passed through
     ctx->itfe = kEffectInterface;
-    ctx->converter = nullptr;
-    ctx->enabled = false;
     memset(&ctx->config, 0, sizeof(ctx->config));
     ctx->config.inputCfg.samplingRate = 48000;
     ctx->config.inputCfg.channels = AUDIO_CHANNEL_OUT_STEREO;
     ctx->config.inputCfg.format = AUDIO_FORMAT_PCM_16_BIT;
     memcpy(&ctx->config.outputCfg, &ctx->config.inputCfg, sizeof(ctx->config.inputCfg));
 
+    ctx->core.attachStats(statsPage());
+
     *pHandle = (effect_handle_t)ctx;
     return 0;
 }
@@ -177,12 +226,7 @@ static int effect_create(const effect_uuid_t* uuid,
 static int effect_release(effect_handle_t handle) {
     ALOGI("effect_release");
     auto* ctx = reinterpret_cast<AudioShift432EffectContext*>(handle);
-    if (ctx) {
-        if (ctx->converter) {
-            delete ctx->converter;
-        }
-        delete ctx;
-    }
+    delete ctx;
     return 0;
 }
 
@@ -199,9 +243,9 @@ static uint32_t effect_get_descriptor(const effect_uuid_t* uuid,
         .uuid = { 0xf22a9ce0, 0x7a11, 0x11ee, 0xb962,
                   { 0x02, 0x42, 0xac, 0x12, 0x00, 0x02 } },
         .apiVersion = EFFECT_CONTROL_API_VERSION,
-        .flags = EFFECT_FLAG_TYPE_INSERT | EFFECT_FLAG_INSERT_LAST,
+        .flags = kEffectFlags,
         .cpuLoad = 500,
-        .memoryUsage = 64,
+        .memoryUsage = 256,
         .name = "AudioShift 432Hz",
         .implementor = "AudioShift Project"
     };
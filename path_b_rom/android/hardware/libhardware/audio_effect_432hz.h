@@ -19,4 +19,10 @@ typedef enum {
     AUDIOSHIFT_PARAM_ENABLED       = 0,  // int32: 0=off, 1=on
     AUDIOSHIFT_PARAM_PITCH_CENTS   = 1,  // int32: pitch in centitones (-3177 for 432Hz)
     AUDIOSHIFT_PARAM_LATENCY_MS    = 2,  // int32: read-only latency estimate
+    AUDIOSHIFT_PARAM_INTERPOLATOR  = 3,  // int32: 0=linear, 1=cubic (default), 2=shannon
+    AUDIOSHIFT_PARAM_PROFILE       = 4,  // int32: 0=music (default), 1=voip, 2=game
+    AUDIOSHIFT_PARAM_MEMORY        = 5,  // int32[3]: read-only bytes allocated, used, peak used
+    AUDIOSHIFT_PARAM_SHRINK_TO_FIT = 6,  // int32: write-only, any value releases burst capacity
+    AUDIOSHIFT_PARAM_SINK_LATENCY_MS = 7,   // int32: delay after the effect, overrides the EFFECT_CMD_SET_DEVICE estimate
+    AUDIOSHIFT_PARAM_LATENCY_BUDGET_MS = 8, // int32: total output delay allowed, 0 = engine default
 } AudioShift432HzParam;
@@ -18,6 +18,14 @@ resetprop persist.audioshift.enabled     "1"
 resetprop persist.audioshift.pitch_ratio "0.981818"   # 432/440
 resetprop persist.audioshift.version     "1.0.0"
 
+# ──────────────────────────────────────────────────────────────
+# Statistics page: the effect maps /data/vendor/audioshift/stats
+# inside audioserver; `audioshift_stats` reads it without binder calls
+# ──────────────────────────────────────────────────────────────
+mkdir -p /data/vendor/audioshift
+chown audioserver:audio /data/vendor/audioshift
+chmod 0755 /data/vendor/audioshift
+
 # ──────────────────────────────────────────────────────────────
 # Verify effect library is accessible to AudioFlinger
 # ──────────────────────────────────────────────────────────────
@@ -7,76 +7,71 @@
  * Signal flow:
  *   AudioFlinger output buffer
  *       → EffectProcess() [int16_t PCM in]
- *       → int16_t→float32 conversion
- *       → SoundTouch WSOLA pitch-shift (432/440 ratio)
- *       → float32→int16_t conversion
+ *       → dsp::Effect::process() — the shared effect core and its backend
+ *         (int16 → float, WSOLA pitch-shift by 432/440, float → int16)
  *       → AudioFlinger continues to HAL
  *
- * Threading: AudioFlinger calls process() on its mixer thread.
- *            All SoundTouch access is single-threaded per-instance,
+ * Standard commands go through dsp::handleEffectCommand(); this file adds
+ * the proprietary CMD_* commands and the shared-memory stats page.
+ *
+ * Threading: AudioFlinger calls process() on its mixer thread and
+ *            command() on a binder thread, serialised per effect,
  *            so no locking is needed inside process().
  *
  * Reference: docs/ANDROID_INTERNALS.md §4 "Audio Effects Framework"
  */
 
 #include "audioshift_hook.h"
+#include "effect_command.h"
 
-#include <cmath>
-#include <cstdlib>
+#include <cinttypes>
 #include <cstring>
 #include <new>
-#include <time.h>
-
-// SoundTouch from shared DSP layer
-// When cross-compiled for Android, the NDK build links against
-// the static soundtouch_internal built by path_c_magisk/native/CMakeLists.txt
-#include "SoundTouch.h"
+#include <unistd.h>
 
-using soundtouch::SoundTouch;
+using audioshift::dsp::Interpolator;
+using audioshift::dsp::MemoryUsage;
+using audioshift::dsp::ProcessingProfile;
+using audioshift::dsp::StatsPage;
 
 // ─── Internal helpers ─────────────────────────────────────────────────────────
 
 namespace
 {
 
-    /** Monotonic wall-clock in milliseconds. */
-    static inline double nowMs()
-    {
-        struct timespec ts;
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        return static_cast<double>(ts.tv_sec) * 1000.0 +
-               static_cast<double>(ts.tv_nsec) / 1.0e6;
-    }
-
     /**
-     * Convert signed 16-bit PCM → float32 in [-1, +1].
-     * Handles interleaved stereo (channels=2) or mono (channels=1).
+     * Process-wide statistics page, mapped by the first EffectCreate() on the
+     * binder thread. nullptr if no shared memory could be had at all.
      */
-    static void pcm16ToFloat(const int16_t *src, float *dst, int frames, int channels)
+    static StatsPage *statsPage()
     {
-        const int samples = frames * channels;
-        const float kScale = 1.0f / 32768.0f;
-        for (int i = 0; i < samples; ++i)
+        static StatsPage *const page = []
         {
-            dst[i] = static_cast<float>(src[i]) * kScale;
-        }
+            StatsPage *p = StatsPage::create();
+            if (!p)
+                ASHIFT_LOGW("Stats page unavailable");
+            else if (!p->isFileBacked())
+                ASHIFT_LOGI("Stats page in memfd: /proc/%d/fd/%d", getpid(), p->fd());
+            return p;
+        }();
+        return page;
     }
 
-    /**
-     * Convert float32 in [-1, +1] → signed 16-bit PCM with clamping.
-     */
-    static void floatToPcm16(const float *src, int16_t *dst, int frames, int channels)
+    /** Heap held by an instance: the context, and once enabled the backend. */
+    static MemoryUsage memoryUsage(const audioshift::AudioShiftContext *ctx)
     {
-        const int samples = frames * channels;
-        for (int i = 0; i < samples; ++i)
-        {
-            float v = src[i] * 32768.0f;
-            if (v > 32767.0f)
-                v = 32767.0f;
-            else if (v < -32768.0f)
-                v = -32768.0f;
-            dst[i] = static_cast<int16_t>(v);
-        }
+        MemoryUsage usage = ctx->core.memoryUsage();
+        usage.allocatedBytes += sizeof(*ctx);
+        usage.usedBytes += sizeof(*ctx);
+        usage.peakUsedBytes += sizeof(*ctx);
+        return usage;
+    }
+
+    /** Writes a 0 status to the reply, if the caller asked for one. */
+    static void replyOk(uint32_t *replySize, void *pReplyData)
+    {
+        if (replySize && *replySize >= sizeof(int) && pReplyData)
+            *(int *)pReplyData = 0;
     }
 
     // ─── Effect interface function table (forward declarations) ───────────────────
@@ -120,13 +115,9 @@ extern "C" int EffectCreate(const effect_uuid_t *uuid,
         return -ENOMEM;
 
     ctx->itfe = &kEffectInterface;
-    ctx->enabled = false;
-    ctx->pitchSemitones = audioshift::PITCH_SEMITONES_432_HZ;
-    ctx->lastLatencyMs = 0.0f;
-    ctx->lastCpuPercent = 0.0f;
-    ctx->frameCount = 0;
 
-    // Default config: 48 kHz stereo (Android standard)
+    // Default config: 48 kHz stereo (Android standard), which the core
+    // starts from too. The backend is allocated on the first EFFECT_CMD_ENABLE
     memset(&ctx->config, 0, sizeof(ctx->config));
     ctx->config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
     ctx->config.inputCfg.format = AUDIO_FORMAT_PCM_16_BIT;
@@ -141,23 +132,11 @@ extern "C" int EffectCreate(const effect_uuid_t *uuid,
     ctx->config.outputCfg.bufferProvider.getBuffer = nullptr;
     ctx->config.outputCfg.bufferProvider.releaseBuffer = nullptr;
 
-    // Initialise SoundTouch
-    SoundTouch *st = new (std::nothrow) SoundTouch();
-    if (!st)
-    {
-        delete ctx;
-        return -ENOMEM;
-    }
-    st->setChannels(audioshift::DEFAULT_CHANNELS);
-    st->setSampleRate(audioshift::DEFAULT_SAMPLE_RATE);
-    st->setPitchSemiTones(ctx->pitchSemitones);
-    st->setSetting(SETTING_USE_QUICKSEEK, 1); // lower latency
-    st->setSetting(SETTING_USE_AA_FILTER, 1); // anti-alias
-    ctx->soundtouch = static_cast<void *>(st);
+    ctx->core.attachStats(statsPage());
 
     *pHandle = reinterpret_cast<effect_handle_t>(ctx);
-    ASHIFT_LOGI("EffectCreate: AudioShift instance created (pitch=%.4f st)",
-                ctx->pitchSemitones);
+    ASHIFT_LOGI("EffectCreate: AudioShift instance created (pitch=%.4f st, %zu bytes)",
+                ctx->core.settings().pitchSemitones, sizeof(*ctx));
     return 0;
 }
 
@@ -166,11 +145,7 @@ extern "C" int EffectRelease(effect_handle_t handle)
     if (!handle)
         return -EINVAL;
     auto *ctx = reinterpret_cast<audioshift::AudioShiftContext *>(handle);
-    ASHIFT_LOGI("EffectRelease: processed %" PRIu64 " frames", ctx->frameCount);
-    if (ctx->soundtouch)
-    {
-        delete static_cast<SoundTouch *>(ctx->soundtouch);
-    }
+    ASHIFT_LOGI("EffectRelease: processed %" PRIu64 " frames", ctx->core.framesProcessed());
     delete ctx;
     return 0;
 }
@@ -212,57 +187,10 @@ static int effectProcess(effect_handle_t self,
     if (!ctx || !inBuf || !outBuf)
         return -EINVAL;
 
-    // Pass-through if disabled
-    if (!ctx->enabled)
-    {
-        if (outBuf->raw != inBuf->raw)
-        {
-            memcpy(outBuf->raw, inBuf->raw,
-                   inBuf->frameCount * 2 * sizeof(int16_t)); // stereo
-        }
-        return 0;
-    }
-
-    const int frames = static_cast<int>(inBuf->frameCount);
-    const int channels = 2; // stereo
-
-    if (frames <= 0 || frames > audioshift::MAX_FRAME_SIZE)
-    {
-        ASHIFT_LOGW("effectProcess: unexpected frameCount=%d", frames);
-        return -EINVAL;
-    }
-
-    const double t0 = nowMs();
-
-    SoundTouch *st = static_cast<SoundTouch *>(ctx->soundtouch);
-
-    // 1. int16_t PCM → float32
-    pcm16ToFloat(inBuf->s16, ctx->floatBuf, frames, channels);
-
-    // 2. Feed to SoundTouch
-    st->putSamples(ctx->floatBuf, static_cast<uint32_t>(frames));
-
-    // 3. Drain processed samples
-    uint32_t received = st->receiveSamples(ctx->floatBuf,
-                                           static_cast<uint32_t>(frames));
-
-    // If SoundTouch hasn't buffered enough yet, receive what we can and
-    // zero-fill the rest to avoid glitches during the initial fill period.
-    if (received < static_cast<uint32_t>(frames))
-    {
-        const int missing = frames - static_cast<int>(received);
-        memset(ctx->floatBuf + received * channels, 0,
-               missing * channels * sizeof(float));
-    }
-
-    // 4. float32 → int16_t PCM
-    floatToPcm16(ctx->floatBuf, outBuf->s16, frames, channels);
-
-    // 5. Update stats
-    ctx->frameCount += static_cast<uint64_t>(frames);
-    ctx->lastLatencyMs = static_cast<float>(nowMs() - t0);
-
-    return 0;
+    // Pass-through while disabled (or if the backend could not be allocated)
+    // is handled by the core; buffers may be shared or separate and hold
+    // the PCM format negotiated at EFFECT_CMD_SET_CONFIG
+    return ctx->core.process(inBuf->raw, outBuf->raw, static_cast<int>(inBuf->frameCount));
 }
 
 // ─── Effect commands ──────────────────────────────────────────────────────────
@@ -278,109 +206,149 @@ static int effectCommand(effect_handle_t self,
     if (!ctx)
         return -EINVAL;
 
+    int status = 0;
+    if (audioshift::dsp::handleEffectCommand(ctx->core, ctx->config, cmdCode, cmdSize,
+                                             pCmdData, replySize, pReplyData, status))
+    {
+        if (cmdCode == EFFECT_CMD_ENABLE)
+        {
+            if (status == -ENOMEM)
+                ASHIFT_LOGE("EFFECT_CMD_ENABLE: out of memory, staying in pass-through");
+            else
+                ASHIFT_LOGI("AudioShift ENABLED — 440→432 Hz active");
+        }
+        else if (cmdCode == EFFECT_CMD_DISABLE)
+        {
+            ASHIFT_LOGI("AudioShift DISABLED — pass-through mode");
+        }
+        else if (cmdCode == EFFECT_CMD_SET_CONFIG)
+        {
+            ASHIFT_LOGI("CMD_SET_CONFIG: sr=%d ch=%d status=%d", ctx->core.sampleRate(),
+                        ctx->core.channels(), status);
+        }
+        else if (cmdCode == EFFECT_CMD_SET_DEVICE)
+        {
+            ASHIFT_LOGI("CMD_SET_DEVICE: sink %.0f ms", ctx->core.settings().sinkLatencyMs);
+        }
+        return status;
+    }
+
     switch (cmdCode)
     {
 
-    case EFFECT_CMD_INIT:
-        ASHIFT_LOGD("CMD_INIT");
-        if (!replySize || *replySize < sizeof(int) || !pReplyData)
+    case EFFECT_CMD_GET_DESCRIPTOR:
+        if (!pReplyData || !replySize || *replySize < sizeof(effect_descriptor_t))
             return -EINVAL;
-        *(int *)pReplyData = 0;
+        *(effect_descriptor_t *)pReplyData = audioshift::AUDIOSHIFT_EFFECT_DESCRIPTOR;
         return 0;
 
-    case EFFECT_CMD_SET_CONFIG:
+        // ── Proprietary commands ──────────────────────────────────────────────────
+
+    case audioshift::CMD_SET_PITCH_RATIO:
     {
-        if (cmdSize < sizeof(effect_config_t) || !pCmdData)
+        if (cmdSize < sizeof(float) || !pCmdData)
             return -EINVAL;
-        if (!replySize || *replySize < sizeof(int) || !pReplyData)
+        const float ratio = *(const float *)pCmdData;
+        if (ctx->core.setPitchRatio(ratio) != 0)
             return -EINVAL;
-
-        const auto *cfg = static_cast<const effect_config_t *>(pCmdData);
-        ctx->config = *cfg;
-
-        const int sr = static_cast<int>(cfg->inputCfg.samplingRate);
-        const int ch = audio_channel_count_from_out_mask(cfg->inputCfg.channels);
-        SoundTouch *st = static_cast<SoundTouch *>(ctx->soundtouch);
-        st->setSampleRate(static_cast<uint32_t>(sr));
-        st->setChannels(static_cast<uint32_t>(ch));
-        st->setPitchSemiTones(ctx->pitchSemitones);
-        st->clear();
-
-        ASHIFT_LOGI("CMD_SET_CONFIG: sr=%d ch=%d", sr, ch);
-        *(int *)pReplyData = 0;
+        ASHIFT_LOGI("CMD_SET_PITCH_RATIO: ratio=%.6f → %.4f semitones", ratio,
+                    ctx->core.settings().pitchSemitones);
+        replyOk(replySize, pReplyData);
         return 0;
     }
 
-    case EFFECT_CMD_GET_CONFIG:
-        if (!pReplyData || !replySize || *replySize < sizeof(effect_config_t))
+    case audioshift::CMD_SET_AUTO_BYPASS:
+    {
+        if (cmdSize < sizeof(int) || !pCmdData)
             return -EINVAL;
-        *(effect_config_t *)pReplyData = ctx->config;
-        return 0;
-
-    case EFFECT_CMD_RESET:
-        static_cast<SoundTouch *>(ctx->soundtouch)->clear();
-        ctx->frameCount = 0;
-        ctx->lastLatencyMs = 0.0f;
-        ctx->lastCpuPercent = 0.0f;
-        return 0;
-
-    case EFFECT_CMD_ENABLE:
-        ctx->enabled = true;
-        ASHIFT_LOGI("AudioShift ENABLED — 440→432 Hz active");
-        if (replySize && *replySize >= sizeof(int) && pReplyData)
-            *(int *)pReplyData = 0;
-        return 0;
-
-    case EFFECT_CMD_DISABLE:
-        ctx->enabled = false;
-        static_cast<SoundTouch *>(ctx->soundtouch)->clear();
-        ASHIFT_LOGI("AudioShift DISABLED — pass-through mode");
-        if (replySize && *replySize >= sizeof(int) && pReplyData)
-            *(int *)pReplyData = 0;
+        ctx->core.setAutoBypass(*(const int *)pCmdData != 0);
+        ASHIFT_LOGI("CMD_SET_AUTO_BYPASS: %s", ctx->core.settings().autoBypass ? "on" : "off");
+        replyOk(replySize, pReplyData);
         return 0;
+    }
 
-    case EFFECT_CMD_GET_DESCRIPTOR:
-        if (!pReplyData || !replySize || *replySize < sizeof(effect_descriptor_t))
+    case audioshift::CMD_SET_INTERPOLATOR:
+    {
+        if (cmdSize < sizeof(int) || !pCmdData)
             return -EINVAL;
-        *(effect_descriptor_t *)pReplyData = audioshift::AUDIOSHIFT_EFFECT_DESCRIPTOR;
+        const int interpolator = *(const int *)pCmdData;
+        if (ctx->core.setInterpolator(static_cast<Interpolator>(interpolator)) != 0)
+            return -EINVAL;
+        ASHIFT_LOGI("CMD_SET_INTERPOLATOR: %d", interpolator);
+        replyOk(replySize, pReplyData);
         return 0;
+    }
 
-        // ── Proprietary commands ──────────────────────────────────────────────────
-
-    case audioshift::CMD_SET_PITCH_RATIO:
+    case audioshift::CMD_SET_PROFILE:
     {
-        if (cmdSize < sizeof(float) || !pCmdData)
+        if (cmdSize < sizeof(int) || !pCmdData)
             return -EINVAL;
-        const float ratio = *(const float *)pCmdData;
-        if (ratio <= 0.0f || ratio > 2.0f)
+        const int profile = *(const int *)pCmdData;
+        if (ctx->core.setProfile(static_cast<ProcessingProfile>(profile)) != 0)
             return -EINVAL;
-        // Convert ratio to semitones: 12 * log2(ratio)
-        ctx->pitchSemitones = 12.0f * log2f(ratio);
-        static_cast<SoundTouch *>(ctx->soundtouch)->setPitchSemiTones(ctx->pitchSemitones);
-        ASHIFT_LOGI("CMD_SET_PITCH_RATIO: ratio=%.6f → %.4f semitones", ratio, ctx->pitchSemitones);
-        if (replySize && *replySize >= sizeof(int) && pReplyData)
-            *(int *)pReplyData = 0;
+        ASHIFT_LOGI("CMD_SET_PROFILE: %d", profile);
+        replyOk(replySize, pReplyData);
         return 0;
     }
 
+    case audioshift::CMD_GET_TUNING_REFERENCE:
+        if (!pReplyData || !replySize || *replySize < sizeof(float))
+            return -EINVAL;
+        *(float *)pReplyData = ctx->core.referenceHz();
+        return 0;
+
     case audioshift::CMD_GET_LATENCY_MS:
         if (!pReplyData || !replySize || *replySize < sizeof(float))
             return -EINVAL;
-        *(float *)pReplyData = ctx->lastLatencyMs;
+        *(float *)pReplyData = ctx->core.lastCallbackMs();
         return 0;
 
     case audioshift::CMD_GET_CPU_USAGE:
         if (!pReplyData || !replySize || *replySize < sizeof(float))
             return -EINVAL;
-        *(float *)pReplyData = ctx->lastCpuPercent;
+        *(float *)pReplyData = ctx->core.cpuPercent();
         return 0;
 
     case audioshift::CMD_RESET_STATS:
-        ctx->frameCount = 0;
-        ctx->lastLatencyMs = 0.0f;
-        ctx->lastCpuPercent = 0.0f;
+        ctx->core.resetStats();
         return 0;
 
+    case audioshift::CMD_SET_LATENCY_BUDGET:
+    {
+        if (cmdSize < 2 * sizeof(float) || !pCmdData)
+            return -EINVAL;
+        const float *values = static_cast<const float *>(pCmdData);
+        if (ctx->core.setLatencyBudget(values[0], values[1]) != 0)
+            return -EINVAL;
+        ASHIFT_LOGI("CMD_SET_LATENCY_BUDGET: sink %.1f ms, budget %.1f ms",
+                    ctx->core.settings().sinkLatencyMs, ctx->core.settings().latencyBudgetMs);
+        replyOk(replySize, pReplyData);
+        return 0;
+    }
+
+    case audioshift::CMD_GET_MEMORY_USAGE:
+    {
+        if (!pReplyData || !replySize || *replySize < 3 * sizeof(uint32_t))
+            return -EINVAL;
+        const MemoryUsage usage = memoryUsage(ctx);
+        uint32_t *reply = static_cast<uint32_t *>(pReplyData);
+        reply[0] = static_cast<uint32_t>(usage.allocatedBytes);
+        reply[1] = static_cast<uint32_t>(usage.usedBytes);
+        reply[2] = static_cast<uint32_t>(usage.peakUsedBytes);
+        *replySize = 3 * sizeof(uint32_t);
+        return 0;
+    }
+
+    case audioshift::CMD_SHRINK_TO_FIT:
+    {
+        ctx->core.shrinkToFit();
+        const MemoryUsage usage = memoryUsage(ctx);
+        ASHIFT_LOGI("CMD_SHRINK_TO_FIT: %zu bytes allocated, %zu in use", usage.allocatedBytes,
+                    usage.usedBytes);
+        replyOk(replySize, pReplyData);
+        return 0;
+    }
+
     default:
         ASHIFT_LOGW("effectCommand: unknown cmd=0x%08x", cmdCode);
         return -EINVAL;
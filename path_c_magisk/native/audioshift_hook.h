@@ -7,7 +7,10 @@
  * Implementation Strategy:
  *   - Registers as an Android audio effect via the Effects API
  *   - AudioFlinger loads the library for all audio output tracks
- *   - WSOLA pitch-shift (SoundTouch) applied in the process callback
+ *   - The shared effect core (shared/dsp/src/effect_core.h) does the work;
+ *     this library adds the descriptor, the proprietary commands and the
+ *     stats page. The DSP backend is chosen at build time
+ *     (AUDIOSHIFT_EFFECT_BACKEND in CMakeLists.txt)
  *
  * Architecture reference: docs/ANDROID_INTERNALS.md
  */
@@ -23,6 +26,8 @@
 // <hardware/audio_effect.h> provides effect_interface_s and related structs
 #include <hardware/audio_effect.h>
 
+#include "effect_backend.h" // shared/dsp/src
+
 #define LOG_TAG "AudioShift"
 #define ASHIFT_LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define ASHIFT_LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
@@ -31,20 +36,18 @@
 
 namespace audioshift
 {
-
     // ─── Constants ────────────────────────────────────────────────────────────────
 
     /**
      * Pitch ratio: 432 / 440 = 0.981818...
-     * Semitones:   12 * log2(432/440) ≈ -0.3164 semitones
+     * Semitones:   12 * log2(432/440) ≈ -0.3177 semitones
      */
     constexpr float PITCH_RATIO_432_HZ = 432.0f / 440.0f;
-    constexpr float PITCH_SEMITONES_432_HZ = -0.3164f; // Pre-computed
+    constexpr float PITCH_SEMITONES_432_HZ = dsp::PITCH_SEMITONES_432_HZ;
 
     /** Default DSP parameters */
     constexpr int DEFAULT_SAMPLE_RATE = 48000;
     constexpr int DEFAULT_CHANNELS = 2;
-    constexpr int MAX_FRAME_SIZE = 8192; // samples per channel
     constexpr float MAX_LATENCY_MS = 20.0f;
 
     // ─── Effect UUID ──────────────────────────────────────────────────────────────
@@ -66,7 +69,7 @@ namespace audioshift
         (EFFECT_FLAG_TYPE_INSERT | EFFECT_FLAG_INSERT_LAST |
          EFFECT_FLAG_DEVICE_IND | EFFECT_FLAG_AUDIO_MODE_IND), // flags
         500,                                                   // cpuLoad (0.5% in MIPS tenths)
-        32,                                                    // memoryUsage (KB)
+        264,                                                   // memoryUsage (KB, enabled stereo 48 kHz; see CMD_GET_MEMORY_USAGE)
         "AudioShift 432Hz Converter",                          // name
         "AudioShift Project"                                   // implementor
     };
@@ -81,6 +84,13 @@ namespace audioshift
         CMD_GET_LATENCY_MS = EFFECT_CMD_FIRST_PROPRIETARY + 2,  // float ms (reply)
         CMD_GET_CPU_USAGE = EFFECT_CMD_FIRST_PROPRIETARY + 3,   // float % (reply)
         CMD_RESET_STATS = EFFECT_CMD_FIRST_PROPRIETARY + 4,
+        CMD_SET_AUTO_BYPASS = EFFECT_CMD_FIRST_PROPRIETARY + 5,     // int 0/1
+        CMD_GET_TUNING_REFERENCE = EFFECT_CMD_FIRST_PROPRIETARY + 6, // float Hz (reply), 0 = unknown
+        CMD_SET_INTERPOLATOR = EFFECT_CMD_FIRST_PROPRIETARY + 7,     // int 0 linear, 1 cubic, 2 shannon
+        CMD_SET_PROFILE = EFFECT_CMD_FIRST_PROPRIETARY + 8,          // int 0 music, 1 voip, 2 game
+        CMD_GET_MEMORY_USAGE = EFFECT_CMD_FIRST_PROPRIETARY + 9,     // uint32[3] bytes allocated, used, peak (reply)
+        CMD_SHRINK_TO_FIT = EFFECT_CMD_FIRST_PROPRIETARY + 10,       // release capacity left by bursts
+        CMD_SET_LATENCY_BUDGET = EFFECT_CMD_FIRST_PROPRIETARY + 11,  // float[2] sink ms (< 0 keeps the device's), budget ms (0 = none)
     };
 
     // ─── Effect Context ───────────────────────────────────────────────────────────
@@ -88,27 +98,18 @@ namespace audioshift
     /**
      * Per-instance state maintained by the effect engine.
      * The first member MUST be effect_handle_t (Android requirement).
+     *
+     * Settings, format, enable state, the process loop and the statistics
+     * live in the shared core. It allocates its DSP backend on the first
+     * EFFECT_CMD_ENABLE, on the binder thread; until then commands only
+     * record settings, and process() never allocates.
      */
     struct AudioShiftContext
     {
         const struct effect_interface_s *itfe; // MUST be first — cast compatibility
 
-        // Configuration
-        audio_config_t config;
-        bool enabled;
-        float pitchSemitones;
-
-        // SoundTouch DSP backend (opaque pointer avoids direct SoundTouch dependency
-        // in this header — forward-declared and heap-allocated in the .cpp)
-        void *soundtouch;
-
-        // Scratch buffer for float32 conversion
-        float floatBuf[MAX_FRAME_SIZE * DEFAULT_CHANNELS];
-
-        // Stats (sampled on each process() call)
-        float lastLatencyMs;
-        float lastCpuPercent;
-        uint64_t frameCount;
+        effect_config_t config; // last accepted EFFECT_CMD_SET_CONFIG
+        dsp::Effect core;
     };
 
     // ─── C API (exported symbols) ─────────────────────────────────────────────────
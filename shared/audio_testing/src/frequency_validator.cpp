@@ -3,8 +3,11 @@
  *
  * DFT-based frequency detection with:
  *   - Hann windowing (reduces spectral leakage)
- *   - Manual DFT magnitude spectrum (O(N²); fine for N ≤ 32768)
+ *   - FFT magnitude spectrum (O(N log N) for any N, via Bluestein when N is
+ *     not a power of two); plans are cached per thread
  *   - Quadratic-interpolated peak refinement (sub-bin accuracy)
+ *   - Goertzel filter bank for a few known targets (O(N·T))
+ *   - A persistent worker pool for analyzeBatch()
  *
  * For N = 8192 at 48 kHz, bin resolution = 48000/8192 ≈ 5.86 Hz.
  * After quadratic refinement, accuracy ≲ 0.5 Hz for pure tones.
@@ -15,10 +18,16 @@
 #include "frequency_validator.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <complex>
+#include <condition_variable>
 #include <cstddef>
+#include <functional>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 namespace audioshift
 {
@@ -52,37 +61,193 @@ namespace audioshift
             }
 
             /**
-             * Compute DFT magnitude spectrum for bins 0 … N/2 (inclusive).
+             * FFT of one signal length, with its Hann window and scratch space.
              *
-             * For each bin k:
-             *   re = Σ x[n] × cos(2πkn/N)
-             *   im = Σ x[n] × sin(2πkn/N)
-             *   mag = sqrt(re²+im²)
-             *
-             * Complexity O(N²) — acceptable for N ≤ 16384.
+             * Power-of-two lengths use an iterative radix-2 transform. Other
+             * lengths use Bluestein's chirp-z algorithm: the N-point DFT becomes
+             * a convolution with a chirp, evaluated with M-point FFTs (M ≥ 2N−1,
+             * a power of two), so every N gets exactly the bins of the O(N²) DFT.
+             * Arithmetic is in double precision like the direct DFT it replaces.
              */
-            std::vector<float> computeDftMagnitude(const std::vector<float> &signal)
+            class SpectrumPlan
             {
-                const std::size_t N = signal.size();
-                const std::size_t half = N / 2 + 1;
-                std::vector<float> mag(half, 0.0f);
+            public:
+                std::size_t length() const { return N_; }
+
+                void build(std::size_t N)
+                {
+                    N_ = N;
+                    const bool pow2 = (N & (N - 1)) == 0;
+                    M_ = 1;
+                    while (M_ < (pow2 ? N : 2 * N - 1))
+                    {
+                        M_ <<= 1;
+                    }
 
-                const double twoPiOverN = 2.0 * M_PI / static_cast<double>(N);
+                    window_.resize(N);
+                    const double norm = 2.0 * M_PI / static_cast<double>(N - 1);
+                    for (std::size_t n = 0; n < N; ++n)
+                    {
+                        window_[n] = 0.5 * (1.0 - std::cos(norm * static_cast<double>(n)));
+                    }
+
+                    twiddle_.resize(M_ / 2);
+                    for (std::size_t k = 0; k < M_ / 2; ++k)
+                    {
+                        twiddle_[k] = std::polar(1.0, -2.0 * M_PI * static_cast<double>(k) /
+                                                          static_cast<double>(M_));
+                    }
+                    bitReverse_.resize(M_);
+                    for (std::size_t i = 0, j = 0; i < M_; ++i)
+                    {
+                        bitReverse_[i] = j;
+                        std::size_t bit = M_ >> 1;
+                        for (; bit && (j & bit); bit >>= 1)
+                        {
+                            j ^= bit;
+                        }
+                        j |= bit;
+                    }
+                    scratch_.assign(M_, {});
+
+                    chirp_.clear();
+                    chirpFilter_.clear();
+                    if (pow2)
+                    {
+                        return;
+                    }
+                    // w[n] = exp(−iπn²/N); n² is reduced mod 2N to keep the angle exact
+                    chirp_.resize(N);
+                    for (std::size_t n = 0; n < N; ++n)
+                    {
+                        const std::size_t phase = static_cast<std::size_t>(
+                            (static_cast<unsigned long long>(n) * n) % (2 * N));
+                        chirp_[n] = std::polar(1.0, -M_PI * static_cast<double>(phase) /
+                                                        static_cast<double>(N));
+                    }
+                    chirpFilter_.assign(M_, {});
+                    chirpFilter_[0] = std::conj(chirp_[0]);
+                    for (std::size_t n = 1; n < N; ++n)
+                    {
+                        chirpFilter_[n] = chirpFilter_[M_ - n] = std::conj(chirp_[n]);
+                    }
+                    fft(chirpFilter_.data(), false);
+                }
 
-                for (std::size_t k = 0; k < half; ++k)
+                /** Hann-windowed DFT magnitudes of @p signal, bins 0 … N/2 */
+                void magnitude(const SignalSpan &signal, std::vector<float> &mag)
                 {
-                    double re = 0.0;
-                    double im = 0.0;
-                    const double kNorm = twoPiOverN * static_cast<double>(k);
+                    const std::size_t N = N_;
+                    const bool bluestein = !chirp_.empty();
                     for (std::size_t n = 0; n < N; ++n)
                     {
-                        const double angle = kNorm * static_cast<double>(n);
-                        re += static_cast<double>(signal[n]) * std::cos(angle);
-                        im -= static_cast<double>(signal[n]) * std::sin(angle);
+                        // Rounded through float like the windowed copy the DFT used
+                        const float x = static_cast<float>(
+                            static_cast<double>(signal.samples[n * signal.stride]) * window_[n]);
+                        scratch_[n] = bluestein ? static_cast<double>(x) * chirp_[n]
+                                                : std::complex<double>(x, 0.0);
+                    }
+                    std::fill(scratch_.begin() + N, scratch_.end(), std::complex<double>());
+                    fft(scratch_.data(), false);
+
+                    double scale = 1.0;
+                    if (bluestein)
+                    {
+                        for (std::size_t k = 0; k < M_; ++k)
+                        {
+                            scratch_[k] *= chirpFilter_[k];
+                        }
+                        fft(scratch_.data(), true);
+                        // |X[k]| = |w[k] · conv[k] / M| and |w[k]| = 1
+                        scale = 1.0 / static_cast<double>(M_);
+                    }
+
+                    mag.resize(N / 2 + 1);
+                    for (std::size_t k = 0; k < mag.size(); ++k)
+                    {
+                        mag[k] = static_cast<float>(std::abs(scratch_[k]) * scale);
                     }
-                    mag[k] = static_cast<float>(std::sqrt(re * re + im * im));
                 }
-                return mag;
+
+            private:
+                /** In-place radix-2 transform of M_ points; unscaled when @p inverse */
+                void fft(std::complex<double> *a, bool inverse) const
+                {
+                    for (std::size_t i = 0; i < M_; ++i)
+                    {
+                        const std::size_t j = bitReverse_[i];
+                        if (i < j)
+                        {
+                            std::swap(a[i], a[j]);
+                        }
+                    }
+                    for (std::size_t len = 2; len <= M_; len <<= 1)
+                    {
+                        const std::size_t half = len / 2;
+                        const std::size_t step = M_ / len;
+                        for (std::size_t i = 0; i < M_; i += len)
+                        {
+                            for (std::size_t k = 0; k < half; ++k)
+                            {
+                                const std::complex<double> w = inverse ? std::conj(twiddle_[k * step])
+                                                                       : twiddle_[k * step];
+                                const std::complex<double> u = a[i + k];
+                                const std::complex<double> v = a[i + k + half] * w;
+                                a[i + k] = u + v;
+                                a[i + k + half] = u - v;
+                            }
+                        }
+                    }
+                }
+
+                std::size_t N_ = 0;
+                std::size_t M_ = 0; // FFT size: N, or the Bluestein convolution length
+                std::vector<double> window_;
+                std::vector<std::complex<double>> twiddle_;
+                std::vector<std::size_t> bitReverse_;
+                std::vector<std::complex<double>> chirp_;       // empty for power-of-two N
+                std::vector<std::complex<double>> chirpFilter_; // FFT of the conjugate chirp
+                std::vector<std::complex<double>> scratch_;
+            };
+
+            /**
+             * The calling thread's plan and spectrum buffer. The plan is rebuilt
+             * only when the signal length changes, so a matrix of same-length
+             * signals allocates nothing after the first one.
+             */
+            struct ThreadAnalyzer
+            {
+                SpectrumPlan plan;
+                std::vector<float> mag;
+
+                const std::vector<float> &spectrum(const SignalSpan &signal)
+                {
+                    if (plan.length() != signal.length)
+                    {
+                        plan.build(signal.length);
+                    }
+                    plan.magnitude(signal, mag);
+                    return mag;
+                }
+            };
+
+            ThreadAnalyzer &threadAnalyzer()
+            {
+                thread_local ThreadAnalyzer analyzer;
+                return analyzer;
+            }
+
+            float spanRms(const SignalSpan &signal)
+            {
+                if (signal.length == 0)
+                    return 0.0f;
+                double sum = 0.0;
+                for (std::size_t n = 0; n < signal.length; ++n)
+                {
+                    const double s = static_cast<double>(signal.samples[n * signal.stride]);
+                    sum += s * s;
+                }
+                return static_cast<float>(std::sqrt(sum / static_cast<double>(signal.length)));
             }
 
             /**
@@ -143,6 +308,197 @@ namespace audioshift
                 return static_cast<float>(refinedFreq);
             }
 
+            /**
+             * Run a bank of Goertzel resonators over @p x in a single pass.
+             *
+             * The sample loop is outer and the probe loop inner, so the probes
+             * form independent lanes the compiler can vectorise.  Double
+             * precision keeps the recursion stable for low ω at large N.
+             *
+             * Returns |X(ω)| for each probe frequency in @p omegas (rad/sample).
+             */
+            std::vector<double> goertzelBank(const std::vector<float> &x,
+                                             const std::vector<double> &omegas)
+            {
+                const std::size_t P = omegas.size();
+                std::vector<double> coeff(P), s1(P, 0.0), s2(P, 0.0);
+                for (std::size_t p = 0; p < P; ++p)
+                {
+                    coeff[p] = 2.0 * std::cos(omegas[p]);
+                }
+
+                for (float sample : x)
+                {
+                    const double v = static_cast<double>(sample);
+                    for (std::size_t p = 0; p < P; ++p)
+                    {
+                        const double s0 = v + coeff[p] * s1[p] - s2[p];
+                        s2[p] = s1[p];
+                        s1[p] = s0;
+                    }
+                }
+
+                std::vector<double> mag(P);
+                for (std::size_t p = 0; p < P; ++p)
+                {
+                    const double power = s1[p] * s1[p] + s2[p] * s2[p] - coeff[p] * s1[p] * s2[p];
+                    mag[p] = std::sqrt(std::max(power, 0.0));
+                }
+                return mag;
+            }
+
+            // Energy share a tone must carry to count as dominant (tone RMS / signal RMS)
+            constexpr float kMinToneRmsRatio = 0.5f;
+
+            // Half-width of the Hann main lobe, in bins
+            constexpr std::size_t kMainLobeBins = 2;
+
+            FrequencyAnalysis analyzeSignal(const SignalSpan &signal, uint32_t sampleRate)
+            {
+                FrequencyAnalysis result;
+                result.rms = spanRms(signal);
+                // Check for silence: avoid returning nonsense on zero input.
+                if (signal.length < 4 || sampleRate == 0 || result.rms < 1e-6f)
+                {
+                    return result;
+                }
+
+                const std::vector<float> &mag = threadAnalyzer().spectrum(signal);
+                const std::size_t peak = findPeakBin(mag);
+                result.frequencyHz = refinePeakInternal(mag, peak, sampleRate, signal.length);
+
+                double lobe = 0.0;
+                double total = 0.0;
+                for (std::size_t k = 1; k < mag.size(); ++k)
+                {
+                    const double power = static_cast<double>(mag[k]) * static_cast<double>(mag[k]);
+                    total += power;
+                    if (k + kMainLobeBins >= peak && k <= peak + kMainLobeBins)
+                    {
+                        lobe += power;
+                    }
+                }
+                result.confidence = total > 0.0 ? static_cast<float>(lobe / total) : 0.0f;
+                return result;
+            }
+
+            /**
+             * Workers for analyzeBatch(), started on first use and kept for the
+             * life of the process so their thread-local plans survive between
+             * batches. The calling thread works too; concurrent batches from
+             * different threads take turns.
+             */
+            class WorkerPool
+            {
+            public:
+                static WorkerPool &instance()
+                {
+                    static WorkerPool pool;
+                    return pool;
+                }
+
+                ~WorkerPool()
+                {
+                    {
+                        std::lock_guard<std::mutex> guard(lock_);
+                        stop_ = true;
+                    }
+                    wake_.notify_all();
+                    for (std::thread &t : workers_)
+                    {
+                        t.join();
+                    }
+                }
+
+                /** Calls @p task(i) for every i < @p count on up to @p threads threads */
+                void run(std::size_t count, unsigned threads, const std::function<void(std::size_t)> &task)
+                {
+                    std::lock_guard<std::mutex> serial(runLock_);
+                    const std::size_t helpers =
+                        std::min<std::size_t>(threads > 0 ? threads - 1 : 0, count > 0 ? count - 1 : 0);
+                    {
+                        std::unique_lock<std::mutex> lk(lock_);
+                        // A worker that woke too late for the last batch may still be leaving
+                        finished_.wait(lk, [&] { return active_ == 0; });
+                        while (workers_.size() < helpers)
+                        {
+                            const std::size_t id = workers_.size();
+                            const unsigned long long seen = generation_;
+                            workers_.emplace_back([this, id, seen] { work(id, seen); });
+                        }
+                        task_ = &task;
+                        count_ = count;
+                        helpers_ = helpers;
+                        next_.store(0);
+                        done_.store(0);
+                        ++generation_;
+                    }
+                    wake_.notify_all();
+
+                    drain(task, count);
+                    std::unique_lock<std::mutex> lk(lock_);
+                    finished_.wait(lk, [&] { return done_.load() == count_ && active_ == 0; });
+                }
+
+            private:
+                WorkerPool() = default;
+
+                void drain(const std::function<void(std::size_t)> &task, std::size_t count)
+                {
+                    for (std::size_t i; (i = next_.fetch_add(1)) < count;)
+                    {
+                        task(i);
+                        if (done_.fetch_add(1) + 1 == count)
+                        {
+                            std::lock_guard<std::mutex> guard(lock_);
+                            finished_.notify_all();
+                        }
+                    }
+                }
+
+                void work(std::size_t id, unsigned long long seen)
+                {
+                    std::unique_lock<std::mutex> lk(lock_);
+                    for (;;)
+                    {
+                        wake_.wait(lk, [&] { return stop_ || generation_ != seen; });
+                        if (stop_)
+                        {
+                            return;
+                        }
+                        seen = generation_;
+                        if (id >= helpers_)
+                        {
+                            continue;
+                        }
+                        const std::function<void(std::size_t)> &task = *task_;
+                        const std::size_t count = count_;
+                        ++active_;
+                        lk.unlock();
+                        drain(task, count);
+                        lk.lock();
+                        if (--active_ == 0)
+                        {
+                            finished_.notify_all();
+                        }
+                    }
+                }
+
+                std::mutex runLock_;
+                std::mutex lock_; // guards everything below except the atomics
+                std::condition_variable wake_;
+                std::condition_variable finished_;
+                std::vector<std::thread> workers_;
+                const std::function<void(std::size_t)> *task_ = nullptr;
+                std::size_t count_ = 0;
+                std::size_t helpers_ = 0;
+                std::size_t active_ = 0;
+                unsigned long long generation_ = 0;
+                bool stop_ = false;
+                std::atomic<std::size_t> next_{0};
+                std::atomic<std::size_t> done_{0};
+            };
+
         } // anonymous namespace
 
         // ── Public: applyHannWindow ──────────────────────────────────────────────────
@@ -172,8 +528,7 @@ namespace audioshift
             {
                 return {};
             }
-            const auto windowed = applyHannWindowInternal(signal);
-            return computeDftMagnitude(windowed);
+            return threadAnalyzer().spectrum({signal.data(), signal.size(), 1});
         }
 
         // ── Public: rmsEnergy ────────────────────────────────────────────────────────
@@ -195,40 +550,150 @@ namespace audioshift
         float FrequencyValidator::detectFrequency(const std::vector<float> &signal,
                                                   uint32_t sampleRate)
         {
-            if (signal.size() < 4 || sampleRate == 0)
+            return analyzeSignal({signal.data(), signal.size(), 1}, sampleRate).frequencyHz;
+        }
+
+        // ── Public: isFrequency ───────────────────────────────────────────────────────
+
+        bool FrequencyValidator::isFrequency(const std::vector<float> &signal,
+                                             uint32_t sampleRate,
+                                             float expectedHz,
+                                             float toleranceHz)
+        {
+            const float detected = detectFrequency(signal, sampleRate);
+            if (detected <= 0.0f)
+                return false;
+            return std::abs(detected - expectedHz) <= toleranceHz;
+        }
+
+        // ── Public: measureTones ─────────────────────────────────────────────────────
+
+        std::vector<ToneMeasurement> FrequencyValidator::measureTones(
+            const std::vector<float> &signal,
+            uint32_t sampleRate,
+            const std::vector<float> &targetsHz)
+        {
+            if (signal.size() < 256 || sampleRate == 0 || targetsHz.empty())
             {
-                return 0.0f;
+                return {};
             }
 
-            // Check for silence: avoid returning nonsense on zero input.
-            if (rmsEnergy(signal) < 1e-6f)
+            const std::size_t N = signal.size();
+            const double binHz = static_cast<double>(sampleRate) / static_cast<double>(N);
+            const double hzToOmega = 2.0 * M_PI / static_cast<double>(sampleRate);
+
+            // Three probes per target: one bin below, on target, one bin above
+            std::vector<double> omegas;
+            omegas.reserve(targetsHz.size() * 3);
+            for (float target : targetsHz)
             {
-                return 0.0f;
+                for (int offset = -1; offset <= 1; ++offset)
+                {
+                    omegas.push_back((static_cast<double>(target) + offset * binHz) * hzToOmega);
+                }
             }
 
             const auto windowed = applyHannWindowInternal(signal);
-            const auto mag = computeDftMagnitude(windowed);
+            const auto mag = goertzelBank(windowed, omegas);
+
+            // A Hann-windowed sine of amplitude A peaks at A·N/4
+            const double magToAmplitude = 4.0 / static_cast<double>(N);
 
-            if (mag.size() < 3)
+            std::vector<ToneMeasurement> result(targetsHz.size());
+            for (std::size_t t = 0; t < targetsHz.size(); ++t)
             {
-                return 0.0f;
-            }
+                const double ym1 = mag[3 * t];
+                const double y0 = mag[3 * t + 1];
+                const double y1 = mag[3 * t + 2];
+
+                ToneMeasurement &m = result[t];
+                m.targetHz = targetsHz[t];
+                m.amplitude = static_cast<float>(y0 * magToAmplitude);
+                m.peakInWindow = (y0 > ym1) && (y0 >= y1);
+                if (!m.peakInWindow)
+                {
+                    continue;
+                }
 
-            const std::size_t peak = findPeakBin(mag);
-            return refinePeakInternal(mag, peak, sampleRate, signal.size());
+                const double denom = ym1 - 2.0 * y0 + y1;
+                double delta = 0.0;
+                if (denom < 0.0)
+                {
+                    delta = 0.5 * (ym1 - y1) / denom;
+                }
+                m.frequencyHz = static_cast<float>(static_cast<double>(targetsHz[t]) + delta * binHz);
+                m.amplitude = static_cast<float>((y0 - 0.25 * (ym1 - y1) * delta) * magToAmplitude);
+            }
+            return result;
         }
 
-        // ── Public: isFrequency ───────────────────────────────────────────────────────
+        // ── Public: isFrequencyGoertzel ──────────────────────────────────────────────
 
-        bool FrequencyValidator::isFrequency(const std::vector<float> &signal,
-                                             uint32_t sampleRate,
-                                             float expectedHz,
-                                             float toleranceHz)
+        bool FrequencyValidator::isFrequencyGoertzel(const std::vector<float> &signal,
+                                                     uint32_t sampleRate,
+                                                     float expectedHz,
+                                                     float toleranceHz)
         {
-            const float detected = detectFrequency(signal, sampleRate);
-            if (detected <= 0.0f)
+            const float rms = rmsEnergy(signal);
+            if (rms < 1e-6f)
+            {
                 return false;
-            return std::abs(detected - expectedHz) <= toleranceHz;
+            }
+
+            const auto tones = measureTones(signal, sampleRate, {expectedHz});
+            if (tones.empty() || !tones[0].peakInWindow)
+            {
+                return false;
+            }
+
+            const float toneRms = tones[0].amplitude / std::sqrt(2.0f);
+            return std::abs(tones[0].frequencyHz - expectedHz) <= toleranceHz &&
+                   toneRms >= kMinToneRmsRatio * rms;
+        }
+
+        // ── Public: validatePitchShiftGoertzel ───────────────────────────────────────
+
+        bool FrequencyValidator::validatePitchShiftGoertzel(const std::vector<float> &input,
+                                                            const std::vector<float> &output,
+                                                            uint32_t sampleRate,
+                                                            float fromHz,
+                                                            float toHz,
+                                                            float toleranceHz)
+        {
+            return isFrequencyGoertzel(input, sampleRate, fromHz, toleranceHz) &&
+                   isFrequencyGoertzel(output, sampleRate, toHz, toleranceHz);
+        }
+
+        // ── Public: analyzeBatch ─────────────────────────────────────────────────────
+
+        std::vector<FrequencyAnalysis> FrequencyValidator::analyzeBatch(
+            const std::vector<SignalSpan> &signals,
+            uint32_t sampleRate,
+            unsigned threads)
+        {
+            std::vector<FrequencyAnalysis> results(signals.size());
+            if (threads == 0)
+            {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            WorkerPool::instance().run(signals.size(), threads, [&](std::size_t i) {
+                results[i] = analyzeSignal(signals[i], sampleRate);
+            });
+            return results;
+        }
+
+        // ── Public: channelSpans ─────────────────────────────────────────────────────
+
+        std::vector<SignalSpan> FrequencyValidator::channelSpans(const float *interleaved,
+                                                                 std::size_t frames,
+                                                                 uint32_t channels)
+        {
+            std::vector<SignalSpan> spans(channels);
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                spans[c] = {interleaved + c, frames, channels};
+            }
+            return spans;
         }
 
         // ── Public: validatePitchShift ───────────────────────────────────────────────
@@ -6,8 +6,8 @@
  *
  * The algorithm:
  *   1. Apply a Hann window to reduce spectral leakage.
- *   2. Compute the DFT magnitude spectrum via the Goertzel algorithm (single
- *      frequency sweep) or a manual DFT for the full spectrum (small N).
+ *   2. Compute the N-point DFT magnitude spectrum with an FFT (radix-2 for
+ *      power-of-two N, Bluestein's chirp-z transform for any other N).
  *   3. Find the bin k with maximum magnitude.
  *   4. Refine using three-point quadratic interpolation for sub-bin accuracy:
  *        δ = 0.5 × (|k-1| - |k+1|) / (|k-1| - 2|k| + |k+1|)
@@ -15,6 +15,18 @@
  *
  * Accuracy: ≤ 1 Hz for N ≥ 4096 at 48 kHz; ≤ 0.5 Hz for N ≥ 8192.
  *
+ * When only a few known frequencies matter (is the tone at 432 Hz and not at
+ * 440 Hz?), measureTones() and the *Goertzel variants skip the full spectrum:
+ * a Goertzel filter bank probes each target and its two neighbouring bin
+ * offsets in a single O(N) pass over the signal, and the same quadratic
+ * refinement is applied to the three probe magnitudes.
+ *
+ * Test matrices that measure thousands of signals should use analyzeBatch():
+ * it takes the signals as views (an interleaved channel needs no copy) and
+ * spreads them over a persistent worker pool. Each thread keeps its FFT
+ * plan, window and scratch buffers between signals of the same length, so
+ * steady-state analysis allocates nothing.
+ *
  * Thread-safety: all public methods are static and thread-safe.
  *
  * SPDX-License-Identifier: Apache-2.0
@@ -22,6 +34,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -30,6 +43,38 @@ namespace audioshift
     namespace testing
     {
 
+        /**
+         * Result of probing one target frequency with the Goertzel filter bank.
+         */
+        struct ToneMeasurement
+        {
+            float targetHz = 0.0f;    ///< Frequency that was probed
+            float frequencyHz = 0.0f; ///< Refined peak frequency, 0 if no peak near target
+            float amplitude = 0.0f;   ///< Estimated sine amplitude at the refined peak
+            bool peakInWindow = false; ///< true if the target probe beat both neighbours
+        };
+
+        /**
+         * Non-owning view of one signal: every @p stride-th sample starting at
+         * @p samples, so channel c of interleaved PCM is {base + c, frames, channels}.
+         */
+        struct SignalSpan
+        {
+            const float *samples = nullptr;
+            std::size_t length = 0; ///< Samples in the signal (frames, for a channel)
+            std::size_t stride = 1;
+        };
+
+        /**
+         * Result of analysing one signal with analyzeBatch().
+         */
+        struct FrequencyAnalysis
+        {
+            float frequencyHz = 0.0f; ///< As detectFrequency(): 0 on silence or invalid input
+            float rms = 0.0f;         ///< As rmsEnergy()
+            float confidence = 0.0f;  ///< Share of the spectral energy in the peak's main lobe, 0…1
+        };
+
         /**
          * Stateless frequency-detection helper.
          *
@@ -97,6 +142,80 @@ namespace audioshift
                                            float toHz,
                                            float toleranceHz = 2.0f);
 
+            // ── Goertzel filter bank (O(N) per target) ──────────────────────────────
+
+            /**
+             * Probe a small set of target frequencies in one pass.
+             *
+             * Each target f is evaluated at f − Δ, f and f + Δ (Δ = sampleRate/N,
+             * one DFT bin) on the Hann-windowed signal. If the centre probe is the
+             * largest of the three, the peak is refined by quadratic interpolation
+             * exactly like detectFrequency(); otherwise the tone is reported as not
+             * present near the target.
+             *
+             * @param signal      Mono float PCM, at least 256 samples.
+             * @param sampleRate  Sample rate in Hz.
+             * @param targetsHz   Frequencies to probe (keep it small; cost is O(N·T)).
+             * @return            One measurement per target, in the same order.
+             *                    Empty on invalid input.
+             */
+            static std::vector<ToneMeasurement> measureTones(const std::vector<float> &signal,
+                                                             uint32_t sampleRate,
+                                                             const std::vector<float> &targetsHz);
+
+            /**
+             * Goertzel counterpart of isFrequency().
+             *
+             * True if a peak exists within one bin of @p expectedHz, its refined
+             * frequency is within @p toleranceHz, and the tone carries a dominant
+             * share of the signal energy (RMS of the tone ≥ half the signal RMS).
+             * A tone at 440 Hz is therefore rejected when 432 Hz is expected.
+             */
+            static bool isFrequencyGoertzel(const std::vector<float> &signal,
+                                            uint32_t sampleRate,
+                                            float expectedHz,
+                                            float toleranceHz = 1.0f);
+
+            /**
+             * Goertzel counterpart of validatePitchShift(): input must be at
+             * @p fromHz and output at @p toHz, both per isFrequencyGoertzel().
+             */
+            static bool validatePitchShiftGoertzel(const std::vector<float> &input,
+                                                   const std::vector<float> &output,
+                                                   uint32_t sampleRate,
+                                                   float fromHz,
+                                                   float toHz,
+                                                   float toleranceHz = 2.0f);
+
+            // ── Batch API (test matrices) ─────────────────────────────────────────
+
+            /**
+             * Analyse many signals in one call.
+             *
+             * Each result holds the same frequency as detectFrequency() and the same
+             * RMS as rmsEnergy() would report for that signal. Confidence is the
+             * fraction of the windowed spectrum's energy (DC excluded) within the
+             * Hann main lobe (±2 bins) of the peak: ≈ 1 for a clean tone, low for
+             * noise or several tones of similar level.
+             *
+             * @param signals     Views of the signals; they may differ in length.
+             * @param sampleRate  Common sample rate in Hz.
+             * @param threads     Threads to use, including the caller; 0 = one per CPU.
+             * @return            One analysis per signal, in the same order.
+             */
+            static std::vector<FrequencyAnalysis> analyzeBatch(const std::vector<SignalSpan> &signals,
+                                                               uint32_t sampleRate,
+                                                               unsigned threads = 0);
+
+            /**
+             * One SignalSpan per channel of interleaved PCM.
+             *
+             * @param interleaved  frames × channels samples; must outlive the spans.
+             */
+            static std::vector<SignalSpan> channelSpans(const float *interleaved,
+                                                        std::size_t frames,
+                                                        uint32_t channels);
+
             // ── Diagnostic helpers ────────────────────────────────────────────────
 
             /**
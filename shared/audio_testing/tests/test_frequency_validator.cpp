@@ -195,7 +195,7 @@ namespace audioshift
             /**
              * Helper: naive "pitch shift" by resampling a mono float buffer.
              *
-             * Applies a ratio by selecting samples at positions n / ratio (linear
+             * Applies a ratio by selecting samples at positions n · ratio (linear
              * interpolation).  Not high quality, but sufficient to produce a signal
              * that FrequencyValidator can detect at the shifted frequency.
              */
@@ -206,7 +206,7 @@ namespace audioshift
                 std::vector<float> out(N);
                 for (std::size_t n = 0; n < N; ++n)
                 {
-                    const double srcPos = static_cast<double>(n) / static_cast<double>(ratio);
+                    const double srcPos = static_cast<double>(n) * static_cast<double>(ratio);
                     const std::size_t i0 = static_cast<std::size_t>(srcPos);
                     const double frac = srcPos - static_cast<double>(i0);
                     if (i0 + 1 < N)
@@ -259,6 +259,195 @@ namespace audioshift
                     input440, silence, kSampleRate, 440.0f, 432.0f, 2.0f));
             }
 
+            // ── Goertzel filter bank ─────────────────────────────────────────────────────
+
+            TEST_F(FrequencyValidatorTest, MeasureTonesRefinesEachTarget)
+            {
+                // Two-tone mix; each target is measured independently in one pass
+                const auto a = makeTone(432.0f);
+                const auto b = makeTone(1000.0f);
+                std::vector<float> mix(kFrames);
+                for (uint32_t i = 0; i < kFrames; ++i)
+                {
+                    mix[i] = a[i] + b[i];
+                }
+
+                const auto tones = FrequencyValidator::measureTones(mix, kSampleRate, {432.0f, 1000.0f});
+                ASSERT_EQ(tones.size(), 2u);
+                EXPECT_TRUE(tones[0].peakInWindow);
+                EXPECT_TRUE(tones[1].peakInWindow);
+                EXPECT_NEAR(tones[0].frequencyHz, 432.0f, 0.5f);
+                EXPECT_NEAR(tones[1].frequencyHz, 1000.0f, 0.5f);
+                EXPECT_NEAR(tones[0].amplitude, 0.5f, 0.05f);
+                EXPECT_NEAR(tones[1].amplitude, 0.5f, 0.05f);
+            }
+
+            TEST_F(FrequencyValidatorTest, MeasureTonesRefinesOffTargetPeak)
+            {
+                // Tone sits 2 Hz off the probed target: still within one bin, and the
+                // refined estimate should land on the real tone
+                const auto tone = makeTone(434.0f);
+                const auto tones = FrequencyValidator::measureTones(tone, kSampleRate, {432.0f});
+                ASSERT_EQ(tones.size(), 1u);
+                EXPECT_TRUE(tones[0].peakInWindow);
+                EXPECT_NEAR(tones[0].frequencyHz, 434.0f, 0.5f);
+            }
+
+            TEST_F(FrequencyValidatorTest, MeasureTonesAgreesWithDetectFrequency)
+            {
+                const auto tone = makeTone(440.0f);
+                const float dft = FrequencyValidator::detectFrequency(tone, kSampleRate);
+                const auto tones = FrequencyValidator::measureTones(tone, kSampleRate, {440.0f});
+                ASSERT_EQ(tones.size(), 1u);
+                EXPECT_NEAR(tones[0].frequencyHz, dft, 0.5f);
+                // Probing on the target avoids the bin-grid bias of the DFT path
+                EXPECT_NEAR(tones[0].frequencyHz, 440.0f, 0.1f);
+            }
+
+            TEST_F(FrequencyValidatorTest, GoertzelDistinguishes432And440Hz)
+            {
+                const auto tone440 = makeTone(440.0f);
+                const auto tone432 = makeTone(432.0f);
+
+                EXPECT_TRUE(FrequencyValidator::isFrequencyGoertzel(tone432, kSampleRate, 432.0f, 1.0f));
+                EXPECT_TRUE(FrequencyValidator::isFrequencyGoertzel(tone440, kSampleRate, 440.0f, 1.0f));
+                EXPECT_FALSE(FrequencyValidator::isFrequencyGoertzel(tone440, kSampleRate, 432.0f, 1.0f));
+                EXPECT_FALSE(FrequencyValidator::isFrequencyGoertzel(tone432, kSampleRate, 440.0f, 1.0f));
+            }
+
+            TEST_F(FrequencyValidatorTest, GoertzelRejectsMinorComponent)
+            {
+                // A quiet 432 Hz component under a loud 1 kHz tone is not "the" frequency
+                const auto loud = makeTone(1000.0f);
+                const auto quiet = makeTone(432.0f);
+                std::vector<float> mix(kFrames);
+                for (uint32_t i = 0; i < kFrames; ++i)
+                {
+                    mix[i] = loud[i] + 0.1f * quiet[i];
+                }
+                EXPECT_FALSE(FrequencyValidator::isFrequencyGoertzel(mix, kSampleRate, 432.0f, 1.0f));
+                EXPECT_TRUE(FrequencyValidator::isFrequencyGoertzel(mix, kSampleRate, 1000.0f, 1.0f));
+            }
+
+            TEST_F(FrequencyValidatorTest, GoertzelSilenceIsNeverAccepted)
+            {
+                const auto silence = makeSilence();
+                EXPECT_FALSE(FrequencyValidator::isFrequencyGoertzel(silence, kSampleRate, 440.0f, 100.0f));
+            }
+
+            TEST_F(FrequencyValidatorTest, GoertzelValidatesPitchShift440To432)
+            {
+                const auto input440 = makeTone(440.0f);
+                const auto output432 = naivePitchShift(input440, 432.0f / 440.0f);
+
+                EXPECT_TRUE(FrequencyValidator::validatePitchShiftGoertzel(
+                    input440, output432, kSampleRate, 440.0f, 432.0f, 2.0f));
+                EXPECT_FALSE(FrequencyValidator::validatePitchShiftGoertzel(
+                    input440, input440, kSampleRate, 440.0f, 432.0f, 2.0f));
+            }
+
+            TEST_F(FrequencyValidatorTest, MeasureTonesRejectsInvalidInput)
+            {
+                const std::vector<float> tiny = {0.5f, -0.5f};
+                EXPECT_TRUE(FrequencyValidator::measureTones(tiny, kSampleRate, {440.0f}).empty());
+                EXPECT_TRUE(FrequencyValidator::measureTones(makeTone(440.0f), 0, {440.0f}).empty());
+                EXPECT_TRUE(FrequencyValidator::measureTones(makeTone(440.0f), kSampleRate, {}).empty());
+            }
+
+            // ── Batch API ────────────────────────────────────────────────────────────────
+
+            TEST_F(FrequencyValidatorTest, BatchMatchesSingleSignalApi)
+            {
+                // Power-of-two and other lengths (the latter take the Bluestein path)
+                const std::vector<std::vector<float>> tones = {
+                    makeTone(440.0f), makeTone(432.0f, 6000), makeTone(1000.0f, 4801), makeSilence(1000)};
+                std::vector<SignalSpan> spans;
+                for (const auto &t : tones)
+                {
+                    spans.push_back({t.data(), t.size(), 1});
+                }
+
+                const auto results = FrequencyValidator::analyzeBatch(spans, kSampleRate, 2);
+                ASSERT_EQ(results.size(), tones.size());
+                for (std::size_t i = 0; i < tones.size(); ++i)
+                {
+                    EXPECT_FLOAT_EQ(results[i].frequencyHz,
+                                    FrequencyValidator::detectFrequency(tones[i], kSampleRate));
+                    EXPECT_FLOAT_EQ(results[i].rms, FrequencyValidator::rmsEnergy(tones[i]));
+                }
+                EXPECT_NEAR(results[1].frequencyHz, 432.0f, 1.0f);
+                EXPECT_NEAR(results[2].frequencyHz, 1000.0f, 1.0f);
+                EXPECT_FLOAT_EQ(results[3].frequencyHz, 0.0f);
+            }
+
+            TEST_F(FrequencyValidatorTest, BatchReadsInterleavedChannels)
+            {
+                const auto left = makeTone(432.0f);
+                const auto right = makeTone(440.0f);
+                std::vector<float> stereo(2 * kFrames);
+                for (uint32_t i = 0; i < kFrames; ++i)
+                {
+                    stereo[2 * i] = left[i];
+                    stereo[2 * i + 1] = 0.25f * right[i];
+                }
+
+                const auto spans = FrequencyValidator::channelSpans(stereo.data(), kFrames, 2);
+                ASSERT_EQ(spans.size(), 2u);
+                const auto results = FrequencyValidator::analyzeBatch(spans, kSampleRate);
+                ASSERT_EQ(results.size(), 2u);
+                EXPECT_NEAR(results[0].frequencyHz, 432.0f, 0.5f);
+                EXPECT_NEAR(results[1].frequencyHz, 440.0f, 0.5f);
+                EXPECT_NEAR(results[0].rms, kAmp / std::sqrt(2.0f), 0.01f);
+                EXPECT_NEAR(results[1].rms, 0.25f * kAmp / std::sqrt(2.0f), 0.01f);
+            }
+
+            TEST_F(FrequencyValidatorTest, BatchConfidenceSeparatesCleanFromMixed)
+            {
+                const auto clean = makeTone(432.0f);
+                const auto other = makeTone(1000.0f);
+                std::vector<float> mix(kFrames);
+                for (uint32_t i = 0; i < kFrames; ++i)
+                {
+                    mix[i] = clean[i] + other[i];
+                }
+                const auto silence = makeSilence();
+
+                const auto results = FrequencyValidator::analyzeBatch(
+                    {{clean.data(), kFrames, 1}, {mix.data(), kFrames, 1}, {silence.data(), kFrames, 1}},
+                    kSampleRate);
+                ASSERT_EQ(results.size(), 3u);
+                EXPECT_GT(results[0].confidence, 0.99f);
+                EXPECT_NEAR(results[1].confidence, 0.5f, 0.05f);
+                EXPECT_FLOAT_EQ(results[2].confidence, 0.0f);
+            }
+
+            TEST_F(FrequencyValidatorTest, BatchResultsIndependentOfThreadCount)
+            {
+                // Rate × length matrix, as a pitch-accuracy sweep would run it
+                std::vector<std::vector<float>> signals;
+                for (int i = 0; i < 48; ++i)
+                {
+                    signals.push_back(makeTone(200.0f + 37.0f * static_cast<float>(i), 2048 + 512 * (i % 5)));
+                }
+                std::vector<SignalSpan> spans;
+                for (const auto &s : signals)
+                {
+                    spans.push_back({s.data(), s.size(), 1});
+                }
+
+                const auto serial = FrequencyValidator::analyzeBatch(spans, kSampleRate, 1);
+                const auto parallel = FrequencyValidator::analyzeBatch(spans, kSampleRate, 4);
+                ASSERT_EQ(serial.size(), spans.size());
+                ASSERT_EQ(parallel.size(), spans.size());
+                for (std::size_t i = 0; i < spans.size(); ++i)
+                {
+                    EXPECT_FLOAT_EQ(serial[i].frequencyHz, parallel[i].frequencyHz);
+                    EXPECT_FLOAT_EQ(serial[i].confidence, parallel[i].confidence);
+                    EXPECT_NEAR(serial[i].frequencyHz, 200.0f + 37.0f * static_cast<float>(i), 2.0f);
+                }
+                EXPECT_TRUE(FrequencyValidator::analyzeBatch({}, kSampleRate).empty());
+            }
+
             // ── Edge cases ───────────────────────────────────────────────────────────────
 
             TEST_F(FrequencyValidatorTest, EmptySpectrumOnTinyInput)
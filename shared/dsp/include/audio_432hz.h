@@ -1,17 +1,103 @@
 #ifndef AUDIOSHIFT_AUDIO_432HZ_H
 #define AUDIOSHIFT_AUDIO_432HZ_H
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 
 namespace audioshift {
 namespace dsp {
 
+/** Pitch shift from A4 = 440 Hz to 432 Hz: 12 · log2(432 / 440) semitones */
+constexpr float PITCH_SEMITONES_432_HZ = -0.31767f;
+
+/**
+ * @brief Interpolator of the engine's sample-rate transposer
+ *
+ * Values match SoundTouch's SETTING_INTERPOLATION.
+ */
+enum class Interpolator {
+    kLinear = 0,   ///< 2 taps, cheapest, audible high-frequency roll-off
+    kCubic = 1,    ///< 4 taps (default)
+    kShannon = 2,  ///< 8-tap Kaiser-windowed sinc, mono/stereo only
+};
+
+/**
+ * @brief Latency/quality trade-off of the processing chain
+ *
+ * Selects the anti-alias filter of the rate transposer. The low-delay
+ * profiles use a minimum-phase design, whose group delay is a frame or two
+ * instead of half the filter length. They also use the approximate WSOLA
+ * overlap search (SETTING_FAST_SEEK), which cuts the cost of the engine's
+ * hottest loop and rarely splices more than a sample or two from the exact
+ * choice.
+ *
+ * VoIP replaces WSOLA with a pitch-synchronous (PSOLA) voice engine: voiced
+ * speech is delayed by half a pitch period on average, under 7 ms for
+ * voices down to 75 Hz, and unvoiced sound passes through unchanged.
+ * Music played into it still changes pitch, but less cleanly.
+ */
+enum class ProcessingProfile {
+    kMusic = 0,  ///< 64-tap linear-phase anti-alias filter, exact search (default)
+    kVoip = 1,   ///< PSOLA voice engine: least delay, cost follows the voiced share
+    kGame = 2,   ///< 64-tap minimum-phase filter, fast search: low delay, full stop band
+};
+
+/**
+ * @brief WSOLA configuration chosen from the output latency budget
+ *
+ * Ordered from best quality to least delay. Longer sequences and seek
+ * windows splice less often and find better matches, at the cost of delay.
+ */
+enum class LatencyTier {
+    kHighQuality = 0,  ///< ~106 ms: 80 ms sequences
+    kBalanced = 1,     ///< ~56 ms: 40 ms sequences (default)
+    kLowLatency = 2,   ///< ~28 ms: 20 ms sequences, minimum-phase anti-alias filter
+    kMinimum = 3,      ///< ~15 ms: 10 ms sequences, minimum-phase anti-alias filter
+};
+
+/**
+ * @brief Heap footprint of a converter
+ *
+ * Covers the converter itself, its engines, filter tables, sample queues
+ * and scratch buffers, including the nested low-band converter in
+ * band-split mode.
+ */
+struct MemoryUsage {
+    size_t allocatedBytes;  ///< Held now, including spare capacity
+    size_t usedBytes;       ///< Part of it holding state or queued audio
+    size_t peakUsedBytes;   ///< Most ever needed at once since creation or shrinkToFit()
+};
+
+/**
+ * @brief Where a shadow engine runs (Audio432HzConverter::setShadow())
+ */
+enum class ShadowMode {
+    kInline = 0,  ///< Inside process(), after the production engine
+    kWorker = 1,  ///< On a worker thread fed through a lock-free queue
+};
+
+/**
+ * @brief Production output against a shadow engine's, on identical input
+ *
+ * Both outputs are compared as mono mixes, once the lag between them has
+ * been found by cross-correlation.
+ */
+struct ShadowMetrics {
+    uint64_t framesCompared;  ///< Output frames compared so far
+    uint64_t dropped;         ///< Buffers the shadow missed (worker behind, or too large)
+    float costRatio;          ///< Shadow processing time / production processing time
+    float snrDb;              ///< Production over the aligned difference, ~1 s average; 0 until aligned
+    float pitchCents;         ///< Shadow content pitch relative to production; 0 until both are estimated
+    int lagFrames;            ///< Shadow output delay relative to production
+};
+
 /**
  * @brief Real-time audio pitch-shift to 432 Hz tuning frequency
  *
  * Converts audio from 440 Hz tuning (A4=440) to 432 Hz tuning (A4=432)
- * using WSOLA (Waveform Similarity Overlap-Add) algorithm.
+ * using WSOLA (Waveform Similarity Overlap-Add) algorithm, or PSOLA
+ * (Pitch-Synchronous Overlap-Add) in the VoIP profile.
  *
  * Conversion ratio: 432/440 ≈ 0.98182 (-31.77 cents)
  *
@@ -31,6 +117,9 @@ public:
 
     /**
      * @brief Process audio buffer to 432 Hz pitch
+     *
+     * Runs with subnormal floats flushed to zero (FTZ/DAZ on x86, FZ on ARM);
+     * the caller's floating-point mode is restored before returning.
      * @param buffer Input/output PCM audio buffer (int16 samples)
      * @param numSamples Number of samples in buffer
      * @return Actual samples processed
@@ -38,7 +127,40 @@ public:
     int process(int16_t* buffer, int numSamples);
 
     /**
-     * @brief Set sample rate (may reset internal state)
+     * @brief Process @p in into a separate output buffer
+     *
+     * Same as the in-place overload without the copy an out-of-place caller
+     * would otherwise make first. @p in is left untouched; @p out may alias it.
+     * @param in Input PCM audio (int16 samples)
+     * @param out Output PCM audio, @p numSamples samples
+     * @param numSamples Number of samples in each buffer
+     * @return Actual samples processed
+     */
+    int process(const int16_t* in, int16_t* out, int numSamples);
+
+    /**
+     * @brief Process float audio in [-1, 1), for sources beyond 16 bits
+     *
+     * The same stream as the int16 overloads: switching entry points between
+     * calls is seamless. Nothing on the way is rounded to 16 bits, and the
+     * output is not clamped. In deterministic mode the hashes cover the
+     * float bytes. The shadow (setShadow()) is fed by the int16 overloads
+     * only.
+     * @param in Interleaved input, @p frames × channels samples
+     * @param out Interleaved output, may alias @p in
+     * @param frames Frames in each buffer (not samples, unlike the int16 overloads)
+     * @return Frames processed
+     */
+    int process(const float* in, float* out, int frames);
+
+    /**
+     * @brief Set sample rate
+     *
+     * A new rate keeps the stream running: the engines are re-primed with
+     * the last 200 ms of input resampled to the new rate, and what the old
+     * engines still had buffered is crossfaded into the new output over
+     * 10 ms. Setting the current rate again restarts processing (buffered
+     * audio is discarded).
      * @param sampleRate New sample rate in Hz
      */
     void setSampleRate(int sampleRate);
@@ -50,7 +172,179 @@ public:
     void setPitchShiftSemitones(float semitones);
 
     /**
-     * @brief Get estimated latency from input to output
+     * @brief Select the internal sample layout
+     *
+     * Planar mode deinterleaves once on input (fused with the int16→float
+     * conversion), runs one mono engine per channel on 64-byte aligned
+     * contiguous arrays and reinterleaves once on output. Mono data lets the
+     * filter and correlation kernels run at full SIMD width; the gain grows
+     * with the channel count. Channel 0 chooses the splice positions for all
+     * channels so the stereo image is preserved.
+     *
+     * Switching restarts processing (buffered audio is discarded).
+     * @param enabled true for planar, false for interleaved (default)
+     */
+    void setPlanarProcessing(bool enabled);
+
+    /**
+     * @brief Check whether planar processing is active
+     * @return true if per-channel engines are in use
+     */
+    bool isPlanarProcessing() const;
+
+    /**
+     * @brief Process hi-res input in two bands
+     *
+     * At integer multiples of 48 kHz or 44.1 kHz (88.2, 96, 176.4, 192 kHz)
+     * a linear-phase crossover splits the input at 20 kHz. The low band is
+     * decimated to the base rate and pitch-shifted there; the ultrasonic
+     * band is only delayed to match and then added back. WSOLA cost then
+     * stays at the base-rate level instead of growing with the sample rate.
+     * At other rates the setting is remembered but has no effect.
+     *
+     * Switching restarts processing (buffered audio is discarded).
+     * @param enabled true to split hi-res input
+     */
+    void setBandSplit(bool enabled);
+
+    /**
+     * @brief Check whether band-split mode is requested
+     * @return true if enabled, whatever the current sample rate
+     */
+    bool isBandSplit() const;
+
+    /**
+     * @brief Check whether the band-split path is actually running
+     * @return true if enabled and the sample rate is a supported hi-res rate
+     */
+    bool isBandSplitActive() const;
+
+    /**
+     * @brief Select the interpolator of the sample-rate transposer
+     *
+     * All three have SSE versions, which are used unless deterministic mode
+     * is on. Shannon is limited to mono and stereo engines; with more
+     * interleaved channels the engines stay on cubic.
+     *
+     * Switching restarts processing (buffered audio is discarded).
+     * @param interpolator Interpolation algorithm
+     */
+    void setInterpolator(Interpolator interpolator);
+
+    /**
+     * @brief Get the selected interpolator
+     * @return Interpolation algorithm
+     */
+    Interpolator getInterpolator() const;
+
+    /**
+     * @brief Select the processing profile
+     *
+     * Switching restarts processing (buffered audio is discarded).
+     * @param profile Latency/quality trade-off
+     */
+    void setProcessingProfile(ProcessingProfile profile);
+
+    /**
+     * @brief Get the selected processing profile
+     * @return Processing profile
+     */
+    ProcessingProfile getProcessingProfile() const;
+
+    /**
+     * @brief Fit the engine's delay into what the output sink leaves over
+     *
+     * Picks the best-quality LatencyTier whose engine latency fits into
+     * budgetMs - sinkLatencyMs, or the lowest-delay tier if the link alone
+     * nearly uses up the budget. Low-delay tiers also switch the music
+     * profile's anti-alias filter to minimum phase. The new settings take
+     * effect on the running stream at the next WSOLA sequence, without a
+     * restart (in band-split mode the low band restarts).
+     *
+     * @param sinkLatencyMs Delay added after the effect, e.g. a Bluetooth codec
+     * @param budgetMs Total delay the stream can afford; <= 0 restores kBalanced
+     */
+    void setOutputLatency(float sinkLatencyMs, float budgetMs);
+
+    /**
+     * @brief Get the tier picked by setOutputLatency()
+     * @return kBalanced unless a budget is set
+     */
+    LatencyTier getLatencyTier() const;
+
+    /**
+     * @brief Enable bit-exact deterministic processing
+     *
+     * Restricts the engines to the portable C kernels, so that the output
+     * depends only on the input and the build, not on the CPU's SIMD
+     * extensions. While enabled, every output buffer is hashed (XXH64) and
+     * golden-output tests can compare hashes instead of spectra.
+     *
+     * Switching restarts processing (buffered audio is discarded).
+     * @param enabled true for deterministic mode
+     */
+    void setDeterministic(bool enabled);
+
+    /**
+     * @brief Check whether deterministic mode is active
+     * @return true if the portable kernels are in use
+     */
+    bool isDeterministic() const;
+
+    /**
+     * @brief XXH64 of the output of the last process() call
+     * @return Hash of the little-endian sample bytes, 0 if not deterministic
+     */
+    uint64_t getLastBufferHash() const;
+
+    /**
+     * @brief XXH64 over all output since the stream started
+     *
+     * Equal to hashing the concatenation of all buffers returned by process()
+     * since the last mode switch or setSampleRate().
+     * @return Running hash, 0 if not deterministic
+     */
+    uint64_t getStreamHash() const;
+
+    /**
+     * @brief Pass through content that is already tuned to A4 = 432 Hz
+     *
+     * A background analyser estimates the concert-pitch reference of the
+     * input from a pitch histogram over tens of seconds (decimated audio,
+     * incremental FFT). Once it is confidently at 432 Hz, the output fades
+     * into the untouched input and the engines stop running; if the
+     * reference moves away again, the engines are primed in the background
+     * and the output fades back to processed audio. Hysteresis keeps the
+     * decision from flapping.
+     *
+     * Off by default. Enabling resets the estimate.
+     * @param enabled true to allow automatic bypass
+     */
+    void setAutoBypass(bool enabled);
+
+    /**
+     * @brief Check whether automatic bypass is allowed
+     * @return true if the tuning analyser is running
+     */
+    bool isAutoBypass() const;
+
+    /**
+     * @brief Check whether the input is currently passed through untouched
+     * @return true while auto-bypass holds the engines idle
+     */
+    bool isBypassed() const;
+
+    /**
+     * @brief Estimated A4 reference of the input
+     * @return Hz, 0 until enough material was analysed or if auto-bypass is off
+     */
+    float getEstimatedReferenceHz() const;
+
+    /**
+     * @brief Get latency from input to output
+     *
+     * Reported by the engine for the current settings, including the
+     * anti-alias filter's group delay and the band-split filters.
      * @return Latency in milliseconds
      */
     float getLatencyMs() const;
@@ -61,6 +355,54 @@ public:
      */
     float getCpuUsagePercent() const;
 
+    /**
+     * @brief Current heap footprint
+     *
+     * Walks the engines without allocating; cheap enough for a stats
+     * command but not meant for every callback.
+     */
+    MemoryUsage getMemoryUsage() const;
+
+    /**
+     * @brief Return capacity that a burst left behind
+     *
+     * Sample queues shrink to the peak they needed since the previous call
+     * (or creation), and scratch buffers to the size of the last process()
+     * call, so calling this periodically converges on the steady-state
+     * footprint. Buffered audio is kept. Allocates: call it from a control
+     * thread, not from the audio callback.
+     */
+    void shrinkToFit();
+
+    /**
+     * @brief Run another converter beside this one for A/B comparison
+     *
+     * @p shadow gets the same input as this converter and keeps its own
+     * settings, except the sample rate, which follows setSampleRate(). Its
+     * output is compared with this converter's and dropped; process()
+     * output is unchanged. In ShadowMode::kWorker process() only copies the
+     * buffers to a worker thread and skips the shadow when the worker has
+     * no room; in ShadowMode::kInline the shadow runs inside process().
+     *
+     * Allocates: call it from a control thread, not from the audio
+     * callback. Replaces any shadow already running.
+     * @param shadow Converter under evaluation, same channel count; nullptr stops the shadow
+     * @return false if the channel counts differ or out of memory (no shadow then runs)
+     */
+    bool setShadow(std::unique_ptr<Audio432HzConverter> shadow, ShadowMode mode = ShadowMode::kWorker);
+
+    /**
+     * @brief Check whether a shadow converter is running
+     * @return true after a successful setShadow()
+     */
+    bool hasShadow() const;
+
+    /**
+     * @brief Comparison of this converter's output with the shadow's
+     * @return Metrics so far; zeros without a shadow
+     */
+    ShadowMetrics getShadowMetrics() const;
+
 private:
     class Impl;  // Pimpl pattern for hiding SoundTouch dependency
     std::unique_ptr<Impl> pImpl_;
@@ -1,10 +1,23 @@
 #include "audio_432hz.h"
+#include "band_split.h"
+#include "denormal_guard.h"
+#include "latency_budget.h"
+#include "output_hash.h"
+#include "pcm_convert.h"
+#include "psola_shifter.h"
+#include "shadow_runner.h"
+#include "stream_switch.h"
+#include "tuning_estimator.h"
 
 #include <SoundTouch.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <vector>
 
 namespace audioshift
@@ -12,35 +25,785 @@ namespace audioshift
 namespace dsp
 {
 
+namespace
+{
+
+// A converter run as a shadow: interleaved int16 in and out, like process()
+class ConverterShadow final : public ShadowEngine
+{
+public:
+    ConverterShadow(std::unique_ptr<Audio432HzConverter> converter, int sampleRate, int channels)
+        : converter_(std::move(converter)), sampleRate_(sampleRate), channels_(channels)
+    {
+    }
+
+    int process(const void* in, void* out, int frames, PcmFormat format) override
+    {
+        if (format != PcmFormat::kInt16)
+        {
+            return 0;
+        }
+        return converter_->process(static_cast<const int16_t*>(in), static_cast<int16_t*>(out),
+                                   frames * channels_) /
+               channels_;
+    }
+
+    // Same rate: restarts the stream
+    void reset() override { converter_->setSampleRate(sampleRate_); }
+
+    void setSampleRate(int sampleRate)
+    {
+        sampleRate_ = sampleRate;
+        converter_->setSampleRate(sampleRate);
+    }
+
+    const Audio432HzConverter& converter() const { return *converter_; }
+
+private:
+    std::unique_ptr<Audio432HzConverter> converter_;
+    int sampleRate_;
+    const int channels_;
+};
+
+// Sample-type dispatch for the int16 and float entry points. Float samples
+// are in the engines' [-1, 1) range already
+inline void toFloat(const int16_t* in, float* out, size_t count)
+{
+    int16ToFloat(in, out, count);
+}
+
+inline void toFloat(const float* in, float* out, size_t count)
+{
+    std::copy(in, in + count, out);
+}
+
+inline void fromFloat(const float* in, int16_t* out, size_t count)
+{
+    floatToInt16(in, out, count);
+}
+
+inline void fromFloat(const float* in, float* out, size_t count)
+{
+    std::copy(in, in + count, out);
+}
+
+inline void deinterleave(const int16_t* in, int frames, int channels, PlanarBuffer& out)
+{
+    deinterleaveToFloat(in, frames, channels, out);
+}
+
+void deinterleave(const float* in, int frames, int channels, PlanarBuffer& out)
+{
+    for (int c = 0; c < channels; c++)
+    {
+        float* dst = out.channel(c);
+        for (int i = 0; i < frames; i++)
+        {
+            dst[i] = in[static_cast<size_t>(i) * channels + c];
+        }
+    }
+}
+
+inline void interleave(const PlanarBuffer& in, int frames, int channels, int16_t* out)
+{
+    interleaveToInt16(in, frames, channels, out);
+}
+
+void interleave(const PlanarBuffer& in, int frames, int channels, float* out)
+{
+    for (int c = 0; c < channels; c++)
+    {
+        const float* src = in.channel(c);
+        for (int i = 0; i < frames; i++)
+        {
+            out[static_cast<size_t>(i) * channels + c] = src[i];
+        }
+    }
+}
+
+// Linear blend, 'from' at g = 0
+inline int16_t blend(int16_t from, int16_t to, float g)
+{
+    return static_cast<int16_t>(std::lround(from + g * (to - from)));
+}
+
+inline float blend(float from, float to, float g)
+{
+    return from + g * (to - from);
+}
+
+}  // namespace
+
 // Pimpl implementation using SoundTouch
 class Audio432HzConverter::Impl
 {
 public:
-    soundtouch::SoundTouch soundTouch;
+    std::unique_ptr<soundtouch::SoundTouch> soundTouch;
     int sampleRate;
     int channels;
+    float pitchSemitones;
     std::vector<float> floatIn;
     std::vector<float> floatOut;
+    int lastFrames = 0;  // size of the latest process() call, scratch shrinks to it
+    bool floatStream = false;  // the latest call came through the float entry point
     std::atomic<float> cpuUsage{0.0f};
     std::chrono::steady_clock::time_point lastProcessTime;
 
-    // Pitch shift value: 432/440 = 0.98182 = -31.77 cents ≈ -0.5296 semitones
-    static constexpr float PITCH_SEMITONES = -0.5296f;
+    // Planar mode: one mono engine per channel, channel 0 leads the WSOLA
+    // splice positions so all channels stay phase-aligned
+    bool planar = false;
+    std::vector<std::unique_ptr<soundtouch::SoundTouch>> planarEngines;
+    PlanarBuffer planarIn;
+    PlanarBuffer planarOut;
+
+    // VoIP profile: the pitch-synchronous voice engine replaces WSOLA, whose
+    // engines then sit idle
+    std::unique_ptr<PsolaShifter> voice;
+
+    // Deterministic mode: portable C kernels only, output hashed per buffer
+    bool deterministic = false;
+    Interpolator interpolator = Interpolator::kCubic;
+    ProcessingProfile profile = ProcessingProfile::kMusic;
+    LatencyTier latencyTier = LatencyTier::kBalanced;
+    OutputHash streamHash;
+    uint64_t lastBufferHash = 0;
 
-    Impl(int sr, int ch) : sampleRate(sr), channels(ch)
+    // Band-split mode (hi-res rates): only the band below 20 kHz is shifted,
+    // by a nested converter running at the base rate
+    bool bandSplit = false;
+    std::unique_ptr<BandSplitter> splitter;
+    std::unique_ptr<Audio432HzConverter> lowBand;
+    std::vector<int16_t> lowBuffer;
+    std::vector<float> lowFloat;  // float entry point
+
+    // Auto-bypass: content already mastered at A4 = 432 passes through untouched
+    enum class BypassState
     {
-        soundTouch.setSampleRate(sr);
-        soundTouch.setChannels(ch);
-        soundTouch.setPitchSemiTones(PITCH_SEMITONES);
+        kActive,    // engines running, output is processed
+        kBypassed,  // engines idle, output is the input
+        kResuming,  // engines priming, input stays audible until they deliver
+    };
+    bool autoBypass = false;
+    BypassState bypassState = BypassState::kActive;
+    TuningEstimator tuning;
+    std::vector<int16_t> dry;
+    std::vector<float> dryFloat;  // float entry point
 
-        // Tuning for real-time: lower latency, reasonable quality
-        soundTouch.setSetting(SETTING_USE_AA_FILTER, 1);
-        soundTouch.setSetting(SETTING_SEQUENCE_MS, 40);
-        soundTouch.setSetting(SETTING_SEEKWINDOW_MS, 15);
-        soundTouch.setSetting(SETTING_OVERLAP_MS, 8);
+    // Rate switching: recent input re-primes the engines at the new rate,
+    // and the old engines' pending output fades out over the new output.
+    // Without the memory for it a rate change restarts the stream
+    std::unique_ptr<StreamSwitch> streamSwitch;
+
+    static constexpr float TARGET_REFERENCE_HZ = 432.0f;
 
+    // Shadow converter under evaluation, fed the same input (setShadow())
+    std::unique_ptr<ShadowRunner> shadow;
+    ConverterShadow* shadowEngine = nullptr;  // engine of shadow
+
+    Impl(int sr, int ch)
+        : sampleRate(sr), channels(ch), pitchSemitones(PITCH_SEMITONES_432_HZ), tuning(sr)
+    {
+        soundTouch = makeEngine(ch);
+        streamSwitch.reset(StreamSwitch::create(sr, ch));
         lastProcessTime = std::chrono::steady_clock::now();
     }
+
+    std::unique_ptr<soundtouch::SoundTouch> makeEngine(int ch)
+    {
+        // Extension mask 0 pins SoundTouch to its plain C kernels, whose
+        // accumulation order is the same on every CPU
+        auto st = std::make_unique<soundtouch::SoundTouch>(deterministic ? 0u : 0xffffffffu);
+        configure(*st, ch);
+        return st;
+    }
+
+    void configure(soundtouch::SoundTouch& st, int ch)
+    {
+        st.setSampleRate(sampleRate);
+        st.setChannels(ch);
+        st.setPitchSemiTones(pitchSemitones);
+
+        // Tuning for real-time: lower latency, reasonable quality
+        st.setSetting(SETTING_USE_AA_FILTER, 1);
+        st.setSetting(SETTING_INTERPOLATION, static_cast<int>(interpolator));
+        // Search for each splice as its input arrives, not all in the callback
+        // that completes the sequence; same output, even cost per callback
+        st.setSetting(SETTING_SPREAD_SEEK, 1);
+        // Longer sequences and a narrower search on sustained material,
+        // the tier's lengths near onsets; never more delay than the tier's
+        st.setSetting(SETTING_ADAPTIVE_SEQUENCE, 1);
+        applyLatency(st);
+    }
+
+    // Sequence lengths and anti-alias filter for the latency tier. SoundTouch
+    // picks these up between sequences, so this is safe on a running engine
+    void applyLatency(soundtouch::SoundTouch& st)
+    {
+        applyLatencyTier(st, latencyTier);
+        const ProcessingProfile aa = effectiveProfile(profile, latencyTier);
+        st.setSetting(SETTING_AA_FILTER_LENGTH, aa == ProcessingProfile::kVoip ? 32 : 64);
+        st.setSetting(SETTING_AA_FILTER_MINIMUM_PHASE, aa != ProcessingProfile::kMusic);
+        // The search follows the requested profile: music on a short tier keeps it exact
+        st.setSetting(SETTING_FAST_SEEK, profile != ProcessingProfile::kMusic);
+    }
+
+    // Engines that hold no audio yet take the new settings in place. A
+    // running stream keeps its old delay unless it is re-primed, so it goes
+    // through the seamless switch instead
+    void setLatencyTier(LatencyTier tier)
+    {
+        if (tier == latencyTier)
+        {
+            return;
+        }
+        const soundtouch::SoundTouch& lead = leadEngine();
+        if (!splitter && lead.numSamples() == 0 && lead.numUnprocessedSamples() == 0)
+        {
+            latencyTier = tier;
+            forEachEngine([this](soundtouch::SoundTouch& st) { applyLatency(st); });
+            return;
+        }
+        switchStream(sampleRate, tier);
+    }
+
+    void createPlanarEngines()
+    {
+        planarEngines.clear();
+        for (int c = 0; c < channels; c++)
+        {
+            auto st = makeEngine(1);
+            if (c > 0)
+            {
+                st->setSeekLeader(planarEngines[0].get());
+            }
+            planarEngines.push_back(std::move(st));
+        }
+    }
+
+    template <typename Fn>
+    void forEachEngine(Fn fn)
+    {
+        fn(*soundTouch);
+        for (auto& st : planarEngines)
+        {
+            fn(*st);
+        }
+    }
+
+    void clearEngines()
+    {
+        forEachEngine([](soundtouch::SoundTouch& st) { st.clear(); });
+        if (voice)
+        {
+            voice->clear();
+        }
+    }
+
+    // Created for the VoIP profile unless the band-split path runs; a nested
+    // low-band converter has its own
+    void configureVoice()
+    {
+        voice.reset();
+        if (profile == ProcessingProfile::kVoip && !splitter)
+        {
+            voice.reset(PsolaShifter::create(sampleRate, channels));
+            if (voice)
+            {
+                voice->setPitchSemitones(pitchSemitones);
+            }
+        }
+    }
+
+    // Per-sample-type scratch of the band-split and auto-bypass paths
+    std::vector<int16_t>& lowScratch(const int16_t*) { return lowBuffer; }
+    std::vector<float>& lowScratch(const float*) { return lowFloat; }
+    std::vector<int16_t>& dryScratch(const int16_t*) { return dry; }
+    std::vector<float>& dryScratch(const float*) { return dryFloat; }
+
+    // All paths return the number of frames written to the front of out,
+    // which may alias in. T is int16_t or float
+    template <typename T>
+    int processInterleaved(const T* in, T* out, int frames)
+    {
+        const size_t totalSamples = static_cast<size_t>(frames) * channels;
+        if (floatIn.size() < totalSamples)
+        {
+            floatIn.resize(totalSamples);
+            floatOut.resize(totalSamples);
+        }
+
+        toFloat(in, floatIn.data(), totalSamples);
+
+        soundTouch->putSamples(floatIn.data(), frames);
+        const int received = static_cast<int>(soundTouch->receiveSamples(floatOut.data(), frames));
+
+        fromFloat(floatOut.data(), out, static_cast<size_t>(received) * channels);
+        return received;
+    }
+
+    template <typename T>
+    int processPlanar(const T* in, T* out, int frames)
+    {
+        planarIn.reserve(channels, frames);
+        planarOut.reserve(channels, frames);
+
+        deinterleave(in, frames, channels, planarIn);
+
+        // The leader (channel 0) must run first so followers find its splice points
+        int received = frames;
+        for (int c = 0; c < channels; c++)
+        {
+            planarEngines[c]->putSamples(planarIn.channel(c), frames);
+            const int got = static_cast<int>(
+                    planarEngines[c]->receiveSamples(planarOut.channel(c), frames));
+            received = std::min(received, got);
+        }
+
+        interleave(planarOut, received, channels, out);
+        return received;
+    }
+
+    // The voice engine delivers a frame for every frame in
+    template <typename T>
+    int processVoice(const T* in, T* out, int frames)
+    {
+        const size_t totalSamples = static_cast<size_t>(frames) * channels;
+        if (floatIn.size() < totalSamples)
+        {
+            floatIn.resize(totalSamples);
+            floatOut.resize(totalSamples);
+        }
+        toFloat(in, floatIn.data(), totalSamples);
+        voice->process(floatIn.data(), floatOut.data(), frames);
+        fromFloat(floatOut.data(), out, totalSamples);
+        return frames;
+    }
+
+    template <typename T>
+    int render(const T* in, T* out, int frames)
+    {
+        if (splitter)
+        {
+            return processBandSplit(in, out, frames);
+        }
+        if (voice)
+        {
+            return processVoice(in, out, frames);
+        }
+        return planar ? processPlanar(in, out, frames) : processInterleaved(in, out, frames);
+    }
+
+    template <typename T>
+    int processBandSplit(const T* in, T* out, int frames)
+    {
+        std::vector<T>& low = lowScratch(in);
+        const size_t lowSamples = static_cast<size_t>(frames / splitter->factor() + 1) * channels;
+        if (low.size() < lowSamples)
+        {
+            low.resize(lowSamples);
+        }
+
+        const int lowFrames = splitter->split(in, frames, low.data());
+        processLowBand(low.data(), lowFrames);
+        splitter->merge(low.data(), lowFrames, out, frames);
+        return frames;
+    }
+
+    void processLowBand(int16_t* low, int lowFrames) { lowBand->process(low, lowFrames * channels); }
+    void processLowBand(float* low, int lowFrames) { lowBand->process(low, low, lowFrames); }
+
+    // Creates or drops the band-split path to match the mode and sample rate
+    void configureBandSplit()
+    {
+        const int baseRate = BandSplitter::baseRateFor(sampleRate);
+        if (!bandSplit || baseRate == 0)
+        {
+            splitter.reset();
+            lowBand.reset();
+            return;
+        }
+
+        lowBand = std::make_unique<Audio432HzConverter>(baseRate, channels);
+        lowBand->setPitchShiftSemitones(pitchSemitones);
+        lowBand->setDeterministic(deterministic);
+        lowBand->setInterpolator(interpolator);
+        lowBand->setProcessingProfile(profile);
+        lowBand->setPlanarProcessing(planar);
+        lowBand->pImpl_->setLatencyTier(latencyTier);
+
+        splitter = std::make_unique<BandSplitter>(sampleRate, channels);
+        splitter->setLowBandLatency(lowBand->pImpl_->latencyFrames());
+    }
+
+    // Linear crossfade from 'from' to 'to' across the buffer; out may alias either
+    template <typename T>
+    void crossfade(const T* from, const T* to, T* out, int frames)
+    {
+        const float step = 1.0f / frames;
+        for (int i = 0; i < frames; i++)
+        {
+            const float g = (i + 1) * step;
+            for (int c = 0; c < channels; c++)
+            {
+                const size_t k = static_cast<size_t>(i) * channels + c;
+                out[k] = blend(from[k], to[k], g);
+            }
+        }
+    }
+
+    // Runs the bypass state machine for one buffer; returns the valid frames
+    template <typename T>
+    int processAutoBypass(const T* in, T* out, int frames)
+    {
+        const size_t n = static_cast<size_t>(frames) * channels;
+        const bool matched = tuning.matchesReference(TARGET_REFERENCE_HZ,
+                                                     bypassState == BypassState::kBypassed);
+        if (bypassState == BypassState::kBypassed)
+        {
+            if (matched)
+            {
+                std::copy(in, in + n, out);
+                return frames;
+            }
+            bypassState = BypassState::kResuming;
+        }
+
+        // Rendering in place overwrites the input, so keep a copy of it
+        const T* input = in;
+        if (in == out)
+        {
+            std::vector<T>& dryIn = dryScratch(in);
+            if (dryIn.size() < n)
+            {
+                dryIn.resize(n);
+            }
+            std::copy(in, in + n, dryIn.begin());
+            input = dryIn.data();
+        }
+
+        const int received = render(in, out, frames);
+        std::fill(out + static_cast<size_t>(received) * channels, out + n, T());
+
+        if (bypassState == BypassState::kActive)
+        {
+            if (!matched)
+            {
+                return received;
+            }
+            // Fade the processed signal into the input, then let the engines idle
+            crossfade(out, input, out, frames);
+            clearEngines();
+            bypassState = BypassState::kBypassed;
+            return frames;
+        }
+
+        // Resuming
+        if (matched)
+        {
+            std::copy(input, input + n, out);
+            clearEngines();
+            bypassState = BypassState::kBypassed;
+        }
+        else if (received < frames)
+        {
+            std::copy(input, input + n, out);
+        }
+        else
+        {
+            crossfade(input, out, out, frames);
+            bypassState = BypassState::kActive;
+        }
+        return frames;
+    }
+
+    const soundtouch::SoundTouch& leadEngine() const
+    {
+        return planar ? *planarEngines[0] : *soundTouch;
+    }
+
+    // Frames the output trails the input by: the engines' latency, the
+    // crossover filters in band-split mode
+    int latencyFrames() const
+    {
+        if (splitter)
+        {
+            // The splitter's delay already includes the low-band engine's
+            return splitter->latencyFrames();
+        }
+        if (voice)
+        {
+            return voice->latencyFrames();
+        }
+        return leadEngine().getSetting(SETTING_INITIAL_LATENCY);
+    }
+
+    // Latency plus output already produced but not handed out yet
+    int backlogFrames() const
+    {
+        if (splitter)
+        {
+            const Impl& low = *lowBand->pImpl_;
+            return splitter->latencyFrames() +
+                   static_cast<int>(low.leadEngine().numSamples()) * splitter->factor();
+        }
+        return latencyFrames() + static_cast<int>(leadEngine().numSamples());
+    }
+
+    // Feeds the engines without collecting their output
+    void queueInput(const int16_t* buffer, int frames)
+    {
+        if (planar)
+        {
+            planarIn.reserve(channels, frames);
+            deinterleaveToFloat(buffer, frames, channels, planarIn);
+            for (int c = 0; c < channels; c++)
+            {
+                planarEngines[c]->putSamples(planarIn.channel(c), frames);
+            }
+            return;
+        }
+        const size_t totalSamples = static_cast<size_t>(frames) * channels;
+        if (floatIn.size() < totalSamples)
+        {
+            floatIn.resize(totalSamples);
+            floatOut.resize(totalSamples);
+        }
+        int16ToFloat(buffer, floatIn.data(), totalSamples);
+        soundTouch->putSamples(floatIn.data(), frames);
+    }
+
+    // Moves the running stream to a new rate and/or latency tier without a
+    // restart. The engines keep their tables; SoundTouch only recomputes the
+    // rate-dependent stretch sizes (the anti-alias filter depends on the
+    // pitch ratio alone)
+    void switchStream(int newRate, LatencyTier newTier)
+    {
+        const double step = static_cast<double>(sampleRate) / newRate;
+        const bool running = bypassState != BypassState::kBypassed;
+        const bool retune = newTier != latencyTier;
+
+        // What the old engines would have played next: their buffered audio,
+        // pushed out by silence
+        const int oldBacklog = running ? backlogFrames() : 0;
+        if (running && streamSwitch)
+        {
+            float* tail = streamSwitch->tail();
+            const int tailFrames = streamSwitch->tailFrames();
+            const size_t tailSamples = static_cast<size_t>(tailFrames) * channels;
+            std::fill(tail, tail + tailSamples, 0.0f);
+            const int got = render(tail, tail, tailFrames);
+            std::fill(tail + static_cast<size_t>(got) * channels, tail + tailSamples, 0.0f);
+        }
+        if (streamSwitch && !streamSwitch->begin(newRate, running))
+        {
+            streamSwitch.reset();  // this and later changes restart the stream
+        }
+        if (newRate != sampleRate)
+        {
+            tuning.setSampleRate(newRate);
+        }
+
+        sampleRate = newRate;
+        latencyTier = newTier;
+        forEachEngine([this, newRate, retune](soundtouch::SoundTouch& st) {
+            st.setSampleRate(newRate);
+            if (retune)
+            {
+                applyLatency(st);
+            }
+            st.clear();
+        });
+        configureBandSplit();
+        configureVoice();
+        streamHash.reset();
+        lastBufferHash = 0;
+        if (!running || !streamSwitch)
+        {
+            return;
+        }
+
+        // Priming output duplicates what was already played. After a rate
+        // switch only as much is dropped as leaves the new engines trailing
+        // the input by the old backlog, so the two outputs line up for the
+        // crossfade. A new tier is there to change that delay: the output
+        // jumps to the new engines' own latency, and the alignment makes the
+        // jump a WSOLA-style splice
+        const int16_t* recent = streamSwitch->recent();
+        const int frames = streamSwitch->recentFrames();
+        if (splitter || voice)
+        {
+            // The nested converter's queue is out of reach; the fade covers
+            // whatever offset remains. The voice engine queues nothing, so
+            // its output already lines up
+            std::vector<int16_t> primed(static_cast<size_t>(frames) * channels);
+            render(recent, primed.data(), frames);
+            return;
+        }
+        queueInput(recent, frames);
+        const int keep = retune ? 0 : static_cast<int>(std::lround(oldBacklog / step)) - latencyFrames();
+        soundtouch::SoundTouch& lead = planar ? *planarEngines[0] : *soundTouch;
+        // Output peek through the pipe interface, as FIFOSamplePipe::moveSamples does
+        const float* queued = static_cast<soundtouch::FIFOSamplePipe&>(lead).ptrBegin();
+        const int queuedFrames = static_cast<int>(lead.numSamples());
+        const int drop = streamSwitch->align(queued, queuedFrames, planar ? 1 : channels,
+                                             queuedFrames - std::max(0, keep));
+        forEachEngine([drop](soundtouch::SoundTouch& st) {
+            st.receiveSamples(static_cast<uint>(drop));
+        });
+    }
+
+    // One buffer through history, engines, handover and hash, for either
+    // entry point; returns the processing time in nanoseconds
+    template <typename T>
+    uint64_t processBuffer(const T* in, T* out, int frames)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+
+        lastFrames = frames;
+        floatStream = std::is_same<T, float>::value;
+        if (streamSwitch)
+        {
+            streamSwitch->remember(in, frames);
+        }
+        int received;
+        if (autoBypass)
+        {
+            tuning.analyze(in, frames, channels);
+            received = processAutoBypass(in, out, frames);
+        }
+        else
+        {
+            received = render(in, out, frames);
+        }
+
+        // Zero-fill remainder if fewer samples returned (startup latency)
+        const size_t numSamples = static_cast<size_t>(frames) * channels;
+        std::fill(out + static_cast<size_t>(received) * channels, out + numSamples, T());
+
+        if (streamSwitch && streamSwitch->fading())
+        {
+            streamSwitch->apply(out, frames);
+        }
+
+        if (deterministic)
+        {
+            const size_t bytes = numSamples * sizeof(T);
+            lastBufferHash = OutputHash::hash(out, bytes);
+            streamHash.update(out, bytes);
+        }
+
+        // Update CPU usage estimation
+        auto t1 = std::chrono::steady_clock::now();
+        auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        auto audioTimeUs = (frames * 1e6) / sampleRate;
+        cpuUsage.store(100.0f * elapsedUs / audioTimeUs, std::memory_order_relaxed);
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+
+    // Scratch is rewritten by every call, so its whole size counts as used
+    template <typename T>
+    static void addScratch(soundtouch::MemoryUsage& usage, const std::vector<T>& v)
+    {
+        usage.allocated += v.capacity() * sizeof(T);
+        usage.used += v.size() * sizeof(T);
+        usage.peakUsed += v.size() * sizeof(T);
+    }
+
+    template <typename T>
+    static void shrinkScratch(std::vector<T>& v, size_t size)
+    {
+        v.resize(std::min(v.size(), size));
+        v.shrink_to_fit();
+    }
+
+    void addMemoryUsage(soundtouch::MemoryUsage& usage) const
+    {
+        const size_t tables = sizeof(*this) + tuning.memoryBytes();
+        usage.allocated += tables;
+        usage.used += tables;
+        usage.peakUsed += tables;
+        soundTouch->addMemoryUsage(usage);
+        for (const auto& st : planarEngines)
+        {
+            st->addMemoryUsage(usage);
+        }
+        if (voice)
+        {
+            voice->addMemoryUsage(usage);
+        }
+        addScratch(usage, floatIn);
+        addScratch(usage, floatOut);
+        addScratch(usage, lowBuffer);
+        addScratch(usage, lowFloat);
+        addScratch(usage, dry);
+        addScratch(usage, dryFloat);
+        const size_t planarBytes = planarIn.capacityBytes() + planarOut.capacityBytes();
+        usage.allocated += planarBytes;
+        usage.used += planarBytes;
+        usage.peakUsed += planarBytes;
+        if (splitter)
+        {
+            splitter->addMemoryUsage(usage);
+            lowBand->pImpl_->addMemoryUsage(usage);
+        }
+        if (streamSwitch)
+        {
+            const size_t bytes = streamSwitch->memoryBytes();
+            usage.allocated += bytes;
+            usage.used += bytes;
+            usage.peakUsed += bytes;
+        }
+        if (shadow)
+        {
+            const size_t runner = shadow->memoryBytes();
+            usage.allocated += runner;
+            usage.used += runner;
+            usage.peakUsed += runner;
+            shadowEngine->converter().pImpl_->addMemoryUsage(usage);
+        }
+    }
+
+    // Scratch the current mode does not touch goes entirely
+    void shrinkToFit()
+    {
+        forEachEngine([](soundtouch::SoundTouch& st) { st.shrinkToFit(); });
+        const size_t samples = static_cast<size_t>(lastFrames) * channels;
+        const bool interleaved = (!planar || voice) && !splitter;
+        shrinkScratch(floatIn, interleaved ? samples : 0);
+        shrinkScratch(floatOut, interleaved ? samples : 0);
+        shrinkScratch(dry, autoBypass && !floatStream ? samples : 0);
+        shrinkScratch(dryFloat, autoBypass && floatStream ? samples : 0);
+        const size_t lowSamples =
+                splitter ? static_cast<size_t>(lastFrames / splitter->factor() + 1) * channels : 0;
+        shrinkScratch(lowBuffer, floatStream ? 0 : lowSamples);
+        shrinkScratch(lowFloat, floatStream ? lowSamples : 0);
+        if (splitter)
+        {
+            splitter->shrinkToFit();
+            lowBand->shrinkToFit();
+        }
+        const bool planarUsed = planar && !splitter;
+        planarIn.shrink(channels, planarUsed ? lastFrames : 0);
+        planarOut.shrink(channels, planarUsed ? lastFrames : 0);
+    }
+
+    // Rebuilds the engines for the current mode; buffered audio is dropped
+    void rebuildEngines()
+    {
+        soundTouch = makeEngine(channels);
+        if (planar)
+        {
+            createPlanarEngines();
+        }
+        else
+        {
+            planarEngines.clear();
+        }
+        configureBandSplit();
+        configureVoice();
+        streamHash.reset();
+        lastBufferHash = 0;
+    }
 };
 
 Audio432HzConverter::Audio432HzConverter(int sampleRate, int channels)
@@ -52,83 +815,238 @@ Audio432HzConverter::~Audio432HzConverter() = default;
 
 int Audio432HzConverter::process(int16_t* buffer, int numSamples)
 {
-    if (!buffer || numSamples <= 0 || !pImpl_)
+    return process(buffer, buffer, numSamples);
+}
+
+int Audio432HzConverter::process(const int16_t* in, int16_t* out, int numSamples)
+{
+    if (!in || !out || numSamples <= 0 || !pImpl_)
     {
         return 0;
     }
 
-    auto t0 = std::chrono::steady_clock::now();
+    // Fade-outs leave the filters' state subnormal; the caller's FP mode
+    // comes back on return
+    DenormalGuard denormals;
 
-    // Resize staging buffers to avoid repeated allocations
-    uint32_t totalSamples = numSamples;
-    if (pImpl_->floatIn.size() < totalSamples)
+    // numSamples counts interleaved samples; the engines work in frames
+    const int frames = numSamples / pImpl_->channels;
+    if (pImpl_->shadow)
     {
-        pImpl_->floatIn.resize(totalSamples);
-        pImpl_->floatOut.resize(totalSamples * 2);  // extra headroom for output
+        pImpl_->shadow->begin(in, frames, PcmFormat::kInt16);  // before an in-place call overwrites it
     }
 
-    // Convert int16 to float
-    for (int i = 0; i < numSamples; i++)
+    const uint64_t elapsedNs = pImpl_->processBuffer(in, out, frames);
+
+    if (pImpl_->shadow)
     {
-        pImpl_->floatIn[i] = buffer[i] / 32768.0f;
+        // The zero-filled start is part of the output the shadow is held to
+        pImpl_->shadow->end(out, frames, elapsedNs);
     }
 
-    // Process through SoundTouch
-    pImpl_->soundTouch.putSamples(pImpl_->floatIn.data(), numSamples / pImpl_->channels);
+    return numSamples;
+}
 
-    // Receive processed samples
-    uint32_t received = pImpl_->soundTouch.receiveSamples(
-            pImpl_->floatOut.data(),
-            std::min((uint32_t)pImpl_->floatOut.size(), (uint32_t)(numSamples * 2)));
+int Audio432HzConverter::process(const float* in, float* out, int frames)
+{
+    if (!in || !out || frames <= 0 || !pImpl_)
+    {
+        return 0;
+    }
+
+    DenormalGuard denormals;
+    pImpl_->processBuffer(in, out, frames);
+    return frames;
+}
 
-    // Convert back to int16, handle silence for startup latency
-    uint32_t outputSamples = std::min(received, (uint32_t)numSamples);
-    for (uint32_t i = 0; i < outputSamples; i++)
+void Audio432HzConverter::setSampleRate(int sampleRate)
+{
+    if (!pImpl_)
+    {
+        return;
+    }
+    if (pImpl_->shadow)
+    {
+        pImpl_->shadow->drain();
+        pImpl_->shadowEngine->setSampleRate(sampleRate);
+        pImpl_->shadow->restart(sampleRate, pImpl_->channels);
+    }
+    if (sampleRate != pImpl_->sampleRate)
     {
-        float sample = pImpl_->floatOut[i] * 32767.0f;
-        sample = std::max(-32768.0f, std::min(32767.0f, sample));
-        buffer[i] = (int16_t)sample;
+        pImpl_->switchStream(sampleRate, pImpl_->latencyTier);
+        return;
     }
 
-    // Zero-fill remainder if fewer samples returned (startup latency)
-    for (uint32_t i = outputSamples; i < numSamples; i++)
+    // Same rate: restart the stream
+    pImpl_->clearEngines();
+    pImpl_->tuning.setSampleRate(sampleRate);
+    pImpl_->configureBandSplit();
+    pImpl_->configureVoice();
+    if (pImpl_->streamSwitch)
+    {
+        pImpl_->streamSwitch->cancel();
+    }
+    pImpl_->streamHash.reset();
+    pImpl_->lastBufferHash = 0;
+}
+
+void Audio432HzConverter::setPitchShiftSemitones(float semitones)
+{
+    if (pImpl_)
     {
-        buffer[i] = 0;
+        pImpl_->pitchSemitones = semitones;
+        pImpl_->forEachEngine([semitones](soundtouch::SoundTouch& st) {
+            st.setPitchSemiTones(semitones);
+        });
+        if (pImpl_->voice)
+        {
+            pImpl_->voice->setPitchSemitones(semitones);
+        }
+        if (pImpl_->lowBand)
+        {
+            pImpl_->lowBand->setPitchShiftSemitones(semitones);
+        }
     }
+}
 
-    // Update CPU usage estimation
-    auto t1 = std::chrono::steady_clock::now();
-    auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
-    auto audioTimeUs = (numSamples * 1e6) / pImpl_->sampleRate;
-    pImpl_->cpuUsage.store(100.0f * elapsedUs / audioTimeUs, std::memory_order_relaxed);
+void Audio432HzConverter::setPlanarProcessing(bool enabled)
+{
+    if (!pImpl_ || pImpl_->planar == enabled)
+    {
+        return;
+    }
 
-    return numSamples;
+    // Switching engines restarts the stream; the old engine's tail is dropped
+    pImpl_->planar = enabled;
+    pImpl_->rebuildEngines();
 }
 
-void Audio432HzConverter::setSampleRate(int sampleRate)
+bool Audio432HzConverter::isPlanarProcessing() const
 {
-    if (pImpl_)
+    return pImpl_ && pImpl_->planar;
+}
+
+void Audio432HzConverter::setBandSplit(bool enabled)
+{
+    if (!pImpl_ || pImpl_->bandSplit == enabled)
     {
-        pImpl_->sampleRate = sampleRate;
-        pImpl_->soundTouch.setSampleRate(sampleRate);
-        pImpl_->soundTouch.clear();
+        return;
     }
+    pImpl_->bandSplit = enabled;
+    pImpl_->configureBandSplit();
+    pImpl_->configureVoice();
 }
 
-void Audio432HzConverter::setPitchShiftSemitones(float semitones)
+bool Audio432HzConverter::isBandSplit() const
+{
+    return pImpl_ && pImpl_->bandSplit;
+}
+
+bool Audio432HzConverter::isBandSplitActive() const
+{
+    return pImpl_ && pImpl_->splitter;
+}
+
+void Audio432HzConverter::setInterpolator(Interpolator interpolator)
+{
+    if (!pImpl_ || pImpl_->interpolator == interpolator)
+    {
+        return;
+    }
+    pImpl_->interpolator = interpolator;
+    pImpl_->rebuildEngines();
+}
+
+Interpolator Audio432HzConverter::getInterpolator() const
+{
+    return pImpl_ ? pImpl_->interpolator : Interpolator::kCubic;
+}
+
+void Audio432HzConverter::setProcessingProfile(ProcessingProfile profile)
+{
+    if (!pImpl_ || pImpl_->profile == profile)
+    {
+        return;
+    }
+    pImpl_->profile = profile;
+    pImpl_->rebuildEngines();
+}
+
+void Audio432HzConverter::setOutputLatency(float sinkLatencyMs, float budgetMs)
 {
     if (pImpl_)
     {
-        pImpl_->soundTouch.setPitchSemiTones(semitones);
+        pImpl_->setLatencyTier(budgetMs > 0.0f ? chooseLatencyTier(sinkLatencyMs, budgetMs)
+                                               : LatencyTier::kBalanced);
+    }
+}
+
+LatencyTier Audio432HzConverter::getLatencyTier() const
+{
+    return pImpl_ ? pImpl_->latencyTier : LatencyTier::kBalanced;
+}
+
+ProcessingProfile Audio432HzConverter::getProcessingProfile() const
+{
+    return pImpl_ ? pImpl_->profile : ProcessingProfile::kMusic;
+}
+
+void Audio432HzConverter::setDeterministic(bool enabled)
+{
+    if (!pImpl_ || pImpl_->deterministic == enabled)
+    {
+        return;
     }
+    pImpl_->deterministic = enabled;
+    pImpl_->rebuildEngines();
+}
+
+bool Audio432HzConverter::isDeterministic() const
+{
+    return pImpl_ && pImpl_->deterministic;
+}
+
+uint64_t Audio432HzConverter::getLastBufferHash() const
+{
+    return pImpl_ ? pImpl_->lastBufferHash : 0;
+}
+
+uint64_t Audio432HzConverter::getStreamHash() const
+{
+    return (pImpl_ && pImpl_->deterministic) ? pImpl_->streamHash.digest() : 0;
+}
+
+void Audio432HzConverter::setAutoBypass(bool enabled)
+{
+    if (!pImpl_ || pImpl_->autoBypass == enabled)
+    {
+        return;
+    }
+    pImpl_->autoBypass = enabled;
+    pImpl_->tuning.reset();
+    // The engines were cleared on entering bypass; processing restarts from silence
+    pImpl_->bypassState = Impl::BypassState::kActive;
+}
+
+bool Audio432HzConverter::isAutoBypass() const
+{
+    return pImpl_ && pImpl_->autoBypass;
+}
+
+bool Audio432HzConverter::isBypassed() const
+{
+    return pImpl_ && pImpl_->autoBypass && pImpl_->bypassState == Impl::BypassState::kBypassed;
+}
+
+float Audio432HzConverter::getEstimatedReferenceHz() const
+{
+    return (pImpl_ && pImpl_->autoBypass) ? pImpl_->tuning.referenceHz() : 0.0f;
 }
 
 float Audio432HzConverter::getLatencyMs() const
 {
     if (!pImpl_) return 0.0f;
-    // Latency = (sequenceMs/2 + seekwindowMs + overlapMs) * sample rate independent estimate
-    // Approximate: 40ms/2 + 15ms + 8ms ≈ 35ms + network buffering
-    return 35.0f;
+    return 1000.0f * pImpl_->latencyFrames() / pImpl_->sampleRate;
 }
 
 float Audio432HzConverter::getCpuUsagePercent() const
@@ -137,5 +1055,70 @@ float Audio432HzConverter::getCpuUsagePercent() const
     return pImpl_->cpuUsage.load(std::memory_order_relaxed);
 }
 
+MemoryUsage Audio432HzConverter::getMemoryUsage() const
+{
+    MemoryUsage result = {};
+    if (!pImpl_) return result;
+
+    soundtouch::MemoryUsage usage = {};
+    pImpl_->addMemoryUsage(usage);
+    result.allocatedBytes = sizeof(*this) + usage.allocated;
+    result.usedBytes = sizeof(*this) + usage.used;
+    result.peakUsedBytes = sizeof(*this) + usage.peakUsed;
+    return result;
+}
+
+void Audio432HzConverter::shrinkToFit()
+{
+    if (pImpl_)
+    {
+        pImpl_->shrinkToFit();
+    }
+}
+
+bool Audio432HzConverter::setShadow(std::unique_ptr<Audio432HzConverter> shadow, ShadowMode mode)
+{
+    if (!pImpl_)
+    {
+        return false;
+    }
+    pImpl_->shadow.reset();
+    pImpl_->shadowEngine = nullptr;
+    if (!shadow)
+    {
+        return true;
+    }
+    if (!shadow->pImpl_ || shadow->pImpl_->channels != pImpl_->channels)
+    {
+        return false;
+    }
+
+    shadow->setSampleRate(pImpl_->sampleRate);
+    std::unique_ptr<ConverterShadow> engine(
+        new (std::nothrow) ConverterShadow(std::move(shadow), pImpl_->sampleRate, pImpl_->channels));
+    if (!engine)
+    {
+        return false;
+    }
+    ConverterShadow* raw = engine.get();
+    pImpl_->shadow.reset(ShadowRunner::create(std::move(engine), pImpl_->sampleRate, pImpl_->channels, mode));
+    if (!pImpl_->shadow)
+    {
+        return false;
+    }
+    pImpl_->shadowEngine = raw;
+    return true;
+}
+
+bool Audio432HzConverter::hasShadow() const
+{
+    return pImpl_ && pImpl_->shadow;
+}
+
+ShadowMetrics Audio432HzConverter::getShadowMetrics() const
+{
+    return pImpl_ && pImpl_->shadow ? pImpl_->shadow->metrics() : ShadowMetrics();
+}
+
 }  // namespace dsp
 }  // namespace audioshift
@@ -0,0 +1,308 @@
+#include "band_split.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+constexpr double PASS_BAND_HZ = 20000.0;
+constexpr double STOP_BAND_DB = 70.0;
+constexpr double PI = 3.14159265358979323846;
+
+// Zeroth-order modified Bessel function of the first kind (Kaiser window)
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Eight independent partial sums: vectorises without reassociating the
+// floating-point additions, so the result is the same at any SIMD width
+inline float dot(const float* a, const float* b, int n)
+{
+    float acc[8] = {};
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            acc[j] += a[i + j] * b[i + j];
+        }
+    }
+    float sum = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+    for (; i < n; i++)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+inline int16_t toInt16(float v)
+{
+    return static_cast<int16_t>(std::lround(std::max(-32768.0f, std::min(32767.0f, v))));
+}
+
+// Samples are kept in int16 units; float input and output is in [-1, 1)
+inline float toUnits(int16_t v)
+{
+    return v;
+}
+
+inline float toUnits(float v)
+{
+    return v * 32768.0f;
+}
+
+inline void fromUnits(float v, int16_t& out)
+{
+    out = toInt16(v);
+}
+
+inline void fromUnits(float v, float& out)
+{
+    out = v * (1.0f / 32768.0f);
+}
+
+}  // namespace
+
+int BandSplitter::baseRateFor(int sampleRate)
+{
+    for (int base : {48000, 44100})
+    {
+        if (sampleRate >= 2 * base && sampleRate % base == 0)
+        {
+            return base;
+        }
+    }
+    return 0;
+}
+
+BandSplitter::BandSplitter(int sampleRate, int channels)
+    : sampleRate_(sampleRate),
+      channels_(channels),
+      factor_(1),
+      lowBandLatency_(0),
+      delayedInput_(channels),
+      lowDelayed_(channels),
+      upsampled_(channels)
+{
+    const int base = baseRateFor(sampleRate);
+    factor_ = base > 0 ? sampleRate / base : 1;
+
+    // Kaiser design: pass band to 20 kHz. Content between the base Nyquist and
+    // base - 20 kHz only aliases into the inaudible 20 kHz..Nyquist range, so
+    // the stop band can start there; that halves the filter length
+    const double stopHz = (base > 0 ? base : sampleRate) - PASS_BAND_HZ;
+    const double transition = (stopHz - PASS_BAND_HZ) / sampleRate;
+    const double cutoff = 0.5 * (PASS_BAND_HZ + stopHz) / sampleRate;
+    const double beta = 0.1102 * (STOP_BAND_DB - 8.7);
+    int numTaps = static_cast<int>(std::ceil((STOP_BAND_DB - 8.0) / (2.285 * 2.0 * PI * transition))) + 1;
+    numTaps |= 1;
+    groupDelay_ = (numTaps - 1) / 2;
+
+    taps_.resize(numTaps);
+    double sum = 0.0;
+    for (int n = 0; n < numTaps; n++)
+    {
+        const double t = n - groupDelay_;
+        const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * PI * cutoff * t) / (PI * t);
+        const double r = t / groupDelay_;
+        const double w = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+        taps_[n] = static_cast<float>(sinc * w);
+        sum += sinc * w;
+    }
+    for (float& t : taps_)
+    {
+        t = static_cast<float>(t / sum);
+    }
+
+    // Polyphase interpolator: phase r uses taps r, r + M, r + 2M, ... scaled by M
+    phaseLength_ = (numTaps + factor_ - 1) / factor_;
+    polyphase_.assign(static_cast<size_t>(factor_) * phaseLength_, 0.0f);
+    for (int r = 0; r < factor_; r++)
+    {
+        for (int k = 0; k < phaseLength_; k++)
+        {
+            const int n = r + k * factor_;
+            if (n < numTaps)
+            {
+                polyphase_[r * phaseLength_ + k] = taps_[n] * factor_;
+            }
+        }
+    }
+
+    history_.resize(static_cast<size_t>(channels_) * 2 * numTaps);
+    lowHistory_.resize(static_cast<size_t>(channels_) * 2 * phaseLength_);
+    clear();
+}
+
+void BandSplitter::setLowBandLatency(int baseFrames)
+{
+    lowBandLatency_ = std::max(0, baseFrames);
+    clear();
+}
+
+int BandSplitter::latencyFrames() const
+{
+    return 2 * groupDelay_ + factor_ * lowBandLatency_;
+}
+
+void BandSplitter::addMemoryUsage(soundtouch::MemoryUsage& usage) const
+{
+    // The tables and histories are sized once and in use in full
+    const size_t fixed = sizeof(*this) + (taps_.capacity() + polyphase_.capacity() +
+                                          history_.capacity() + lowHistory_.capacity()) *
+                                                 sizeof(float);
+    usage.allocated += fixed;
+    usage.used += fixed;
+    usage.peakUsed += fixed;
+    delayedInput_.addMemoryUsage(usage);
+    lowDelayed_.addMemoryUsage(usage);
+    upsampled_.addMemoryUsage(usage);
+}
+
+void BandSplitter::shrinkToFit()
+{
+    delayedInput_.shrinkToFit();
+    lowDelayed_.shrinkToFit();
+    upsampled_.shrinkToFit();
+}
+
+void BandSplitter::clear()
+{
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    std::fill(lowHistory_.begin(), lowHistory_.end(), 0.0f);
+    historyPos_ = 0;
+    lowPos_ = 0;
+    decimPhase_ = 0;
+
+    // Priming: the interpolator delivers in blocks of factor_ frames, the input
+    // waits for both filter delays plus the low-band processing, and the
+    // unprocessed low band for the low-band processing
+    upsampled_.clear();
+    upsampled_.addSilent(factor_ - 1);
+    delayedInput_.clear();
+    delayedInput_.addSilent(latencyFrames());
+    lowDelayed_.clear();
+    lowDelayed_.addSilent(lowBandLatency_);
+}
+
+int BandSplitter::split(const int16_t* in, int frames, int16_t* low)
+{
+    return splitSamples(in, frames, low);
+}
+
+int BandSplitter::split(const float* in, int frames, float* low)
+{
+    return splitSamples(in, frames, low);
+}
+
+void BandSplitter::merge(const int16_t* low, int lowFrames, int16_t* out, int frames)
+{
+    mergeSamples(low, lowFrames, out, frames);
+}
+
+void BandSplitter::merge(const float* low, int lowFrames, float* out, int frames)
+{
+    mergeSamples(low, lowFrames, out, frames);
+}
+
+template <typename T>
+int BandSplitter::splitSamples(const T* in, int frames, T* low)
+{
+    const int numTaps = static_cast<int>(taps_.size());
+    float* delayed = delayedInput_.ptrEnd(frames);
+    float* lowCopy = lowDelayed_.ptrEnd(frames / factor_ + 1);
+    int lowFrames = 0;
+
+    for (int i = 0; i < frames; i++)
+    {
+        // The low-pass only runs at the decimated instants
+        const bool emit = (decimPhase_ == factor_ - 1);
+        for (int c = 0; c < channels_; c++)
+        {
+            // Newest sample first: window[k] is x[n - k]
+            float* window = history_.data() + static_cast<size_t>(c) * 2 * numTaps + historyPos_;
+            const float x = toUnits(in[i * channels_ + c]);
+            window[0] = x;
+            window[numTaps] = x;
+            delayed[i * channels_ + c] = x;
+
+            if (emit)
+            {
+                // The copy holds what merge() will read back, rounding included
+                T& y = low[lowFrames * channels_ + c];
+                fromUnits(dot(taps_.data(), window, numTaps), y);
+                lowCopy[lowFrames * channels_ + c] = toUnits(y);
+            }
+        }
+        historyPos_ = (historyPos_ == 0 ? numTaps : historyPos_) - 1;
+        if (emit)
+        {
+            lowFrames++;
+        }
+        decimPhase_ = (decimPhase_ + 1) % factor_;
+    }
+
+    delayedInput_.putSamples(frames);
+    lowDelayed_.putSamples(lowFrames);
+    return lowFrames;
+}
+
+template <typename T>
+void BandSplitter::mergeSamples(const T* low, int lowFrames, T* out, int frames)
+{
+    // Only the change the processing made to the low band is interpolated:
+    // out = x + interp(processed - unprocessed), both delayed to line up.
+    // With identity processing the correction is zero and out is exactly x.
+    const float* unprocessed = lowDelayed_.ptrBegin();
+    for (int j = 0; j < lowFrames; j++)
+    {
+        float* block = upsampled_.ptrEnd(factor_);
+        for (int c = 0; c < channels_; c++)
+        {
+            float* window = lowHistory_.data() + static_cast<size_t>(c) * 2 * phaseLength_ + lowPos_;
+            const float v = toUnits(low[j * channels_ + c]) - unprocessed[j * channels_ + c];
+            window[0] = v;
+            window[phaseLength_] = v;
+
+            for (int r = 0; r < factor_; r++)
+            {
+                block[r * channels_ + c] = dot(polyphase_.data() + r * phaseLength_, window, phaseLength_);
+            }
+        }
+        lowPos_ = (lowPos_ == 0 ? phaseLength_ : lowPos_) - 1;
+        upsampled_.putSamples(factor_);
+    }
+    lowDelayed_.receiveSamples(lowFrames);
+
+    // The priming guarantees both streams hold at least 'frames' frames here
+    const float* correction = upsampled_.ptrBegin();
+    const float* input = delayedInput_.ptrBegin();
+    const size_t count = static_cast<size_t>(frames) * channels_;
+    for (size_t k = 0; k < count; k++)
+    {
+        fromUnits(input[k] + correction[k], out[k]);
+    }
+    upsampled_.receiveSamples(frames);
+    delayedInput_.receiveSamples(frames);
+}
+
+}  // namespace dsp
+}  // namespace audioshift
@@ -0,0 +1,120 @@
+#ifndef AUDIOSHIFT_BAND_SPLIT_H
+#define AUDIOSHIFT_BAND_SPLIT_H
+
+#include <FIFOSampleBuffer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Two-band split/merge for hi-res sample rates
+ *
+ * A linear-phase Kaiser low-pass (pass band to 20 kHz) feeds a polyphase
+ * decimator down to the base rate (48 kHz, or 44.1 kHz for the 88.2/176.4
+ * kHz family), so the low band can be pitch-shifted at base-rate cost. The
+ * filter only runs at the decimated instants.
+ *
+ * The ultrasonic band is the exact complement of the low band and never
+ * gets filtered on its own: merge() interpolates only the difference the
+ * processing made to the low band (processed minus unprocessed, N/M taps
+ * per output) and adds it to the delayed full-rate input. The delays
+ * include the latency of whatever ran on the low band in between. With
+ * nothing in between, merge(split(x)) is exactly x delayed by
+ * latencyFrames().
+ *
+ * Samples stay in int16 units internally, so the low band can be handed
+ * to the int16 converter without rescaling. The float overloads take and
+ * return [-1, 1) and leave the low band unrounded.
+ */
+class BandSplitter
+{
+public:
+    /**
+     * @brief Base rate a hi-res rate splits down to
+     * @return 48000 or 44100 for integer multiples (×2 and up), 0 otherwise
+     */
+    static int baseRateFor(int sampleRate);
+
+    BandSplitter(int sampleRate, int channels);
+
+    int factor() const { return factor_; }
+    int baseRate() const { return sampleRate_ / factor_; }
+
+    /**
+     * @brief Delay of the low-band processing, in base-rate frames
+     *
+     * The ultrasonic band is delayed by the same amount. Clears the
+     * buffered state.
+     */
+    void setLowBandLatency(int baseFrames);
+
+    /** @brief End-to-end delay at the full rate, in frames */
+    int latencyFrames() const;
+
+    /** @brief Drop all buffered audio */
+    void clear();
+
+    /**
+     * @brief Split @p frames of interleaved input
+     * @param low  Receives the decimated low band; room for frames / factor() + 1 frames
+     * @return     Number of low-band frames written
+     */
+    int split(const int16_t* in, int frames, int16_t* low);
+    int split(const float* in, int frames, float* low);
+
+    /**
+     * @brief Interpolate @p lowFrames processed low-band frames and recombine
+     *
+     * Always writes exactly @p frames frames to @p out, which may alias
+     * the buffer split() read from.
+     */
+    void merge(const int16_t* low, int lowFrames, int16_t* out, int frames);
+    void merge(const float* low, int lowFrames, float* out, int frames);
+
+    /** @brief Add the filter tables, histories and delay lines to @p usage */
+    void addMemoryUsage(soundtouch::MemoryUsage& usage) const;
+
+    /** @brief Release delay-line capacity beyond the peak since the last call */
+    void shrinkToFit();
+
+private:
+    template <typename T>
+    int splitSamples(const T* in, int frames, T* low);
+
+    template <typename T>
+    void mergeSamples(const T* low, int lowFrames, T* out, int frames);
+
+    int sampleRate_;
+    int channels_;
+    int factor_;
+    int groupDelay_;         ///< (taps - 1) / 2 at the full rate
+    int lowBandLatency_;     ///< base-rate frames
+
+    std::vector<float> taps_;        ///< low-pass, full rate
+    std::vector<float> polyphase_;   ///< interpolation sub-filters, factor_ × phaseLength_
+    int phaseLength_;
+
+    // Per-channel input history, duplicated so the window is always contiguous
+    std::vector<float> history_;
+    int historyPos_;
+    int decimPhase_;
+
+    // Per-channel low-band history for interpolation (also duplicated)
+    std::vector<float> lowHistory_;
+    int lowPos_;
+
+    soundtouch::FIFOSampleBuffer delayedInput_;   ///< full rate, for the ultrasonic band
+    soundtouch::FIFOSampleBuffer lowDelayed_;     ///< unprocessed low band, base rate
+    soundtouch::FIFOSampleBuffer upsampled_;      ///< interpolated low-band correction
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_BAND_SPLIT_H
@@ -0,0 +1,641 @@
+#include "batch_convert.h"
+
+#include "output_hash.h"
+#include "soundtouch_backend.h"
+#include "stream_convert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+// Bump when a change alters the output, so old cache entries stop matching
+constexpr uint32_t CACHE_FORMAT_VERSION = 1;
+// Input converted before a chunk starts, so the engine has settled
+constexpr int WARMUP_MS = 1000;
+// Crossfade between neighbouring chunks
+constexpr int SEAM_MS = 10;
+// Farthest two chunks' timelines are searched apart (WSOLA keeps each
+// within about one seek window of the input)
+constexpr int MAX_LAG_MS = 30;
+constexpr size_t FEED_FRAMES = 8192;
+constexpr size_t IO_BYTES = 1 << 20;
+
+using Clock = std::chrono::steady_clock;
+
+/** Raw engine output of one chunk: frame i holds input frame 'start' + i */
+struct ChunkOutput
+{
+    int64_t start = 0;
+    int lag = 0;  // frames this chunk's timeline is shifted to meet the previous one
+    std::vector<int16_t> pcm;
+    bool done = false;
+};
+
+struct FileState
+{
+    BatchJob* job = nullptr;
+    int inFd = -1;
+    int outFd = -1;
+    PcmInput format;
+    off_t inData = 0;   // offset of the first input sample
+    off_t outData = 0;  // offset of the first output sample
+    int64_t frames = 0;
+    int chunks = 0;
+    int64_t chunkFrames = 0;
+    std::string tempPath;
+    std::string finalPath;  // cache entry, or the output without a cache
+
+    std::mutex lock;  // guards everything below
+    std::vector<ChunkOutput> outputs;
+    int nextToWrite = 0;
+    int remaining = 0;
+    int error = 0;
+
+    ~FileState()
+    {
+        if (inFd >= 0) close(inFd);
+        if (outFd >= 0) close(outFd);
+    }
+
+    int64_t chunkStart(int k) const { return k * chunkFrames; }
+    int64_t chunkEnd(int k) const { return k + 1 == chunks ? frames : (k + 1) * chunkFrames; }
+};
+
+struct Task
+{
+    int file;
+    int chunk;  // -1: open, hash, look up the cache and plan the chunks
+};
+
+/** A worker's own tasks: it takes from the back, thieves from the front */
+struct TaskQueue
+{
+    std::mutex lock;
+    std::deque<Task> tasks;
+};
+
+std::string hex(uint64_t value)
+{
+    char text[17];
+    snprintf(text, sizeof(text), "%016" PRIx64, value);
+    return text;
+}
+
+bool sameFile(const std::string& a, const std::string& b)
+{
+    struct stat sa, sb;
+    return stat(a.c_str(), &sa) == 0 && stat(b.c_str(), &sb) == 0 && sa.st_dev == sb.st_dev &&
+           sa.st_ino == sb.st_ino;
+}
+
+int copyFile(const std::string& from, const std::string& to)
+{
+    const int in = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return -errno;
+    const int out = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0)
+    {
+        const int err = -errno;
+        close(in);
+        return err;
+    }
+    std::vector<uint8_t> buffer(IO_BYTES);
+    int err = 0;
+    for (;;)
+    {
+        const ssize_t got = readFull(in, buffer.data(), buffer.size());
+        if (got <= 0)
+        {
+            err = static_cast<int>(got);
+            break;
+        }
+        err = writeFull(out, buffer.data(), static_cast<size_t>(got));
+        if (err) break;
+    }
+    close(in);
+    if (close(out) && !err) err = -errno;
+    return err;
+}
+
+/** Make @p output the cache entry: a hard link, or a copy across file systems */
+int publish(const std::string& entry, const std::string& output)
+{
+    if (sameFile(entry, output)) return 0;
+    const std::string temp = output + ".tmp" + std::to_string(getpid());
+    unlink(temp.c_str());
+    int err = link(entry.c_str(), temp.c_str()) == 0 ? 0 : copyFile(entry, temp);
+    if (!err && rename(temp.c_str(), output.c_str())) err = -errno;
+    if (err) unlink(temp.c_str());
+    return err;
+}
+
+ssize_t preadFull(int fd, void* buffer, size_t bytes, off_t offset)
+{
+    size_t done = 0;
+    while (done < bytes)
+    {
+        const ssize_t n = pread(fd, static_cast<uint8_t*>(buffer) + done, bytes - done,
+                                offset + static_cast<off_t>(done));
+        if (n == 0) break;
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(done);
+}
+
+class Scheduler
+{
+public:
+    Scheduler(std::vector<BatchJob>& jobs, const BatchOptions& options, BatchStats& stats)
+        : jobs_(jobs), options_(options), stats_(stats)
+    {
+    }
+
+    void run()
+    {
+        int threads = options_.threads > 0 ? options_.threads
+                                           : static_cast<int>(std::thread::hardware_concurrency());
+        threads = std::max(1, threads);
+        queues_ = std::vector<TaskQueue>(static_cast<size_t>(threads));
+        files_.resize(jobs_.size());
+        settingsHash_ = hashSettings();
+
+        // Longest first, dealt round-robin: every worker starts on a long
+        // file, which it splits, while the short ones wait at the fronts of
+        // the queues for whoever runs dry
+        std::vector<std::pair<off_t, int>> order;
+        for (size_t i = 0; i < jobs_.size(); i++)
+        {
+            struct stat st;
+            order.emplace_back(stat(jobs_[i].input.c_str(), &st) == 0 ? st.st_size : 0,
+                               static_cast<int>(i));
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        pending_ = static_cast<int>(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            queues_[i % queues_.size()].tasks.push_front(Task{order[i].second, -1});
+        }
+
+        std::vector<std::thread> workers;
+        for (int w = 1; w < threads; w++)
+        {
+            workers.emplace_back([this, w] { work(w); });
+        }
+        work(0);
+        for (std::thread& t : workers)
+        {
+            t.join();
+        }
+    }
+
+private:
+    void work(int self)
+    {
+        int idle = 0;
+        for (;;)
+        {
+            Task task;
+            if (takeOwn(self, task) || steal(self, task))
+            {
+                idle = 0;
+                task.chunk < 0 ? runFile(self, task.file) : runChunk(task.file, task.chunk);
+                pending_.fetch_sub(1);
+                continue;
+            }
+            if (pending_.load() == 0) return;
+            // Only in-flight tasks remain, and they may still split
+            if (++idle < 16)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                const timespec ts = {0, 200000};
+                nanosleep(&ts, nullptr);
+            }
+        }
+    }
+
+    bool takeOwn(int self, Task& task)
+    {
+        TaskQueue& q = queues_[self];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty()) return false;
+        task = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int self, Task& task)
+    {
+        const size_t n = queues_.size();
+        for (size_t i = 1; i < n; i++)
+        {
+            TaskQueue& q = queues_[(self + i) % n];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty()) continue;
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            stats_.steals++;
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t hashSettings() const
+    {
+        OutputHash h;
+        const EffectSettings settings = offlineSettings(options_.pitchSemitones);
+        const int values[] = {static_cast<int>(CACHE_FORMAT_VERSION), static_cast<int>(options_.inputFormat),
+                              options_.sampleRate, options_.channels, WARMUP_MS, SEAM_MS, MAX_LAG_MS};
+        h.update(values, sizeof(values));
+        h.update(&settings.pitchSemitones, sizeof(settings.pitchSemitones));
+        h.update(&settings.latencyBudgetMs, sizeof(settings.latencyBudgetMs));
+        h.update(&options_.chunkSeconds, sizeof(options_.chunkSeconds));
+        return h.digest();
+    }
+
+    int hashInput(int fd, uint64_t& key) const
+    {
+        OutputHash h(settingsHash_);
+        std::vector<uint8_t> buffer(IO_BYTES);
+        for (off_t offset = 0;;)
+        {
+            const ssize_t got = preadFull(fd, buffer.data(), buffer.size(), offset);
+            if (got < 0) return static_cast<int>(got);
+            if (got == 0) break;
+            h.update(buffer.data(), static_cast<size_t>(got));
+            offset += got;
+        }
+        key = h.digest();
+        return 0;
+    }
+
+    void finishJob(FileState& f, int status, bool cached)
+    {
+        f.job->status = status;
+        f.job->cached = cached && status == 0;
+        std::lock_guard<std::mutex> guard(statsLock_);
+        if (status) stats_.failed++;
+        else if (cached) stats_.cached++;
+        else
+        {
+            stats_.converted++;
+            stats_.audioSeconds += static_cast<double>(f.frames) / f.format.sampleRate;
+        }
+    }
+
+    void runFile(int self, int index)
+    {
+        files_[index].reset(new FileState());
+        FileState& f = *files_[index];
+        f.job = &jobs_[index];
+        const int err = openFile(f);
+        if (err || f.chunks == 0)
+        {
+            release(f);
+            finishJob(f, err, f.chunks == 0 && f.finalPath.empty());
+            return;
+        }
+        // Chunk 0 at the back, where this worker takes next: chunks then
+        // finish roughly in order and little output waits in memory
+        std::lock_guard<std::mutex> guard(queues_[self].lock);
+        pending_.fetch_add(f.chunks);
+        for (int k = f.chunks - 1; k >= 0; k--)
+        {
+            queues_[self].tasks.push_back(Task{index, k});
+        }
+    }
+
+    /** Opens, hashes and plans; chunks == 0 on return means nothing to convert */
+    int openFile(FileState& f)
+    {
+        f.inFd = open(f.job->input.c_str(), O_RDONLY | O_CLOEXEC);
+        if (f.inFd < 0) return -errno;
+        int err = readPcmHeader(f.inFd, options_.inputFormat, options_.sampleRate,
+                                options_.channels, f.format);
+        if (err) return err;
+        f.inData = f.format.wav ? lseek(f.inFd, 0, SEEK_CUR) : 0;
+        struct stat st;
+        if (f.inData < 0 || fstat(f.inFd, &st)) return -errno;
+        const int64_t frameBytes = f.format.channels * static_cast<int64_t>(sizeof(int16_t));
+        int64_t bytes = st.st_size - f.inData;
+        if (f.format.dataBytes) bytes = std::min<int64_t>(bytes, f.format.dataBytes);
+        f.frames = std::max<int64_t>(0, bytes) / frameBytes;
+
+        const std::string ext = f.format.wav ? ".wav" : ".raw";
+        if (!options_.cacheDir.empty())
+        {
+            uint64_t key = 0;
+            err = hashInput(f.inFd, key);
+            if (err) return err;
+            const std::string entry = options_.cacheDir + "/" + hex(key) + ext;
+            if (access(entry.c_str(), F_OK) == 0)
+            {
+                return publish(entry, f.job->output);
+            }
+            f.finalPath = entry;
+        }
+        else
+        {
+            f.finalPath = f.job->output;
+        }
+
+        f.tempPath = f.finalPath + ".tmp" + std::to_string(getpid()) + "." +
+                     std::to_string(f.job - jobs_.data());
+        f.outFd = open(f.tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (f.outFd < 0) return -errno;
+        if (f.format.wav)
+        {
+            uint8_t header[WAV_HEADER_BYTES];
+            makeWavHeader(header, f.format.sampleRate, f.format.channels, static_cast<uint64_t>(f.frames));
+            err = writeFull(f.outFd, header, sizeof(header));
+            f.outData = WAV_HEADER_BYTES;
+        }
+        if (!err && ftruncate(f.outFd, f.outData + f.frames * frameBytes)) err = -errno;
+        if (err || f.frames == 0)
+        {
+            return err ? (unlink(f.tempPath.c_str()), err) : complete(f);
+        }
+
+        f.chunkFrames = std::max<int64_t>(1, std::llround(options_.chunkSeconds * f.format.sampleRate));
+        f.chunks = f.frames < f.chunkFrames * 3 / 2
+                       ? 1
+                       : static_cast<int>((f.frames + f.chunkFrames / 2) / f.chunkFrames);
+        f.remaining = f.chunks;
+        f.outputs.resize(static_cast<size_t>(f.chunks));
+        {
+            std::lock_guard<std::mutex> guard(statsLock_);
+            stats_.chunks += static_cast<uint64_t>(f.chunks);
+        }
+        return 0;
+    }
+
+    /** Renames the finished output into place and publishes it */
+    int complete(FileState& f)
+    {
+        close(f.outFd);
+        f.outFd = -1;
+        int err = rename(f.tempPath.c_str(), f.finalPath.c_str()) ? -errno : 0;
+        if (err)
+        {
+            unlink(f.tempPath.c_str());
+        }
+        else if (f.finalPath != f.job->output)
+        {
+            err = publish(f.finalPath, f.job->output);
+        }
+        return err;
+    }
+
+    void runChunk(int index, int k)
+    {
+        FileState& f = *files_[index];
+        ChunkOutput out;
+        int err;
+        {
+            std::lock_guard<std::mutex> guard(f.lock);
+            err = f.error;
+        }
+        if (!err)
+        {
+            err = convertChunk(f, k, out);
+        }
+
+        std::lock_guard<std::mutex> guard(f.lock);
+        if (err && !f.error) f.error = err;
+        out.done = true;
+        f.outputs[k] = std::move(out);
+        // Whoever completes the next chunk in line writes out every chunk
+        // that is ready
+        while (!f.error && f.nextToWrite < f.chunks && f.outputs[f.nextToWrite].done)
+        {
+            f.error = writeChunk(f, f.nextToWrite);
+            if (f.nextToWrite > 0) f.outputs[f.nextToWrite - 1] = ChunkOutput();
+            f.nextToWrite++;
+        }
+        if (--f.remaining > 0) return;
+
+        f.outputs.clear();
+        if (f.error)
+        {
+            err = f.error;
+            unlink(f.tempPath.c_str());
+        }
+        else
+        {
+            err = complete(f);
+        }
+        release(f);
+        finishJob(f, err, false);
+    }
+
+    /** Closes a finished file's descriptors: a library can outnumber the fd limit */
+    static void release(FileState& f)
+    {
+        if (f.inFd >= 0) close(f.inFd);
+        if (f.outFd >= 0) close(f.outFd);
+        f.inFd = f.outFd = -1;
+    }
+
+    int convertChunk(FileState& f, int k, ChunkOutput& out) const
+    {
+        const int rate = f.format.sampleRate;
+        const int channels = f.format.channels;
+        const int64_t seam = rate * SEAM_MS / 1000;
+        const int64_t maxLag = rate * MAX_LAG_MS / 1000;
+
+        // This chunk writes [chunkStart, chunkEnd) and provides 'seam'
+        // frames past its end for the crossfade into the next; shifting it
+        // may need up to maxLag either side
+        const int64_t first = k == 0 ? 0 : f.chunkStart(k) - maxLag;
+        const int64_t last = (k + 1 == f.chunks ? f.frames : f.chunkEnd(k) + seam) + maxLag;
+        out.start = k == 0 ? 0 : std::max<int64_t>(0, first - rate * WARMUP_MS / 1000);
+        const size_t wanted = static_cast<size_t>(last - out.start);
+
+        std::unique_ptr<SoundTouchBackend> engine(
+            SoundTouchBackend::create(rate, channels, offlineSettings(options_.pitchSemitones)));
+        if (!engine) return -ENOMEM;
+        out.pcm.resize((wanted + FEED_FRAMES) * channels);
+        std::vector<int16_t> in(FEED_FRAMES * channels);
+        const size_t frameBytes = channels * sizeof(int16_t);
+
+        // Input past the end of the file is silence that flushes the engine
+        size_t written = 0;
+        for (int64_t pos = out.start; written < wanted; pos += FEED_FRAMES)
+        {
+            const int64_t real = std::max<int64_t>(0, std::min<int64_t>(FEED_FRAMES, f.frames - pos));
+            if (real > 0)
+            {
+                const ssize_t got = preadFull(f.inFd, in.data(), real * frameBytes,
+                                              f.inData + pos * static_cast<off_t>(frameBytes));
+                if (got < 0) return static_cast<int>(got);
+                if (got != static_cast<ssize_t>(real * frameBytes)) return -EIO;
+            }
+            std::fill(in.begin() + real * channels, in.end(), 0);
+            written += static_cast<size_t>(
+                engine->process(in.data(), out.pcm.data() + written * channels,
+                                static_cast<int>(FEED_FRAMES), PcmFormat::kInt16));
+        }
+        out.pcm.resize(wanted * channels);
+        return 0;
+    }
+
+    /** Output frame @p t from chunk @p c, shifted by its lag */
+    static int16_t sample(const ChunkOutput& c, int64_t t, int channel, int channels)
+    {
+        const int64_t i = t - c.start + c.lag;
+        if (i < 0 || (i + 1) * channels > static_cast<int64_t>(c.pcm.size())) return 0;
+        return c.pcm[i * channels + channel];
+    }
+
+    /**
+     * Offset of chunk @p cur that best continues @p prev at frame @p at:
+     * the normalised cross-correlation peak of the channel sums over the
+     * crossfade, as WSOLA picks its splice offsets
+     */
+    static int findLag(const ChunkOutput& prev, ChunkOutput& cur, int64_t at, int64_t length,
+                       int64_t maxLag, int channels)
+    {
+        std::vector<float> a(length), b(length + 2 * maxLag);
+        for (int64_t i = 0; i < length; i++)
+        {
+            for (int c = 0; c < channels; c++) a[i] += sample(prev, at + i, c, channels);
+        }
+        cur.lag = 0;
+        for (int64_t i = 0; i < length + 2 * maxLag; i++)
+        {
+            for (int c = 0; c < channels; c++) b[i] += sample(cur, at - maxLag + i, c, channels);
+        }
+
+        int best = 0;
+        double bestScore = 0.0;
+        for (int64_t lag = -maxLag; lag <= maxLag; lag++)
+        {
+            double dot = 0.0;
+            double energy = 1e-9;
+            const float* x = b.data() + lag + maxLag;
+            for (int64_t i = 0; i < length; i++)
+            {
+                dot += a[i] * x[i];
+                energy += x[i] * x[i];
+            }
+            const double score = dot / std::sqrt(energy);
+            // Ties (silence) keep the chunk on its own timeline
+            if (score > bestScore || (score == bestScore && std::abs(lag) < std::abs(best)))
+            {
+                bestScore = score;
+                best = static_cast<int>(lag);
+            }
+        }
+        return best;
+    }
+
+    int writeChunk(FileState& f, int k) const
+    {
+        const int channels = f.format.channels;
+        const int64_t seam = f.format.sampleRate * SEAM_MS / 1000;
+        ChunkOutput& cur = f.outputs[k];
+        const int64_t begin = f.chunkStart(k);
+        const int64_t end = f.chunkEnd(k);
+        if (k > 0)
+        {
+            cur.lag = findLag(f.outputs[k - 1], cur, begin, seam,
+                              f.format.sampleRate * MAX_LAG_MS / 1000, channels);
+        }
+
+        std::vector<int16_t> buffer(FEED_FRAMES * channels);
+        for (int64_t t0 = begin; t0 < end; t0 += FEED_FRAMES)
+        {
+            const int64_t n = std::min<int64_t>(FEED_FRAMES, end - t0);
+            for (int64_t i = 0; i < n; i++)
+            {
+                const int64_t t = t0 + i;
+                for (int c = 0; c < channels; c++)
+                {
+                    int16_t v = sample(cur, t, c, channels);
+                    if (k > 0 && t < begin + seam)
+                    {
+                        const float w = (t - begin + 0.5f) / seam;
+                        const float mixed = (1.0f - w) * sample(f.outputs[k - 1], t, c, channels) + w * v;
+                        v = static_cast<int16_t>(std::lround(mixed));
+                    }
+                    buffer[i * channels + c] = v;
+                }
+            }
+            const size_t bytes = static_cast<size_t>(n) * channels * sizeof(int16_t);
+            const off_t offset = f.outData + t0 * static_cast<off_t>(channels * sizeof(int16_t));
+            if (pwrite(f.outFd, buffer.data(), bytes, offset) != static_cast<ssize_t>(bytes))
+            {
+                return errno ? -errno : -EIO;
+            }
+        }
+        return 0;
+    }
+
+    std::vector<BatchJob>& jobs_;
+    const BatchOptions& options_;
+    BatchStats& stats_;
+    uint64_t settingsHash_ = 0;
+    std::vector<TaskQueue> queues_;
+    std::vector<std::unique_ptr<FileState>> files_;
+    std::atomic<int> pending_{0};
+    std::mutex statsLock_;
+};
+
+}  // namespace
+
+int batchConvert(std::vector<BatchJob>& jobs, const BatchOptions& options, BatchStats* stats)
+{
+    BatchStats local;
+    BatchStats& s = stats ? *stats : local;
+    s = BatchStats();
+    if (options.chunkSeconds <= 0.0)
+    {
+        return -EINVAL;
+    }
+    if (!options.cacheDir.empty() && mkdir(options.cacheDir.c_str(), 0755) && errno != EEXIST)
+    {
+        return -errno;
+    }
+
+    const Clock::time_point start = Clock::now();
+    Scheduler(jobs, options, s).run();
+    s.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (const BatchJob& job : jobs)
+    {
+        if (job.status) return job.status;
+    }
+    return 0;
+}
+
+}  // namespace dsp
+}  // namespace audioshift
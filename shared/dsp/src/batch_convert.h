@@ -0,0 +1,82 @@
+#ifndef AUDIOSHIFT_BATCH_CONVERT_H
+#define AUDIOSHIFT_BATCH_CONVERT_H
+
+/**
+ * Library-wide batch conversion.
+ *
+ * Converts many files at once on a pool of workers with work stealing.
+ * Files longer than about one and a half chunks are split into chunks that
+ * convert independently; short files are scheduled between them. An
+ * optional on-disk cache, keyed by the content hash of each input and the
+ * conversion settings, lets re-runs skip inputs that have not changed.
+ */
+
+#include "audio_432hz.h"
+#include "pcm_file.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+struct BatchJob
+{
+    std::string input;
+    std::string output;
+    int status = 0;       ///< Set by batchConvert(): 0 or -errno
+    bool cached = false;  ///< Set by batchConvert(): output taken from the cache
+};
+
+struct BatchOptions
+{
+    StreamFormat inputFormat = StreamFormat::kAuto;  ///< Output format follows the input
+    int sampleRate = 48000;  ///< Of raw inputs
+    int channels = 2;        ///< Of raw inputs
+    float pitchSemitones = PITCH_SEMITONES_432_HZ;
+    int threads = 0;             ///< 0: one per CPU
+    double chunkSeconds = 20.0;  ///< Length of the pieces long files are split into
+    std::string cacheDir;        ///< Empty: no cache
+};
+
+struct BatchStats
+{
+    int converted = 0;
+    int cached = 0;  ///< Skipped: the cache held the result
+    int failed = 0;
+    uint64_t chunks = 0;  ///< Conversion tasks run
+    uint64_t steals = 0;  ///< Tasks a worker took from another worker's queue
+    double audioSeconds = 0.0;  ///< Of the converted files
+    double wallSeconds = 0.0;
+};
+
+/**
+ * @brief Convert every job's input to its output
+ *
+ * Outputs are written under a temporary name and renamed into place when
+ * complete, so a failed or interrupted run never leaves a truncated file.
+ * With a cache, a result lives in the cache directory and the output is a
+ * hard link to it (a copy across file systems); an output that already is
+ * that link is left alone.
+ *
+ * Chunks start a second early so the engine has settled by the chunk
+ * boundary. Neighbouring chunks are joined like WSOLA joins sequences: the
+ * later one is shifted to the offset where it best matches the earlier
+ * one and crossfaded in over 10 ms. The output has the input's length;
+ * for a single-chunk file it is identical to streamConvert()'s.
+ *
+ * Chunks of one file that finish out of order are held in memory until
+ * the ones before them are done.
+ *
+ * @param jobs Updated with each job's status
+ * @return 0 if every job succeeded, else the first failed job's status
+ */
+int batchConvert(std::vector<BatchJob>& jobs, const BatchOptions& options, BatchStats* stats);
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_BATCH_CONVERT_H
@@ -0,0 +1,170 @@
+#ifndef AUDIOSHIFT_CONVERTER_BACKEND_H
+#define AUDIOSHIFT_CONVERTER_BACKEND_H
+
+#include "effect_core.h"
+#include "pcm_convert.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief EffectCore backend running the full Audio432HzConverter
+ *
+ * Adds what the bare engine lacks: crossfaded auto-bypass and band split
+ * at hi-res rates. Sample rate and latency tier changes are seamless in
+ * both (stream_switch.h). 16-bit PCM
+ * goes straight to the converter; wider formats are converted to float in
+ * blocks of BLOCK_FRAMES and take its float entry point.
+ */
+class ConverterBackend
+{
+public:
+    static constexpr int BLOCK_FRAMES = 1024;
+
+    static ConverterBackend* create(int sampleRate, int channels, const EffectSettings& settings)
+    {
+        std::unique_ptr<Audio432HzConverter> converter(
+            new (std::nothrow) Audio432HzConverter(sampleRate, channels));
+        std::unique_ptr<float[]> scratch(
+            new (std::nothrow) float[static_cast<size_t>(BLOCK_FRAMES) * channels]);
+        if (!converter || !scratch)
+        {
+            return nullptr;
+        }
+        apply(*converter, settings);
+        return new (std::nothrow)
+            ConverterBackend(std::move(converter), std::move(scratch), sampleRate, channels);
+    }
+
+    bool setFormat(int sampleRate, int channels, const EffectSettings& settings)
+    {
+        if (channels == channels_)
+        {
+            converter_->setSampleRate(sampleRate);
+            sampleRate_ = sampleRate;
+            return true;
+        }
+        // The converter's engines are built for one channel count
+        std::unique_ptr<Audio432HzConverter> converter(
+            new (std::nothrow) Audio432HzConverter(sampleRate, channels));
+        std::unique_ptr<float[]> scratch(
+            channels > channels_ ? new (std::nothrow) float[static_cast<size_t>(BLOCK_FRAMES) * channels]
+                                 : nullptr);
+        if (!converter || (channels > channels_ && !scratch))
+        {
+            return false;
+        }
+        apply(*converter, settings);
+        converter_ = std::move(converter);
+        if (scratch)
+        {
+            scratch_ = std::move(scratch);
+        }
+        sampleRate_ = sampleRate;
+        channels_ = channels;
+        return true;
+    }
+
+    void reset()
+    {
+        // Setting the current rate again restarts the stream
+        converter_->setSampleRate(sampleRate_);
+    }
+
+    void setPitchSemitones(float semitones) { converter_->setPitchShiftSemitones(semitones); }
+
+    bool setInterpolator(Interpolator interpolator)
+    {
+        converter_->setInterpolator(interpolator);
+        return converter_->getInterpolator() == interpolator;
+    }
+
+    void setProfile(ProcessingProfile profile) { converter_->setProcessingProfile(profile); }
+
+    void setOutputLatency(float sinkLatencyMs, float budgetMs)
+    {
+        converter_->setOutputLatency(sinkLatencyMs, budgetMs);
+    }
+
+    void setAutoBypass(bool enabled) { converter_->setAutoBypass(enabled); }
+
+    static bool supportsFormat(PcmFormat) { return true; }
+
+    int process(const void* in, void* out, int frames, PcmFormat format)
+    {
+        // The converter zero-fills what its engines cannot deliver yet
+        if (format == PcmFormat::kInt16)
+        {
+            converter_->process(static_cast<const int16_t*>(in), static_cast<int16_t*>(out),
+                                frames * channels_);
+            return frames;
+        }
+
+        // Each block is written back over input that has already been read
+        const size_t frameBytes = bytesPerSample(format) * channels_;
+        const auto* src = static_cast<const uint8_t*>(in);
+        auto* dst = static_cast<uint8_t*>(out);
+        for (int done = 0; done < frames;)
+        {
+            const int n = std::min(BLOCK_FRAMES, frames - done);
+            const size_t offset = static_cast<size_t>(done) * frameBytes;
+            const size_t samples = static_cast<size_t>(n) * channels_;
+            pcmToFloat(src + offset, format, scratch_.get(), samples);
+            converter_->process(scratch_.get(), scratch_.get(), n);
+            floatToPcm(scratch_.get(), format, dst + offset, samples);
+            done += n;
+        }
+        return frames;
+    }
+
+    bool isBypassed() const { return converter_->isBypassed(); }
+    float referenceHz() const { return converter_->getEstimatedReferenceHz(); }
+    float latencyMs() const { return converter_->getLatencyMs(); }
+
+    void addMemoryUsage(MemoryUsage& usage) const
+    {
+        const MemoryUsage converter = converter_->getMemoryUsage();
+        const size_t fixed = sizeof(*this) + static_cast<size_t>(BLOCK_FRAMES) * channels_ * sizeof(float);
+        usage.allocatedBytes += fixed + converter.allocatedBytes;
+        usage.usedBytes += fixed + converter.usedBytes;
+        usage.peakUsedBytes += fixed + converter.peakUsedBytes;
+    }
+
+    void shrinkToFit() { converter_->shrinkToFit(); }
+
+private:
+    ConverterBackend(std::unique_ptr<Audio432HzConverter> converter, std::unique_ptr<float[]> scratch,
+                     int sampleRate, int channels)
+        : converter_(std::move(converter)),
+          scratch_(std::move(scratch)),
+          sampleRate_(sampleRate),
+          channels_(channels)
+    {
+    }
+
+    static void apply(Audio432HzConverter& converter, const EffectSettings& settings)
+    {
+        converter.setPitchShiftSemitones(settings.pitchSemitones);
+        converter.setInterpolator(settings.interpolator);
+        converter.setProcessingProfile(settings.profile);
+        converter.setOutputLatency(settings.sinkLatencyMs, settings.latencyBudgetMs);
+        converter.setAutoBypass(settings.autoBypass);
+    }
+
+    std::unique_ptr<Audio432HzConverter> converter_;
+    std::unique_ptr<float[]> scratch_;  // BLOCK_FRAMES * channels, formats other than int16
+    int sampleRate_;
+    int channels_;
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_CONVERTER_BACKEND_H
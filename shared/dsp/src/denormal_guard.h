@@ -0,0 +1,100 @@
+#ifndef AUDIOSHIFT_DENORMAL_GUARD_H
+#define AUDIOSHIFT_DENORMAL_GUARD_H
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define AUDIOSHIFT_DENORMAL_GUARD_SSE 1
+#elif defined(__aarch64__)
+#define AUDIOSHIFT_DENORMAL_GUARD_A64 1
+#elif defined(__arm__) && defined(__ARM_FP)
+#define AUDIOSHIFT_DENORMAL_GUARD_VFP 1
+#endif
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Flushes subnormal floats to zero for the lifetime of the object
+ *
+ * Once a stream fades out, recursive state (the tuning estimator's
+ * band-pass, running averages) decays into the subnormal range, where each
+ * operation can cost a hundred times more on x86 and on ARM cores without
+ * flush-to-zero. Processing entry points hold one of these: FTZ and DAZ on
+ * SSE, FZ on ARM. The caller's control register is restored on exit, so
+ * the host's own FP settings are never changed behind its back. Nesting is
+ * free: an inner guard finds the mode already set and writes nothing.
+ *
+ * On other targets it does nothing.
+ */
+class DenormalGuard
+{
+public:
+    DenormalGuard() : saved_(read()), changed_((saved_ | kFlushBits) != saved_)
+    {
+        if (changed_)
+        {
+            write(saved_ | kFlushBits);
+        }
+    }
+
+    ~DenormalGuard()
+    {
+        if (changed_)
+        {
+            write(saved_);
+        }
+    }
+
+    DenormalGuard(const DenormalGuard&) = delete;
+    DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+    /** @brief Whether this target can flush subnormals at all */
+    static constexpr bool supported() { return kFlushBits != 0; }
+
+private:
+#if defined(AUDIOSHIFT_DENORMAL_GUARD_SSE)
+    // MXCSR: FTZ (bit 15) and DAZ (bit 6)
+    static constexpr uint64_t kFlushBits = 0x8040;
+    static uint64_t read() { return _mm_getcsr(); }
+    static void write(uint64_t state) { _mm_setcsr(static_cast<unsigned int>(state)); }
+#elif defined(AUDIOSHIFT_DENORMAL_GUARD_A64)
+    // FPCR: FZ (bit 24), flushes inputs and results
+    static constexpr uint64_t kFlushBits = 1ull << 24;
+    static uint64_t read()
+    {
+        uint64_t state;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(state));
+        return state;
+    }
+    static void write(uint64_t state) { __asm__ __volatile__("msr fpcr, %0" : : "r"(state)); }
+#elif defined(AUDIOSHIFT_DENORMAL_GUARD_VFP)
+    // FPSCR: FZ (bit 24)
+    static constexpr uint64_t kFlushBits = 1ull << 24;
+    static uint64_t read()
+    {
+        uint32_t state;
+        __asm__ __volatile__("vmrs %0, fpscr" : "=r"(state));
+        return state;
+    }
+    static void write(uint64_t state)
+    {
+        __asm__ __volatile__("vmsr fpscr, %0" : : "r"(static_cast<uint32_t>(state)));
+    }
+#else
+    static constexpr uint64_t kFlushBits = 0;
+    static uint64_t read() { return 0; }
+    static void write(uint64_t) {}
+#endif
+
+    uint64_t saved_;
+    bool changed_;
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_DENORMAL_GUARD_H
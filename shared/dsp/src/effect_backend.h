@@ -0,0 +1,37 @@
+#ifndef AUDIOSHIFT_EFFECT_BACKEND_H
+#define AUDIOSHIFT_EFFECT_BACKEND_H
+
+/**
+ * Compile-time choice of the DSP backend behind EffectCore.
+ *
+ * Define AUDIOSHIFT_EFFECT_BACKEND_CONVERTER to run the full
+ * Audio432HzConverter (needs audio_432hz.cpp and its sources); the default
+ * is the bare SoundTouch engine (soundtouch_backend.cpp).
+ */
+
+#include "effect_core.h"
+
+#if defined(AUDIOSHIFT_EFFECT_BACKEND_CONVERTER)
+#include "converter_backend.h"
+#else
+#include "soundtouch_backend.h"
+#endif
+
+namespace audioshift
+{
+namespace dsp
+{
+
+#if defined(AUDIOSHIFT_EFFECT_BACKEND_CONVERTER)
+using EffectBackend = ConverterBackend;
+#else
+using EffectBackend = SoundTouchBackend;
+#endif
+
+/** The effect core both Android effects instantiate */
+using Effect = EffectCore<EffectBackend>;
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_EFFECT_BACKEND_H
@@ -0,0 +1,182 @@
+#ifndef AUDIOSHIFT_EFFECT_COMMAND_H
+#define AUDIOSHIFT_EFFECT_COMMAND_H
+
+/**
+ * Standard Android effect commands on top of EffectCore.
+ *
+ * Only the Android effects include this header; EffectCore itself does not
+ * depend on the effect HAL.
+ */
+
+#include "effect_core.h"
+
+#include <hardware/audio_effect.h>
+
+#include <cerrno>
+#include <cstdint>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Map an integer PCM audio_format_t onto the core's sample layouts
+ * @return false for float, compressed and anything else the core cannot run
+ */
+inline bool toPcmFormat(uint32_t format, PcmFormat& pcm)
+{
+    switch (format)
+    {
+    case AUDIO_FORMAT_PCM_16_BIT:
+        pcm = PcmFormat::kInt16;
+        return true;
+    case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+        pcm = PcmFormat::kInt24Packed;
+        return true;
+    case AUDIO_FORMAT_PCM_8_24_BIT:
+        pcm = PcmFormat::kQ8_23;
+        return true;
+    case AUDIO_FORMAT_PCM_32_BIT:
+        pcm = PcmFormat::kInt32;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Check an EFFECT_CMD_SET_CONFIG request against what the core runs
+ *
+ * Input and output must be the same interleaved integer PCM format (16,
+ * packed 24, 8.24 or 32 bit) at the same rate and channel mask; output
+ * fields left at 0 take the input's value. Whether the backend runs the
+ * format is checked by EffectCore::setFormat().
+ * @return 0 and the negotiated format, or -EINVAL
+ */
+inline int negotiateFormat(const effect_config_t& config, int& sampleRate, int& channels,
+                           PcmFormat& pcm)
+{
+    const buffer_config_t& in = config.inputCfg;
+    const buffer_config_t& out = config.outputCfg;
+    if (!toPcmFormat(in.format, pcm) ||
+        (out.format != AUDIO_FORMAT_DEFAULT && out.format != in.format) ||
+        (out.samplingRate != 0 && out.samplingRate != in.samplingRate) ||
+        (out.channels != 0 && out.channels != in.channels))
+    {
+        return -EINVAL;
+    }
+    sampleRate = static_cast<int>(in.samplingRate);
+    channels = static_cast<int>(audio_channel_count_from_out_mask(in.channels));
+    return 0;
+}
+
+/**
+ * @brief Run the life-cycle and format commands both effects share
+ *
+ * Handles EFFECT_CMD_INIT, SET_CONFIG, GET_CONFIG, RESET, ENABLE, DISABLE,
+ * SET_DEVICE and SET_AUDIO_MODE. @p config is the effect's copy of the negotiated
+ * configuration; it only changes when SET_CONFIG succeeds. Commands whose
+ * reply carries a status (INIT, SET_CONFIG, ENABLE, DISABLE) get it there
+ * as well as in @p status.
+ *
+ * @return false if @p cmdCode is not one of these; the effect handles its
+ *         own control commands
+ */
+template <class Backend>
+bool handleEffectCommand(EffectCore<Backend>& core, effect_config_t& config,
+                         uint32_t cmdCode, uint32_t cmdSize, void* pCmdData,
+                         uint32_t* replySize, void* pReplyData, int& status)
+{
+    const bool statusReply = replySize && *replySize >= sizeof(int) && pReplyData;
+    switch (cmdCode)
+    {
+    case EFFECT_CMD_INIT:
+        status = statusReply ? 0 : -EINVAL;
+        break;
+
+    case EFFECT_CMD_SET_CONFIG:
+    {
+        if (cmdSize < sizeof(effect_config_t) || !pCmdData || !statusReply)
+        {
+            status = -EINVAL;
+            return true;
+        }
+        const auto& requested = *static_cast<const effect_config_t*>(pCmdData);
+        int sampleRate = 0;
+        int channels = 0;
+        PcmFormat pcm = PcmFormat::kInt16;
+        status = negotiateFormat(requested, sampleRate, channels, pcm);
+        if (status == 0)
+        {
+            status = core.setFormat(sampleRate, channels, pcm);
+        }
+        if (status == 0)
+        {
+            config = requested;
+        }
+        break;
+    }
+
+    case EFFECT_CMD_GET_CONFIG:
+        if (!pReplyData || !replySize || *replySize < sizeof(effect_config_t))
+        {
+            status = -EINVAL;
+            return true;
+        }
+        *static_cast<effect_config_t*>(pReplyData) = config;
+        status = 0;
+        return true;
+
+    case EFFECT_CMD_RESET:
+        core.reset();
+        status = 0;
+        return true;
+
+    case EFFECT_CMD_ENABLE:
+        status = core.enable();
+        break;
+
+    case EFFECT_CMD_DISABLE:
+        core.disable();
+        status = 0;
+        break;
+
+    case EFFECT_CMD_SET_DEVICE:
+        if (cmdSize < sizeof(uint32_t) || !pCmdData)
+        {
+            status = -EINVAL;
+            return true;
+        }
+        core.setDevice(*static_cast<const uint32_t*>(pCmdData));
+        status = 0;
+        return true;
+
+    case EFFECT_CMD_SET_AUDIO_MODE:
+    {
+        if (cmdSize < sizeof(uint32_t) || !pCmdData)
+        {
+            status = -EINVAL;
+            return true;
+        }
+        const uint32_t mode = *static_cast<const uint32_t*>(pCmdData);
+        core.setVoiceCall(mode == AUDIO_MODE_IN_CALL || mode == AUDIO_MODE_IN_COMMUNICATION);
+        status = 0;
+        return true;
+    }
+
+    default:
+        return false;
+    }
+
+    if (statusReply)
+    {
+        *static_cast<int*>(pReplyData) = status;
+    }
+    return true;
+}
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_EFFECT_COMMAND_H
@@ -0,0 +1,674 @@
+#ifndef AUDIOSHIFT_EFFECT_CORE_H
+#define AUDIOSHIFT_EFFECT_CORE_H
+
+#include "audio_432hz.h"
+#include "denormal_guard.h"
+#include "latency_budget.h"
+#include "pcm_convert.h"
+#include "shadow_runner.h"
+#include "stats_page.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/** Formats the effects accept in EFFECT_CMD_SET_CONFIG */
+constexpr int EFFECT_MIN_SAMPLE_RATE = 8000;
+constexpr int EFFECT_MAX_SAMPLE_RATE = 192000;
+constexpr int EFFECT_MAX_CHANNELS = 8;
+
+/**
+ * @brief Effect settings, recorded whether or not an engine exists yet
+ *
+ * The backend is built from these on the first enable and kept in step
+ * with them afterwards.
+ */
+struct EffectSettings
+{
+    float pitchSemitones = PITCH_SEMITONES_432_HZ;
+    Interpolator interpolator = Interpolator::kCubic;
+    ProcessingProfile profile = ProcessingProfile::kMusic;
+    bool autoBypass = true;       ///< Pass content already at 432 Hz through
+    float sinkLatencyMs = 0.0f;   ///< Delay after the effect
+    float latencyBudgetMs = 0.0f; ///< Total output delay allowed, 0 = engine default
+};
+
+/**
+ * @brief Shadow engine that follows an EffectCore's settings
+ *
+ * Type-erased so one EffectCore can be shadowed by a backend of any type.
+ */
+class ShadowBackend : public ShadowEngine
+{
+public:
+    virtual bool setFormat(int sampleRate, int channels, const EffectSettings& settings) = 0;
+    virtual void setPitchSemitones(float semitones) = 0;
+    virtual bool setInterpolator(Interpolator interpolator) = 0;
+    virtual void setProfile(ProcessingProfile profile) = 0;
+    virtual void setOutputLatency(float sinkLatencyMs, float budgetMs) = 0;
+    virtual void setAutoBypass(bool enabled) = 0;
+};
+
+/** @brief An EffectCore backend run as a shadow */
+template <class Backend>
+class BackendShadow final : public ShadowBackend
+{
+public:
+    /** @return nullptr if out of memory */
+    static BackendShadow* create(int sampleRate, int channels, const EffectSettings& settings)
+    {
+        std::unique_ptr<Backend> backend(Backend::create(sampleRate, channels, settings));
+        return backend ? new (std::nothrow) BackendShadow(std::move(backend)) : nullptr;
+    }
+
+    int process(const void* in, void* out, int frames, PcmFormat format) override
+    {
+        return Backend::supportsFormat(format) ? backend_->process(in, out, frames, format) : 0;
+    }
+    void reset() override { backend_->reset(); }
+    bool setFormat(int sampleRate, int channels, const EffectSettings& settings) override
+    {
+        return backend_->setFormat(sampleRate, channels, settings);
+    }
+    void setPitchSemitones(float semitones) override { backend_->setPitchSemitones(semitones); }
+    bool setInterpolator(Interpolator interpolator) override
+    {
+        return backend_->setInterpolator(interpolator);
+    }
+    void setProfile(ProcessingProfile profile) override { backend_->setProfile(profile); }
+    void setOutputLatency(float sinkLatencyMs, float budgetMs) override
+    {
+        backend_->setOutputLatency(sinkLatencyMs, budgetMs);
+    }
+    void setAutoBypass(bool enabled) override { backend_->setAutoBypass(enabled); }
+
+private:
+    explicit BackendShadow(std::unique_ptr<Backend> backend) : backend_(std::move(backend)) {}
+
+    std::unique_ptr<Backend> backend_;
+};
+
+/**
+ * @brief Android-independent part of the audio effect
+ *
+ * Holds the state both effects share: settings, format, the enable state,
+ * the lazily allocated DSP backend, the process loop and the statistics.
+ * PATH-B and PATH-C wrap it in their own effect_interface_s and map their
+ * control commands onto its setters; standard commands go through
+ * handleEffectCommand() (effect_command.h).
+ *
+ * The backend is a template parameter, picked at compile time (see
+ * effect_backend.h), so calls into it are direct and inlinable. A backend
+ * provides:
+ *
+ *     static Backend* create(int sampleRate, int channels, const EffectSettings&);
+ *                                         // nullptr if out of memory
+ *     bool setFormat(int sampleRate, int channels, const EffectSettings&);
+ *     void reset();                       // drop buffered audio
+ *     void setPitchSemitones(float semitones);
+ *     bool setInterpolator(Interpolator interpolator);
+ *     void setProfile(ProcessingProfile profile);
+ *     void setOutputLatency(float sinkLatencyMs, float budgetMs);
+ *     void setAutoBypass(bool enabled);
+ *     static bool supportsFormat(PcmFormat format);
+ *     int process(const void* in, void* out, int frames, PcmFormat format);
+ *                                         // frames written to the front of out
+ *     bool isBypassed() const;
+ *     float referenceHz() const;          // 0 = unknown
+ *     float latencyMs() const;
+ *     void addMemoryUsage(MemoryUsage& usage) const;
+ *     void shrinkToFit();
+ *
+ * process() must accept @p out aliasing @p in, and must not allocate.
+ *
+ * Threading: process() runs on the audio thread, everything else on the
+ * binder thread. AudioFlinger serialises the two per effect, so no locks
+ * are taken. Only enable(), setFormat(), setProfile() and
+ * setLatencyBudget() (a tier switch re-primes the engine) allocate.
+ *
+ * A second backend can run as a shadow (startShadow()) to compare an
+ * engine under evaluation with the production one on live audio. It gets
+ * the same input and settings; its output is measured against the
+ * backend's and dropped, never written to @p out. The comparison goes to
+ * shadowMetrics() and the stats page.
+ */
+template <class Backend>
+class EffectCore
+{
+public:
+    EffectCore() = default;
+
+    ~EffectCore()
+    {
+        if (statsSlot_ >= 0)
+        {
+            statsPage_->releaseSlot(statsSlot_);
+        }
+    }
+
+    EffectCore(const EffectCore&) = delete;
+    EffectCore& operator=(const EffectCore&) = delete;
+
+    /**
+     * @brief Publish this instance's statistics to @p page
+     *
+     * Takes a slot; without one (no page, or page full) the instance runs
+     * unmonitored.
+     */
+    void attachStats(StatsPage* page)
+    {
+        stats_ = InstanceStats();
+        statsPage_ = page;
+        statsSlot_ = page ? page->acquireSlot(stats_.id) : -1;
+        publishStats();
+    }
+
+    // ── Format ──────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Negotiate the stream format
+     *
+     * Re-sending the current format (routing changes do) keeps the primed
+     * engine. A new sample rate is handed to the backend, which keeps the
+     * stream running if it can. The sample layout is converted per call,
+     * so changing only @p pcm never touches the engine. A shadow engine
+     * that cannot follow the new format is stopped.
+     * @return 0, -EINVAL for an unsupported format, or -ENOMEM (the previous
+     *         format, sample layout included, stays in force)
+     */
+    int setFormat(int sampleRate, int channels, PcmFormat pcm = PcmFormat::kInt16)
+    {
+        if (sampleRate < EFFECT_MIN_SAMPLE_RATE || sampleRate > EFFECT_MAX_SAMPLE_RATE ||
+            channels < 1 || channels > EFFECT_MAX_CHANNELS || !Backend::supportsFormat(pcm))
+        {
+            return -EINVAL;
+        }
+        if (sampleRate != sampleRate_ || channels != channels_)
+        {
+            if (engine_ && !engine_->setFormat(sampleRate, channels, engineSettings()))
+            {
+                return -ENOMEM;  // the old format stays in force
+            }
+            if (shadow_)
+            {
+                shadow_->drain();
+                if (shadowBackend_->setFormat(sampleRate, channels, engineSettings()))
+                {
+                    shadow_->restart(sampleRate, channels);
+                }
+                else
+                {
+                    stopShadow();  // production switched; a shadow that cannot follow goes
+                }
+            }
+            sampleRate_ = sampleRate;
+            channels_ = channels;
+        }
+        // Only once the engine took it: process() sizes the buffers by it
+        pcmFormat_ = pcm;
+        publishStats();
+        return 0;
+    }
+
+    int sampleRate() const { return sampleRate_; }
+    int channels() const { return channels_; }
+    PcmFormat pcmFormat() const { return pcmFormat_; }
+
+    // ── State ───────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Start processing; allocates the backend on the first call
+     *
+     * Most instances are created disabled and many are released without
+     * ever being enabled, so nothing but the settings exists before this.
+     * @return 0, or -ENOMEM (the effect then stays in pass-through)
+     */
+    int enable()
+    {
+        if (!engine_)
+        {
+            engine_.reset(Backend::create(sampleRate_, channels_, engineSettings()));
+            if (!engine_)
+            {
+                return -ENOMEM;
+            }
+        }
+        enabled_ = true;
+        publishStats();
+        return 0;
+    }
+
+    /** @brief Stop processing and drop buffered audio; the backend is kept */
+    void disable()
+    {
+        enabled_ = false;
+        if (engine_)
+        {
+            engine_->reset();
+        }
+        restartShadow();
+        publishStats();
+    }
+
+    /** @brief Drop buffered audio and clear the statistics */
+    void reset()
+    {
+        if (engine_)
+        {
+            engine_->reset();
+        }
+        restartShadow();
+        resetStats();
+    }
+
+    bool isEnabled() const { return enabled_; }
+    bool hasEngine() const { return engine_ != nullptr; }
+
+    // ── Shadow engine ───────────────────────────────────────────────────────
+
+    /**
+     * @brief Run a @p Shadow backend beside the production one
+     *
+     * Replaces any shadow already running. In ShadowMode::kInline it runs
+     * inside process() and adds its cost to the callback; in
+     * ShadowMode::kWorker the callback only copies the buffers to a worker
+     * thread, and calls the worker has no room for are dropped. Allocates.
+     * @return 0, or -ENOMEM
+     */
+    template <class Shadow>
+    int startShadow(ShadowMode mode = ShadowMode::kWorker)
+    {
+        stopShadow();
+        std::unique_ptr<ShadowBackend> backend(
+            BackendShadow<Shadow>::create(sampleRate_, channels_, engineSettings()));
+        if (!backend)
+        {
+            return -ENOMEM;
+        }
+        ShadowBackend* raw = backend.get();
+        shadow_.reset(ShadowRunner::create(std::move(backend), sampleRate_, channels_, mode));
+        if (!shadow_)
+        {
+            return -ENOMEM;
+        }
+        shadowBackend_ = raw;
+        shadowBackend_->setOutputLatency(settings_.sinkLatencyMs, settings_.latencyBudgetMs);
+        publishStats();
+        return 0;
+    }
+
+    /** @brief Stop the shadow engine and free it */
+    void stopShadow()
+    {
+        shadow_.reset();
+        shadowBackend_ = nullptr;
+        publishStats();
+    }
+
+    bool hasShadow() const { return shadow_ != nullptr; }
+
+    /** @brief Comparison so far; zeros without a shadow */
+    ShadowMetrics shadowMetrics() const { return shadow_ ? shadow_->metrics() : ShadowMetrics(); }
+
+    // ── Settings ────────────────────────────────────────────────────────────
+
+    const EffectSettings& settings() const { return settings_; }
+
+    /** @return 0, or -EINVAL unless 0 < @p ratio <= 2 */
+    int setPitchRatio(float ratio)
+    {
+        if (!(ratio > 0.0f && ratio <= 2.0f))
+        {
+            return -EINVAL;
+        }
+        settings_.pitchSemitones = 12.0f * std::log2(ratio);
+        if (engine_)
+        {
+            engine_->setPitchSemitones(settings_.pitchSemitones);
+        }
+        if (ShadowBackend* shadow = drainShadow())
+        {
+            shadow->setPitchSemitones(settings_.pitchSemitones);
+        }
+        return 0;
+    }
+
+    /** @return 0, or -EINVAL if the backend cannot run it on this format */
+    int setInterpolator(Interpolator interpolator)
+    {
+        const int value = static_cast<int>(interpolator);
+        if (value < 0 || value > 2 || (engine_ && !engine_->setInterpolator(interpolator)))
+        {
+            return -EINVAL;
+        }
+        settings_.interpolator = interpolator;
+        if (ShadowBackend* shadow = drainShadow())
+        {
+            shadow->setInterpolator(interpolator);  // a shadow that cannot keeps its own
+        }
+        return 0;
+    }
+
+    /** @return 0, or -EINVAL for an unknown profile */
+    int setProfile(ProcessingProfile profile)
+    {
+        const int value = static_cast<int>(profile);
+        if (value < 0 || value > 2)
+        {
+            return -EINVAL;
+        }
+        settings_.profile = profile;
+        if (engine_)
+        {
+            engine_->setProfile(engineProfile());
+        }
+        if (ShadowBackend* shadow = drainShadow())
+        {
+            shadow->setProfile(engineProfile());
+        }
+        publishStats();
+        return 0;
+    }
+
+    /**
+     * @brief Follow the phone's audio mode (EFFECT_CMD_SET_AUDIO_MODE)
+     *
+     * During a call, cellular or VoIP, the backend runs the VoIP profile
+     * whatever profile is set; the set one returns when the call ends.
+     */
+    void setVoiceCall(bool inCall)
+    {
+        if (inCall == voiceCall_)
+        {
+            return;
+        }
+        voiceCall_ = inCall;
+        if (engine_)
+        {
+            engine_->setProfile(engineProfile());
+        }
+        if (ShadowBackend* shadow = drainShadow())
+        {
+            shadow->setProfile(engineProfile());
+        }
+        publishStats();
+    }
+
+    bool isVoiceCall() const { return voiceCall_; }
+
+    /** @brief Profile the backend runs: the set one, or VoIP during a call */
+    ProcessingProfile engineProfile() const
+    {
+        return voiceCall_ ? ProcessingProfile::kVoip : settings_.profile;
+    }
+
+    void setAutoBypass(bool enabled)
+    {
+        settings_.autoBypass = enabled;
+        if (engine_)
+        {
+            engine_->setAutoBypass(enabled);
+        }
+        if (ShadowBackend* shadow = drainShadow())
+        {
+            shadow->setAutoBypass(enabled);
+        }
+        publishStats();
+    }
+
+    /** @brief Take the sink latency from the output device (EFFECT_CMD_SET_DEVICE) */
+    void setDevice(uint32_t device)
+    {
+        settings_.sinkLatencyMs = deviceSinkLatencyMs(device);
+        applyOutputLatency();
+    }
+
+    /**
+     * @param sinkLatencyMs  Delay after the effect; < 0 keeps the device estimate
+     * @param budgetMs       Total output delay allowed, 0 = engine default
+     * @return 0, or -EINVAL for a negative budget
+     */
+    int setLatencyBudget(float sinkLatencyMs, float budgetMs)
+    {
+        if (!(budgetMs >= 0.0f))
+        {
+            return -EINVAL;
+        }
+        if (sinkLatencyMs >= 0.0f)
+        {
+            settings_.sinkLatencyMs = sinkLatencyMs;
+        }
+        settings_.latencyBudgetMs = budgetMs;
+        applyOutputLatency();
+        return 0;
+    }
+
+    // ── Processing ──────────────────────────────────────────────────────────
+
+    /**
+     * @brief Process @p frames interleaved frames from @p in into @p out
+     *
+     * Both buffers hold samples in the negotiated pcmFormat(). @p out may
+     * alias @p in. Disabled, or without a backend, the input is passed
+     * through. Frames the engine cannot deliver yet (start-up) are
+     * zero-filled and counted as an underrun. The engine runs with
+     * subnormals flushed to zero (DenormalGuard).
+     * @return 0, or -EINVAL for a bad buffer
+     */
+    int process(const void* in, void* out, int frames)
+    {
+        if (!in || !out || frames <= 0)
+        {
+            return -EINVAL;
+        }
+        const size_t frameBytes = bytesPerSample(pcmFormat_) * channels_;
+        if (!enabled_ || !engine_)
+        {
+            if (out != in)
+            {
+                std::memcpy(out, in, static_cast<size_t>(frames) * frameBytes);
+            }
+            return 0;
+        }
+
+        DenormalGuard denormals;  // restores the caller's FP mode on return
+        if (shadow_)
+        {
+            shadow_->begin(in, frames, pcmFormat_);  // before an in-place call overwrites it
+        }
+        const auto t0 = std::chrono::steady_clock::now();
+        const int received = engine_->process(in, out, frames, pcmFormat_);
+        if (received < frames)
+        {
+            // Zero is silence in every integer layout
+            std::memset(static_cast<uint8_t*>(out) + static_cast<size_t>(received) * frameBytes, 0,
+                        static_cast<size_t>(frames - received) * frameBytes);
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - t0;
+        if (shadow_)
+        {
+            shadow_->end(out, received, static_cast<uint64_t>(elapsed.count() * 1.0e6));
+        }
+
+        framesProcessed_ += static_cast<uint64_t>(frames);
+        recordCallback(frames, elapsed.count(), received < frames);
+        return 0;
+    }
+
+    // ── Telemetry ───────────────────────────────────────────────────────────
+
+    /** @brief Content A4 estimate in Hz, 0 = unknown */
+    float referenceHz() const { return engine_ ? engine_->referenceHz() : 0.0f; }
+
+    /** @brief Algorithmic latency of the engine in ms, 0 before the first enable */
+    float latencyMs() const { return engine_ ? engine_->latencyMs() : 0.0f; }
+
+    /** @brief Wall-clock time the last process() call took, in ms */
+    float lastCallbackMs() const { return lastCallbackMs_; }
+
+    /** @brief Last callback's processing time as a percentage of its duration */
+    float cpuPercent() const { return cpuPercent_; }
+
+    uint64_t framesProcessed() const { return framesProcessed_; }
+
+    /** @brief Heap held by the backend and any shadow; the caller adds its own context */
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage = {};
+        if (engine_)
+        {
+            engine_->addMemoryUsage(usage);
+        }
+        if (shadow_)
+        {
+            // The shadow backend's own heap is not visible through the runner
+            const size_t bytes = shadow_->memoryBytes();
+            usage.allocatedBytes += bytes;
+            usage.usedBytes += bytes;
+            usage.peakUsedBytes += bytes;
+        }
+        return usage;
+    }
+
+    /** @brief Release capacity left by bursts; allocates, binder thread only */
+    void shrinkToFit()
+    {
+        if (engine_)
+        {
+            engine_->shrinkToFit();
+        }
+    }
+
+    /** @brief Clear the counters, keeping the instance id */
+    void resetStats()
+    {
+        const uint32_t id = stats_.id;
+        stats_ = InstanceStats();
+        stats_.id = id;
+        framesProcessed_ = 0;
+        lastCallbackMs_ = 0.0f;
+        cpuPercent_ = 0.0f;
+        publishStats();
+    }
+
+private:
+    EffectSettings engineSettings() const
+    {
+        EffectSettings settings = settings_;
+        settings.profile = engineProfile();
+        return settings;
+    }
+
+    void applyOutputLatency()
+    {
+        if (engine_)
+        {
+            engine_->setOutputLatency(settings_.sinkLatencyMs, settings_.latencyBudgetMs);
+        }
+        if (ShadowBackend* shadow = drainShadow())
+        {
+            shadow->setOutputLatency(settings_.sinkLatencyMs, settings_.latencyBudgetMs);
+        }
+    }
+
+    // The shadow backend, once its worker is idle and it can be reconfigured
+    ShadowBackend* drainShadow()
+    {
+        if (!shadow_)
+        {
+            return nullptr;
+        }
+        shadow_->drain();
+        return shadowBackend_;
+    }
+
+    // The backend dropped its audio: the shadow drops its own to stay aligned
+    void restartShadow()
+    {
+        if (shadow_)
+        {
+            shadow_->restart(sampleRate_, channels_);
+        }
+    }
+
+    // Refreshes state and settings in the record and publishes it
+    void publishStats()
+    {
+        if (statsSlot_ < 0)
+        {
+            return;
+        }
+        stats_.flags = (enabled_ ? kStatsEnabled : 0u) |
+                       (engine_ && engine_->isBypassed() ? kStatsAutoBypassed : 0u) |
+                       (engine_ ? kStatsEngineAllocated : 0u) | (shadow_ ? kStatsShadow : 0u);
+        stats_.profile = static_cast<int32_t>(engineProfile());
+        stats_.sampleRate = sampleRate_;
+        stats_.channels = channels_;
+        stats_.tuningHz = referenceHz();
+        const ShadowMetrics shadow = shadowMetrics();
+        stats_.shadowCost = shadow.costRatio;
+        stats_.shadowSnrDb = shadow.snrDb;
+        stats_.shadowCents = shadow.pitchCents;
+        stats_.shadowLag = shadow.lagFrames;
+        stats_.shadowDropped = shadow.dropped;
+        statsPage_->publish(statsSlot_, stats_);
+    }
+
+    void recordCallback(int frames, double elapsedMs, bool underrun)
+    {
+        const double bufferMs = 1000.0 * frames / sampleRate_;
+        const float duty = static_cast<float>(elapsedMs / bufferMs);
+        lastCallbackMs_ = static_cast<float>(elapsedMs);
+        cpuPercent_ = 100.0f * duty;
+
+        if (statsSlot_ < 0)
+        {
+            return;
+        }
+        const uint64_t busyNs = static_cast<uint64_t>(elapsedMs * 1.0e6);
+        stats_.callbacks++;
+        stats_.frames += static_cast<uint64_t>(frames);
+        stats_.underruns += underrun ? 1 : 0;
+        stats_.busyNs += busyNs;
+        stats_.audioNs += static_cast<uint64_t>(bufferMs * 1.0e6);
+        stats_.dutyCycle = duty;
+        stats_.maxDutyCycle = std::max(duty, stats_.maxDutyCycle);
+        stats_.histogram[StatsPage::histogramBucket(busyNs)]++;
+        stats_.latencyMs = engine_->latencyMs();
+        publishStats();
+    }
+
+    EffectSettings settings_;
+    int sampleRate_ = 48000;
+    int channels_ = 2;
+    PcmFormat pcmFormat_ = PcmFormat::kInt16;
+    bool enabled_ = false;
+    bool voiceCall_ = false;
+    std::unique_ptr<Backend> engine_;  // nullptr until the first enable()
+    std::unique_ptr<ShadowRunner> shadow_;
+    ShadowBackend* shadowBackend_ = nullptr;  // engine of shadow_
+
+    float lastCallbackMs_ = 0.0f;
+    float cpuPercent_ = 0.0f;
+    uint64_t framesProcessed_ = 0;
+
+    StatsPage* statsPage_ = nullptr;
+    int statsSlot_ = -1;
+    InstanceStats stats_ = {};
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_EFFECT_CORE_H
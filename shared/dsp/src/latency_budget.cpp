@@ -0,0 +1,91 @@
+#include "latency_budget.h"
+
+#include <SoundTouch.h>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+// Highest quality first. Latencies as reported by SETTING_INITIAL_LATENCY
+// for the 432 Hz shift at 48 kHz, rounded up.
+const LatencyTierSettings TIERS[] = {
+    {80, 25, 12, false, 106.0f},  // kHighQuality
+    {40, 15, 8, false, 56.0f},    // kBalanced
+    {20, 8, 4, true, 28.0f},      // kLowLatency
+    {10, 5, 3, true, 15.0f},      // kMinimum
+};
+
+// audio_devices_t values from system/audio-hal-enums.h
+constexpr uint32_t DEVICE_OUT_BLUETOOTH_SCO_MASK = 0x10u | 0x20u | 0x40u;
+constexpr uint32_t DEVICE_OUT_BLUETOOTH_A2DP_MASK = 0x80u | 0x100u | 0x200u;
+constexpr uint32_t DEVICE_OUT_BLE_HEADSET = 0x20000000u;
+constexpr uint32_t DEVICE_OUT_BLE_SPEAKER = 0x20000001u;
+constexpr uint32_t DEVICE_OUT_BLE_BROADCAST = 0x20000002u;
+
+// See research/CODEC_LATENCY_ANALYSIS.md
+constexpr float SBC_LATENCY_MS = 15.0f;
+constexpr float SCO_LATENCY_MS = 10.0f;
+constexpr float LE_AUDIO_LATENCY_MS = 10.0f;
+
+}  // namespace
+
+const LatencyTierSettings& latencyTierSettings(LatencyTier tier)
+{
+    return TIERS[static_cast<int>(tier)];
+}
+
+LatencyTier chooseLatencyTier(float sinkLatencyMs, float budgetMs)
+{
+    const float remaining = budgetMs - sinkLatencyMs;
+    for (int t = 0; t < static_cast<int>(LatencyTier::kMinimum); t++)
+    {
+        if (TIERS[t].latencyMs <= remaining)
+        {
+            return static_cast<LatencyTier>(t);
+        }
+    }
+    return LatencyTier::kMinimum;
+}
+
+ProcessingProfile effectiveProfile(ProcessingProfile requested, LatencyTier tier)
+{
+    if (latencyTierSettings(tier).lowDelayFilter && requested == ProcessingProfile::kMusic)
+    {
+        return ProcessingProfile::kGame;
+    }
+    return requested;
+}
+
+void applyLatencyTier(soundtouch::SoundTouch& st, LatencyTier tier)
+{
+    const LatencyTierSettings& s = latencyTierSettings(tier);
+    st.setSetting(SETTING_SEQUENCE_MS, s.sequenceMs);
+    st.setSetting(SETTING_SEEKWINDOW_MS, s.seekWindowMs);
+    st.setSetting(SETTING_OVERLAP_MS, s.overlapMs);
+}
+
+float deviceSinkLatencyMs(uint32_t device)
+{
+    // LE Audio types are plain values, not bits of the legacy mask
+    if (device == DEVICE_OUT_BLE_HEADSET || device == DEVICE_OUT_BLE_SPEAKER ||
+        device == DEVICE_OUT_BLE_BROADCAST)
+    {
+        return LE_AUDIO_LATENCY_MS;
+    }
+    if (device & DEVICE_OUT_BLUETOOTH_A2DP_MASK)
+    {
+        return SBC_LATENCY_MS;
+    }
+    if (device & DEVICE_OUT_BLUETOOTH_SCO_MASK)
+    {
+        return SCO_LATENCY_MS;
+    }
+    return 0.0f;
+}
+
+}  // namespace dsp
+}  // namespace audioshift
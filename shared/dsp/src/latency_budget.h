@@ -0,0 +1,70 @@
+#ifndef AUDIOSHIFT_LATENCY_BUDGET_H
+#define AUDIOSHIFT_LATENCY_BUDGET_H
+
+#include "audio_432hz.h"
+
+#include <cstdint>
+
+namespace soundtouch
+{
+class SoundTouch;
+}
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Engine settings of one latency tier
+ *
+ * The WSOLA sequence and seek window dominate the engine's delay: its
+ * latency is about their sum, plus the anti-alias filter's group delay.
+ */
+struct LatencyTierSettings
+{
+    int sequenceMs;
+    int seekWindowMs;
+    int overlapMs;
+    bool lowDelayFilter;  ///< Force a minimum-phase anti-alias filter
+    float latencyMs;      ///< Engine latency, measured at 48 kHz
+};
+
+/** @brief Settings of @p tier */
+const LatencyTierSettings& latencyTierSettings(LatencyTier tier);
+
+/**
+ * @brief Best-quality tier whose engine latency fits what the sink leaves
+ *
+ * @param sinkLatencyMs  Delay added after the effect (codec, radio link)
+ * @param budgetMs       Total output delay the stream can afford
+ * @return The highest tier that fits in budgetMs - sinkLatencyMs, or
+ *         kMinimum if none does
+ */
+LatencyTier chooseLatencyTier(float sinkLatencyMs, float budgetMs);
+
+/**
+ * @brief Anti-alias profile to run with @p tier
+ *
+ * Low-delay tiers replace the linear-phase music filter by the 64-tap
+ * minimum-phase one; the other profiles already are minimum-phase.
+ */
+ProcessingProfile effectiveProfile(ProcessingProfile requested, LatencyTier tier);
+
+/** @brief Apply the WSOLA settings of @p tier; takes effect on the next batch */
+void applyLatencyTier(soundtouch::SoundTouch& st, LatencyTier tier);
+
+/**
+ * @brief Typical delay of an output device after the effect
+ *
+ * @param device  audio_devices_t as passed with EFFECT_CMD_SET_DEVICE
+ * @return Milliseconds; Bluetooth A2DP assumes SBC, the slowest mandatory
+ *         codec, since the device type does not name the codec. Wired,
+ *         USB and built-in outputs return 0.
+ */
+float deviceSinkLatencyMs(uint32_t device);
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_LATENCY_BUDGET_H
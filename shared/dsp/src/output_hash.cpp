@@ -0,0 +1,175 @@
+#include "output_hash.h"
+
+#include <cstring>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// Little-endian loads; memcpy keeps them alignment-safe
+inline uint64_t read64(const uint8_t* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t val)
+{
+    acc ^= round(0, val);
+    return acc * PRIME1 + PRIME4;
+}
+
+// Consumes whole 32-byte stripes, returns the number of bytes used
+size_t consumeStripes(uint64_t acc[4], const uint8_t* p, size_t length)
+{
+    const uint8_t* const start = p;
+    while (length >= 32)
+    {
+        acc[0] = round(acc[0], read64(p));
+        acc[1] = round(acc[1], read64(p + 8));
+        acc[2] = round(acc[2], read64(p + 16));
+        acc[3] = round(acc[3], read64(p + 24));
+        p += 32;
+        length -= 32;
+    }
+    return static_cast<size_t>(p - start);
+}
+
+uint64_t finalize(uint64_t h, const uint8_t* p, size_t length)
+{
+    while (length >= 8)
+    {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+        length -= 8;
+    }
+    if (length >= 4)
+    {
+        h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+        length -= 4;
+    }
+    while (length > 0)
+    {
+        h ^= (*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+        p++;
+        length--;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+}  // namespace
+
+void OutputHash::reset(uint64_t seed)
+{
+    seed_ = seed;
+    acc_[0] = seed + PRIME1 + PRIME2;
+    acc_[1] = seed + PRIME2;
+    acc_[2] = seed;
+    acc_[3] = seed - PRIME1;
+    totalLength_ = 0;
+    pendingLength_ = 0;
+}
+
+void OutputHash::update(const void* data, size_t length)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    totalLength_ += length;
+
+    // Top up a partial stripe left over from the previous call
+    if (pendingLength_ > 0)
+    {
+        const size_t fill = (length < 32 - pendingLength_) ? length : 32 - pendingLength_;
+        std::memcpy(pending_ + pendingLength_, p, fill);
+        pendingLength_ += fill;
+        p += fill;
+        length -= fill;
+        if (pendingLength_ < 32)
+        {
+            return;
+        }
+        consumeStripes(acc_, pending_, 32);
+        pendingLength_ = 0;
+    }
+
+    const size_t used = consumeStripes(acc_, p, length);
+    p += used;
+    length -= used;
+
+    std::memcpy(pending_, p, length);
+    pendingLength_ = length;
+}
+
+uint64_t OutputHash::digest() const
+{
+    uint64_t h;
+    if (totalLength_ >= 32)
+    {
+        h = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) + rotl(acc_[3], 18);
+        for (int i = 0; i < 4; i++)
+        {
+            h = mergeRound(h, acc_[i]);
+        }
+    }
+    else
+    {
+        h = seed_ + PRIME5;
+    }
+    h += totalLength_;
+    return finalize(h, pending_, pendingLength_);
+}
+
+uint64_t OutputHash::hash(const void* data, size_t length, uint64_t seed)
+{
+    OutputHash h(seed);
+    h.update(data, length);
+    return h.digest();
+}
+
+}  // namespace dsp
+}  // namespace audioshift
@@ -0,0 +1,48 @@
+#ifndef AUDIOSHIFT_OUTPUT_HASH_H
+#define AUDIOSHIFT_OUTPUT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Streaming XXH64 hash for comparing audio output against golden runs
+ *
+ * Produces the same digests as the reference xxHash XXH64 for the same
+ * bytes, whether the data arrives in one piece or in arbitrary chunks.
+ * Runs at memory bandwidth, so hashing every output buffer is practically
+ * free compared to the DSP itself.
+ */
+class OutputHash
+{
+public:
+    explicit OutputHash(uint64_t seed = 0) { reset(seed); }
+
+    /** @brief Restart the hash */
+    void reset(uint64_t seed = 0);
+
+    /** @brief Feed @p length bytes */
+    void update(const void* data, size_t length);
+
+    /** @brief Hash of all bytes fed since reset(); does not change state */
+    uint64_t digest() const;
+
+    /** @brief One-shot XXH64 of a single block */
+    static uint64_t hash(const void* data, size_t length, uint64_t seed = 0);
+
+private:
+    uint64_t acc_[4];
+    uint64_t seed_;
+    uint64_t totalLength_;
+    uint8_t pending_[32];
+    size_t pendingLength_;
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_OUTPUT_HASH_H
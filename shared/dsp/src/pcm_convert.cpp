@@ -0,0 +1,489 @@
+#include "pcm_convert.h"
+
+#include <cpu_detect.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(SOUNDTOUCH_ALLOW_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+constexpr size_t FLOATS_PER_LINE = PlanarBuffer::ALIGNMENT / sizeof(float);
+constexpr float INPUT_SCALE = 1.0f / 32768.0f;
+constexpr float OUTPUT_SCALE = 32767.0f;
+
+// Scaling of the 32-bit containers: float = int * in; int = trunc(clamp(float * out))
+struct IntRange
+{
+    float in;
+    float out;
+    float min;
+    float max;
+};
+
+// 24 bits, packed or Q8.23: full scale as for int16, 2^23 - 1
+constexpr IntRange RANGE_24 = {1.0f / 8388608.0f, 8388607.0f, -8388608.0f, 8388607.0f};
+// 2^31 - 1 is not a float; 2147483520 is the largest one below 2^31
+constexpr IntRange RANGE_32 = {1.0f / 2147483648.0f, 2147483648.0f, -2147483648.0f, 2147483520.0f};
+
+inline int16_t toInt16(float sample)
+{
+    sample *= OUTPUT_SCALE;
+    sample = std::max(-32768.0f, std::min(32767.0f, sample));
+    return static_cast<int16_t>(sample);
+}
+
+inline int32_t toInt32(float sample, const IntRange& range)
+{
+    sample *= range.out;
+    sample = std::max(range.min, std::min(range.max, sample));
+    return static_cast<int32_t>(sample);
+}
+
+inline int32_t loadInt24(const uint8_t* p)
+{
+    // Into the top three bytes, then an arithmetic shift sign-extends
+    const uint32_t bits = (static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) |
+                          (static_cast<uint32_t>(p[2]) << 24);
+    return static_cast<int32_t>(bits) >> 8;
+}
+
+inline void storeInt24(int32_t value, uint8_t* p)
+{
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    p[2] = static_cast<uint8_t>(value >> 16);
+}
+
+// ---------------------------------------------------------------------------
+// Scalar kernels (also handle the tails of the SIMD kernels)
+// ---------------------------------------------------------------------------
+
+void int16ToFloatScalar(const int16_t* in, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = in[i] * INPUT_SCALE;
+    }
+}
+
+void floatToInt16Scalar(const float* in, int16_t* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = toInt16(in[i]);
+    }
+}
+
+void int32ToFloatScalar(const int32_t* in, float* out, size_t count, const IntRange& range)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = static_cast<float>(in[i]) * range.in;
+    }
+}
+
+void floatToInt32Scalar(const float* in, int32_t* out, size_t count, const IntRange& range)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = toInt32(in[i], range);
+    }
+}
+
+void int24ToFloatScalar(const uint8_t* in, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = static_cast<float>(loadInt24(in + 3 * i)) * RANGE_24.in;
+    }
+}
+
+void floatToInt24Scalar(const float* in, uint8_t* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        storeInt24(toInt32(in[i], RANGE_24), out + 3 * i);
+    }
+}
+
+void deinterleaveStereoScalar(const int16_t* in, float* left, float* right, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++)
+    {
+        left[i] = in[2 * i] * INPUT_SCALE;
+        right[i] = in[2 * i + 1] * INPUT_SCALE;
+    }
+}
+
+void interleaveStereoScalar(const float* left, const float* right, int16_t* out, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++)
+    {
+        out[2 * i] = toInt16(left[i]);
+        out[2 * i + 1] = toInt16(right[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 kernels, compiled for AVX2 per function and selected at runtime.
+// Rounding and saturation match the scalar kernels bit for bit.
+// ---------------------------------------------------------------------------
+
+#if defined(SOUNDTOUCH_ALLOW_AVX2)
+
+#if defined(__GNUC__)
+#define AUDIOSHIFT_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AUDIOSHIFT_AVX2_TARGET
+#endif
+
+AUDIOSHIFT_AVX2_TARGET inline __m256i toInt32Avx2(__m256 v)
+{
+    v = _mm256_mul_ps(v, _mm256_set1_ps(OUTPUT_SCALE));
+    // min before max so that NaN ends up as +32767 like std::min/std::max
+    v = _mm256_min_ps(v, _mm256_set1_ps(32767.0f));
+    v = _mm256_max_ps(v, _mm256_set1_ps(-32768.0f));
+    return _mm256_cvttps_epi32(v);
+}
+
+AUDIOSHIFT_AVX2_TARGET inline __m256i toInt32Avx2(__m256 v, const IntRange& range)
+{
+    v = _mm256_mul_ps(v, _mm256_set1_ps(range.out));
+    v = _mm256_min_ps(v, _mm256_set1_ps(range.max));
+    v = _mm256_max_ps(v, _mm256_set1_ps(range.min));
+    return _mm256_cvttps_epi32(v);
+}
+
+AUDIOSHIFT_AVX2_TARGET void int16ToFloatAvx2(const int16_t* in, float* out, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(INPUT_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(f, scale));
+    }
+    int16ToFloatScalar(in + i, out + i, count - i);
+}
+
+AUDIOSHIFT_AVX2_TARGET void floatToInt16Avx2(const float* in, int16_t* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i a = toInt32Avx2(_mm256_loadu_ps(in + i));
+        __m256i b = toInt32Avx2(_mm256_loadu_ps(in + i + 8));
+        // packs works per 128-bit lane: [a0-3 b0-3 | a4-7 b4-7] -> restore order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    floatToInt16Scalar(in + i, out + i, count - i);
+}
+
+AUDIOSHIFT_AVX2_TARGET void int32ToFloatAvx2(const int32_t* in, float* out, size_t count, const IntRange& range)
+{
+    const __m256 scale = _mm256_set1_ps(range.in);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    }
+    int32ToFloatScalar(in + i, out + i, count - i, range);
+}
+
+AUDIOSHIFT_AVX2_TARGET void floatToInt32Avx2(const float* in, int32_t* out, size_t count, const IntRange& range)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), toInt32Avx2(_mm256_loadu_ps(in + i), range));
+    }
+    floatToInt32Scalar(in + i, out + i, count - i, range);
+}
+
+AUDIOSHIFT_AVX2_TARGET void int24ToFloatAvx2(const uint8_t* in, float* out, size_t count)
+{
+    // Per lane, sample k's three bytes go to the top of dword k (low byte zero)
+    const __m256i spread = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256 scale = _mm256_set1_ps(RANGE_24.in);
+    size_t i = 0;
+    // Each lane loads 16 bytes for its 12, so stop while 2 samples remain
+    for (; i + 10 <= count; i += 8)
+    {
+        const uint8_t* p = in + 3 * i;
+        __m256i bytes = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+        __m256i s = _mm256_srai_epi32(_mm256_shuffle_epi8(bytes, spread), 8);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    }
+    int24ToFloatScalar(in + 3 * i, out + i, count - i);
+}
+
+AUDIOSHIFT_AVX2_TARGET void floatToInt24Avx2(const float* in, uint8_t* out, size_t count)
+{
+    // Per lane, the low three bytes of each dword into the first 12 bytes
+    const __m256i gather = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i packed = _mm256_shuffle_epi8(toInt32Avx2(_mm256_loadu_ps(in + i), RANGE_24), gather);
+        // Exactly 24 bytes: the rest of an in-place buffer may still be unread
+        uint8_t* p = out + 3 * i;
+        const __m128i lo = _mm256_castsi256_si128(packed);
+        const __m128i hi = _mm256_extracti128_si256(packed, 1);
+        const int32_t loTail = _mm_extract_epi32(lo, 2);
+        const int32_t hiTail = _mm_extract_epi32(hi, 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), lo);
+        std::memcpy(p + 8, &loTail, 4);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p + 12), hi);
+        std::memcpy(p + 20, &hiTail, 4);
+    }
+    floatToInt24Scalar(in + i, out + 3 * i, count - i);
+}
+
+AUDIOSHIFT_AVX2_TARGET void deinterleaveStereoAvx2(const int16_t* in, float* left, float* right, size_t frames)
+{
+    const __m256 scale = _mm256_set1_ps(INPUT_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        // 8 stereo frames: a = frames 0-3, b = frames 4-7, as l r l r ...
+        __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+        __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 8));
+        __m256 a = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s0)), scale);
+        __m256 b = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s1)), scale);
+
+        // per lane: [a0 a2 b0 b2 | a4 a6 b4 b6], then fix the lane order
+        __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        l = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), 0xD8));
+        r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), 0xD8));
+        _mm256_storeu_ps(left + i, l);
+        _mm256_storeu_ps(right + i, r);
+    }
+    deinterleaveStereoScalar(in + 2 * i, left + i, right + i, frames - i);
+}
+
+AUDIOSHIFT_AVX2_TARGET void interleaveStereoAvx2(const float* left, const float* right, int16_t* out, size_t frames)
+{
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m256 l = _mm256_loadu_ps(left + i);
+        __m256 r = _mm256_loadu_ps(right + i);
+        // [l0 r0 l1 r1 | l4 r4 l5 r5] and [l2 r2 l3 r3 | l6 r6 l7 r7];
+        // the per-lane pack then yields frames 0-7 in order
+        __m256i lo = toInt32Avx2(_mm256_unpacklo_ps(l, r));
+        __m256i hi = toInt32Avx2(_mm256_unpackhi_ps(l, r));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_packs_epi32(lo, hi));
+    }
+    interleaveStereoScalar(left + i, right + i, out + 2 * i, frames - i);
+}
+
+#endif  // SOUNDTOUCH_ALLOW_AVX2
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+// ---------------------------------------------------------------------------
+
+struct PcmKernels
+{
+    const char* name;
+    void (*int16ToFloat)(const int16_t*, float*, size_t);
+    void (*floatToInt16)(const float*, int16_t*, size_t);
+    void (*deinterleaveStereo)(const int16_t*, float*, float*, size_t);
+    void (*interleaveStereo)(const float*, const float*, int16_t*, size_t);
+    void (*int32ToFloat)(const int32_t*, float*, size_t, const IntRange&);
+    void (*floatToInt32)(const float*, int32_t*, size_t, const IntRange&);
+    void (*int24ToFloat)(const uint8_t*, float*, size_t);
+    void (*floatToInt24)(const float*, uint8_t*, size_t);
+};
+
+PcmKernels selectKernels()
+{
+#if defined(SOUNDTOUCH_ALLOW_AVX2)
+    if (detectCPUextensions() & SUPPORT_AVX2)
+    {
+        return {"avx2", int16ToFloatAvx2, floatToInt16Avx2, deinterleaveStereoAvx2,
+                interleaveStereoAvx2, int32ToFloatAvx2, floatToInt32Avx2, int24ToFloatAvx2,
+                floatToInt24Avx2};
+    }
+#endif
+    return {"scalar", int16ToFloatScalar, floatToInt16Scalar, deinterleaveStereoScalar,
+            interleaveStereoScalar, int32ToFloatScalar, floatToInt32Scalar, int24ToFloatScalar,
+            floatToInt24Scalar};
+}
+
+const PcmKernels& kernels()
+{
+    static const PcmKernels selected = selectKernels();
+    return selected;
+}
+
+}  // namespace
+
+void PlanarBuffer::reserve(int channels, int frames)
+{
+    if (channels <= channels_ && frames <= frames_)
+    {
+        return;
+    }
+    channels_ = std::max(channels, channels_);
+    frames_ = std::max(frames, frames_);
+
+    // Round each channel up to whole cache lines so every channel stays aligned
+    stride_ = (static_cast<size_t>(frames_) + FLOATS_PER_LINE - 1) & ~(FLOATS_PER_LINE - 1);
+    storage_.assign(stride_ * channels_ + FLOATS_PER_LINE, 0.0f);
+
+    auto addr = reinterpret_cast<uintptr_t>(storage_.data());
+    addr = (addr + ALIGNMENT - 1) & ~static_cast<uintptr_t>(ALIGNMENT - 1);
+    base_ = reinterpret_cast<float*>(addr);
+}
+
+void PlanarBuffer::shrink(int channels, int frames)
+{
+    storage_ = std::vector<float>();
+    base_ = nullptr;
+    stride_ = 0;
+    channels_ = 0;
+    frames_ = 0;
+    if (channels > 0 && frames > 0)
+    {
+        reserve(channels, frames);
+    }
+}
+
+void int16ToFloat(const int16_t* in, float* out, size_t count)
+{
+    kernels().int16ToFloat(in, out, count);
+}
+
+void floatToInt16(const float* in, int16_t* out, size_t count)
+{
+    kernels().floatToInt16(in, out, count);
+}
+
+size_t bytesPerSample(PcmFormat format)
+{
+    switch (format)
+    {
+    case PcmFormat::kInt16:
+        return 2;
+    case PcmFormat::kInt24Packed:
+        return 3;
+    case PcmFormat::kQ8_23:
+    case PcmFormat::kInt32:
+        break;
+    }
+    return 4;
+}
+
+void pcmToFloat(const void* in, PcmFormat format, float* out, size_t count)
+{
+    switch (format)
+    {
+    case PcmFormat::kInt16:
+        kernels().int16ToFloat(static_cast<const int16_t*>(in), out, count);
+        break;
+    case PcmFormat::kInt24Packed:
+        kernels().int24ToFloat(static_cast<const uint8_t*>(in), out, count);
+        break;
+    case PcmFormat::kQ8_23:
+        kernels().int32ToFloat(static_cast<const int32_t*>(in), out, count, RANGE_24);
+        break;
+    case PcmFormat::kInt32:
+        kernels().int32ToFloat(static_cast<const int32_t*>(in), out, count, RANGE_32);
+        break;
+    }
+}
+
+void floatToPcm(const float* in, PcmFormat format, void* out, size_t count)
+{
+    switch (format)
+    {
+    case PcmFormat::kInt16:
+        kernels().floatToInt16(in, static_cast<int16_t*>(out), count);
+        break;
+    case PcmFormat::kInt24Packed:
+        kernels().floatToInt24(in, static_cast<uint8_t*>(out), count);
+        break;
+    case PcmFormat::kQ8_23:
+        kernels().floatToInt32(in, static_cast<int32_t*>(out), count, RANGE_24);
+        break;
+    case PcmFormat::kInt32:
+        kernels().floatToInt32(in, static_cast<int32_t*>(out), count, RANGE_32);
+        break;
+    }
+}
+
+void deinterleaveToFloat(const int16_t* in, int frames, int channels, PlanarBuffer& out)
+{
+    if (channels == 1)
+    {
+        kernels().int16ToFloat(in, out.channel(0), frames);
+    }
+    else if (channels == 2)
+    {
+        kernels().deinterleaveStereo(in, out.channel(0), out.channel(1), frames);
+    }
+    else
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            float* dst = out.channel(c);
+            const int16_t* src = in + c;
+            for (int i = 0; i < frames; i++)
+            {
+                dst[i] = src[static_cast<size_t>(i) * channels] * INPUT_SCALE;
+            }
+        }
+    }
+}
+
+void interleaveToInt16(const PlanarBuffer& in, int frames, int channels, int16_t* out)
+{
+    if (channels == 1)
+    {
+        kernels().floatToInt16(in.channel(0), out, frames);
+    }
+    else if (channels == 2)
+    {
+        kernels().interleaveStereo(in.channel(0), in.channel(1), out, frames);
+    }
+    else
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            const float* src = in.channel(c);
+            int16_t* dst = out + c;
+            for (int i = 0; i < frames; i++)
+            {
+                dst[static_cast<size_t>(i) * channels] = toInt16(src[i]);
+            }
+        }
+    }
+}
+
+const char* pcmKernelName()
+{
+    return kernels().name;
+}
+
+}  // namespace dsp
+}  // namespace audioshift
@@ -0,0 +1,144 @@
+#ifndef AUDIOSHIFT_PCM_CONVERT_H
+#define AUDIOSHIFT_PCM_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Per-channel (planar) float storage with 64-byte aligned channels
+ *
+ * All channels live in one allocation. Each channel starts on a 64-byte
+ * boundary so that SIMD kernels can use full-width aligned loads whatever
+ * the channel count is.
+ */
+class PlanarBuffer
+{
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    /**
+     * @brief Make room for at least @p frames samples in each of @p channels
+     *
+     * Only grows; existing contents are not preserved when it does.
+     */
+    void reserve(int channels, int frames);
+
+    /**
+     * @brief Reallocate to exactly @p frames samples per channel
+     *
+     * Frees the storage for 0 frames. Contents are not preserved.
+     */
+    void shrink(int channels, int frames);
+
+    /** @brief Bytes held by the allocation */
+    size_t capacityBytes() const { return storage_.capacity() * sizeof(float); }
+
+    float* channel(int index)
+    {
+        return base_ + static_cast<size_t>(index) * stride_;
+    }
+
+    const float* channel(int index) const
+    {
+        return base_ + static_cast<size_t>(index) * stride_;
+    }
+
+    /** @brief Capacity of each channel in samples */
+    int frames() const { return frames_; }
+
+private:
+    std::vector<float> storage_;
+    float* base_ = nullptr;
+    size_t stride_ = 0;
+    int channels_ = 0;
+    int frames_ = 0;
+};
+
+/**
+ * @brief Integer PCM sample layouts the DSP input and output stages read and write
+ *
+ * All are little-endian and interleaved. Full scale maps to [-1, 1) in
+ * float; output saturates to the same range.
+ */
+enum class PcmFormat
+{
+    kInt16,        ///< 16-bit
+    kInt24Packed,  ///< 24-bit in 3 bytes
+    kQ8_23,        ///< 24-bit in the low bits of an int32, sign-extended (Android 8.24)
+    kInt32,        ///< 32-bit
+};
+
+/** @brief Bytes one sample of @p format takes */
+size_t bytesPerSample(PcmFormat format);
+
+/**
+ * @brief Convert int16 PCM to float in [-1, 1)
+ * @param in Source samples
+ * @param out Destination, @p count samples
+ * @param count Number of samples (any layout)
+ */
+void int16ToFloat(const int16_t* in, float* out, size_t count);
+
+/**
+ * @brief Convert float to int16 PCM with saturation
+ * @param in Source samples
+ * @param out Destination, @p count samples
+ * @param count Number of samples (any layout)
+ */
+void floatToInt16(const float* in, int16_t* out, size_t count);
+
+/**
+ * @brief Convert interleaved int16 PCM to planar float in one pass
+ * @param in Interleaved input, @p frames * @p channels samples
+ * @param frames Samples per channel
+ * @param channels Channel count
+ * @param out Destination with room for @p frames in each channel
+ */
+void deinterleaveToFloat(const int16_t* in, int frames, int channels, PlanarBuffer& out);
+
+/**
+ * @brief Convert planar float to interleaved int16 PCM with saturation
+ * @param in Planar source
+ * @param frames Samples per channel
+ * @param channels Channel count
+ * @param out Interleaved output, @p frames * @p channels samples
+ */
+void interleaveToInt16(const PlanarBuffer& in, int frames, int channels, int16_t* out);
+
+/**
+ * @brief Convert integer PCM of any PcmFormat to float in [-1, 1)
+ * @param in Source samples
+ * @param format Layout of @p in
+ * @param out Destination, @p count samples
+ * @param count Number of samples (any layout)
+ */
+void pcmToFloat(const void* in, PcmFormat format, float* out, size_t count);
+
+/**
+ * @brief Convert float to integer PCM of any PcmFormat with saturation
+ *
+ * Writes exactly @p count samples, so @p out may be the unread rest of a
+ * buffer that is being converted in place.
+ * @param in Source samples
+ * @param format Layout of @p out
+ * @param out Destination, @p count samples
+ * @param count Number of samples (any layout)
+ */
+void floatToPcm(const float* in, PcmFormat format, void* out, size_t count);
+
+/**
+ * @brief Name of the conversion kernel set picked for this CPU
+ * @return "avx2" or "scalar"
+ */
+const char* pcmKernelName();
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_PCM_CONVERT_H
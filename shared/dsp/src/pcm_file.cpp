@@ -0,0 +1,175 @@
+#include "pcm_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "raw and WAV streams are read and written as host-order int16"
+#endif
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+uint32_t le32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t le16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+void put32(uint8_t* p, uint32_t v)
+{
+    memcpy(p, &v, 4);
+}
+
+void put16(uint8_t* p, uint16_t v)
+{
+    memcpy(p, &v, 2);
+}
+
+
+
+/** Discard @p bytes of input; works on pipes too */
+int skip(int fd, size_t bytes)
+{
+    uint8_t sink[512];
+    while (bytes > 0)
+    {
+        const size_t n = std::min(bytes, sizeof(sink));
+        const ssize_t got = readFull(fd, sink, n);
+        if (got < 0) return static_cast<int>(got);
+        if (static_cast<size_t>(got) < n) return -EINVAL;
+        bytes -= n;
+    }
+    return 0;
+}
+
+}  // namespace
+
+ssize_t readFull(int fd, void* buffer, size_t bytes)
+{
+    size_t done = 0;
+    while (done < bytes)
+    {
+        const ssize_t n = read(fd, static_cast<uint8_t*>(buffer) + done, bytes - done);
+        if (n == 0)
+        {
+            break;
+        }
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(done);
+}
+
+int writeFull(int fd, const void* buffer, size_t bytes)
+{
+    size_t done = 0;
+    while (done < bytes)
+    {
+        const ssize_t n = write(fd, static_cast<const uint8_t*>(buffer) + done, bytes - done);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+int readPcmHeader(int fd, StreamFormat inputFormat, int rawRate, int rawChannels, PcmInput& format)
+{
+    format = PcmInput();
+    format.sampleRate = rawRate;
+    format.channels = rawChannels;
+
+    uint8_t riff[12];
+    const ssize_t got = inputFormat == StreamFormat::kRaw ? 0 : readFull(fd, riff, 12);
+    if (got < 0) return static_cast<int>(got);
+    format.wav = got == 12 && memcmp(riff, "RIFF", 4) == 0 && memcmp(riff + 8, "WAVE", 4) == 0;
+    if (!format.wav)
+    {
+        if (inputFormat == StreamFormat::kWav) return -EINVAL;
+        memcpy(format.prefix, riff, static_cast<size_t>(got));
+        format.prefixBytes = static_cast<size_t>(got);
+    }
+
+    bool haveFmt = false;
+    while (format.wav)
+    {
+        uint8_t chunk[8];
+        if (readFull(fd, chunk, 8) != 8) return -EINVAL;
+        const uint32_t size = le32(chunk + 4);
+        if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!haveFmt) return -EINVAL;
+            // Streaming writers leave the size at 0 or 0xFFFFFFFF
+            format.dataBytes = size == WAV_UNKNOWN_SIZE ? 0 : size;
+            break;
+        }
+        if (memcmp(chunk, "fmt ", 4) == 0)
+        {
+            uint8_t fmt[40];
+            if (size < 16 || size > sizeof(fmt) || readFull(fd, fmt, size + (size & 1)) !=
+                                                       static_cast<ssize_t>(size + (size & 1)))
+            {
+                return -EINVAL;
+            }
+            const uint16_t tag = le16(fmt);
+            // WAVE_FORMAT_EXTENSIBLE: the subformat GUID starts with the tag
+            const bool pcm = tag == 1 || (tag == 0xFFFE && size >= 26 && le16(fmt + 24) == 1);
+            if (!pcm || le16(fmt + 14) != 16) return -EINVAL;
+            format.channels = le16(fmt + 2);
+            format.sampleRate = static_cast<int>(le32(fmt + 4));
+            haveFmt = true;
+        }
+        else
+        {
+            const int err = skip(fd, size + (size & 1));
+            if (err) return err;
+        }
+    }
+
+    if (format.sampleRate < PCM_MIN_SAMPLE_RATE || format.sampleRate > PCM_MAX_SAMPLE_RATE ||
+        format.channels < 1 || format.channels > PCM_MAX_CHANNELS)
+    {
+        return -EINVAL;
+    }
+    return 0;
+}
+
+void makeWavHeader(uint8_t* h, int sampleRate, int channels, uint64_t frames)
+{
+    const uint64_t bytes = frames * channels * sizeof(int16_t);
+    const bool known = frames > 0 && bytes + WAV_HEADER_BYTES - 8 < WAV_UNKNOWN_SIZE;
+    memcpy(h, "RIFF", 4);
+    put32(h + 4, known ? static_cast<uint32_t>(bytes + WAV_HEADER_BYTES - 8) : WAV_UNKNOWN_SIZE);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put32(h + 16, 16);
+    put16(h + 20, 1);
+    put16(h + 22, static_cast<uint16_t>(channels));
+    put32(h + 24, static_cast<uint32_t>(sampleRate));
+    put32(h + 28, static_cast<uint32_t>(sampleRate * channels * sizeof(int16_t)));
+    put16(h + 32, static_cast<uint16_t>(channels * sizeof(int16_t)));
+    put16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put32(h + 40, known ? static_cast<uint32_t>(bytes) : WAV_UNKNOWN_SIZE);
+}
+
+}  // namespace dsp
+}  // namespace audioshift
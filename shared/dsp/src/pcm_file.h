@@ -0,0 +1,64 @@
+#ifndef AUDIOSHIFT_PCM_FILE_H
+#define AUDIOSHIFT_PCM_FILE_H
+
+/**
+ * Raw and WAV 16-bit PCM on file descriptors, for the host tools.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+constexpr int PCM_MIN_SAMPLE_RATE = 8000;
+constexpr int PCM_MAX_SAMPLE_RATE = 192000;
+constexpr int PCM_MAX_CHANNELS = 8;
+constexpr size_t WAV_HEADER_BYTES = 44;
+/** Size fields of a WAV written to a pipe: "until end of stream" */
+constexpr uint32_t WAV_UNKNOWN_SIZE = 0xFFFFFFFFu;
+
+enum class StreamFormat
+{
+    kAuto = 0,  ///< Input: WAV if it starts with a RIFF/WAVE header, else raw. Output: as input
+    kRaw = 1,   ///< Headerless interleaved signed 16-bit little-endian PCM
+    kWav = 2,   ///< RIFF/WAVE with 16-bit PCM samples
+};
+
+/** What readPcmHeader() found */
+struct PcmInput
+{
+    bool wav = false;
+    int sampleRate = 0;
+    int channels = 0;
+    uint64_t dataBytes = 0;  ///< 0: until end of file
+    uint8_t prefix[12];      ///< Raw samples consumed while looking for a header
+    size_t prefixBytes = 0;
+};
+
+/**
+ * @brief Identify the input and consume a WAV header up to the first sample
+ *
+ * Chunks other than "fmt " and "data" are skipped, so the descriptor may
+ * be a pipe. Raw input takes @p rawRate and @p rawChannels; the first
+ * bytes read while checking for a header are returned in the prefix.
+ * @return 0, -EINVAL for a malformed or unsupported input, or -errno
+ */
+int readPcmHeader(int fd, StreamFormat format, int rawRate, int rawChannels, PcmInput& input);
+
+/** @brief Canonical 44-byte WAV header; @p frames 0 writes WAV_UNKNOWN_SIZE */
+void makeWavHeader(uint8_t* header, int sampleRate, int channels, uint64_t frames);
+
+/** @brief Read until @p bytes arrived or end of file; @return bytes read or -errno */
+ssize_t readFull(int fd, void* buffer, size_t bytes);
+
+/** @brief Write all of @p buffer; @return 0 or -errno */
+int writeFull(int fd, const void* buffer, size_t bytes);
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_PCM_FILE_H
@@ -0,0 +1,403 @@
+#include "psola_shifter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+constexpr int ANALYSIS_RATE = 8000;   // the tracker decimates to about this rate
+constexpr float SILENCE_RMS = 1.8e-3f;  // -55 dBFS: quieter input is never voiced
+constexpr float VOICED_ONSET = 0.65f;   // correlation that starts a voiced segment
+constexpr float VOICED_HOLD = 0.45f;    // ... and that keeps it going
+constexpr float PEAK_SHARE = 0.85f;     // shortest lag this close to the best wins
+constexpr double PI = 3.14159265358979323846;
+
+int ringSize(int frames)
+{
+    int size = 1;
+    while (size < frames)
+    {
+        size <<= 1;
+    }
+    return size;
+}
+
+// Normalised cross-correlation of the last 'window' samples of x[0, length)
+// with the same span 'lag' samples earlier
+double correlation(const float* x, int length, int window, int lag)
+{
+    const float* a = x + length - window;
+    const float* b = a - lag;
+    double ab = 0.0;
+    double aa = 0.0;
+    double bb = 0.0;
+    for (int i = 0; i < window; i++)
+    {
+        ab += a[i] * b[i];
+        aa += a[i] * a[i];
+        bb += b[i] * b[i];
+    }
+    return aa > 0.0 && bb > 0.0 ? ab / std::sqrt(aa * bb) : 0.0;
+}
+
+// Vertex of the parabola through three neighbouring values, relative to the middle one
+double parabolicPeak(double left, double centre, double right)
+{
+    const double curvature = left - 2.0 * centre + right;
+    if (curvature >= 0.0)
+    {
+        return 0.0;
+    }
+    return std::max(-0.5, std::min(0.5, 0.5 * (left - right) / curvature));
+}
+
+}  // namespace
+
+PsolaShifter* PsolaShifter::create(int sampleRate, int channels)
+{
+    auto* shifter = new (std::nothrow) PsolaShifter(sampleRate, channels);
+    if (shifter && !shifter->allocate())
+    {
+        delete shifter;
+        return nullptr;
+    }
+    return shifter;
+}
+
+PsolaShifter::PsolaShifter(int sampleRate, int channels)
+    : sampleRate_(sampleRate), channels_(channels)
+{
+    minPeriod_ = static_cast<int>(sampleRate / MAX_F0_HZ);
+    maxPeriod_ = static_cast<int>(std::ceil(sampleRate / MIN_F0_HZ));
+    decimation_ = std::max(1, sampleRate / ANALYSIS_RATE);
+    const double rate = static_cast<double>(sampleRate) / decimation_;
+    minLag_ = std::max(2, static_cast<int>(rate / MAX_F0_HZ));
+    maxLag_ = static_cast<int>(std::ceil(rate / MIN_F0_HZ));
+    window_ = maxLag_;
+    hop_ = std::max(1, sampleRate * HOP_MS / 1000);
+}
+
+PsolaShifter::~PsolaShifter()
+{
+    delete[] memory_;
+}
+
+bool PsolaShifter::allocate()
+{
+    // A grain reads at most one period before its start and runs for two;
+    // the refinement window reaches back two periods and a bit
+    const int inputFrames = ringSize(4 * maxPeriod_ + 4 * decimation_);
+    const int analysisFrames = ringSize(window_ + maxLag_ + 3);
+    const int spanFrames = std::max(window_ + maxLag_ + 2, (window_ + maxLag_ + 2) * decimation_ + 1);
+
+    const size_t inputFloats = static_cast<size_t>(inputFrames) * channels_;
+    memoryFloats_ = inputFloats + analysisFrames + spanFrames + (maxLag_ + 2) + (HANN_SIZE + 1);
+    memory_ = new (std::nothrow) float[memoryFloats_];
+    if (!memory_)
+    {
+        return false;
+    }
+    input_ = memory_;
+    inputMask_ = inputFrames - 1;
+    analysis_ = input_ + inputFloats;
+    analysisMask_ = analysisFrames - 1;
+    span_ = analysis_ + analysisFrames;
+    nccf_ = span_ + spanFrames;
+    hann_ = nccf_ + maxLag_ + 2;
+    for (int k = 0; k <= HANN_SIZE; k++)
+    {
+        const double s = std::sin(PI * k / HANN_SIZE);
+        hann_[k] = static_cast<float>(s * s);
+    }
+    clear();
+    return true;
+}
+
+void PsolaShifter::setPitchSemitones(float semitones)
+{
+    ratio_ = std::max(0.5f, std::min(2.0f, std::exp2(semitones / 12.0f)));
+}
+
+void PsolaShifter::clear()
+{
+    std::fill(input_, input_ + static_cast<size_t>(inputMask_ + 1) * channels_, 0.0f);
+    std::fill(analysis_, analysis_ + analysisMask_ + 1, 0.0f);
+    frames_ = 0;
+    analysisFrames_ = 0;
+    decimationSum_ = 0.0f;
+    decimationCount_ = 0;
+    voiced_ = false;
+    period_ = 0.0;
+    mark_ = 0.0;
+    nextCheck_ = 0;
+    nextGrain_ = 0.0;
+    voicedFrames_ = 0;
+    grainCount_ = 0;
+}
+
+float PsolaShifter::f0Hz() const
+{
+    return voiced_ ? static_cast<float>(sampleRate_ / period_) : 0.0f;
+}
+
+void PsolaShifter::process(const float* in, float* out, int frames)
+{
+    // Each input frame is stored before its output frame is written, so an
+    // aliased buffer is safe
+    for (int i = 0; i < frames; i++)
+    {
+        const float* frame = in + static_cast<size_t>(i) * channels_;
+        const int64_t now = frames_;
+        std::copy(frame, frame + channels_, input_ + static_cast<size_t>(now & inputMask_) * channels_);
+        frames_++;
+        analyse(frame);
+        advanceMarks(now);
+        if (now >= nextGrain_)
+        {
+            startGrain(now);
+        }
+        overlapAdd(now, out + static_cast<size_t>(i) * channels_);
+    }
+}
+
+void PsolaShifter::analyse(const float* frame)
+{
+    float mono = 0.0f;
+    for (int c = 0; c < channels_; c++)
+    {
+        mono += frame[c];
+    }
+    decimationSum_ += mono / channels_;
+    if (++decimationCount_ == decimation_)
+    {
+        analysis_[analysisFrames_ & analysisMask_] = decimationSum_ / decimation_;
+        analysisFrames_++;
+        decimationSum_ = 0.0f;
+        decimationCount_ = 0;
+    }
+}
+
+// Voiced, the pitch is re-estimated at every mark, so the marks follow the
+// period as it moves. Unvoiced, only every hop
+void PsolaShifter::advanceMarks(int64_t now)
+{
+    if (voiced_)
+    {
+        while (voiced_ && mark_ + period_ <= now)
+        {
+            mark_ += period_;
+            trackPitch();
+        }
+        if (!voiced_)
+        {
+            nextCheck_ = now + hop_;
+        }
+    }
+    else if (now >= nextCheck_)
+    {
+        nextCheck_ = now + hop_;
+        trackPitch();
+        if (voiced_)
+        {
+            mark_ = static_cast<double>(now);
+        }
+    }
+    voicedFrames_ += voiced_ ? 1 : 0;
+}
+
+void PsolaShifter::trackPitch()
+{
+    const int length = window_ + maxLag_ + 2;
+    if (analysisFrames_ < length)
+    {
+        voiced_ = false;
+        return;
+    }
+    for (int i = 0; i < length; i++)
+    {
+        span_[i] = analysis_[(analysisFrames_ - length + i) & analysisMask_];
+    }
+
+    // The level gate keeps silence and room noise from costing a search
+    const float* x = span_ + length - window_;
+    double energy = 0.0;
+    for (int i = 0; i < window_; i++)
+    {
+        energy += x[i] * x[i];
+    }
+    if (energy < static_cast<double>(SILENCE_RMS) * SILENCE_RMS * window_)
+    {
+        voiced_ = false;
+        return;
+    }
+
+    // Energy of the lagged span slides by one sample per lag
+    double lagged = 0.0;
+    for (int i = 0; i < window_; i++)
+    {
+        lagged += x[i - minLag_ + 1] * x[i - minLag_ + 1];
+    }
+    float best = 0.0f;
+    for (int lag = minLag_ - 1; lag <= maxLag_ + 1; lag++)
+    {
+        double cross = 0.0;
+        for (int i = 0; i < window_; i++)
+        {
+            cross += x[i] * x[i - lag];
+        }
+        const double r = lagged > 0.0 ? cross / std::sqrt(energy * lagged) : 0.0;
+        nccf_[lag] = static_cast<float>(r);
+        if (lag >= minLag_ && lag <= maxLag_)
+        {
+            best = std::max(best, nccf_[lag]);
+        }
+        lagged += x[-lag - 1] * x[-lag - 1] - x[window_ - lag - 1] * x[window_ - lag - 1];
+    }
+    voiced_ = best >= (voiced_ ? VOICED_HOLD : VOICED_ONSET);
+    if (!voiced_)
+    {
+        return;
+    }
+
+    // Multiples of the period correlate about as well as the period itself:
+    // the shortest lag that nearly matches the best one is the period
+    int lag = minLag_;
+    for (; lag <= maxLag_; lag++)
+    {
+        if (nccf_[lag] >= PEAK_SHARE * best && nccf_[lag] >= nccf_[lag - 1] && nccf_[lag] >= nccf_[lag + 1])
+        {
+            break;
+        }
+    }
+    lag = std::min(lag, maxLag_);
+    const double coarse = (lag + parabolicPeak(nccf_[lag - 1], nccf_[lag], nccf_[lag + 1])) * decimation_;
+    const double period = decimation_ > 1 ? refinePeriod(coarse) : coarse;
+    period_ = std::max(static_cast<double>(minPeriod_) / 2.0,
+                       std::min(static_cast<double>(maxPeriod_ + decimation_), period));
+}
+
+// The decimated estimate is good to a fraction of a decimated sample; the
+// full-rate search around it places the marks to a fraction of a frame
+double PsolaShifter::refinePeriod(double coarse)
+{
+    const int centre = static_cast<int>(std::lround(coarse));
+    const int window = window_ * decimation_;
+    const int length = window + centre + decimation_ + 1;
+    for (int i = 0; i < length; i++)
+    {
+        const float* frame = input_ + static_cast<size_t>((frames_ - length + i) & inputMask_) * channels_;
+        float mono = 0.0f;
+        for (int c = 0; c < channels_; c++)
+        {
+            mono += frame[c];
+        }
+        span_[i] = mono / channels_;
+    }
+
+    int bestLag = centre;
+    double best = -2.0;
+    double left = 0.0;
+    double right = 0.0;
+    double previous = correlation(span_, length, window, centre - decimation_);
+    for (int lag = centre - decimation_ + 1; lag < centre + decimation_; lag++)
+    {
+        const double r = correlation(span_, length, window, lag);
+        if (r > best)
+        {
+            best = r;
+            bestLag = lag;
+            left = previous;
+            right = correlation(span_, length, window, lag + 1);
+        }
+        previous = r;
+    }
+    return bestLag + parabolicPeak(left, best, right);
+}
+
+void PsolaShifter::startGrain(int64_t now)
+{
+    // Unvoiced grains read the input in place: they only carry the
+    // crossfades in and out of voiced segments
+    const double period = voiced_ ? period_ : hop_;
+    const int64_t offset = voiced_ ? now - static_cast<int64_t>(mark_) : 0;
+    if (grainCount_ == MAX_GRAINS)
+    {
+        std::copy(grains_ + 1, grains_ + MAX_GRAINS, grains_);
+        grainCount_--;
+    }
+    grains_[grainCount_++] = {now, offset, 2 * static_cast<int>(std::lround(period))};
+    const double step = voiced_ ? period / ratio_ : period;
+    nextGrain_ = std::max(nextGrain_ + step, static_cast<double>(now + 1));
+}
+
+void PsolaShifter::overlapAdd(int64_t now, float* out)
+{
+    bool inPlace = true;
+    for (int g = 0; g < grainCount_; g++)
+    {
+        inPlace = inPlace && grains_[g].offset == 0;
+    }
+
+    if (inPlace)
+    {
+        const float* frame = input_ + static_cast<size_t>(now & inputMask_) * channels_;
+        std::copy(frame, frame + channels_, out);
+    }
+    else
+    {
+        // Normalising by the summed window keeps the level flat while the
+        // grain spacing differs from the grain period
+        std::fill(out, out + channels_, 0.0f);
+        float weight = 0.0f;
+        for (int g = 0; g < grainCount_; g++)
+        {
+            const Grain& grain = grains_[g];
+            const float pos = static_cast<float>(now - grain.start) * HANN_SIZE / grain.length;
+            const int k = static_cast<int>(pos);
+            const float w = hann_[k] + (pos - k) * (hann_[k + 1] - hann_[k]);
+            const float* frame =
+                    input_ + static_cast<size_t>((now - grain.offset) & inputMask_) * channels_;
+            for (int c = 0; c < channels_; c++)
+            {
+                out[c] += w * frame[c];
+            }
+            weight += w;
+        }
+        if (weight > 1e-3f)
+        {
+            for (int c = 0; c < channels_; c++)
+            {
+                out[c] /= weight;
+            }
+        }
+    }
+
+    // Grains end where their window returns to zero
+    int kept = 0;
+    for (int g = 0; g < grainCount_; g++)
+    {
+        if (now - grains_[g].start + 1 < grains_[g].length)
+        {
+            grains_[kept++] = grains_[g];
+        }
+    }
+    grainCount_ = kept;
+}
+
+void PsolaShifter::addMemoryUsage(soundtouch::MemoryUsage& usage) const
+{
+    const size_t bytes = sizeof(*this) + memoryFloats_ * sizeof(float);
+    usage.allocated += bytes;
+    usage.used += bytes;
+    usage.peakUsed += bytes;
+}
+
+}  // namespace dsp
+}  // namespace audioshift
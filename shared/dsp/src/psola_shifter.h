@@ -0,0 +1,139 @@
+#ifndef AUDIOSHIFT_PSOLA_SHIFTER_H
+#define AUDIOSHIFT_PSOLA_SHIFTER_H
+
+#include <FIFOSamplePipe.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Pitch-synchronous overlap-add (TD-PSOLA) pitch shifter for speech
+ *
+ * The voice engine behind the VoIP profile. A streaming pitch tracker
+ * (normalised autocorrelation on a copy decimated to about 8 kHz, refined
+ * at the full rate) places analysis marks one period apart. Every
+ * 1 / ratio periods a two-period Hann grain is cut at the latest mark and
+ * added to the output, so the voice keeps its timing and formants while
+ * its fundamental moves by the pitch ratio.
+ *
+ * Grains only ever start at marks already heard, so nothing waits for
+ * future input: voiced sound comes out between none and one period late,
+ * half a period on average. Unvoiced sound and silence pass through
+ * unchanged and undelayed; there the tracker only checks the level every
+ * HOP_MS and nothing is resynthesised, so the cost follows the voiced
+ * share of the signal.
+ *
+ * Output has exactly the length of the input. Only create() allocates.
+ */
+class PsolaShifter
+{
+public:
+    static constexpr float MIN_F0_HZ = 75.0f;   ///< Lowest voice tracked
+    static constexpr float MAX_F0_HZ = 500.0f;  ///< Highest voice tracked
+    static constexpr int HOP_MS = 5;            ///< Voicing check interval while unvoiced
+
+    /** @return nullptr if out of memory */
+    static PsolaShifter* create(int sampleRate, int channels);
+
+    ~PsolaShifter();
+
+    PsolaShifter(const PsolaShifter&) = delete;
+    PsolaShifter& operator=(const PsolaShifter&) = delete;
+
+    /** @brief Pitch ratio 2^(semitones / 12), clamped to one octave either way */
+    void setPitchSemitones(float semitones);
+
+    /** @brief Drop the history and restart the tracker */
+    void clear();
+
+    /**
+     * @brief Shift @p frames interleaved frames from @p in into @p out
+     *
+     * Writes exactly @p frames frames; @p out may alias @p in.
+     */
+    void process(const float* in, float* out, int frames);
+
+    /** @brief Mean delay of voiced sound at MIN_F0_HZ: half the longest period */
+    int latencyFrames() const { return maxPeriod_ / 2; }
+
+    /** @brief Tracked fundamental, 0 while unvoiced */
+    float f0Hz() const;
+
+    /** @brief Frames of input processed as voiced since the last clear() */
+    uint64_t voicedFrames() const { return voicedFrames_; }
+
+    int sampleRate() const { return sampleRate_; }
+    int channels() const { return channels_; }
+
+    /** @brief Add the rings and scratch, all sized at creation, to @p usage */
+    void addMemoryUsage(soundtouch::MemoryUsage& usage) const;
+
+private:
+    // One grain being added to the output: it started at output frame
+    // 'start' and reads the input 'offset' frames earlier
+    struct Grain
+    {
+        int64_t start;
+        int64_t offset;
+        int length;
+    };
+    static constexpr int MAX_GRAINS = 8;
+    static constexpr int HANN_SIZE = 512;
+
+    PsolaShifter(int sampleRate, int channels);
+    bool allocate();
+
+    void analyse(const float* frame);
+    void advanceMarks(int64_t now);
+    void trackPitch();
+    double refinePeriod(double coarse);
+    void startGrain(int64_t now);
+    void overlapAdd(int64_t now, float* out);
+
+    int sampleRate_;
+    int channels_;
+    float ratio_ = 1.0f;
+
+    int minPeriod_;  ///< Full-rate frames
+    int maxPeriod_;
+    int decimation_;
+    int minLag_;     ///< Decimated samples
+    int maxLag_;
+    int window_;     ///< Decimated samples correlated per estimate
+    int hop_;
+
+    float* memory_ = nullptr;  ///< Everything below, one allocation
+    float* input_ = nullptr;   ///< Ring of interleaved frames
+    int inputMask_;
+    float* analysis_ = nullptr;  ///< Ring of the decimated mono mix
+    int analysisMask_;
+    float* span_ = nullptr;      ///< Contiguous copy of what one estimate reads
+    float* nccf_ = nullptr;      ///< Correlation by decimated lag
+    float* hann_ = nullptr;      ///< HANN_SIZE + 1 points across the whole window
+    size_t memoryFloats_ = 0;
+
+    int64_t frames_ = 0;          ///< Input frames received
+    int64_t analysisFrames_ = 0;  ///< Decimated samples written
+    float decimationSum_ = 0.0f;
+    int decimationCount_ = 0;
+
+    bool voiced_ = false;
+    double period_ = 0.0;  ///< Full-rate frames while voiced
+    double mark_ = 0.0;    ///< Latest analysis mark while voiced
+    int64_t nextCheck_ = 0;
+    double nextGrain_ = 0.0;
+    uint64_t voicedFrames_ = 0;
+
+    Grain grains_[MAX_GRAINS];
+    int grainCount_ = 0;
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_PSOLA_SHIFTER_H
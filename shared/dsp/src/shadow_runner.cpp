@@ -0,0 +1,503 @@
+#include "shadow_runner.h"
+
+#include "denormal_guard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <time.h>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+constexpr int DECIMATION = 4;            // coarse lag search
+constexpr int64_t SEARCH_MACS_PER_FRAME = 128;  // search budget per frame of input
+constexpr double MIN_CORRELATION = 0.5;  // weaker peaks keep the previous lag
+constexpr double SILENCE = 1e-10;        // mean square below -100 dBFS is not compared
+constexpr double MAX_SNR_DB = 150.0;
+
+int64_t nextPowerOfTwo(int64_t n)
+{
+    int64_t size = 1;
+    while (size < n)
+    {
+        size <<= 1;
+    }
+    return size;
+}
+
+uint64_t nowNs()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+}  // namespace
+
+ShadowRunner* ShadowRunner::create(std::unique_ptr<ShadowEngine> engine, int sampleRate, int channels,
+                                   ShadowMode mode)
+{
+    if (!engine || sampleRate <= 0 || channels <= 0)
+    {
+        return nullptr;
+    }
+    std::unique_ptr<ShadowRunner> runner(new (std::nothrow) ShadowRunner(std::move(engine), mode));
+    if (!runner)
+    {
+        return nullptr;
+    }
+    runner->allocate(sampleRate, channels);
+    if (mode == ShadowMode::kWorker && !runner->startWorker())
+    {
+        return nullptr;
+    }
+    return runner.release();
+}
+
+ShadowRunner::ShadowRunner(std::unique_ptr<ShadowEngine> engine, ShadowMode mode)
+    : engine_(std::move(engine)), mode_(mode)
+{
+}
+
+ShadowRunner::~ShadowRunner()
+{
+    stopWorker();
+}
+
+void ShadowRunner::allocate(int sampleRate, int channels)
+{
+    // The widest PcmFormat takes 4 bytes a sample
+    const size_t bytes = static_cast<size_t>(MAX_FRAMES) * channels * 4;
+    if (slots_.empty())
+    {
+        slots_.resize(mode_ == ShadowMode::kWorker ? QUEUE_DEPTH : 1);
+    }
+    for (Slot& slot : slots_)
+    {
+        slot.in.resize(bytes);
+        slot.out.resize(mode_ == ShadowMode::kWorker ? bytes : 0);
+    }
+    shadowOut_.resize(bytes);
+    scratch_.resize(static_cast<size_t>(MAX_FRAMES) * channels);
+
+    // The ring holds a search window, the lags either side of it, the input
+    // that arrives while the search runs and a call of the largest size
+    const int64_t span = static_cast<int64_t>(sampleRate) * (WINDOW_MS + 2 * SEARCH_MS) / 1000 +
+                         static_cast<int64_t>(sampleRate) / 2 + 2 * MAX_FRAMES;
+    const int64_t ring = nextPowerOfTwo(span);
+    for (Stream* stream : {&production_, &shadow_})
+    {
+        stream->full.assign(static_cast<size_t>(ring), 0.0f);
+        stream->coarse.assign(static_cast<size_t>(ring / DECIMATION), 0.0f);
+        stream->tuning.setSampleRate(sampleRate);
+    }
+    mask_ = ring - 1;
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+    clearComparison();
+}
+
+bool ShadowRunner::startWorker()
+{
+    free_.reset(new (std::nothrow) SpscQueue<Slot*>(QUEUE_DEPTH));
+    filled_.reset(new (std::nothrow) SpscQueue<Slot*>(QUEUE_DEPTH));
+    if (!free_ || !filled_)
+    {
+        return false;
+    }
+    for (Slot& slot : slots_)
+    {
+        free_->push(&slot);
+    }
+    thread_ = std::thread([this] { worker(); });
+    return true;
+}
+
+void ShadowRunner::stopWorker()
+{
+    if (thread_.joinable())
+    {
+        stop_.store(true, std::memory_order_release);
+        thread_.join();
+    }
+}
+
+void ShadowRunner::worker()
+{
+    // FP mode is per thread: the shadow gets what production runs with
+    DenormalGuard denormals;
+    for (int idle = 0;; idle++)
+    {
+        Slot* slot;
+        if (filled_->pop(slot))
+        {
+            run(*slot, slot->out.data());
+            free_->push(slot);
+            completed_.fetch_add(1, std::memory_order_release);
+            idle = 0;
+            continue;
+        }
+        if (stop_.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        // Spin, then yield, then sleep: buffers arrive every few ms
+        if (idle < 64)
+        {
+            continue;
+        }
+        if (idle < 128)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const timespec ts = {0, 200000};
+        nanosleep(&ts, nullptr);
+    }
+}
+
+void ShadowRunner::begin(const void* in, int frames, PcmFormat format)
+{
+    current_ = nullptr;
+    Slot* slot = nullptr;
+    if (frames > 0 && frames <= MAX_FRAMES)
+    {
+        if (mode_ == ShadowMode::kInline)
+        {
+            slot = &slots_[0];
+        }
+        else if (!free_->pop(slot))
+        {
+            slot = nullptr;
+        }
+    }
+    if (!slot)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        dropping_ = true;
+        return;
+    }
+    std::memcpy(slot->in.data(), in, static_cast<size_t>(frames) * channels_ * bytesPerSample(format));
+    slot->frames = frames;
+    slot->format = format;
+    slot->gap = dropping_;
+    dropping_ = false;
+    current_ = slot;
+}
+
+void ShadowRunner::end(const void* out, int received, uint64_t productionNs)
+{
+    Slot* slot = current_;
+    if (!slot)
+    {
+        return;
+    }
+    current_ = nullptr;
+    slot->received = std::max(0, std::min(received, slot->frames));
+    slot->productionNs = productionNs;
+    if (mode_ == ShadowMode::kInline)
+    {
+        run(*slot, out);
+        return;
+    }
+    std::memcpy(slot->out.data(), out,
+                static_cast<size_t>(slot->received) * channels_ * bytesPerSample(slot->format));
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    filled_->push(slot);  // never full: it holds at most the QUEUE_DEPTH slots
+}
+
+void ShadowRunner::drain()
+{
+    if (mode_ != ShadowMode::kWorker)
+    {
+        return;
+    }
+    while (completed_.load(std::memory_order_acquire) < submitted_.load(std::memory_order_relaxed))
+    {
+        const timespec ts = {0, 100000};
+        nanosleep(&ts, nullptr);
+    }
+}
+
+void ShadowRunner::restart(int sampleRate, int channels)
+{
+    drain();
+    engine_->reset();
+    dropping_ = false;
+    if (sampleRate != sampleRate_ || channels != channels_)
+    {
+        allocate(sampleRate, channels);
+        return;
+    }
+    clearComparison();
+}
+
+ShadowMetrics ShadowRunner::metrics() const
+{
+    ShadowMetrics m;
+    m.framesCompared = framesCompared_.load(std::memory_order_relaxed);
+    m.dropped = dropped_.load(std::memory_order_relaxed);
+    m.costRatio = costRatio_.load(std::memory_order_relaxed);
+    m.snrDb = snrDb_.load(std::memory_order_relaxed);
+    m.pitchCents = pitchCents_.load(std::memory_order_relaxed);
+    m.lagFrames = lagFrames_.load(std::memory_order_relaxed);
+    return m;
+}
+
+size_t ShadowRunner::memoryBytes() const
+{
+    size_t bytes = sizeof(*this) + slots_.capacity() * sizeof(Slot) + shadowOut_.capacity() +
+                   scratch_.capacity() * sizeof(float);
+    for (const Slot& slot : slots_)
+    {
+        bytes += slot.in.capacity() + slot.out.capacity();
+    }
+    for (const Stream* stream : {&production_, &shadow_})
+    {
+        bytes += (stream->full.capacity() + stream->coarse.capacity()) * sizeof(float) +
+                 stream->tuning.memoryBytes();
+    }
+    return bytes;
+}
+
+void ShadowRunner::clearComparison()
+{
+    for (Stream* stream : {&production_, &shadow_})
+    {
+        stream->count = 0;
+        stream->coarseSum = 0.0f;
+        stream->tuning.reset();
+    }
+    searchStart_ = -1;
+    searchStage_ = 0;
+    nextSearch_ = 0;
+    aligned_ = false;
+    lag_ = 0;
+    compared_ = 0;
+    signal_ = 0.0;
+    noise_ = 0.0;
+    shadowNs_ = 0;
+    productionNs_ = 0;
+}
+
+void ShadowRunner::run(Slot& slot, const void* productionOut)
+{
+    if (slot.gap)
+    {
+        engine_->reset();
+        clearComparison();
+    }
+    const uint64_t t0 = nowNs();
+    const int got = std::max(0, std::min(engine_->process(slot.in.data(), shadowOut_.data(), slot.frames,
+                                                          slot.format),
+                                         slot.frames));
+    shadowNs_ += nowNs() - t0;
+    productionNs_ += slot.productionNs;
+
+    push(production_, productionOut, slot.received, slot.format);
+    push(shadow_, shadowOut_.data(), got, slot.format);
+
+    if (searchStart_ < 0 && production_.count >= nextSearch_)
+    {
+        // Newest window for which the shadow holds every lag
+        const int64_t window = static_cast<int64_t>(sampleRate_) * WINDOW_MS / 1000;
+        const int64_t maxLag = static_cast<int64_t>(sampleRate_) * SEARCH_MS / 1000;
+        const int64_t start = (std::min(production_.count, shadow_.count - maxLag) - window) &
+                              ~static_cast<int64_t>(DECIMATION - 1);
+        if (start >= maxLag + DECIMATION)
+        {
+            searchStart_ = start;
+            searchStage_ = 0;
+            searchLag_ = -maxLag / DECIMATION;
+            searchBestCorr_ = -1.0;
+        }
+    }
+    if (searchStart_ >= 0)
+    {
+        searchLag(std::max<int64_t>(slot.frames, 1) * SEARCH_MACS_PER_FRAME);
+    }
+    if (aligned_)
+    {
+        compare();
+    }
+
+    if (productionNs_ > 0)
+    {
+        costRatio_.store(static_cast<float>(static_cast<double>(shadowNs_) / productionNs_),
+                         std::memory_order_relaxed);
+    }
+    if (production_.tuning.hasEstimate() && shadow_.tuning.hasEstimate())
+    {
+        pitchCents_.store(1200.0f * std::log2(shadow_.tuning.referenceHz() / production_.tuning.referenceHz()),
+                          std::memory_order_relaxed);
+    }
+}
+
+void ShadowRunner::push(Stream& stream, const void* pcm, int frames, PcmFormat format)
+{
+    if (frames <= 0)
+    {
+        return;
+    }
+    // Mono mix, in place at the front of the scratch buffer
+    pcmToFloat(pcm, format, scratch_.data(), static_cast<size_t>(frames) * channels_);
+    const float scale = 1.0f / channels_;
+    for (int i = 0; i < frames; i++)
+    {
+        float sum = 0.0f;
+        for (int c = 0; c < channels_; c++)
+        {
+            sum += scratch_[static_cast<size_t>(i) * channels_ + c];
+        }
+        scratch_[i] = sum * scale;
+    }
+    stream.tuning.analyze(scratch_.data(), frames, 1);
+
+    const int64_t coarseMask = (mask_ + 1) / DECIMATION - 1;
+    for (int i = 0; i < frames; i++)
+    {
+        const int64_t n = stream.count++;
+        stream.full[n & mask_] = scratch_[i];
+        stream.coarseSum += scratch_[i];
+        if ((n & (DECIMATION - 1)) == DECIMATION - 1)
+        {
+            stream.coarse[(n / DECIMATION) & coarseMask] = stream.coarseSum / DECIMATION;
+            stream.coarseSum = 0.0f;
+        }
+    }
+}
+
+double ShadowRunner::correlate(const std::vector<float>& p, const std::vector<float>& s, int64_t start,
+                               int length, int64_t lag) const
+{
+    const int64_t mask = static_cast<int64_t>(p.size()) - 1;
+    double cross = 0.0;
+    double pp = 0.0;
+    double ss = 0.0;
+    for (int i = 0; i < length; i++)
+    {
+        const double a = p[(start + i) & mask];
+        const double b = s[(start + lag + i) & mask];
+        cross += a * b;
+        pp += a * a;
+        ss += b * b;
+    }
+    if (pp < SILENCE * length || ss < SILENCE * length)
+    {
+        return -1.0;
+    }
+    return cross / std::sqrt(pp * ss);
+}
+
+// One share of the lag search: every coarse lag over ±SEARCH_MS, then the
+// full-rate lags around the best one
+void ShadowRunner::searchLag(int64_t budget)
+{
+    const int64_t window = static_cast<int64_t>(sampleRate_) * WINDOW_MS / 1000;
+    const int64_t maxLag = static_cast<int64_t>(sampleRate_) * SEARCH_MS / 1000;
+
+    // The window may have left the ring if the calls grew meanwhile
+    if (production_.count - searchStart_ > mask_ + 1 || shadow_.count - (searchStart_ - maxLag) > mask_ + 1)
+    {
+        searchStart_ = -1;
+        return;
+    }
+
+    if (searchStage_ == 0)
+    {
+        const int length = static_cast<int>(window / DECIMATION);
+        const int64_t start = searchStart_ / DECIMATION;
+        for (; searchLag_ <= maxLag / DECIMATION && budget > 0; searchLag_++, budget -= length)
+        {
+            const double corr = correlate(production_.coarse, shadow_.coarse, start, length, searchLag_);
+            if (corr > searchBestCorr_)
+            {
+                searchBestCorr_ = corr;
+                searchBest_ = searchLag_ * DECIMATION;
+            }
+        }
+        if (searchLag_ <= maxLag / DECIMATION)
+        {
+            return;
+        }
+        searchStage_ = 1;
+        searchLag_ = searchBest_ - DECIMATION;
+        searchBestCorr_ = -1.0;
+    }
+
+    const int64_t last = searchBest_ + DECIMATION;  // fixed while refining
+    for (; searchLag_ <= last && budget > 0; searchLag_++, budget -= window)
+    {
+        const double corr = correlate(production_.full, shadow_.full, searchStart_, static_cast<int>(window),
+                                      searchLag_);
+        if (corr > searchBestCorr_)
+        {
+            searchBestCorr_ = corr;
+            searchBest_ = searchLag_;
+        }
+    }
+    if (searchLag_ <= last)
+    {
+        return;
+    }
+
+    if (searchBestCorr_ >= MIN_CORRELATION)
+    {
+        if (!aligned_)
+        {
+            compared_ = searchStart_;
+        }
+        aligned_ = true;
+        lag_ = searchBest_;
+        lagFrames_.store(static_cast<int>(lag_), std::memory_order_relaxed);
+    }
+    nextSearch_ = production_.count + sampleRate_;
+    searchStart_ = -1;
+}
+
+// Aligned difference of the samples both outputs now hold
+void ShadowRunner::compare()
+{
+    const int64_t ring = mask_ + 1;
+    const int64_t upTo = std::min(production_.count, shadow_.count - lag_);
+    const int64_t from = std::max({compared_, production_.count - ring, shadow_.count - ring - lag_, -lag_});
+    if (upTo <= from)
+    {
+        return;
+    }
+    double signal = 0.0;
+    double noise = 0.0;
+    for (int64_t n = from; n < upTo; n++)
+    {
+        const double p = production_.full[n & mask_];
+        const double d = p - shadow_.full[(n + lag_) & mask_];
+        signal += p * p;
+        noise += d * d;
+    }
+    const int64_t count = upTo - from;
+    compared_ = upTo;
+    framesCompared_.fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+    if (signal < SILENCE * count)
+    {
+        return;
+    }
+
+    // Average over about a second of audio
+    const double weight = static_cast<double>(count) / (count + sampleRate_);
+    signal_ += weight * (signal / count - signal_);
+    noise_ += weight * (noise / count - noise_);
+    const double snr = noise_ > 0.0 ? 10.0 * std::log10(signal_ / noise_) : MAX_SNR_DB;
+    snrDb_.store(static_cast<float>(std::min(snr, MAX_SNR_DB)), std::memory_order_relaxed);
+}
+
+}  // namespace dsp
+}  // namespace audioshift
@@ -0,0 +1,200 @@
+#ifndef AUDIOSHIFT_SHADOW_RUNNER_H
+#define AUDIOSHIFT_SHADOW_RUNNER_H
+
+#include "audio_432hz.h"
+#include "pcm_convert.h"
+#include "spsc_queue.h"
+#include "tuning_estimator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Engine under evaluation, run beside the production one
+ *
+ * Same process() contract as an EffectCore backend: frames written to the
+ * front of @p out, which may alias @p in.
+ */
+class ShadowEngine
+{
+public:
+    virtual ~ShadowEngine() = default;
+    virtual int process(const void* in, void* out, int frames, PcmFormat format) = 0;
+    /** @brief Drop buffered audio, as after a gap in the input */
+    virtual void reset() = 0;
+};
+
+/**
+ * @brief Feeds a shadow engine the production input and compares outputs
+ *
+ * The audio thread brackets each production call with begin() and end():
+ * begin() copies the input, before an in-place production call overwrites
+ * it; end() takes the production output and its cost. The shadow output
+ * goes to buffers of the runner only and is dropped after the comparison.
+ *
+ * In ShadowMode::kInline the shadow engine and the comparison run inside
+ * end(). In ShadowMode::kWorker buffers travel to a worker thread through
+ * a lock-free queue and the audio thread only copies: with no free buffer
+ * (the worker fell behind) the call is dropped and counted, and the shadow
+ * restarts after the gap. Nothing on the audio thread blocks or allocates.
+ *
+ * Comparison, on the mono mix of either output:
+ * - the lag between them is found by normalised cross-correlation over
+ *   ±SEARCH_MS, coarse on a 4:1 decimated copy and then refined at the
+ *   full rate, spread over the calls and repeated every second to follow
+ *   drift;
+ * - SNR is production power over the power of the aligned difference,
+ *   averaged over about a second;
+ * - pitch deviation compares the concert-pitch reference each output's
+ *   TuningEstimator finds, in cents;
+ * - relative cost is the shadow engine's time over production's.
+ *
+ * Metrics are atomics, readable from any thread.
+ */
+class ShadowRunner
+{
+public:
+    static constexpr int MAX_FRAMES = 8192;  ///< Larger calls are dropped
+    static constexpr int QUEUE_DEPTH = 8;    ///< Buffers in flight to the worker
+    static constexpr int SEARCH_MS = 150;    ///< Largest lag looked for
+    static constexpr int WINDOW_MS = 100;    ///< Production audio correlated per search
+
+    /** @return nullptr if out of memory */
+    static ShadowRunner* create(std::unique_ptr<ShadowEngine> engine, int sampleRate, int channels,
+                                ShadowMode mode);
+
+    /** Stops the worker; queued buffers are dropped */
+    ~ShadowRunner();
+
+    ShadowRunner(const ShadowRunner&) = delete;
+    ShadowRunner& operator=(const ShadowRunner&) = delete;
+
+    /** @brief Audio thread: copy the input of the production call about to run */
+    void begin(const void* in, int frames, PcmFormat format);
+
+    /**
+     * @brief Audio thread: production wrote @p received frames to @p out
+     * @param productionNs Time the production call took
+     */
+    void end(const void* out, int received, uint64_t productionNs);
+
+    /**
+     * @brief Wait until the worker has finished every buffer handed to it
+     *
+     * Not on the audio thread. The engine can then be reconfigured, as long
+     * as no begin()/end() runs meanwhile.
+     */
+    void drain();
+
+    /**
+     * @brief Restart after production changed format or dropped its audio
+     *
+     * Drains, then resets the engine and the comparison. Reallocates the
+     * buffers if the rate or channel count changed.
+     */
+    void restart(int sampleRate, int channels);
+
+    ShadowEngine& engine() { return *engine_; }
+    ShadowMode mode() const { return mode_; }
+
+    ShadowMetrics metrics() const;
+
+    /** @brief Heap held by the buffers and the comparison */
+    size_t memoryBytes() const;
+
+private:
+    /** One production call on its way to the shadow */
+    struct Slot
+    {
+        std::vector<uint8_t> in;
+        std::vector<uint8_t> out;
+        int frames;
+        int received;
+        PcmFormat format;
+        uint64_t productionNs;
+        bool gap;  ///< calls were dropped before this one
+    };
+
+    /** Mono mix of one output, newest RING samples, plus its 4:1 decimation */
+    struct Stream
+    {
+        std::vector<float> full;
+        std::vector<float> coarse;
+        int64_t count;    ///< samples pushed since the restart
+        float coarseSum;  ///< partial decimation sum
+        TuningEstimator tuning;
+    };
+
+    ShadowRunner(std::unique_ptr<ShadowEngine> engine, ShadowMode mode);
+
+    void allocate(int sampleRate, int channels);
+    bool startWorker();
+    void stopWorker();
+    void worker();
+
+    void run(Slot& slot, const void* productionOut);
+    void clearComparison();
+    void push(Stream& stream, const void* pcm, int frames, PcmFormat format);
+    void searchLag(int64_t budget);
+    void compare();
+    double correlate(const std::vector<float>& p, const std::vector<float>& s, int64_t start, int length,
+                     int64_t lag) const;
+
+    std::unique_ptr<ShadowEngine> engine_;
+    const ShadowMode mode_;
+    int sampleRate_ = 0;
+    int channels_ = 0;
+
+    // Audio thread
+    std::vector<Slot> slots_;
+    Slot* current_ = nullptr;  // between begin() and end()
+    bool dropping_ = false;    // a call was dropped since the last queued one
+    std::atomic<uint64_t> submitted_{0};
+
+    // Worker
+    std::unique_ptr<SpscQueue<Slot*>> free_;
+    std::unique_ptr<SpscQueue<Slot*>> filled_;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> completed_{0};
+
+    // Comparison, on whichever thread runs the shadow
+    std::vector<uint8_t> shadowOut_;
+    std::vector<float> scratch_;  // float samples, then their mono mix
+    Stream production_;
+    Stream shadow_;
+    int64_t mask_ = 0;          // ring size - 1
+    int64_t searchLag_ = 0;     // next lag to score, coarse samples then full
+    int64_t searchStart_ = -1;  // window start in production samples, -1 idle
+    int searchStage_ = 0;       // 0 coarse, 1 fine
+    int64_t searchBest_ = 0;
+    double searchBestCorr_ = 0.0;
+    int64_t nextSearch_ = 0;  // production sample count to start the next one at
+    bool aligned_ = false;
+    int64_t lag_ = 0;       // shadow sample n + lag_ matches production sample n
+    int64_t compared_ = 0;  // next production sample to compare
+    double signal_ = 0.0;
+    double noise_ = 0.0;
+    uint64_t shadowNs_ = 0;
+    uint64_t productionNs_ = 0;
+
+    std::atomic<uint64_t> framesCompared_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<float> costRatio_{0.0f};
+    std::atomic<float> snrDb_{0.0f};
+    std::atomic<float> pitchCents_{0.0f};
+    std::atomic<int> lagFrames_{0};
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_SHADOW_RUNNER_H
@@ -0,0 +1,453 @@
+#include "soundtouch_backend.h"
+
+#include "pcm_convert.h"
+#include "psola_shifter.h"
+#include "stream_switch.h"
+#include "tuning_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <SoundTouch.h>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+// Content already tuned to this A4 reference is passed through
+constexpr float TARGET_REFERENCE_HZ = 432.0f;
+
+}  // namespace
+
+SoundTouchBackend* SoundTouchBackend::create(int sampleRate, int channels,
+                                             const EffectSettings& settings)
+{
+    auto* st = new (std::nothrow) soundtouch::SoundTouch();
+    auto* tuning = new (std::nothrow) TuningEstimator(sampleRate);
+    auto* scratch = new (std::nothrow) float[static_cast<size_t>(BLOCK_FRAMES) * channels];
+    auto* streamSwitch = StreamSwitch::create(sampleRate, channels);
+    SoundTouchBackend* backend = st && tuning && scratch && streamSwitch
+                                     ? new (std::nothrow) SoundTouchBackend(st, tuning, scratch, streamSwitch)
+                                     : nullptr;
+    if (!backend)
+    {
+        delete st;
+        delete tuning;
+        delete[] scratch;
+        delete streamSwitch;
+        return nullptr;
+    }
+
+    st->setSetting(SETTING_USE_QUICKSEEK, 1);  // lower latency
+    st->setSetting(SETTING_USE_AA_FILTER, 1);
+    st->setSetting(SETTING_SPREAD_SEEK, 1);    // even cost per callback
+    st->setSetting(SETTING_ADAPTIVE_SEQUENCE, 1);  // fewer searches on sustained material
+    st->setSetting(SETTING_INTERPOLATION, static_cast<int>(settings.interpolator));
+    st->setChannels(static_cast<uint>(channels));
+    st->setSampleRate(static_cast<uint>(sampleRate));
+    st->setPitchSemiTones(settings.pitchSemitones);
+    backend->sampleRate_ = sampleRate;
+    backend->channels_ = channels;
+    backend->pitchSemitones_ = settings.pitchSemitones;
+    backend->profile_ = settings.profile;
+    backend->autoBypass_ = settings.autoBypass;
+    backend->setOutputLatency(settings.sinkLatencyMs, settings.latencyBudgetMs);
+    backend->applyLatency();
+    backend->configureVoice();
+    return backend;
+}
+
+SoundTouchBackend::SoundTouchBackend(soundtouch::SoundTouch* st, TuningEstimator* tuning,
+                                     float* scratch, StreamSwitch* streamSwitch)
+    : st_(st), tuning_(tuning), scratch_(scratch), streamSwitch_(streamSwitch)
+{
+}
+
+SoundTouchBackend::~SoundTouchBackend()
+{
+    delete st_;
+    delete tuning_;
+    delete[] scratch_;
+    delete streamSwitch_;
+    delete voice_;
+}
+
+bool SoundTouchBackend::setFormat(int sampleRate, int channels, const EffectSettings& settings)
+{
+    if (channels == channels_)
+    {
+        if (sampleRate != sampleRate_)
+        {
+            switchStream(sampleRate, latencyTier_);
+            tuning_->setSampleRate(sampleRate);
+            autoBypassed_ = false;
+        }
+        pitchSemitones_ = settings.pitchSemitones;
+        st_->setPitchSemiTones(settings.pitchSemitones);
+        if (voice_)
+        {
+            voice_->setPitchSemitones(settings.pitchSemitones);
+        }
+        return true;
+    }
+
+    // Input in another channel layout cannot re-prime the engine: restart
+    StreamSwitch* streamSwitch = StreamSwitch::create(sampleRate, channels);
+    float* scratch = channels > channels_
+                         ? new (std::nothrow) float[static_cast<size_t>(BLOCK_FRAMES) * channels]
+                         : nullptr;
+    if (!streamSwitch || (channels > channels_ && !scratch))
+    {
+        delete streamSwitch;
+        delete[] scratch;
+        return false;
+    }
+    delete streamSwitch_;
+    streamSwitch_ = streamSwitch;
+    if (scratch)
+    {
+        delete[] scratch_;
+        scratch_ = scratch;
+    }
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+    pitchSemitones_ = settings.pitchSemitones;
+    st_->setSampleRate(static_cast<uint>(sampleRate));
+    st_->setChannels(static_cast<uint>(channels));
+    st_->setPitchSemiTones(settings.pitchSemitones);
+    st_->clear();
+    configureVoice();
+    tuning_->setSampleRate(sampleRate);
+    autoBypassed_ = false;
+    return true;
+}
+
+void SoundTouchBackend::reset()
+{
+    clear();
+}
+
+void SoundTouchBackend::clear()
+{
+    st_->clear();
+    if (voice_)
+    {
+        voice_->clear();
+    }
+    if (streamSwitch_)
+    {
+        streamSwitch_->cancel();
+    }
+}
+
+int SoundTouchBackend::backlogFrames() const
+{
+    if (voice_)
+    {
+        return voice_->latencyFrames();
+    }
+    return st_->getSetting(SETTING_INITIAL_LATENCY) + static_cast<int>(st_->numSamples());
+}
+
+void SoundTouchBackend::switchStream(int newRate, int newTier)
+{
+    const double step = static_cast<double>(sampleRate_) / newRate;
+    const bool running = !autoBypassed_ && streamSwitch_;
+    const bool retune = newTier != latencyTier_;
+
+    // What the old engine would have played next: its buffered audio,
+    // pushed out by silence
+    const int oldBacklog = running ? backlogFrames() : 0;
+    if (running)
+    {
+        float* tail = streamSwitch_->tail();
+        const int tailFrames = streamSwitch_->tailFrames();
+        const size_t tailSamples = static_cast<size_t>(tailFrames) * channels_;
+        std::fill(tail, tail + tailSamples, 0.0f);
+        if (voice_)
+        {
+            voice_->process(tail, tail, tailFrames);
+        }
+        else
+        {
+            st_->putSamples(tail, static_cast<uint>(tailFrames));
+            const uint got = st_->receiveSamples(tail, static_cast<uint>(tailFrames));
+            std::fill(tail + static_cast<size_t>(got) * channels_, tail + tailSamples, 0.0f);
+        }
+    }
+    if (streamSwitch_ && !streamSwitch_->begin(newRate, running))
+    {
+        delete streamSwitch_;  // this and later changes restart the stream
+        streamSwitch_ = nullptr;
+    }
+
+    sampleRate_ = newRate;
+    latencyTier_ = newTier;
+    st_->setSampleRate(static_cast<uint>(newRate));
+    if (retune)
+    {
+        applyLatency();
+    }
+    configureVoice();  // clears the engine
+    if (!running || !streamSwitch_)
+    {
+        return;
+    }
+
+    // Re-prime with the recent input at the new rate, then drop as much of
+    // the output as leaves the engine trailing the input by the old
+    // backlog, at the splice that lines up with the old continuation (see
+    // Audio432HzConverter::Impl::switchStream)
+    // The voice engine queues nothing, so its output already lines up
+    const int16_t* recent = streamSwitch_->recent();
+    const int frames = streamSwitch_->recentFrames();
+    for (int done = 0; done < frames;)
+    {
+        const int n = std::min(BLOCK_FRAMES, frames - done);
+        int16ToFloat(recent + static_cast<size_t>(done) * channels_, scratch_, static_cast<size_t>(n) * channels_);
+        if (voice_)
+        {
+            voice_->process(scratch_, scratch_, n);
+        }
+        else
+        {
+            st_->putSamples(scratch_, static_cast<uint>(n));
+        }
+        done += n;
+    }
+    if (voice_)
+    {
+        return;
+    }
+    const int keep = retune ? 0
+                            : static_cast<int>(std::lround(oldBacklog / step)) -
+                                      st_->getSetting(SETTING_INITIAL_LATENCY);
+    // Output peek through the pipe interface, as FIFOSamplePipe::moveSamples does
+    const float* queued = static_cast<soundtouch::FIFOSamplePipe&>(*st_).ptrBegin();
+    const int queuedFrames = static_cast<int>(st_->numSamples());
+    const int drop = streamSwitch_->align(queued, queuedFrames, channels_, queuedFrames - std::max(0, keep));
+    st_->receiveSamples(static_cast<uint>(drop));
+}
+
+void SoundTouchBackend::setPitchSemitones(float semitones)
+{
+    pitchSemitones_ = semitones;
+    st_->setPitchSemiTones(semitones);
+    if (voice_)
+    {
+        voice_->setPitchSemitones(semitones);
+    }
+}
+
+bool SoundTouchBackend::setInterpolator(Interpolator interpolator)
+{
+    return st_->setSetting(SETTING_INTERPOLATION, static_cast<int>(interpolator));
+}
+
+void SoundTouchBackend::setProfile(ProcessingProfile profile)
+{
+    profile_ = profile;
+    applyLatency();
+    configureVoice();
+}
+
+void SoundTouchBackend::setOutputLatency(float sinkLatencyMs, float budgetMs)
+{
+    const int tier = budgetMs > 0.0f ? static_cast<int>(chooseLatencyTier(sinkLatencyMs, budgetMs)) : -1;
+    if (tier == latencyTier_)
+    {
+        return;
+    }
+    // SoundTouch adopts new sequence lengths on the fly, but its backlog
+    // would keep the old delay, so a running stream is re-primed
+    if (st_->numSamples() == 0 && st_->numUnprocessedSamples() == 0)
+    {
+        latencyTier_ = tier;
+        applyLatency();
+        return;
+    }
+    switchStream(sampleRate_, tier);
+}
+
+void SoundTouchBackend::setAutoBypass(bool enabled)
+{
+    autoBypass_ = enabled;
+    if (!enabled && autoBypassed_)
+    {
+        autoBypassed_ = false;
+        clear();
+    }
+    tuning_->reset();
+}
+
+void SoundTouchBackend::applyLatency()
+{
+    ProcessingProfile aa = profile_;
+    if (latencyTier_ < 0)
+    {
+        st_->setSetting(SETTING_SEQUENCE_MS, 0);
+        st_->setSetting(SETTING_SEEKWINDOW_MS, 0);
+        st_->setSetting(SETTING_OVERLAP_MS, 8);
+    }
+    else
+    {
+        const auto tier = static_cast<LatencyTier>(latencyTier_);
+        applyLatencyTier(*st_, tier);
+        aa = effectiveProfile(profile_, tier);
+    }
+    // VoIP and game trade linear phase for a minimum-phase filter's short delay
+    st_->setSetting(SETTING_AA_FILTER_LENGTH, aa == ProcessingProfile::kVoip ? 32 : 64);
+    st_->setSetting(SETTING_AA_FILTER_MINIMUM_PHASE, aa != ProcessingProfile::kMusic);
+    // The search follows the requested profile: music on a short tier keeps it exact
+    st_->setSetting(SETTING_FAST_SEEK, profile_ != ProcessingProfile::kMusic);
+}
+
+void SoundTouchBackend::configureVoice()
+{
+    delete voice_;
+    voice_ = nullptr;
+    if (profile_ == ProcessingProfile::kVoip)
+    {
+        voice_ = PsolaShifter::create(sampleRate_, channels_);
+        if (voice_)
+        {
+            voice_->setPitchSemitones(pitchSemitones_);
+        }
+    }
+    st_->clear();
+}
+
+void SoundTouchBackend::readBlock(const uint8_t* in, PcmFormat format, int frames)
+{
+    const size_t samples = static_cast<size_t>(frames) * channels_;
+    pcmToFloat(in, format, scratch_, samples);
+    if (streamSwitch_)
+    {
+        streamSwitch_->remember(scratch_, frames);
+    }
+    if (autoBypass_)
+    {
+        tuning_->analyze(scratch_, frames, channels_);
+    }
+}
+
+int SoundTouchBackend::process(const void* in, void* out, int frames, PcmFormat format)
+{
+    const size_t frameBytes = bytesPerSample(format) * channels_;
+    const auto* src = static_cast<const uint8_t*>(in);
+    auto* dst = static_cast<uint8_t*>(out);
+
+    // Auto-bypass: same transitions as disabling and enabling the effect.
+    // The analysis rides on the input conversion, so the decision is made
+    // on everything up to the previous callback
+    if (autoBypass_)
+    {
+        const bool matched = tuning_->matchesReference(TARGET_REFERENCE_HZ, autoBypassed_);
+        if (matched != autoBypassed_)
+        {
+            autoBypassed_ = matched;
+            clear();
+        }
+        if (autoBypassed_)
+        {
+            for (int done = 0; done < frames;)
+            {
+                const int n = std::min(BLOCK_FRAMES, frames - done);
+                readBlock(src + static_cast<size_t>(done) * frameBytes, format, n);
+                done += n;
+            }
+            if (out != in)
+            {
+                std::memcpy(dst, src, static_cast<size_t>(frames) * frameBytes);
+            }
+            return frames;
+        }
+    }
+
+    if (voice_)
+    {
+        for (int done = 0; done < frames;)
+        {
+            const int n = std::min(BLOCK_FRAMES, frames - done);
+            const size_t offset = static_cast<size_t>(done) * frameBytes;
+            readBlock(src + offset, format, n);
+            voice_->process(scratch_, scratch_, n);
+            if (streamSwitch_ && streamSwitch_->fading())
+            {
+                streamSwitch_->apply(scratch_, n);
+            }
+            floatToPcm(scratch_, format, dst + offset, static_cast<size_t>(n) * channels_);
+            done += n;
+        }
+        return frames;
+    }
+
+    // Output never overtakes input, so an aliased buffer is only written
+    // where it has already been read
+    int written = 0;
+    for (int done = 0; done < frames;)
+    {
+        const int n = std::min(BLOCK_FRAMES, frames - done);
+        readBlock(src + static_cast<size_t>(done) * frameBytes, format, n);
+        st_->putSamples(scratch_, static_cast<uint>(n));
+        done += n;
+
+        while (written < done)
+        {
+            const int want = std::min(BLOCK_FRAMES, done - written);
+            const int got = static_cast<int>(st_->receiveSamples(scratch_, static_cast<uint>(want)));
+            if (got == 0)
+            {
+                break;
+            }
+            if (streamSwitch_ && streamSwitch_->fading())
+            {
+                streamSwitch_->apply(scratch_, got);
+            }
+            floatToPcm(scratch_, format, dst + static_cast<size_t>(written) * frameBytes,
+                       static_cast<size_t>(got) * channels_);
+            written += got;
+        }
+    }
+    return written;
+}
+
+float SoundTouchBackend::referenceHz() const
+{
+    return tuning_->referenceHz();
+}
+
+float SoundTouchBackend::latencyMs() const
+{
+    const int frames = voice_ ? voice_->latencyFrames() : st_->getSetting(SETTING_INITIAL_LATENCY);
+    return 1000.0f * frames / sampleRate_;
+}
+
+void SoundTouchBackend::addMemoryUsage(MemoryUsage& usage) const
+{
+    soundtouch::MemoryUsage st = {};
+    st_->addMemoryUsage(st);
+    if (voice_)
+    {
+        voice_->addMemoryUsage(st);
+    }
+    const size_t fixed = sizeof(*this) + tuning_->memoryBytes() +
+                         static_cast<size_t>(BLOCK_FRAMES) * channels_ * sizeof(float) +
+                         (streamSwitch_ ? streamSwitch_->memoryBytes() : 0);
+    usage.allocatedBytes += st.allocated + fixed;
+    usage.usedBytes += st.used + fixed;
+    usage.peakUsedBytes += st.peakUsed + fixed;
+}
+
+void SoundTouchBackend::shrinkToFit()
+{
+    st_->shrinkToFit();
+}
+
+}  // namespace dsp
+}  // namespace audioshift
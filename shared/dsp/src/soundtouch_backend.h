@@ -0,0 +1,106 @@
+#ifndef AUDIOSHIFT_SOUNDTOUCH_BACKEND_H
+#define AUDIOSHIFT_SOUNDTOUCH_BACKEND_H
+
+#include "effect_core.h"
+
+#include <cstdint>
+
+namespace soundtouch
+{
+class SoundTouch;
+}
+
+namespace audioshift
+{
+namespace dsp
+{
+
+class PsolaShifter;
+class StreamSwitch;
+class TuningEstimator;
+
+/**
+ * @brief EffectCore backend driving one bare interleaved SoundTouch engine
+ *
+ * No band split, and a new channel count restarts the stream. Sample rate
+ * and latency tier changes keep it running through the converter's
+ * StreamSwitch (stream_switch.h); without the memory for a switch they
+ * restart it too. Without a latency budget
+ * the engine runs on SoundTouch's own defaults (automatic sequence and
+ * seek window). Auto-bypass switches hard, clearing the engine. The VoIP
+ * profile runs the pitch-synchronous voice engine (psola_shifter.h)
+ * instead, allocated when the profile is selected; without the memory for
+ * it the SoundTouch engine carries on.
+ *
+ * Buffers of any size and PcmFormat are processed in blocks of BLOCK_FRAMES
+ * through one float scratch block; the format conversion is the only pass
+ * over the integer samples, and the tuning analysis reads its output.
+ */
+class SoundTouchBackend
+{
+public:
+    static constexpr int BLOCK_FRAMES = 1024;
+
+    static SoundTouchBackend* create(int sampleRate, int channels, const EffectSettings& settings);
+
+    ~SoundTouchBackend();
+
+    SoundTouchBackend(const SoundTouchBackend&) = delete;
+    SoundTouchBackend& operator=(const SoundTouchBackend&) = delete;
+
+    bool setFormat(int sampleRate, int channels, const EffectSettings& settings);
+    void reset();
+    void setPitchSemitones(float semitones);
+    bool setInterpolator(Interpolator interpolator);
+    void setProfile(ProcessingProfile profile);
+    void setOutputLatency(float sinkLatencyMs, float budgetMs);
+    void setAutoBypass(bool enabled);
+
+    static bool supportsFormat(PcmFormat) { return true; }
+    int process(const void* in, void* out, int frames, PcmFormat format);
+
+    bool isBypassed() const { return autoBypassed_; }
+    float referenceHz() const;
+    float latencyMs() const;
+    void addMemoryUsage(MemoryUsage& usage) const;
+    void shrinkToFit();
+
+private:
+    SoundTouchBackend(soundtouch::SoundTouch* st, TuningEstimator* tuning, float* scratch,
+                      StreamSwitch* streamSwitch);
+
+    // Sequence lengths and anti-alias filter for the tier and profile
+    void applyLatency();
+
+    // Creates or drops the voice engine to match the profile and format
+    void configureVoice();
+
+    void clear();
+
+    // Moves a running stream to a new rate and/or tier (StreamSwitch)
+    void switchStream(int newRate, int newTier);
+
+    // Frames the output trails the input by, queued output included
+    int backlogFrames() const;
+
+    // Converts one block of input into the scratch and feeds the tuning analysis
+    void readBlock(const uint8_t* in, PcmFormat format, int frames);
+
+    soundtouch::SoundTouch* st_;
+    TuningEstimator* tuning_;
+    float* scratch_;  // BLOCK_FRAMES * channels_
+    StreamSwitch* streamSwitch_;     // nullptr once a switch ran out of memory
+    PsolaShifter* voice_ = nullptr;  // VoIP profile only
+    int sampleRate_ = 0;
+    int channels_ = 0;
+    float pitchSemitones_ = PITCH_SEMITONES_432_HZ;
+    ProcessingProfile profile_ = ProcessingProfile::kMusic;
+    int latencyTier_ = -1;  // LatencyTier, -1 = SoundTouch defaults
+    bool autoBypass_ = true;
+    bool autoBypassed_ = false;
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_SOUNDTOUCH_BACKEND_H
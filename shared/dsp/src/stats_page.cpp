@@ -0,0 +1,209 @@
+#include "stats_page.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+// Readers give up on a slot that stays busy this long; a write takes well
+// under a microsecond, so hitting this means the writer died mid-update
+constexpr int READ_RETRIES = 1000;
+
+int createMemfd()
+{
+#ifdef SYS_memfd_create
+    return static_cast<int>(syscall(SYS_memfd_create, "audioshift_stats", 0));
+#else
+    return -1;
+#endif
+}
+
+}  // namespace
+
+StatsPage::StatsPage(Layout* layout, int fd, bool writable, bool fileBacked)
+    : layout_(layout),
+      fd_(fd),
+      writable_(writable),
+      fileBacked_(fileBacked)
+{
+}
+
+StatsPage::~StatsPage()
+{
+    munmap(layout_, sizeof(Layout));
+    close(fd_);
+}
+
+StatsPage* StatsPage::create(const char* path)
+{
+    bool fileBacked = false;
+    int fd = -1;
+    if (path)
+    {
+        fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        // umask must not keep the monitoring app out
+        if (fd >= 0)
+        {
+            fchmod(fd, 0644);
+            fileBacked = true;
+        }
+    }
+    if (fd < 0)
+    {
+        fd = createMemfd();
+    }
+    if (fd < 0 || ftruncate(fd, sizeof(Layout)) != 0)
+    {
+        if (fd >= 0) close(fd);
+        return nullptr;
+    }
+
+    void* mem = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // A page left by a previous audioserver holds dead instances: start over.
+    // The magic goes in last so readers never accept a half-initialised page.
+    Layout* layout = static_cast<Layout*>(mem);
+    std::memset(static_cast<void*>(layout), 0, sizeof(Layout));
+    layout->version = STATS_PAGE_VERSION;
+    layout->size = sizeof(Layout);
+    layout->maxInstances = STATS_MAX_INSTANCES;
+    std::atomic_thread_fence(std::memory_order_release);
+    layout->magic = STATS_PAGE_MAGIC;
+
+    return new StatsPage(layout, fd, true, fileBacked);
+}
+
+StatsPage* StatsPage::openReadOnly(const char* path)
+{
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Layout)))
+    {
+        close(fd);
+        return nullptr;
+    }
+    void* mem = mmap(nullptr, sizeof(Layout), PROT_READ, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    Layout* layout = static_cast<Layout*>(mem);
+    if (layout->magic != STATS_PAGE_MAGIC || layout->version != STATS_PAGE_VERSION ||
+        layout->size != sizeof(Layout) || layout->maxInstances != STATS_MAX_INSTANCES)
+    {
+        munmap(mem, sizeof(Layout));
+        close(fd);
+        return nullptr;
+    }
+    return new StatsPage(layout, fd, false, true);
+}
+
+int StatsPage::acquireSlot(uint32_t& id)
+{
+    if (!writable_)
+    {
+        id = 0;
+        return -1;
+    }
+    id = static_cast<uint32_t>(layout_->global.instancesCreated.fetch_add(1) + 1);
+    for (int slot = 0; slot < STATS_MAX_INSTANCES; slot++)
+    {
+        uint32_t expected = 0;
+        if (layout_->slots[slot].owned.compare_exchange_strong(expected, 1))
+        {
+            layout_->global.liveInstances.fetch_add(1);
+            InstanceStats stats = {};
+            stats.id = id;
+            publish(slot, stats);
+            return slot;
+        }
+    }
+    layout_->global.droppedInstances.fetch_add(1);
+    return -1;
+}
+
+void StatsPage::releaseSlot(int slot)
+{
+    if (!writable_ || slot < 0 || slot >= STATS_MAX_INSTANCES)
+    {
+        return;
+    }
+    const InstanceStats freed = {};
+    publish(slot, freed);
+    layout_->global.liveInstances.fetch_sub(1);
+    layout_->slots[slot].owned.store(0, std::memory_order_release);
+}
+
+void StatsPage::publish(int slot, const InstanceStats& stats)
+{
+    if (!writable_ || slot < 0 || slot >= STATS_MAX_INSTANCES)
+    {
+        return;
+    }
+    Slot& s = layout_->slots[slot];
+    const uint32_t seq = s.sequence.load(std::memory_order_relaxed);
+    s.sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&s.stats, &stats, sizeof(stats));
+    s.sequence.store(seq + 2, std::memory_order_release);
+}
+
+bool StatsPage::read(int slot, InstanceStats& out) const
+{
+    if (slot < 0 || slot >= STATS_MAX_INSTANCES)
+    {
+        return false;
+    }
+    const Slot& s = layout_->slots[slot];
+    for (int attempt = 0; attempt < READ_RETRIES; attempt++)
+    {
+        const uint32_t before = s.sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            continue;
+        }
+        std::memcpy(&out, &s.stats, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.sequence.load(std::memory_order_relaxed) == before)
+        {
+            return out.id != 0;
+        }
+    }
+    return false;
+}
+
+int StatsPage::histogramBucket(uint64_t ns)
+{
+    uint64_t us = ns / 1000 / STATS_HISTOGRAM_BASE_US;
+    int bucket = 0;
+    while (us > 0 && bucket < STATS_HISTOGRAM_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+}  // namespace dsp
+}  // namespace audioshift
@@ -0,0 +1,174 @@
+#ifndef AUDIOSHIFT_STATS_PAGE_H
+#define AUDIOSHIFT_STATS_PAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/** Default location of the page; service.sh creates the directory */
+constexpr const char* STATS_PAGE_PATH = "/data/vendor/audioshift/stats";
+
+constexpr uint32_t STATS_PAGE_MAGIC = 0x53545341;  // "ASTS"
+constexpr uint32_t STATS_PAGE_VERSION = 2;
+constexpr int STATS_MAX_INSTANCES = 32;
+
+/** Callback cost histogram: bucket 0 is < 16 µs, bucket k is [16·2^(k-1), 16·2^k) µs */
+constexpr int STATS_HISTOGRAM_BUCKETS = 16;
+constexpr uint32_t STATS_HISTOGRAM_BASE_US = 16;
+
+/** InstanceStats::flags */
+enum StatsFlag : uint32_t
+{
+    kStatsEnabled = 1u << 0,
+    kStatsAutoBypassed = 1u << 1,
+    kStatsEngineAllocated = 1u << 2,
+    kStatsShadow = 1u << 3,  ///< A shadow engine runs beside the backend
+};
+
+/**
+ * @brief Statistics of one effect instance, as published to the page
+ *
+ * Plain data: copied in and out under the slot's sequence counter.
+ */
+struct InstanceStats
+{
+    uint32_t id;          ///< Instance number, never reused; 0 marks a free slot
+    uint32_t flags;       ///< StatsFlag bits
+    int32_t profile;      ///< Processing profile (0 music, 1 voip, 2 game)
+    int32_t sampleRate;
+    int32_t channels;
+    uint32_t reserved;
+    uint64_t callbacks;   ///< process() calls
+    uint64_t frames;      ///< Frames processed
+    uint64_t underruns;   ///< Callbacks zero-filled because the engine was still priming
+    uint64_t busyNs;      ///< Total time spent in process()
+    uint64_t audioNs;     ///< Total duration of the audio those calls produced
+    float dutyCycle;      ///< Last callback: processing time / buffer duration
+    float maxDutyCycle;   ///< Worst callback since the stats were reset
+    float latencyMs;      ///< Algorithmic latency of the engine
+    float tuningHz;       ///< Estimated content reference, 0 = unknown
+    uint32_t histogram[STATS_HISTOGRAM_BUCKETS];  ///< Callback cost
+    // Shadow engine (kStatsShadow), see ShadowMetrics
+    float shadowCost;     ///< Shadow time / backend time
+    float shadowSnrDb;    ///< Backend output over the aligned difference
+    float shadowCents;    ///< Shadow's A4 estimate against the backend's
+    int32_t shadowLag;    ///< Shadow output delay in frames
+    uint64_t shadowDropped;  ///< Calls the shadow missed
+};
+
+/** @brief Process-wide counters, updated with atomics */
+struct GlobalStats
+{
+    std::atomic<uint32_t> liveInstances;
+    std::atomic<uint32_t> droppedInstances;  ///< Created while every slot was taken
+    std::atomic<uint64_t> instancesCreated;
+};
+
+/**
+ * @brief Page of effect statistics in shared memory
+ *
+ * Every effect instance owns a slot protected by a sequence lock: the
+ * writer bumps the slot's counter to odd, copies the new InstanceStats in
+ * and bumps it back to even. Readers copy the slot and retry if the
+ * counter was odd or moved meanwhile, so they never block the audio
+ * thread and never see a torn record. Writing a slot costs two stores and
+ * a memcpy of ~170 bytes, which is cheap enough for every callback.
+ *
+ * The page lives in a file mapped MAP_SHARED (STATS_PAGE_PATH by default),
+ * so a monitoring process can map it read-only and sample it at any rate
+ * without a binder call. If the file cannot be created the page falls back
+ * to an anonymous memfd, readable through /proc/<pid>/fd.
+ *
+ * Each slot has a single writer. In the effect this is the instance's
+ * process() and command() calls, which AudioFlinger already serialises
+ * per effect.
+ */
+class StatsPage
+{
+public:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence;
+        std::atomic<uint32_t> owned;  ///< 1 while an instance holds the slot
+        InstanceStats stats;
+    };
+
+    struct Layout
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;          ///< Bytes in the mapping
+        uint32_t maxInstances;
+        GlobalStats global;
+        alignas(64) Slot slots[STATS_MAX_INSTANCES];
+    };
+
+    /**
+     * @brief Create (or reset) the page for writing
+     * @param path  File to map; nullptr or a failing path uses a memfd
+     * @return nullptr if no shared memory could be mapped at all
+     */
+    static StatsPage* create(const char* path = STATS_PAGE_PATH);
+
+    /** @brief Map an existing page read-only; nullptr if absent or incompatible */
+    static StatsPage* openReadOnly(const char* path = STATS_PAGE_PATH);
+
+    ~StatsPage();
+
+    StatsPage(const StatsPage&) = delete;
+    StatsPage& operator=(const StatsPage&) = delete;
+
+    /** @brief True if backed by the file rather than the memfd fallback */
+    bool isFileBacked() const { return fileBacked_; }
+
+    /** @brief File descriptor of the mapping (for logging the memfd) */
+    int fd() const { return fd_; }
+
+    // ── Writer side ─────────────────────────────────────────────────────────
+
+    /**
+     * @brief Take a free slot for a new instance and give it a fresh id
+     * @param id  Receives the instance id (also when no slot was free)
+     * @return Slot index, or -1 if all are in use (the instance then runs
+     *         unmonitored)
+     */
+    int acquireSlot(uint32_t& id);
+
+    /** @brief Mark @p slot free again */
+    void releaseSlot(int slot);
+
+    /** @brief Publish @p stats to @p slot; wait-free */
+    void publish(int slot, const InstanceStats& stats);
+
+    // ── Reader side ─────────────────────────────────────────────────────────
+
+    /**
+     * @brief Consistent copy of one slot
+     * @return false if the slot is free, or if the writer kept it busy for
+     *         every retry
+     */
+    bool read(int slot, InstanceStats& out) const;
+
+    const GlobalStats& global() const { return layout_->global; }
+
+    /** @brief Histogram bucket for a callback that took @p ns */
+    static int histogramBucket(uint64_t ns);
+
+private:
+    StatsPage(Layout* layout, int fd, bool writable, bool fileBacked);
+
+    Layout* layout_;
+    int fd_;
+    bool writable_;
+    bool fileBacked_;
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_STATS_PAGE_H
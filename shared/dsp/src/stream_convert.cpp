@@ -0,0 +1,342 @@
+#include "stream_convert.h"
+
+#include "pcm_file.h"
+#include "soundtouch_backend.h"
+#include "spsc_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+constexpr size_t PAGE_BYTES = 4096;
+constexpr int PIPE_BYTES = 1 << 20;
+
+using Clock = std::chrono::steady_clock;
+
+/** One buffer travelling reader -> converter -> writer and back */
+struct Block
+{
+    int16_t* data;
+    size_t frames;
+    bool last;
+};
+
+struct AlignedFree
+{
+    void operator()(int16_t* p) const { free(p); }
+};
+
+void growPipe(int fd)
+{
+#ifdef F_SETPIPE_SZ
+    // Fails harmlessly on files and above /proc/sys/fs/pipe-max-size
+    fcntl(fd, F_SETPIPE_SZ, PIPE_BYTES);
+#else
+    (void)fd;
+#endif
+}
+
+/**
+ * Shared state of the three stages. Each queue has exactly one producer
+ * and one consumer thread.
+ */
+class Pipeline
+{
+public:
+    Pipeline(int inFd, int outFd, const PcmInput& format, int blockFrames, int depth)
+        : inFd_(inFd), outFd_(outFd), format_(format), blockFrames_(static_cast<size_t>(blockFrames)),
+          freeIn_(depth), filled_(depth), freeOut_(depth), converted_(depth)
+    {
+        const size_t bytes = (blockFrames_ * format.channels * sizeof(int16_t) + PAGE_BYTES - 1) &
+                             ~(PAGE_BYTES - 1);
+        for (int i = 0; i < 2 * depth; i++)
+        {
+            int16_t* data = static_cast<int16_t*>(aligned_alloc(PAGE_BYTES, bytes));
+            if (!data) return;
+            memory_.emplace_back(data);
+            blocks_.push_back(Block{data, 0, false});
+        }
+        for (int i = 0; i < depth; i++)
+        {
+            freeIn_.push(&blocks_[i]);
+            freeOut_.push(&blocks_[depth + i]);
+        }
+        ok_ = true;
+    }
+
+    bool ok() const { return ok_; }
+    size_t blockFrames() const { return blockFrames_; }
+
+    /** First error wins; every stage then winds down */
+    void fail(int err)
+    {
+        int expected = 0;
+        error_.compare_exchange_strong(expected, err);
+        abort_.store(true, std::memory_order_release);
+    }
+
+    int error() const { return error_.load(); }
+
+    /** Spin, then yield, then sleep: buffers take milliseconds to fill */
+    template <class Op>
+    bool wait(Op op)
+    {
+        for (int i = 0; !op(); i++)
+        {
+            if (abort_.load(std::memory_order_acquire)) return false;
+            if (i < 64) continue;
+            if (i < 128)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            const timespec ts = {0, 50000};
+            nanosleep(&ts, nullptr);
+        }
+        return true;
+    }
+
+    bool take(SpscQueue<Block*>& q, Block*& b) { return wait([&] { return q.pop(b); }); }
+    bool give(SpscQueue<Block*>& q, Block* b) { return wait([&] { return q.push(b); }); }
+
+    void reader()
+    {
+        const size_t frameBytes = format_.channels * sizeof(int16_t);
+        const size_t blockBytes = blockFrames_ * frameBytes;
+        uint64_t remaining = format_.dataBytes ? format_.dataBytes : UINT64_MAX;
+        size_t prefix = format_.prefixBytes;
+        size_t carry = 0;  // bytes of a frame split across blocks
+        bool eof = false;
+        while (!eof)
+        {
+            Block* b;
+            if (!take(freeIn_, b)) return;
+            uint8_t* dst = reinterpret_cast<uint8_t*>(b->data);
+            if (carry) memcpy(dst, tail_, carry);
+            if (prefix)
+            {
+                memcpy(dst + carry, format_.prefix, prefix);
+                carry += prefix;
+                prefix = 0;
+            }
+            const size_t want = static_cast<size_t>(std::min<uint64_t>(blockBytes - carry, remaining));
+            const ssize_t got = readFull(inFd_, dst + carry, want);
+            if (got < 0)
+            {
+                fail(static_cast<int>(got));
+                return;
+            }
+            remaining -= static_cast<size_t>(got);
+            eof = static_cast<size_t>(got) < want || remaining == 0;
+            const size_t bytes = carry + static_cast<size_t>(got);
+            b->frames = bytes / frameBytes;
+            carry = eof ? 0 : bytes % frameBytes;  // a truncated last frame is dropped
+            memcpy(tail_, dst + b->frames * frameBytes, carry);
+            b->last = eof;
+            if (!give(filled_, b)) return;
+        }
+    }
+
+    void writer()
+    {
+        const size_t frameBytes = format_.channels * sizeof(int16_t);
+        for (;;)
+        {
+            Block* b;
+            if (!take(converted_, b)) return;
+            const int err = writeFull(outFd_, b->data, b->frames * frameBytes);
+            if (err)
+            {
+                fail(err);
+                return;
+            }
+            const bool last = b->last;
+            if (!give(freeOut_, b) || last) return;
+        }
+    }
+
+    SpscQueue<Block*>& freeIn() { return freeIn_; }
+    SpscQueue<Block*>& filled() { return filled_; }
+    SpscQueue<Block*>& freeOut() { return freeOut_; }
+    SpscQueue<Block*>& converted() { return converted_; }
+
+private:
+    const int inFd_;
+    const int outFd_;
+    const PcmInput format_;
+    const size_t blockFrames_;
+    std::vector<std::unique_ptr<int16_t, AlignedFree>> memory_;
+    std::vector<Block> blocks_;
+    SpscQueue<Block*> freeIn_;
+    SpscQueue<Block*> filled_;
+    SpscQueue<Block*> freeOut_;
+    SpscQueue<Block*> converted_;
+    std::atomic<bool> abort_{false};
+    std::atomic<int> error_{0};
+    bool ok_ = false;
+    uint8_t tail_[PCM_MAX_CHANNELS * sizeof(int16_t)];
+};
+
+}  // namespace
+
+EffectSettings offlineSettings(float pitchSemitones)
+{
+    EffectSettings settings;
+    settings.pitchSemitones = pitchSemitones;
+    settings.autoBypass = false;
+    // Files have no latency budget: take the longest WSOLA sequences
+    settings.latencyBudgetMs = 1000.0f;
+    return settings;
+}
+
+int streamConvert(int inFd, int outFd, const StreamOptions& options, StreamStats* stats)
+{
+    StreamStats local;
+    StreamStats& s = stats ? *stats : local;
+    s = StreamStats();
+    if (options.blockFrames < 1 || options.queueDepth < 1)
+    {
+        return -EINVAL;
+    }
+
+    growPipe(inFd);
+    growPipe(outFd);
+    posix_fadvise(inFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    PcmInput format;
+    int err = readPcmHeader(inFd, options.inputFormat, options.sampleRate, options.channels, format);
+    if (err)
+    {
+        return err;
+    }
+    s.sampleRate = format.sampleRate;
+    s.channels = format.channels;
+    const int channels = format.channels;
+
+    // The bare engine rather than Audio432HzConverter: it reports how much
+    // it delivered instead of zero-filling, so the output has no startup gap
+    // and no holes where the WSOLA backlog grows
+    std::unique_ptr<SoundTouchBackend> engine(SoundTouchBackend::create(
+        format.sampleRate, channels, offlineSettings(options.pitchSemitones)));
+    if (!engine)
+    {
+        return -ENOMEM;
+    }
+    // Silence after the input that pushes the engine's last frames out
+    const size_t tail =
+        static_cast<size_t>(std::lround(engine->latencyMs() * format.sampleRate / 1000.0)) +
+        SoundTouchBackend::BLOCK_FRAMES;
+
+    Pipeline pipe(inFd, outFd, format, options.blockFrames, options.queueDepth);
+    if (!pipe.ok())
+    {
+        return -ENOMEM;
+    }
+
+    const bool wavOut = options.outputFormat == StreamFormat::kWav ||
+                        (options.outputFormat == StreamFormat::kAuto && format.wav);
+    const uint64_t declaredFrames = format.dataBytes / (channels * sizeof(int16_t));
+    const off_t outStart = lseek(outFd, 0, SEEK_CUR);
+    if (wavOut)
+    {
+        uint8_t header[WAV_HEADER_BYTES];
+        makeWavHeader(header, format.sampleRate, channels, declaredFrames);
+        err = writeFull(outFd, header, sizeof(header));
+        if (err)
+        {
+            return err;
+        }
+    }
+
+    const Clock::time_point start = Clock::now();
+    std::thread reader([&] { pipe.reader(); });
+    std::thread writer([&] { pipe.writer(); });
+
+    // Convert on this thread. Once the input has ended, silence pushes the
+    // engine's last frames out and output stops at the input's length
+    Clock::duration busy{0};
+    auto convert = [&](const int16_t* src, size_t frames, bool flushing, bool last) {
+        Block* out;
+        if (!pipe.take(pipe.freeOut(), out)) return false;
+        size_t written = 0;
+        if (frames > 0)
+        {
+            const Clock::time_point t0 = Clock::now();
+            written = static_cast<size_t>(
+                engine->process(src, out->data, static_cast<int>(frames), PcmFormat::kInt16));
+            busy += Clock::now() - t0;
+        }
+        if (flushing)
+        {
+            written = static_cast<size_t>(std::min<uint64_t>(written, s.framesIn - s.framesOut));
+        }
+        out->frames = written;
+        out->last = last;
+        s.framesOut += written;
+        return pipe.give(pipe.converted(), out);
+    };
+
+    for (bool last = false; !last;)
+    {
+        Block* in;
+        if (!pipe.take(pipe.filled(), in)) break;
+        last = in->last;
+        s.framesIn += in->frames;
+        bool ok = convert(in->data, in->frames, last, false);
+        for (size_t padding = last ? tail : 0; ok && padding > 0 && s.framesOut < s.framesIn;)
+        {
+            // The input buffer is free now: reuse it as the silence
+            const size_t n = std::min(padding, pipe.blockFrames());
+            std::fill_n(in->data, n * channels, 0);
+            padding -= n;
+            ok = convert(in->data, n, true, false);
+        }
+        if (ok && last)
+        {
+            ok = convert(nullptr, 0, true, true);
+        }
+        if (!ok || !pipe.give(pipe.freeIn(), in)) break;
+    }
+
+    reader.join();
+    writer.join();
+    s.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    s.convertSeconds = std::chrono::duration<double>(busy).count();
+    if (pipe.error())
+    {
+        return pipe.error();
+    }
+
+    if (wavOut && outStart == 0 && s.framesOut != declaredFrames)
+    {
+        // Seekable output: replace the placeholder sizes
+        uint8_t header[WAV_HEADER_BYTES];
+        makeWavHeader(header, format.sampleRate, channels, s.framesOut);
+        if (pwrite(outFd, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+        {
+            return -errno;
+        }
+    }
+    return 0;
+}
+
+}  // namespace dsp
+}  // namespace audioshift
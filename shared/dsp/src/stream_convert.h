@@ -0,0 +1,72 @@
+#ifndef AUDIOSHIFT_STREAM_CONVERT_H
+#define AUDIOSHIFT_STREAM_CONVERT_H
+
+/**
+ * File and pipe conversion for batch jobs.
+ *
+ * Reads 16-bit PCM (raw or WAV) from one descriptor and writes the 432 Hz
+ * version to another. Reading, converting and writing run on three threads
+ * that hand fixed buffers to each other through lock-free queues, so I/O
+ * overlaps the DSP and memory stays constant however long the stream is.
+ */
+
+#include "audio_432hz.h"
+#include "effect_core.h"
+#include "pcm_file.h"
+
+#include <cstdint>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+struct StreamOptions
+{
+    StreamFormat inputFormat = StreamFormat::kAuto;
+    StreamFormat outputFormat = StreamFormat::kAuto;
+    int sampleRate = 48000;  ///< Of raw input; WAV input carries its own
+    int channels = 2;        ///< Of raw input; WAV input carries its own
+    float pitchSemitones = PITCH_SEMITONES_432_HZ;
+    int blockFrames = 16384;  ///< Frames per buffer handed between threads
+    int queueDepth = 4;       ///< Buffers in flight per stage boundary
+};
+
+struct StreamStats
+{
+    uint64_t framesIn = 0;
+    uint64_t framesOut = 0;
+    int sampleRate = 0;
+    int channels = 0;
+    double wallSeconds = 0.0;     ///< From the first read to the last write
+    double convertSeconds = 0.0;  ///< Spent in the pitch-shift engine
+};
+
+/**
+ * @brief Engine settings for converting files
+ *
+ * Auto-bypass off and the highest-quality latency tier: nothing listens
+ * while a file converts.
+ */
+EffectSettings offlineSettings(float pitchSemitones);
+
+/**
+ * @brief Convert a whole stream from @p inFd to @p outFd
+ *
+ * The output lines up with the input and has its length: the engine is
+ * flushed at the end of input, and nothing is zero-filled at the start.
+ * Returns after end of input once everything is written. A WAV output on a
+ * seekable descriptor gets its sizes patched at the end; on a pipe they
+ * read 0xFFFFFFFF ("until end of stream") unless the input declared them.
+ * Large pipes are requested for both descriptors where the kernel allows.
+ *
+ * @param stats Filled on return if not null, also after an error
+ * @return 0, -EINVAL for a malformed or unsupported input, or the -errno
+ *         of a failed read or write
+ */
+int streamConvert(int inFd, int outFd, const StreamOptions& options, StreamStats* stats);
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_STREAM_CONVERT_H
@@ -0,0 +1,246 @@
+#include "stream_switch.h"
+
+#include "pcm_convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+// Frames a Catmull-Rom resampling of 'inFrames' frames yields; 'step' is
+// input frames per output frame
+int resampledFrames(int inFrames, double step)
+{
+    return inFrames > 1 ? static_cast<int>((inFrames - 1) / step) + 1 : inFrames;
+}
+
+inline void store(float v, float& out)
+{
+    out = v;
+}
+
+inline void store(float v, int16_t& out)
+{
+    out = static_cast<int16_t>(std::lround(std::max(-32768.0f, std::min(32767.0f, v))));
+}
+
+// Catmull-Rom resampling of a ring of interleaved frames starting at frame
+// 'start'; writes the last 'outFrames' output frames. Edges are clamped.
+template <typename T>
+void resampleCubic(const T* in, int inFrames, int start, int channels, double step, T* out,
+                   int outFrames)
+{
+    const int skip = resampledFrames(inFrames, step) - outFrames;
+    auto at = [&](int frame, int c) {
+        frame = std::max(0, std::min(inFrames - 1, frame));
+        return static_cast<float>(in[static_cast<size_t>((start + frame) % inFrames) * channels + c]);
+    };
+    for (int n = 0; n < outFrames; n++)
+    {
+        const double pos = (skip + n) * step;
+        const int i = static_cast<int>(pos);
+        const float t = static_cast<float>(pos - i);
+        for (int c = 0; c < channels; c++)
+        {
+            const float y0 = at(i - 1, c);
+            const float y1 = at(i, c);
+            const float y2 = at(i + 1, c);
+            const float y3 = at(i + 2, c);
+            store(y1 + 0.5f * t * ((y2 - y0) +
+                                   t * ((2.0f * y0 - 5.0f * y1 + 4.0f * y2 - y3) +
+                                        t * (3.0f * (y1 - y2) + y3 - y0))),
+                  out[static_cast<size_t>(n) * channels + c]);
+        }
+    }
+}
+
+}  // namespace
+
+StreamSwitch* StreamSwitch::create(int sampleRate, int channels)
+{
+    auto* sw = new (std::nothrow) StreamSwitch(sampleRate, channels);
+    if (!sw)
+    {
+        return nullptr;
+    }
+    const size_t historySamples = static_cast<size_t>(historyFramesFor(sampleRate)) * channels;
+    const size_t tailSamples = static_cast<size_t>(tailFramesFor(sampleRate)) * channels;
+    sw->history_.reset(new (std::nothrow) int16_t[historySamples]());
+    sw->tail_.reset(new (std::nothrow) float[tailSamples]());
+    if (!sw->history_ || !sw->tail_)
+    {
+        delete sw;
+        return nullptr;
+    }
+    sw->historyFrames_ = historyFramesFor(sampleRate);
+    sw->tailFrames_ = tailFramesFor(sampleRate);
+    return sw;
+}
+
+StreamSwitch::StreamSwitch(int sampleRate, int channels)
+    : sampleRate_(sampleRate), channels_(channels)
+{
+}
+
+void StreamSwitch::remember(const float* in, int frames)
+{
+    // Only the newest historyFrames_ frames can survive
+    for (int i = std::max(0, frames - historyFrames_); i < frames;)
+    {
+        const int n = std::min(frames - i, historyFrames_ - historyPos_);
+        floatToInt16(in + static_cast<size_t>(i) * channels_,
+                     history_.get() + static_cast<size_t>(historyPos_) * channels_,
+                     static_cast<size_t>(n) * channels_);
+        historyPos_ = (historyPos_ + n) % historyFrames_;
+        i += n;
+    }
+}
+
+void StreamSwitch::remember(const int16_t* in, int frames)
+{
+    for (int i = std::max(0, frames - historyFrames_); i < frames;)
+    {
+        const int n = std::min(frames - i, historyFrames_ - historyPos_);
+        std::copy(in + static_cast<size_t>(i) * channels_, in + static_cast<size_t>(i + n) * channels_,
+                  history_.get() + static_cast<size_t>(historyPos_) * channels_);
+        historyPos_ = (historyPos_ + n) % historyFrames_;
+        i += n;
+    }
+}
+
+bool StreamSwitch::begin(int newRate, bool running)
+{
+    const double step = static_cast<double>(sampleRate_) / newRate;
+    const int historyFrames = historyFramesFor(newRate);
+    const int tailFrames = tailFramesFor(newRate);
+    const int recentFrames = std::min(historyFrames, resampledFrames(historyFrames_, step));
+    const int handoverFrames = running ? resampledFrames(tailFrames_, step) : 0;
+
+    std::unique_ptr<int16_t[]> history(
+        new (std::nothrow) int16_t[static_cast<size_t>(historyFrames) * channels_]());
+    std::unique_ptr<float[]> tail(new (std::nothrow) float[static_cast<size_t>(tailFrames) * channels_]());
+    const size_t handoverSize = static_cast<size_t>(handoverFrames) * channels_;
+    std::unique_ptr<float[]> handover(handoverSize > handoverCapacity_ ? new (std::nothrow) float[handoverSize]
+                                                                       : nullptr);
+    if (!history || !tail || (handoverSize > handoverCapacity_ && !handover))
+    {
+        return false;
+    }
+
+    // Oldest first from the start of the ring, so recent() reads it in one piece
+    resampleCubic(history_.get(), historyFrames_, historyPos_, channels_, step, history.get(), recentFrames);
+    if (handover)
+    {
+        handover_ = std::move(handover);
+        handoverCapacity_ = handoverSize;
+    }
+    if (running)
+    {
+        resampleCubic(tail_.get(), tailFrames_, 0, channels_, step, handover_.get(), handoverFrames);
+    }
+    handoverSize_ = handoverSize;
+    handoverPos_ = 0;
+
+    history_ = std::move(history);
+    historyFrames_ = historyFrames;
+    historyPos_ = recentFrames % historyFrames;
+    recentFrames_ = recentFrames;
+    tail_ = std::move(tail);
+    tailFrames_ = tailFrames;
+    sampleRate_ = newRate;
+    return true;
+}
+
+int StreamSwitch::align(const float* queued, int queuedFrames, int stride, int nominalDrop) const
+{
+    const int length = static_cast<int>(handoverSize_) / channels_;
+    const int range = sampleRate_ / 1000 * ALIGN_MS;
+    const int first = std::max(0, nominalDrop - range);
+    const int last = std::min(queuedFrames - length, nominalDrop + range);
+    nominalDrop = std::max(0, std::min(nominalDrop, queuedFrames));
+    if (first > last)
+    {
+        return nominalDrop;
+    }
+
+    int best = nominalDrop;
+    double bestScore = 0.0;
+    for (int d = first; d <= last; d++)
+    {
+        double corr = 0.0;
+        double energy = 0.0;
+        for (int i = 0; i < length; i++)
+        {
+            for (int c = 0; c < stride; c++)
+            {
+                const double v = queued[static_cast<size_t>(d + i) * stride + c];
+                corr += v * handover_[static_cast<size_t>(i) * channels_ + c];
+                energy += v * v;
+            }
+        }
+        const double score = energy > 0.0 ? corr / std::sqrt(energy) : 0.0;
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = d;
+        }
+    }
+    return best;
+}
+
+void StreamSwitch::apply(float* out, int frames)
+{
+    const size_t n = std::min(handoverSize_ - handoverPos_, static_cast<size_t>(frames) * channels_);
+    const float step = 1.0f / (handoverSize_ / channels_);
+    for (size_t k = 0; k < n; k++)
+    {
+        const float g = ((handoverPos_ + k) / channels_ + 1) * step;
+        const float old = handover_[handoverPos_ + k];
+        out[k] = old + g * (out[k] - old);
+    }
+    handoverPos_ += n;
+    if (handoverPos_ == handoverSize_)
+    {
+        cancel();
+    }
+}
+
+void StreamSwitch::apply(int16_t* out, int frames)
+{
+    const size_t n = std::min(handoverSize_ - handoverPos_, static_cast<size_t>(frames) * channels_);
+    const float step = 1.0f / (handoverSize_ / channels_);
+    for (size_t k = 0; k < n; k++)
+    {
+        const float g = ((handoverPos_ + k) / channels_ + 1) * step;
+        // Full scale as floatToInt16() writes it
+        const float old = std::max(-32768.0f, std::min(32767.0f, handover_[handoverPos_ + k] * 32767.0f));
+        out[k] = static_cast<int16_t>(std::lround(old + g * (out[k] - old)));
+    }
+    handoverPos_ += n;
+    if (handoverPos_ == handoverSize_)
+    {
+        cancel();
+    }
+}
+
+void StreamSwitch::cancel()
+{
+    handoverSize_ = 0;
+    handoverPos_ = 0;
+}
+
+size_t StreamSwitch::memoryBytes() const
+{
+    return sizeof(*this) + static_cast<size_t>(historyFrames_) * channels_ * sizeof(int16_t) +
+           (static_cast<size_t>(tailFrames_) * channels_ + handoverCapacity_) * sizeof(float);
+}
+
+}  // namespace dsp
+}  // namespace audioshift
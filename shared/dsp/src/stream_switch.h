@@ -0,0 +1,124 @@
+#ifndef AUDIOSHIFT_STREAM_SWITCH_H
+#define AUDIOSHIFT_STREAM_SWITCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Sample rate and latency tier changes without a restart
+ *
+ * A WSOLA engine cleared for a new rate starts from silence: the output
+ * stops for the engine's latency and the old engines' backlog is lost.
+ * The switch keeps the last HISTORY_MS of input instead. On a change the
+ * owner renders what the old engines would have played next into tail()
+ * (their backlog, pushed out by silence), restarts them and calls begin().
+ * The engines are then re-primed with recent(), their output is cut where
+ * align() finds it lines up with the old continuation, and apply() fades
+ * that continuation out over the first HANDOVER_MS of new output.
+ *
+ * The history is int16 whatever the owner's samples: it only feeds the
+ * first moments after a switch, and costs half as much. Float samples are
+ * in [-1, 1) and scale like pcm_convert.h. Only create() and begin()
+ * allocate.
+ */
+class StreamSwitch
+{
+public:
+    static constexpr int HISTORY_MS = 200;  ///< Input kept for re-priming
+    static constexpr int HANDOVER_MS = 10;  ///< Length of the crossfade
+    static constexpr int ALIGN_MS = 20;     ///< Search range of align()
+
+    /** @return nullptr if out of memory */
+    static StreamSwitch* create(int sampleRate, int channels);
+
+    StreamSwitch(const StreamSwitch&) = delete;
+    StreamSwitch& operator=(const StreamSwitch&) = delete;
+
+    /** @brief Append @p frames interleaved input frames to the history */
+    void remember(const float* in, int frames);
+    void remember(const int16_t* in, int frames);
+
+    /** @brief Room for the old engines' continuation, tailFrames() frames at the current rate */
+    float* tail() { return tail_.get(); }
+    int tailFrames() const { return tailFrames_; }
+
+    /**
+     * @brief Move to @p newRate (may be the current rate, for a new tier)
+     *
+     * Resamples the history and, if @p running, the tail to the new rate;
+     * the tail becomes the handover.
+     * @return false if out of memory; the switch keeps the old rate then
+     */
+    bool begin(int newRate, bool running);
+
+    /**
+     * @brief History at the new rate, oldest first, for re-priming
+     *
+     * Valid from begin() until the next remember().
+     */
+    const int16_t* recent() const { return history_.get(); }
+    int recentFrames() const { return recentFrames_; }
+
+    /**
+     * @brief Refine how many frames of queued output to drop
+     *
+     * WSOLA's splice positions shift the output by up to the seek window,
+     * so the drop is refined the way WSOLA picks a splice: the handover is
+     * matched against the queued output and the best normalised
+     * cross-correlation within ±ALIGN_MS of @p nominalDrop wins.
+     * @param queued   The lead engine's queued output
+     * @param stride   Samples per frame in @p queued: 1 for a mono leader,
+     *                 the channel count for an interleaved engine. Only the
+     *                 first @p stride channels of the handover are compared
+     */
+    int align(const float* queued, int queuedFrames, int stride, int nominalDrop) const;
+
+    /** @brief Whether a handover is still being faded out */
+    bool fading() const { return handoverSize_ > 0; }
+
+    /** @brief Crossfade the next @p frames output frames with the handover */
+    void apply(float* out, int frames);
+    void apply(int16_t* out, int frames);
+
+    /** @brief Drop the handover; the history is kept */
+    void cancel();
+
+    int sampleRate() const { return sampleRate_; }
+
+    size_t memoryBytes() const;
+
+private:
+    StreamSwitch(int sampleRate, int channels);
+
+    static int historyFramesFor(int sampleRate) { return sampleRate / 1000 * HISTORY_MS; }
+    static int tailFramesFor(int sampleRate) { return sampleRate / 1000 * HANDOVER_MS; }
+
+    int sampleRate_;
+    const int channels_;
+
+    // Ring of historyFrames_ interleaved frames. begin() leaves it unrolled,
+    // oldest first, which is what recent() hands out
+    std::unique_ptr<int16_t[]> history_;
+    int historyFrames_ = 0;
+    int historyPos_ = 0;  // next frame to write
+    int recentFrames_ = 0;
+
+    std::unique_ptr<float[]> tail_;  // tailFrames_ frames
+    int tailFrames_ = 0;
+
+    std::unique_ptr<float[]> handover_;
+    size_t handoverCapacity_ = 0;  // interleaved samples
+    size_t handoverSize_ = 0;      // interleaved samples, 0 when not fading
+    size_t handoverPos_ = 0;       // interleaved samples already faded
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_STREAM_SWITCH_H
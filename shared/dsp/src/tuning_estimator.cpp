@@ -0,0 +1,409 @@
+#include "tuning_estimator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+namespace
+{
+
+constexpr int FFT_LOG2 = 12;
+constexpr size_t FFT_SIZE = size_t(1) << FFT_LOG2;
+constexpr int TARGET_DECIMATED_RATE = 8000;
+
+// Only well-resolved fundamentals and low partials vote
+constexpr float MIN_PEAK_HZ = 100.0f;
+constexpr float MAX_PEAK_HZ = 1500.0f;
+constexpr size_t MAX_PEAKS = 24;
+constexpr float PEAK_FLOOR_RATIO = 1e-3f;      // -30 dB below the frame's strongest peak
+constexpr float SILENCE_POWER = 1.0f;          // ~ -60 dBFS sine; quieter frames are skipped
+
+constexpr int HISTOGRAM_BINS = 100;            // 1 cent per bin over one semitone
+constexpr int ESTIMATE_HALF_WIDTH = 12;        // cents either side of the histogram peak
+constexpr float HISTORY_SECONDS = 20.0f;
+constexpr float MIN_ANALYSIS_SECONDS = 10.0f;
+
+constexpr float ENTER_CENTS = 6.0f;
+constexpr float EXIT_CENTS = 12.0f;
+constexpr float ENTER_CONFIDENCE = 0.4f;
+constexpr float EXIT_CONFIDENCE = 0.25f;
+
+constexpr double PI = 3.14159265358979323846;
+
+struct Peak
+{
+    float hz;
+    float weight;
+};
+
+inline int wrapBin(int i)
+{
+    return ((i % HISTOGRAM_BINS) + HISTOGRAM_BINS) % HISTOGRAM_BINS;
+}
+
+}  // namespace
+
+TuningEstimator::TuningEstimator(int sampleRate)
+    : frame_(FFT_SIZE),
+      window_(FFT_SIZE),
+      bitReverse_(FFT_SIZE),
+      twiddleRe_(FFT_SIZE / 2),
+      twiddleIm_(FFT_SIZE / 2),
+      re_(FFT_SIZE),
+      im_(FFT_SIZE),
+      histogram_(HISTOGRAM_BINS)
+{
+    for (size_t i = 0; i < FFT_SIZE; i++)
+    {
+        window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * i / FFT_SIZE));
+
+        uint32_t r = 0;
+        for (int b = 0; b < FFT_LOG2; b++)
+        {
+            r |= ((i >> b) & 1u) << (FFT_LOG2 - 1 - b);
+        }
+        bitReverse_[i] = r;
+    }
+    for (size_t i = 0; i < FFT_SIZE / 2; i++)
+    {
+        twiddleRe_[i] = static_cast<float>(std::cos(-2.0 * PI * i / FFT_SIZE));
+        twiddleIm_[i] = static_cast<float>(std::sin(-2.0 * PI * i / FFT_SIZE));
+    }
+
+    setSampleRate(sampleRate);
+}
+
+void TuningEstimator::setSampleRate(int sampleRate)
+{
+    sampleRate_ = std::max(1, sampleRate);
+    decimation_ = std::max(1, sampleRate_ / TARGET_DECIMATED_RATE);
+    decimatedRate_ = static_cast<float>(sampleRate_) / decimation_;
+
+    // Butterworth low-pass at 0.4 x the decimated Nyquist (RBJ cookbook)
+    const double w0 = 2.0 * PI * (0.2 * decimatedRate_) / sampleRate_;
+    const double alpha = std::sin(w0) / (2.0 * std::sqrt(0.5));
+    const double cosw0 = std::cos(w0);
+    const double a0 = 1.0 + alpha;
+    b0_ = static_cast<float>((1.0 - cosw0) / 2.0 / a0);
+    b1_ = static_cast<float>((1.0 - cosw0) / a0);
+    b2_ = b0_;
+    a1_ = static_cast<float>(-2.0 * cosw0 / a0);
+    a2_ = static_cast<float>((1.0 - alpha) / a0);
+
+    const float hopSeconds = FFT_SIZE / decimatedRate_;
+    histogramDecay_ = std::exp(-hopSeconds / HISTORY_SECONDS);
+
+    reset();
+}
+
+size_t TuningEstimator::memoryBytes() const
+{
+    return (frame_.capacity() + window_.capacity() + twiddleRe_.capacity() +
+            twiddleIm_.capacity() + re_.capacity() + im_.capacity() + histogram_.capacity()) *
+                   sizeof(float) +
+           bitReverse_.capacity() * sizeof(uint32_t);
+}
+
+void TuningEstimator::reset()
+{
+    z1_ = z2_ = 0.0f;
+    decimAccum_ = 0.0f;
+    decimCount_ = 0;
+    framePos_ = 0;
+    stage_ = -1;
+    std::fill(histogram_.begin(), histogram_.end(), 0.0f);
+    samplesSeen_ = 0;
+    referenceHz_ = 0.0f;
+    confidence_ = 0.0f;
+}
+
+void TuningEstimator::analyze(const int16_t* pcm, int frames, int channels)
+{
+    if (!pcm || frames <= 0 || channels <= 0)
+    {
+        return;
+    }
+
+    const float scale = 1.0f / (32768.0f * channels);
+    for (int i = 0; i < frames; i++)
+    {
+        int sum = 0;
+        for (int c = 0; c < channels; c++)
+        {
+            sum += pcm[i * channels + c];
+        }
+        push(sum * scale);
+    }
+    finishCall(frames);
+}
+
+void TuningEstimator::analyze(const float* pcm, int frames, int channels)
+{
+    if (!pcm || frames <= 0 || channels <= 0)
+    {
+        return;
+    }
+
+    const float scale = 1.0f / channels;
+    for (int i = 0; i < frames; i++)
+    {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++)
+        {
+            sum += pcm[i * channels + c];
+        }
+        push(sum * scale);
+    }
+    finishCall(frames);
+}
+
+void TuningEstimator::push(float x)
+{
+    const float y = b0_ * x + z1_;
+    z1_ = b1_ * x - a1_ * y + z2_;
+    z2_ = b2_ * x - a2_ * y;
+
+    decimAccum_ += y;
+    if (++decimCount_ < decimation_)
+    {
+        return;
+    }
+    frame_[framePos_++] = decimAccum_ / decimation_;
+    decimAccum_ = 0.0f;
+    decimCount_ = 0;
+
+    if (framePos_ == FFT_SIZE)
+    {
+        // Callbacks too large to spread the transform over: finish it now
+        while (stage_ >= 0)
+        {
+            runFftStage();
+        }
+        for (size_t k = 0; k < FFT_SIZE; k++)
+        {
+            re_[bitReverse_[k]] = frame_[k] * window_[k];
+            im_[bitReverse_[k]] = 0.0f;
+        }
+        stage_ = 0;
+        framePos_ = 0;
+    }
+}
+
+void TuningEstimator::finishCall(int frames)
+{
+    samplesSeen_ += static_cast<uint64_t>(frames);
+
+    if (stage_ >= 0)
+    {
+        runFftStage();
+    }
+}
+
+void TuningEstimator::runFftStage()
+{
+    // One radix-2 decimation-in-time pass over the bit-reversed frame
+    const size_t half = size_t(1) << stage_;
+    const size_t step = FFT_SIZE / (2 * half);
+    for (size_t base = 0; base < FFT_SIZE; base += 2 * half)
+    {
+        for (size_t j = 0; j < half; j++)
+        {
+            const float wr = twiddleRe_[j * step];
+            const float wi = twiddleIm_[j * step];
+            const size_t a = base + j;
+            const size_t b = a + half;
+            const float tr = re_[b] * wr - im_[b] * wi;
+            const float ti = re_[b] * wi + im_[b] * wr;
+            re_[b] = re_[a] - tr;
+            im_[b] = im_[a] - ti;
+            re_[a] += tr;
+            im_[a] += ti;
+        }
+    }
+
+    if (++stage_ == FFT_LOG2)
+    {
+        stage_ = -1;
+        collectPeaks();
+    }
+}
+
+void TuningEstimator::collectPeaks()
+{
+    const float binHz = decimatedRate_ / FFT_SIZE;
+    const size_t lo = std::max<size_t>(3, static_cast<size_t>(MIN_PEAK_HZ / binHz));
+    const size_t hi = std::min<size_t>(FFT_SIZE / 2 - 3, static_cast<size_t>(MAX_PEAK_HZ / binHz));
+
+    // Power spectrum in place of re_
+    for (size_t k = lo - 2; k <= hi + 2; k++)
+    {
+        re_[k] = re_[k] * re_[k] + im_[k] * im_[k];
+    }
+
+    float maxPower = 0.0f;
+    for (size_t k = lo; k <= hi; k++)
+    {
+        maxPower = std::max(maxPower, re_[k]);
+    }
+    if (maxPower < SILENCE_POWER)
+    {
+        return;
+    }
+
+    // Keep the strongest local maxima (±2 bins clears the Hann sidelobes)
+    std::array<Peak, MAX_PEAKS> peaks;
+    size_t numPeaks = 0;
+    const float floor = maxPower * PEAK_FLOOR_RATIO;
+    for (size_t k = lo; k <= hi; k++)
+    {
+        const float p = re_[k];
+        if (p < floor || p <= re_[k - 1] || p <= re_[k - 2] || p < re_[k + 1] || p < re_[k + 2])
+        {
+            continue;
+        }
+
+        // Quadratic interpolation of log power: sub-bin accurate for a Hann window
+        const float a = std::log(re_[k - 1] + 1e-20f);
+        const float b = std::log(p);
+        const float c = std::log(re_[k + 1] + 1e-20f);
+        const float denom = a - 2.0f * b + c;
+        const float delta = denom < 0.0f ? 0.5f * (a - c) / denom : 0.0f;
+        const Peak peak = {(k + delta) * binHz, std::sqrt(p)};
+
+        if (numPeaks < MAX_PEAKS)
+        {
+            peaks[numPeaks++] = peak;
+        }
+        else
+        {
+            auto weakest = std::min_element(peaks.begin(), peaks.end(),
+                    [](const Peak& x, const Peak& y) { return x.weight < y.weight; });
+            if (weakest->weight < peak.weight)
+            {
+                *weakest = peak;
+            }
+        }
+    }
+
+    float totalWeight = 0.0f;
+    for (size_t i = 0; i < numPeaks; i++)
+    {
+        totalWeight += peaks[i].weight;
+    }
+    if (totalWeight <= 0.0f)
+    {
+        return;
+    }
+
+    for (float& h : histogram_)
+    {
+        h *= histogramDecay_;
+    }
+
+    // Each frame casts one vote in total, split between its peaks; bin i holds
+    // an offset of (i - 50) cents from the 440 Hz grid
+    for (size_t i = 0; i < numPeaks; i++)
+    {
+        const float cents = 1200.0f * std::log2(peaks[i].hz / 440.0f);
+        const float offset = cents - 100.0f * std::round(cents / 100.0f);
+        const float pos = offset + HISTOGRAM_BINS / 2;
+        const int i0 = static_cast<int>(std::floor(pos));
+        const float frac = pos - i0;
+        const float w = peaks[i].weight / totalWeight;
+        histogram_[wrapBin(i0)] += w * (1.0f - frac);
+        histogram_[wrapBin(i0 + 1)] += w * frac;
+    }
+
+    updateEstimate();
+}
+
+void TuningEstimator::updateEstimate()
+{
+    float total = 0.0f;
+    int best = 0;
+    float bestSum = -1.0f;
+    for (int i = 0; i < HISTOGRAM_BINS; i++)
+    {
+        total += histogram_[i];
+        float s = 0.0f;
+        for (int d = -2; d <= 2; d++)
+        {
+            s += histogram_[wrapBin(i + d)];
+        }
+        if (s > bestSum)
+        {
+            bestSum = s;
+            best = i;
+        }
+    }
+    if (total <= 0.0f)
+    {
+        return;
+    }
+
+    // Centroid around the peak, walking outwards so the wrap at ±50 cents is harmless
+    float mass = 0.0f;
+    float moment = 0.0f;
+    for (int d = -ESTIMATE_HALF_WIDTH; d <= ESTIMATE_HALF_WIDTH; d++)
+    {
+        const float h = histogram_[wrapBin(best + d)];
+        mass += h;
+        moment += h * d;
+    }
+
+    float offset = (best - HISTOGRAM_BINS / 2) + (mass > 0.0f ? moment / mass : 0.0f);
+    if (offset >= 50.0f)
+    {
+        offset -= 100.0f;
+    }
+    else if (offset < -50.0f)
+    {
+        offset += 100.0f;
+    }
+
+    referenceHz_ = 440.0f * std::exp2(offset / 1200.0f);
+    confidence_ = mass / total;
+}
+
+bool TuningEstimator::hasEstimate() const
+{
+    return referenceHz_ > 0.0f && analyzedSeconds() >= MIN_ANALYSIS_SECONDS;
+}
+
+float TuningEstimator::referenceHz() const
+{
+    return hasEstimate() ? referenceHz_ : 0.0f;
+}
+
+float TuningEstimator::confidence() const
+{
+    return hasEstimate() ? confidence_ : 0.0f;
+}
+
+float TuningEstimator::analyzedSeconds() const
+{
+    return static_cast<float>(samplesSeen_) / sampleRate_;
+}
+
+bool TuningEstimator::matchesReference(float targetHz, bool currentlyMatched) const
+{
+    if (!hasEstimate() || targetHz <= 0.0f)
+    {
+        return false;
+    }
+
+    const float cents = std::fabs(1200.0f * std::log2(referenceHz_ / targetHz));
+    if (currentlyMatched)
+    {
+        return cents <= EXIT_CENTS && confidence_ >= EXIT_CONFIDENCE;
+    }
+    return cents <= ENTER_CENTS && confidence_ >= ENTER_CONFIDENCE;
+}
+
+}  // namespace dsp
+}  // namespace audioshift
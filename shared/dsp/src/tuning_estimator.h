@@ -0,0 +1,121 @@
+#ifndef AUDIOSHIFT_TUNING_ESTIMATOR_H
+#define AUDIOSHIFT_TUNING_ESTIMATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace audioshift
+{
+namespace dsp
+{
+
+/**
+ * @brief Background estimate of the content's concert-pitch reference (A4)
+ *
+ * The input is downmixed, low-passed and decimated to about 8 kHz. Every
+ * 4096 decimated samples (~0.5 s) a Hann-windowed spectrum is taken and its
+ * strongest peaks between 100 Hz and 2 kHz are refined to sub-bin accuracy.
+ * Each peak votes, weighted by magnitude, for its offset in cents from the
+ * nearest A4 = 440 Hz equal-tempered note. The votes go into a 1-cent
+ * histogram that decays with a 20 s time constant, so the estimate follows
+ * tens of seconds of material and is not thrown by single notes.
+ *
+ * The FFT is incremental: one radix-2 stage runs per analyze() call, so
+ * the cost per audio callback stays bounded and small.
+ *
+ * Allocates only in the constructor and setSampleRate(); analyze() is safe
+ * on the audio thread and never throws.
+ */
+class TuningEstimator
+{
+public:
+    explicit TuningEstimator(int sampleRate = 48000);
+
+    /** @brief Change the input rate; drops the accumulated evidence */
+    void setSampleRate(int sampleRate);
+
+    /** @brief Forget everything analysed so far */
+    void reset();
+
+    /**
+     * @brief Feed interleaved int16 PCM
+     * @param pcm       Interleaved samples
+     * @param frames    Number of frames
+     * @param channels  Channels per frame
+     */
+    void analyze(const int16_t* pcm, int frames, int channels);
+
+    /** @brief Feed interleaved float PCM in [-1, 1) */
+    void analyze(const float* pcm, int frames, int channels);
+
+    /** @brief True once enough material has been seen to trust the estimate */
+    bool hasEstimate() const;
+
+    /** @brief Estimated A4 reference in Hz, 0 until hasEstimate() */
+    float referenceHz() const;
+
+    /** @brief Share of the histogram mass that agrees with the estimate (0..1) */
+    float confidence() const;
+
+    /** @brief Seconds of input analysed since the last reset */
+    float analyzedSeconds() const;
+
+    /**
+     * @brief Hysteresis decision: is the content already tuned to @p targetHz?
+     *
+     * Entering the matched state needs a confident estimate within 6 cents
+     * of the target; leaving it needs a drift beyond 12 cents or a clear
+     * loss of confidence. Passing the current state in keeps the decision
+     * stateless, so any caller's state machine can use it.
+     *
+     * @param targetHz          Reference to compare against, e.g. 432
+     * @param currentlyMatched  Result of the previous decision
+     */
+    bool matchesReference(float targetHz, bool currentlyMatched) const;
+
+    /** @brief Heap held by the FFT tables and the histogram; fixed at construction */
+    size_t memoryBytes() const;
+
+private:
+    // One downmixed input sample through the low-pass and decimator
+    void push(float x);
+    // Per analyze() call: count the input and advance a pending transform
+    void finishCall(int frames);
+    void runFftStage();
+    void collectPeaks();
+    void updateEstimate();
+
+    int sampleRate_;
+    int decimation_;
+    float decimatedRate_;
+
+    // 2nd-order low-pass ahead of the decimator (transposed direct form II)
+    float b0_, b1_, b2_, a1_, a2_;
+    float z1_, z2_;
+    float decimAccum_;
+    int decimCount_;
+
+    // Decimated input frame being filled
+    std::vector<float> frame_;
+    size_t framePos_;
+
+    // Incremental FFT: bit-reversed windowed frame, transformed one stage per call
+    std::vector<float> window_;
+    std::vector<uint32_t> bitReverse_;
+    std::vector<float> twiddleRe_, twiddleIm_;
+    std::vector<float> re_, im_;
+    int stage_;            ///< next stage to run, -1 if no transform pending
+
+    std::vector<float> histogram_;
+    float histogramDecay_;
+
+    uint64_t samplesSeen_;
+    float referenceHz_;
+    float confidence_;
+};
+
+}  // namespace dsp
+}  // namespace audioshift
+
+#endif  // AUDIOSHIFT_TUNING_ESTIMATOR_H
@@ -0,0 +1,92 @@
+/**
+ * hardware/audio_effect.h — Host stub for effect_command.h
+ *
+ * Just the effect HAL types, commands and constants effect_command.h uses,
+ * laid out and numbered as in the platform headers, so the shared command
+ * dispatcher can be tested without an Android tree.
+ *
+ * DO NOT use in production Android builds — use the real platform headers.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// ── system/audio.h ─────────────────────────────────────────────────────────
+
+enum
+{
+    AUDIO_FORMAT_DEFAULT = 0x0,
+    AUDIO_FORMAT_PCM_16_BIT = 0x1,
+    AUDIO_FORMAT_PCM_8_BIT = 0x2,
+    AUDIO_FORMAT_PCM_32_BIT = 0x3,
+    AUDIO_FORMAT_PCM_8_24_BIT = 0x4,
+    AUDIO_FORMAT_PCM_FLOAT = 0x5,
+    AUDIO_FORMAT_PCM_24_BIT_PACKED = 0x6,
+};
+
+enum
+{
+    AUDIO_CHANNEL_OUT_MONO = 0x1,
+    AUDIO_CHANNEL_OUT_STEREO = 0x3,
+    AUDIO_CHANNEL_OUT_5POINT1 = 0x3f,
+};
+
+enum
+{
+    AUDIO_MODE_NORMAL = 0,
+    AUDIO_MODE_RINGTONE = 1,
+    AUDIO_MODE_IN_CALL = 2,
+    AUDIO_MODE_IN_COMMUNICATION = 3,
+};
+
+/** Channel count of a positional output mask */
+static inline uint32_t audio_channel_count_from_out_mask(uint32_t mask)
+{
+    return static_cast<uint32_t>(__builtin_popcount(mask));
+}
+
+// ── hardware/audio_effect.h ────────────────────────────────────────────────
+
+typedef struct
+{
+    void *getBuffer;
+    void *releaseBuffer;
+    void *cookie;
+} buffer_provider_t;
+
+typedef struct
+{
+    buffer_provider_t bufferProvider;
+    uint32_t samplingRate;
+    uint32_t channels;
+    uint8_t format;
+    uint8_t accessMode;
+    uint16_t mask;
+} buffer_config_t;
+
+typedef struct
+{
+    buffer_config_t inputCfg;
+    buffer_config_t outputCfg;
+} effect_config_t;
+
+enum
+{
+    EFFECT_CMD_INIT,
+    EFFECT_CMD_SET_CONFIG,
+    EFFECT_CMD_RESET,
+    EFFECT_CMD_ENABLE,
+    EFFECT_CMD_DISABLE,
+    EFFECT_CMD_SET_PARAM,
+    EFFECT_CMD_SET_PARAM_DEFERRED,
+    EFFECT_CMD_SET_PARAM_COMMIT,
+    EFFECT_CMD_GET_PARAM,
+    EFFECT_CMD_SET_DEVICE,
+    EFFECT_CMD_SET_VOLUME,
+    EFFECT_CMD_SET_AUDIO_MODE,
+    EFFECT_CMD_SET_CONFIG_REVERSE,
+    EFFECT_CMD_SET_INPUT_DEVICE,
+    EFFECT_CMD_GET_CONFIG,
+    EFFECT_CMD_FIRST_PROPRIETARY = 0x10000,
+};
@@ -0,0 +1,190 @@
+#include "AAFilter.h"
+#include "audio_432hz.h"
+#include <complex>
+#include <cstdio>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace soundtouch;
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const uint ALL_X86_EXTENSIONS = 0xffffffff;
+
+// Impulse response of the filter, oldest tap first
+static std::vector<double> impulseResponse(AAFilter& filter) {
+    const int length = static_cast<int>(filter.getLength());
+    std::vector<float> in(2 * length + 1, 0.0f);
+    std::vector<float> out(in.size(), 0.0f);
+    in[length] = 1.0f;
+    const int n = filter.evaluate(out.data(), in.data(), static_cast<uint>(in.size()), 1);
+    return std::vector<double>(out.begin(), out.begin() + n);
+}
+
+// Frequency response at 'f' (cycles per sample)
+static std::complex<double> response(const std::vector<double>& h, double f) {
+    std::complex<double> sum = 0.0;
+    for (size_t n = 0; n < h.size(); n++) {
+        sum += h[n] * std::polar(1.0, -2.0 * M_PI * f * n);
+    }
+    return sum;
+}
+
+static double db(std::complex<double> v) {
+    return 20.0 * std::log10(std::abs(v) + 1e-12);
+}
+
+// Test 1: Response and group delay of the linear- and minimum-phase designs
+static void checkDesign(uint length, bool minimumPhase, double minStopBandDb) {
+    const double cutoff = 0.4;
+    AAFilter filter(length);
+    filter.setMinimumPhase(minimumPhase);
+    filter.setCutoffFreq(cutoff);
+    const std::vector<double> h = impulseResponse(filter);
+
+    double passRipple = 0.0;
+    for (double f = 0.0; f <= 0.8 * cutoff; f += 0.002) {
+        passRipple = std::fmax(passRipple, std::fabs(db(response(h, f))));
+    }
+    double stopBand = -1e9;
+    for (double f = cutoff + 0.06; f <= 0.5; f += 0.001) {
+        stopBand = std::fmax(stopBand, db(response(h, f)));
+    }
+
+    // Group delay at low frequencies from the phase slope; the impulse
+    // response starts one frame after the impulse
+    const double df = 1e-4;
+    const double slope = std::arg(response(h, 2 * df) / response(h, df)) / (2.0 * M_PI * df);
+    const double measuredDelay = -slope - 1.0;
+
+    printf("  %2u taps %-13s: pass band ±%.3f dB, stop band %.1f dB, group delay %.2f (reported %u)\n",
+           length, minimumPhase ? "minimum-phase" : "linear-phase", passRipple, stopBand,
+           measuredDelay, filter.getGroupDelay());
+    ASSERT_TRUE(passRipple < 0.1);
+    ASSERT_TRUE(stopBand < -minStopBandDb);
+    ASSERT_TRUE(std::fabs(measuredDelay - filter.getGroupDelay()) < 1.0);
+    if (minimumPhase) {
+        ASSERT_TRUE(filter.getGroupDelay() < length / 8);
+    } else {
+        ASSERT_TRUE(filter.getGroupDelay() == length - 1 - length / 2);
+    }
+}
+
+void test_designs() {
+    printf("\n[TEST 1] Anti-alias filter designs (cutoff 0.4)\n");
+    checkDesign(64, false, 55.0);
+    checkDesign(64, true, 50.0);
+    checkDesign(32, true, 45.0);
+}
+
+// Test 2: Minimum-phase coefficients run on the SIMD FIR kernels
+void test_sse_matches_generic() {
+    printf("\n[TEST 2] Minimum-phase filter: SIMD matches generic version\n");
+    for (uint channels = 1; channels <= 2; channels++) {
+        AAFilter fast(32, ALL_X86_EXTENSIONS);
+        AAFilter plain(32, 0);
+        for (AAFilter* f : {&fast, &plain}) {
+            f->setMinimumPhase(true);
+            f->setCutoffFreq(0.491);
+        }
+
+        const uint frames = 2000;
+        std::vector<float> src(frames * channels);
+        uint32_t seed = 99;
+        for (float& v : src) {
+            seed = seed * 1664525u + 1013904223u;
+            v = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+        }
+        std::vector<float> outFast(src.size(), 0.0f);
+        std::vector<float> outPlain(src.size(), 0.0f);
+        const uint nFast = fast.evaluate(outFast.data(), src.data(), frames, channels);
+        const uint nPlain = plain.evaluate(outPlain.data(), src.data(), frames, channels);
+
+        float maxDiff = 0.0f;
+        for (uint i = 0; i < std::min(nFast, nPlain) * channels; i++) {
+            maxDiff = std::fmax(maxDiff, std::fabs(outFast[i] - outPlain[i]));
+        }
+        printf("  ch=%u: %u vs %u frames, max diff %.2e\n", channels, nFast, nPlain, maxDiff);
+        // SIMD stereo versions return an even count
+        ASSERT_TRUE(nFast > 0 && nFast <= nPlain && nPlain - nFast <= 1);
+        ASSERT_TRUE(maxDiff < 1e-5f);
+    }
+}
+
+// Test 3: Low-delay profiles report less latency and keep the pitch
+static double zeroCrossingHz(const std::vector<int16_t>& stereo, int sampleRate) {
+    long first = -1;
+    long last = -1;
+    int crossings = 0;
+    for (long i = 1; i < static_cast<long>(stereo.size()) / 2; i++) {
+        if (stereo[2 * (i - 1)] < 0 && stereo[2 * i] >= 0) {
+            if (first < 0) first = i;
+            last = i;
+            crossings++;
+        }
+    }
+    return crossings > 1 ? (crossings - 1) * static_cast<double>(sampleRate) / (last - first) : 0.0;
+}
+
+void test_converter_profiles() {
+    printf("\n[TEST 3] Converter processing profiles\n");
+    const char* const names[] = {"music", "voip", "game"};
+    float latency[3];
+    for (int p = 0; p < 3; p++) {
+        Audio432HzConverter converter(48000, 2);
+        converter.setPitchShiftSemitones(12.0f * std::log2(432.0f / 440.0f));
+        ASSERT_TRUE(converter.getProcessingProfile() == ProcessingProfile::kMusic);
+        converter.setProcessingProfile(static_cast<ProcessingProfile>(p));
+        ASSERT_TRUE(converter.getProcessingProfile() == static_cast<ProcessingProfile>(p));
+        latency[p] = converter.getLatencyMs();
+
+        std::vector<int16_t> all;
+        std::vector<int16_t> buffer(2 * 480);
+        for (int block = 0; block < 300; block++) {
+            for (int i = 0; i < 480; i++) {
+                const double t = (block * 480 + i) / 48000.0;
+                buffer[2 * i] = buffer[2 * i + 1] =
+                    static_cast<int16_t>(10000.0 * std::sin(2.0 * M_PI * 1000.0 * t));
+            }
+            converter.process(buffer.data(), 2 * 480);
+            if (block >= 50) all.insert(all.end(), buffer.begin(), buffer.end());
+        }
+        const double hz = zeroCrossingHz(all, 48000);
+        printf("  %-5s: latency %.2f ms, 1000 Hz in → %.2f Hz out\n", names[p], latency[p], hz);
+        ASSERT_TRUE(latency[p] > 0.0f);
+        ASSERT_TRUE(std::fabs(hz - 1000.0 * 432.0 / 440.0) < 2.0);
+    }
+    ASSERT_TRUE(latency[1] < latency[0]);
+    ASSERT_TRUE(latency[2] < latency[0]);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Anti-Alias Filter Tests\n");
+    printf("========================================\n");
+
+    test_designs();
+    test_sse_matches_generic();
+    test_converter_profiles();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,330 @@
+#include "SoundTouch.h"
+#include "TDStretch.h"
+#include "audio_432hz.h"
+#include "latency_budget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace soundtouch;
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int RATE = 48000;
+static const int CHANNELS = 2;
+static const int CALLBACK = RATE / 200;  // 5 ms
+static const double TEMPO = 440.0 / 432.0;
+static const int TIERS = static_cast<int>(LatencyTier::kMinimum) + 1;
+
+// Sustained stereo pad with a slow vibrato: stationary material
+static std::vector<float> pad(size_t frames) {
+    static const double partials[] = {110.0, 164.8, 220.0, 277.2, 329.6, 440.0};
+    std::vector<float> pcm(frames * CHANNELS);
+    double phase[6] = {0};
+    for (size_t i = 0; i < frames; i++) {
+        double s = 0.0;
+        for (int k = 0; k < 6; k++) {
+            phase[k] += 2.0 * M_PI * partials[k] * (1.0 + 0.003 * std::sin(2.0 * M_PI * 4.0 * i / RATE)) / RATE;
+            s += 0.1 / (1.0 + 0.3 * k) * std::sin(phase[k]);
+        }
+        pcm[i * CHANNELS] = static_cast<float>(s);
+        pcm[i * CHANNELS + 1] = static_cast<float>(0.9 * s);
+    }
+    return pcm;
+}
+
+// The pad under decaying noise bursts at irregular intervals around 300 ms;
+// 'onsets' receives their frames
+static std::vector<float> drums(size_t frames, std::vector<size_t>& onsets) {
+    std::vector<float> pcm = pad(frames);
+    uint32_t seed = 17;
+    for (size_t at = RATE / 4; at + RATE / 10 < frames;) {
+        onsets.push_back(at);
+        for (int i = 0; i < RATE / 10; i++) {
+            const double env = 0.5 * std::exp(-i / (0.015 * RATE));
+            for (int c = 0; c < CHANNELS; c++) {
+                seed = seed * 1664525u + 1013904223u;
+                pcm[(at + i) * CHANNELS + c] += static_cast<float>(env * (seed / 4294967296.0 - 0.5));
+            }
+        }
+        seed = seed * 1664525u + 1013904223u;
+        at += RATE / 4 + seed % (RATE / 8);
+    }
+    return pcm;
+}
+
+// Tempo changer on the plain C kernels that counts its overlap searches,
+// their multiply-adds and the sequences of each length
+class Probe : public TDStretch {
+public:
+    Probe(LatencyTier tier, bool adaptive) {
+        const LatencyTierSettings& s = latencyTierSettings(tier);
+        setChannels(CHANNELS);
+        setParameters(RATE, s.sequenceMs, s.seekWindowMs, s.overlapMs);
+        setTempo(TEMPO);
+        enableAdaptiveSequence(adaptive);
+    }
+    uint64_t work = 0;
+    int longs = 0, sequences = 0;
+
+    uint seeks() const { return seekSerial; }
+    int maxSampleReq = 0;
+
+    // Whole input in 5 ms calls, output into 'out'
+    void run(const std::vector<float>& in, std::vector<float>* out = nullptr) {
+        std::vector<float> buffer(static_cast<size_t>(4 * CALLBACK) * CHANNELS);
+        const size_t frames = in.size() / CHANNELS;
+        uint done = seqCount;
+        for (size_t pos = 0; pos + CALLBACK <= frames; pos += CALLBACK) {
+            putSamples(&in[pos * CHANNELS], CALLBACK);
+            for (; done < seqCount; done++, sequences++) longs += seqLongLog[(done + 1) % SEEK_LOG_LENGTH];
+            maxSampleReq = std::max(maxSampleReq, sampleReq);
+            uint got;
+            while ((got = receiveSamples(buffer.data(), 4 * CALLBACK)) > 0) {
+                if (out) out->insert(out->end(), buffer.begin(), buffer.begin() + got * CHANNELS);
+            }
+        }
+    }
+
+protected:
+    double calcCrossCorr(const float* mixingPos, const float* compare, double& norm) override {
+        work += static_cast<uint64_t>(channels) * overlapLength;
+        return TDStretch::calcCrossCorr(mixingPos, compare, norm);
+    }
+    double calcCrossCorrAccumulate(const float* mixingPos, const float* compare, double& norm) override {
+        work += static_cast<uint64_t>(channels) * overlapLength;
+        return TDStretch::calcCrossCorrAccumulate(mixingPos, compare, norm);
+    }
+};
+
+// Onsets of channel 0: 1 ms blocks whose high-passed energy jumps 20 dB
+// over the 20 ms before them, at least 100 ms apart
+static std::vector<size_t> findOnsets(const std::vector<float>& pcm) {
+    const int block = RATE / 1000;
+    std::vector<double> energy;
+    for (size_t i = 1; (i + block) * CHANNELS <= pcm.size(); i += block) {
+        double e = 0.0;
+        for (int k = 0; k < block; k++) {
+            const double d = pcm[(i + k) * CHANNELS] - pcm[(i + k - 1) * CHANNELS];
+            e += d * d;
+        }
+        energy.push_back(e);
+    }
+    std::vector<size_t> onsets;
+    for (size_t b = 20; b < energy.size(); b++) {
+        double before = 0.0;
+        for (size_t k = b - 20; k < b; k++) before += energy[k] / 20.0;
+        if (energy[b] > 100.0 * before && (onsets.empty() || b * block > onsets.back() + RATE / 10)) {
+            onsets.push_back(b * block);
+        }
+    }
+    return onsets;
+}
+
+// Test 1: The setting reaches the tempo changer and leaves the latency alone
+void test_setting() {
+    printf("\n[TEST 1] SETTING_ADAPTIVE_SEQUENCE\n");
+    SoundTouch st;
+    st.setChannels(CHANNELS);
+    st.setSampleRate(RATE);
+    st.setPitchSemiTones(PITCH_SEMITONES_432_HZ);
+    applyLatencyTier(st, LatencyTier::kBalanced);
+    const int latency = st.getSetting(SETTING_INITIAL_LATENCY);
+    ASSERT_TRUE(st.getSetting(SETTING_ADAPTIVE_SEQUENCE) == 0);
+    ASSERT_TRUE(st.setSetting(SETTING_ADAPTIVE_SEQUENCE, 1));
+    ASSERT_TRUE(st.getSetting(SETTING_ADAPTIVE_SEQUENCE) == 1);
+    ASSERT_TRUE(st.getSetting(SETTING_INITIAL_LATENCY) == latency);
+}
+
+// Test 2: On a stationary pad most sequences are long: fewer and cheaper
+// searches on every tier, and never more input needed than set
+void test_stationary() {
+    printf("\n[TEST 2] Searches on a stationary pad\n");
+    const std::vector<float> in = pad(6 * RATE);
+    for (int t = 0; t < TIERS; t++) {
+        Probe fixed(static_cast<LatencyTier>(t), false);
+        Probe adaptive(static_cast<LatencyTier>(t), true);
+        fixed.run(in);
+        adaptive.run(in);
+        const double seekRatio = static_cast<double>(adaptive.seeks()) / fixed.seeks();
+        const double workRatio = static_cast<double>(adaptive.work) / fixed.work;
+        printf("  tier %d: %.1f -> %.1f searches/s, work %.0f%%, %d of %d sequences long\n", t,
+               fixed.seeks() / 6.0, adaptive.seeks() / 6.0, 100.0 * workRatio, adaptive.longs,
+               adaptive.sequences);
+        // A long sequence searches a third of the window, or at least 5 ms
+        const int seekMs = latencyTierSettings(static_cast<LatencyTier>(t)).seekWindowMs;
+        if (seekMs > 5) {
+            ASSERT_TRUE(seekRatio < 0.95);
+            ASSERT_TRUE(workRatio < (seekMs >= 15 ? 0.5 : 0.8));
+        } else {
+            ASSERT_TRUE(seekRatio <= 1.0);
+            ASSERT_TRUE(workRatio <= 1.0);
+        }
+        ASSERT_TRUE(adaptive.maxSampleReq <= fixed.maxSampleReq);
+    }
+}
+
+// Test 3: Onsets keep the set lengths, so fewer sequences are long than on
+// the bare pad, and the onsets come out once each, their timing as steady as
+// with fixed sequences (within 10%, about what the 1 ms onset grid resolves
+// on the longest tier)
+void test_transients() {
+    printf("\n[TEST 3] Noise bursts over the pad\n");
+    std::vector<size_t> onsets;
+    const std::vector<float> in = drums(16 * RATE, onsets);
+    for (int t = 0; t < TIERS; t++) {
+        double jitter[2];
+        size_t matched[2], extra[2];
+        double longShare = 0.0;
+        for (int adaptive = 0; adaptive < 2; adaptive++) {
+            Probe probe(static_cast<LatencyTier>(t), adaptive != 0);
+            std::vector<float> out;
+            probe.run(in, &out);
+            if (adaptive) longShare = static_cast<double>(probe.longs) / probe.sequences;
+            const std::vector<size_t> heard = findOnsets(out);
+
+            // Displacement of each onset from where the tempo and the delay
+            // of the first one put it; output onsets that match none are
+            // doubled transients or splice clicks
+            std::vector<double> shift;
+            const double delay = heard.empty() ? 0.0 : heard[0] - onsets[0] / TEMPO;
+            for (size_t onset : onsets) {
+                const double expected = onset / TEMPO + delay;
+                for (size_t h : heard) {
+                    if (std::fabs(h - expected) < 0.05 * RATE) {
+                        shift.push_back(h - expected);
+                        break;
+                    }
+                }
+            }
+            double mean = 0.0, var = 0.0;
+            for (double d : shift) mean += d / shift.size();
+            for (double d : shift) var += (d - mean) * (d - mean) / shift.size();
+            jitter[adaptive] = 1000.0 * std::sqrt(var) / RATE;
+            matched[adaptive] = shift.size();
+            extra[adaptive] = heard.size() - shift.size();
+        }
+        printf("  tier %d: %zu onsets; fixed %zu heard, %zu extra, jitter %.2f ms; adaptive %zu heard, "
+               "%zu extra, jitter %.2f ms, %.0f%% long\n",
+               t, onsets.size(), matched[0], extra[0], jitter[0], matched[1], extra[1], jitter[1],
+               100.0 * longShare);
+        ASSERT_TRUE(longShare < 0.5);
+        ASSERT_TRUE(matched[1] == onsets.size());
+        ASSERT_TRUE(extra[1] <= extra[0]);
+        ASSERT_TRUE(jitter[1] <= 1.1 * jitter[0]);
+    }
+}
+
+// Test 4: In 5 ms callbacks the adaptive engine keeps up wherever the fixed
+// one does: once the output has started it never runs short
+void test_cadence() {
+    printf("\n[TEST 4] Output cadence in 5 ms callbacks\n");
+    std::vector<size_t> onsets;
+    const std::vector<float> in = drums(8 * RATE, onsets);
+    for (int t = 0; t < TIERS; t++) {
+        int shortCalls[2];
+        for (int adaptive = 0; adaptive < 2; adaptive++) {
+            SoundTouch st;
+            st.setChannels(CHANNELS);
+            st.setSampleRate(RATE);
+            st.setPitchSemiTones(PITCH_SEMITONES_432_HZ);
+            applyLatencyTier(st, static_cast<LatencyTier>(t));
+            st.setSetting(SETTING_ADAPTIVE_SEQUENCE, adaptive);
+
+            std::vector<float> out(static_cast<size_t>(CALLBACK) * CHANNELS);
+            bool started = false;
+            shortCalls[adaptive] = 0;
+            for (size_t pos = 0; pos + CALLBACK <= in.size() / CHANNELS; pos += CALLBACK) {
+                st.putSamples(&in[pos * CHANNELS], CALLBACK);
+                const uint got = st.receiveSamples(out.data(), CALLBACK);
+                if (started && got < static_cast<uint>(CALLBACK)) shortCalls[adaptive]++;
+                started = started || got == static_cast<uint>(CALLBACK);
+            }
+        }
+        printf("  tier %d: short callbacks after start %d fixed, %d adaptive\n", t, shortCalls[0],
+               shortCalls[1]);
+        ASSERT_TRUE(shortCalls[1] <= shortCalls[0]);
+    }
+}
+
+// Test 5: Planar engines linked by a seek leader follow its lengths and
+// splice where it does, so a follower processes its channel linearly:
+// out(B + C) == out(B) + out(C), whatever the lengths the leader switches to
+void test_linked() {
+    printf("\n[TEST 5] Seek leader and followers\n");
+    std::vector<size_t> onsets;
+    const std::vector<float> stereo = drums(4 * RATE, onsets);
+    const size_t frames = stereo.size() / CHANNELS;
+    std::vector<float> in[4];
+    for (size_t i = 0; i < frames; i++) {
+        const double t = static_cast<double>(i) / RATE;
+        in[0].push_back(stereo[i * CHANNELS]);
+        in[1].push_back(static_cast<float>(0.3 * std::sin(2.0 * M_PI * 700.0 * t)));
+        in[2].push_back(static_cast<float>(0.3 * std::sin(2.0 * M_PI * 1900.0 * t)));
+        in[3].push_back(in[1].back() + in[2].back());
+    }
+
+    SoundTouch engines[4];
+    for (SoundTouch& st : engines) {
+        st.setChannels(1);
+        st.setSampleRate(RATE);
+        st.setPitchSemiTones(PITCH_SEMITONES_432_HZ);
+        applyLatencyTier(st, LatencyTier::kBalanced);
+        st.setSetting(SETTING_ADAPTIVE_SEQUENCE, 1);
+    }
+    for (int e = 1; e < 4; e++) engines[e].setSeekLeader(&engines[0]);
+
+    std::vector<float> out[4];
+    std::vector<float> buffer(CALLBACK);
+    for (size_t pos = 0; pos + CALLBACK <= frames; pos += CALLBACK) {
+        for (int e = 0; e < 4; e++) {
+            engines[e].putSamples(&in[e][pos], CALLBACK);
+            const uint got = engines[e].receiveSamples(buffer.data(), CALLBACK);
+            out[e].insert(out[e].end(), buffer.begin(), buffer.begin() + got);
+        }
+    }
+    double maxErr = 0.0;
+    for (size_t i = 0; i < out[3].size(); i++) {
+        maxErr = std::max(maxErr, static_cast<double>(std::fabs(out[3][i] - out[1][i] - out[2][i])));
+    }
+    printf("  %zu frames out, max deviation from linearity %.2g\n", out[3].size(), maxErr);
+    ASSERT_TRUE(!out[3].empty());
+    ASSERT_TRUE(out[1].size() == out[3].size() && out[2].size() == out[3].size());
+    ASSERT_TRUE(maxErr < 1e-4);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Adaptive Sequence Tests\n");
+    printf("========================================\n");
+
+    test_setting();
+    test_stationary();
+    test_transients();
+    test_cadence();
+    test_linked();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
+
@@ -1,10 +1,13 @@
 #include "audio_432hz.h"
 #include "audio_pipeline.h"
+#include "output_hash.h"
 #include <cstdio>
 #include <cmath>
 #include <cstring>
 #include <vector>
 #include <cassert>
+#include <algorithm>
+#include <cstdlib>
 
 using namespace audioshift::dsp;
 
@@ -151,6 +154,342 @@ void test_process_zero_samples() {
     ASSERT_TRUE(result == 0);
 }
 
+// Test 11: Planar mode toggles and processes
+void test_planar_toggle() {
+    printf("\n[TEST 11] Planar mode toggle\n");
+    Audio432HzConverter converter(48000, 2);
+    ASSERT_TRUE(!converter.isPlanarProcessing());
+
+    converter.setPlanarProcessing(true);
+    ASSERT_TRUE(converter.isPlanarProcessing());
+
+    std::vector<int16_t> buffer(1920);
+    int produced = 0;
+    bool allProcessed = true;
+    for (int block = 0; block < 50; block++) {
+        for (int i = 0; i < 1920; i++) {
+            buffer[i] = static_cast<int16_t>(8000.0 * std::sin(2.0 * M_PI * 440.0 * (block * 960 + i / 2) / 48000.0));
+        }
+        if (converter.process(buffer.data(), 1920) != 1920) allProcessed = false;
+        for (int16_t s : buffer) {
+            if (s != 0) produced++;
+        }
+    }
+    ASSERT_TRUE(allProcessed);
+    ASSERT_TRUE(produced > 0);
+
+    converter.setPlanarProcessing(false);
+    ASSERT_TRUE(!converter.isPlanarProcessing());
+}
+
+// Runs a planar converter on L = 440 Hz and R = the given right-channel
+// partials, returning the right output channel
+static std::vector<int16_t> planarRightChannel(double f1, double a1, double f2, double a2) {
+    Audio432HzConverter converter(48000, 2);
+    converter.setPlanarProcessing(true);
+
+    std::vector<int16_t> right;
+    std::vector<int16_t> buffer(1920);
+    for (int block = 0; block < 100; block++) {
+        for (int i = 0; i < 960; i++) {
+            const double t = (block * 960 + i) / 48000.0;
+            buffer[2 * i] = static_cast<int16_t>(0.4 * 32767.0 * std::sin(2.0 * M_PI * 440.0 * t));
+            buffer[2 * i + 1] = static_cast<int16_t>(32767.0 * (a1 * std::sin(2.0 * M_PI * f1 * t) +
+                                                                a2 * std::sin(2.0 * M_PI * f2 * t)));
+        }
+        converter.process(buffer.data(), 1920);
+        for (int i = 0; i < 960; i++) {
+            right.push_back(buffer[2 * i + 1]);
+        }
+    }
+    return right;
+}
+
+// Test 12: Planar channels splice at identical positions
+void test_planar_phase_locked() {
+    printf("\n[TEST 12] Planar channels stay phase-locked\n");
+
+    // All channels splice where channel 0 does, so with a fixed left channel
+    // the right channel is processed linearly: out(B + C) == out(B) + out(C).
+    // Independent seeking would pick content-dependent splice points instead.
+    std::vector<int16_t> outB = planarRightChannel(700.0, 0.3, 0.0, 0.0);
+    std::vector<int16_t> outC = planarRightChannel(0.0, 0.0, 1900.0, 0.3);
+    std::vector<int16_t> outBC = planarRightChannel(700.0, 0.3, 1900.0, 0.3);
+
+    int maxErr = 0;
+    for (size_t i = 0; i < outBC.size(); i++) {
+        maxErr = std::max(maxErr, std::abs(outBC[i] - outB[i] - outC[i]));
+    }
+    ASSERT_TRUE(maxErr <= 3);
+}
+
+// Runs 50 blocks of a two-tone stereo signal, returning the per-buffer hashes
+static std::vector<uint64_t> deterministicRun(Audio432HzConverter& converter,
+                                              std::vector<int16_t>* output) {
+    std::vector<uint64_t> hashes;
+    std::vector<int16_t> buffer(1920);
+    for (int block = 0; block < 50; block++) {
+        for (int i = 0; i < 960; i++) {
+            const double t = (block * 960 + i) / 48000.0;
+            buffer[2 * i] = static_cast<int16_t>(12000.0 * std::sin(2.0 * M_PI * 440.0 * t));
+            buffer[2 * i + 1] = static_cast<int16_t>(9000.0 * std::sin(2.0 * M_PI * 660.0 * t));
+        }
+        converter.process(buffer.data(), 1920);
+        hashes.push_back(converter.getLastBufferHash());
+        if (output) output->insert(output->end(), buffer.begin(), buffer.end());
+    }
+    return hashes;
+}
+
+// Test 13: Deterministic mode reproduces identical hashes
+void test_deterministic_hashes() {
+    printf("\n[TEST 13] Deterministic mode hashes\n");
+    Audio432HzConverter normal(48000, 2);
+    ASSERT_TRUE(!normal.isDeterministic());
+    deterministicRun(normal, nullptr);
+    ASSERT_TRUE(normal.getLastBufferHash() == 0);
+    ASSERT_TRUE(normal.getStreamHash() == 0);
+
+    Audio432HzConverter a(48000, 2);
+    Audio432HzConverter b(48000, 2);
+    a.setDeterministic(true);
+    b.setDeterministic(true);
+    ASSERT_TRUE(a.isDeterministic());
+
+    std::vector<int16_t> outA;
+    std::vector<uint64_t> hashesA = deterministicRun(a, &outA);
+    std::vector<uint64_t> hashesB = deterministicRun(b, nullptr);
+    ASSERT_TRUE(hashesA == hashesB);
+    ASSERT_TRUE(a.getStreamHash() == b.getStreamHash());
+    ASSERT_TRUE(hashesA.front() != hashesA.back());
+
+    // the stream hash covers exactly the samples handed back to the caller
+    ASSERT_TRUE(a.getStreamHash() == OutputHash::hash(outA.data(), outA.size() * sizeof(int16_t)));
+}
+
+// Test 14: Deterministic planar mode hashes reproduce as well
+void test_deterministic_planar() {
+    printf("\n[TEST 14] Deterministic planar mode\n");
+    Audio432HzConverter a(48000, 2);
+    Audio432HzConverter b(48000, 2);
+    a.setDeterministic(true);
+    a.setPlanarProcessing(true);
+    b.setPlanarProcessing(true);
+    b.setDeterministic(true);
+
+    ASSERT_TRUE(deterministicRun(a, nullptr) == deterministicRun(b, nullptr));
+    ASSERT_TRUE(a.getStreamHash() != 0);
+}
+
+// Fills a stereo buffer with an equal-tempered triad tuned to 'referenceHz'
+static void fillTriad(std::vector<int16_t>& buffer, int block, float referenceHz) {
+    const int frames = static_cast<int>(buffer.size() / 2);
+    for (int i = 0; i < frames; i++) {
+        const double t = (block * frames + i) / 48000.0;
+        double v = 0.0;
+        for (int n = 0; n < 3; n++) {
+            const double f0 = referenceHz * std::pow(2.0, (n == 0 ? 0 : n == 1 ? 4 : 7) / 12.0);
+            v += std::sin(2.0 * M_PI * f0 * t) + 0.5 * std::sin(4.0 * M_PI * f0 * t);
+        }
+        buffer[2 * i] = static_cast<int16_t>(4000.0 * v);
+        buffer[2 * i + 1] = static_cast<int16_t>(4000.0 * v);
+    }
+}
+
+// Test 15: Content already at 432 Hz ends up passed through untouched
+void test_auto_bypass_432() {
+    printf("\n[TEST 15] Auto-bypass on 432 Hz content\n");
+    Audio432HzConverter converter(48000, 2);
+    ASSERT_TRUE(!converter.isAutoBypass());
+    converter.setAutoBypass(true);
+    ASSERT_TRUE(converter.isAutoBypass());
+
+    std::vector<int16_t> buffer(1920);
+    std::vector<int16_t> input;
+    for (int block = 0; block < 750; block++) {
+        fillTriad(buffer, block, 432.0f);
+        input = buffer;
+        converter.process(buffer.data(), 1920);
+    }
+    ASSERT_TRUE(converter.isBypassed());
+    ASSERT_NEAR(converter.getEstimatedReferenceHz(), 432.0f, 1.0f);
+    ASSERT_TRUE(buffer == input);
+
+    // switching it off restarts normal processing
+    converter.setAutoBypass(false);
+    ASSERT_TRUE(!converter.isBypassed());
+    ASSERT_TRUE(converter.getEstimatedReferenceHz() == 0.0f);
+}
+
+// Test 16: Standard 440 Hz content keeps being processed
+void test_auto_bypass_440() {
+    printf("\n[TEST 16] No auto-bypass on 440 Hz content\n");
+    Audio432HzConverter converter(48000, 2);
+    converter.setAutoBypass(true);
+
+    std::vector<int16_t> buffer(1920);
+    std::vector<int16_t> input;
+    bool everBypassed = false;
+    for (int block = 0; block < 750; block++) {
+        fillTriad(buffer, block, 440.0f);
+        input = buffer;
+        converter.process(buffer.data(), 1920);
+        everBypassed = everBypassed || converter.isBypassed();
+    }
+    ASSERT_TRUE(!everBypassed);
+    ASSERT_NEAR(converter.getEstimatedReferenceHz(), 440.0f, 1.0f);
+    ASSERT_TRUE(buffer != input);
+}
+
+// Test 17: A rate switch keeps playing: no gap, no click
+static void checkRateSwitch(int fromRate, int toRate, bool planar) {
+    Audio432HzConverter converter(fromRate, 2);
+    converter.setPitchShiftSemitones(12.0f * std::log2(432.0f / 440.0f));
+    converter.setPlanarProcessing(planar);
+
+    // 1 kHz tone that stays continuous in time across the switch
+    std::vector<int16_t> out;
+    std::vector<int16_t> buffer;
+    double t = 0.0;
+    int rate = fromRate;
+    for (int block = 0; block < 200; block++) {
+        if (block == 100) {
+            rate = toRate;
+            converter.setSampleRate(rate);
+        }
+        const int frames = rate / 100;
+        buffer.resize(2 * frames);
+        for (int i = 0; i < frames; i++) {
+            buffer[2 * i] = buffer[2 * i + 1] = static_cast<int16_t>(10000.0 * std::sin(2.0 * M_PI * 1000.0 * t));
+            t += 1.0 / rate;
+        }
+        converter.process(buffer.data(), 2 * frames);
+        if (block >= 100) {
+            for (int i = 0; i < frames; i++) out.push_back(buffer[2 * i]);
+        }
+    }
+
+    // Envelope over whole periods of the shifted tone for the first 100 ms,
+    // and the largest step across the 10 ms crossfade against the steepest
+    // slope of the tone itself
+    const int period = static_cast<int>(std::lround(toRate / (1000.0 * 432.0 / 440.0)));
+    double minRms = 1e9;
+    for (int w = 0; w + period < toRate / 10; w += period / 4) {
+        double energy = 0.0;
+        for (int i = w; i < w + period; i++) energy += static_cast<double>(out[i]) * out[i];
+        minRms = std::min(minRms, std::sqrt(energy / period));
+    }
+    int maxStep = 0;
+    for (int i = 1; i < toRate / 50; i++) maxStep = std::max(maxStep, std::abs(out[i] - out[i - 1]));
+    const double slope = 10000.0 * 2.0 * M_PI * 1000.0 * 432.0 / 440.0 / toRate;
+
+    printf("  %d → %d Hz%s: min RMS %.0f (tone %.0f), max step %d (tone %.0f)\n", fromRate, toRate,
+           planar ? " planar" : "", minRms, 10000.0 / std::sqrt(2.0), maxStep, slope);
+    ASSERT_TRUE(minRms > 0.9 * 10000.0 / std::sqrt(2.0));
+    ASSERT_TRUE(maxStep < 1.1 * slope);
+}
+
+void test_seamless_rate_switch() {
+    printf("\n[TEST 17] Seamless sample-rate switch\n");
+    checkRateSwitch(48000, 44100, false);
+    checkRateSwitch(44100, 48000, false);
+    checkRateSwitch(48000, 44100, true);
+}
+
+// Test 18: Footprint reporting and release after a burst
+void test_memory_usage() {
+    printf("\n[TEST 18] Memory usage and shrinkToFit()\n");
+    Audio432HzConverter converter(48000, 2);
+    converter.setPitchShiftSemitones(12.0f * std::log2(432.0f / 440.0f));
+
+    std::vector<int16_t> tone(2 * 9600);
+    for (size_t i = 0; i < tone.size(); i++) {
+        tone[i] = static_cast<int16_t>(8000.0 * std::sin(2.0 * M_PI * 440.0 * (i / 2) / 48000.0));
+    }
+    std::vector<int16_t> buffer;
+    auto run = [&](int frames) {
+        buffer.assign(tone.begin(), tone.begin() + 2 * frames);
+        converter.process(buffer.data(), 2 * frames);
+    };
+    const MemoryUsage idle = converter.getMemoryUsage();
+    ASSERT_TRUE(idle.allocatedBytes > 0 && idle.usedBytes <= idle.allocatedBytes);
+
+    // One oversized callback, then steady 10 ms buffers
+    run(9600);
+    for (int i = 0; i < 20; i++) run(480);
+    const MemoryUsage burst = converter.getMemoryUsage();
+    ASSERT_TRUE(burst.allocatedBytes > idle.allocatedBytes);
+    ASSERT_TRUE(burst.usedBytes <= burst.allocatedBytes);
+    ASSERT_TRUE(burst.peakUsedBytes >= burst.usedBytes);
+
+    converter.shrinkToFit();
+    for (int i = 0; i < 20; i++) run(480);
+    converter.shrinkToFit();
+    const MemoryUsage shrunk = converter.getMemoryUsage();
+    printf("  allocated: idle %zu, after burst %zu, shrunk %zu bytes (used %zu)\n",
+           idle.allocatedBytes, burst.allocatedBytes, shrunk.allocatedBytes, shrunk.usedBytes);
+    ASSERT_TRUE(shrunk.allocatedBytes < burst.allocatedBytes);
+    ASSERT_TRUE(shrunk.usedBytes <= shrunk.allocatedBytes);
+
+    // Processing carries on from the buffered audio
+    bool audible = false;
+    run(480);
+    for (int i = 0; i < 2 * 480; i++) audible = audible || buffer[i] != 0;
+    ASSERT_TRUE(audible);
+}
+
+// Test 19: The float entry point runs the same stream as the int16 one,
+// without the 16-bit rounding of its input and output
+static void checkFloatStream(int rate, bool planar, bool bandSplit) {
+    Audio432HzConverter a(rate, 2);
+    Audio432HzConverter b(rate, 2);
+    for (Audio432HzConverter* c : {&a, &b}) {
+        c->setDeterministic(true);
+        c->setPlanarProcessing(planar);
+        c->setBandSplit(bandSplit);
+    }
+
+    const int frames = rate / 100;
+    std::vector<int16_t> pcm(2 * frames);
+    std::vector<float> samples(2 * frames);
+    double maxDiff = 0.0;
+    double peak = 0.0;
+    bool complete = true;
+    for (int block = 0; block < 100; block++) {
+        for (int i = 0; i < frames; i++) {
+            const double t = (static_cast<double>(block) * frames + i) / rate;
+            pcm[2 * i] = static_cast<int16_t>(12000.0 * std::sin(2.0 * M_PI * 440.0 * t));
+            pcm[2 * i + 1] = static_cast<int16_t>(9000.0 * std::sin(2.0 * M_PI * 660.0 * t));
+        }
+        for (size_t i = 0; i < pcm.size(); i++) samples[i] = pcm[i] / 32768.0f;
+        a.process(pcm.data(), static_cast<int>(pcm.size()));
+        complete = complete && b.process(samples.data(), samples.data(), frames) == frames;
+        for (size_t i = 0; i < pcm.size(); i++) {
+            maxDiff = std::max(maxDiff, std::fabs(samples[i] * 32768.0 - pcm[i]));
+            peak = std::max(peak, std::fabs(samples[i] * 32768.0));
+        }
+    }
+    printf("  %d Hz%s%s: max difference to the int16 stream %.2f LSB16 (peak %.0f)\n", rate,
+           planar ? " planar" : "", bandSplit ? " band split" : "", maxDiff, peak);
+    ASSERT_TRUE(complete);
+    ASSERT_TRUE(peak > 10000.0);
+    // The int16 stream also rounds its low band, on the way down and back
+    ASSERT_TRUE(maxDiff < (bandSplit ? 4.0 : 2.0));
+    ASSERT_TRUE(b.getStreamHash() != 0 && b.getStreamHash() != a.getStreamHash());
+}
+
+void test_float_stream() {
+    printf("\n[TEST 19] Float entry point\n");
+    checkFloatStream(48000, false, false);
+    checkFloatStream(48000, true, false);
+    checkFloatStream(96000, false, true);
+
+    Audio432HzConverter converter(48000, 2);
+    float sample = 0.0f;
+    ASSERT_TRUE(converter.process(static_cast<const float*>(nullptr), &sample, 1) == 0);
+    ASSERT_TRUE(converter.process(&sample, &sample, 0) == 0);
+}
+
 int main(int argc, char* argv[]) {
     printf("========================================\n");
     printf("AudioShift DSP Library Unit Tests\n");
@@ -166,6 +505,15 @@ int main(int argc, char* argv[]) {
     test_pipeline_processInPlace();
     test_process_null_buffer();
     test_process_zero_samples();
+    test_planar_toggle();
+    test_planar_phase_locked();
+    test_deterministic_hashes();
+    test_deterministic_planar();
+    test_auto_bypass_432();
+    test_auto_bypass_440();
+    test_seamless_rate_switch();
+    test_memory_usage();
+    test_float_stream();
 
     printf("\n========================================\n");
     printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
@@ -0,0 +1,189 @@
+#include "audio_432hz.h"
+#include "band_split.h"
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+// Stereo test signal: audible tone plus an ultrasonic one
+static int16_t sampleAt(long n, int c, int sampleRate, bool audible = true) {
+    const double t = static_cast<double>(n) / sampleRate;
+    const double tone = audible ? std::sin(2.0 * M_PI * (c ? 1500.0 : 1000.0) * t) : 0.0;
+    const double ultrasonic = std::sin(2.0 * M_PI * 30000.0 * t);
+    return static_cast<int16_t>(std::lround(8000.0 * tone + 4000.0 * ultrasonic));
+}
+
+// Frequency of a mono tone from its positive-going zero crossings
+static double zeroCrossingHz(const std::vector<int16_t>& interleaved, int channel,
+                             int channels, int sampleRate) {
+    long first = -1;
+    long last = -1;
+    int crossings = 0;
+    const long frames = static_cast<long>(interleaved.size()) / channels;
+    for (long i = 1; i < frames; i++) {
+        if (interleaved[(i - 1) * channels + channel] < 0 &&
+            interleaved[i * channels + channel] >= 0) {
+            if (first < 0) first = i;
+            last = i;
+            crossings++;
+        }
+    }
+    return crossings > 1 ? (crossings - 1) * static_cast<double>(sampleRate) / (last - first) : 0.0;
+}
+
+// Test 1: Supported rates
+void test_base_rates() {
+    printf("\n[TEST 1] Base rate selection\n");
+    ASSERT_TRUE(BandSplitter::baseRateFor(96000) == 48000);
+    ASSERT_TRUE(BandSplitter::baseRateFor(192000) == 48000);
+    ASSERT_TRUE(BandSplitter::baseRateFor(88200) == 44100);
+    ASSERT_TRUE(BandSplitter::baseRateFor(176400) == 44100);
+    ASSERT_TRUE(BandSplitter::baseRateFor(48000) == 0);
+    ASSERT_TRUE(BandSplitter::baseRateFor(44100) == 0);
+    ASSERT_TRUE(BandSplitter::baseRateFor(64000) == 0);
+}
+
+// Test 2: Split + merge is a pure delay when the low band comes back as it
+// went out, and leaves only the ultrasonic band when the low band is muted
+static void checkReconstruction(int sampleRate, int lowLatency, bool muteLowBand) {
+    BandSplitter splitter(sampleRate, 2);
+    splitter.setLowBandLatency(lowLatency);
+    const int delay = splitter.latencyFrames();
+    ASSERT_TRUE(delay > 0);
+
+    // Odd buffer sizes exercise the decimator phase carry-over
+    std::vector<int16_t> buffer(2 * 1031);
+    std::vector<int16_t> low(2 * (1031 / splitter.factor() + 1));
+    std::vector<int16_t> lowDelayLine(2 * lowLatency, 0);
+    long n = 0;
+    int maxError = 0;
+    for (int block = 0; block < 60; block++) {
+        const int frames = 1031 - (block % 3) * 200;
+        for (int i = 0; i < frames; i++) {
+            for (int c = 0; c < 2; c++) buffer[2 * i + c] = sampleAt(n + i, c, sampleRate);
+        }
+        const int lowFrames = splitter.split(buffer.data(), frames, low.data());
+
+        // Stand-in for the converter: a plain delay of 'lowLatency' base-rate frames
+        lowDelayLine.insert(lowDelayLine.end(), low.begin(), low.begin() + 2 * lowFrames);
+        std::vector<int16_t> delayedLow(lowDelayLine.begin(), lowDelayLine.begin() + 2 * lowFrames);
+        lowDelayLine.erase(lowDelayLine.begin(), lowDelayLine.begin() + 2 * lowFrames);
+        if (muteLowBand) std::fill(delayedLow.begin(), delayedLow.end(), 0);
+
+        splitter.merge(delayedLow.data(), lowFrames, buffer.data(), frames);
+        for (int i = 0; i < frames; i++) {
+            const long src = n + i - delay;
+            if (src < 4 * delay) continue;  // skip the filters' start-up transient
+            for (int c = 0; c < 2; c++) {
+                const int expected = sampleAt(src, c, sampleRate, !muteLowBand);
+                maxError = std::max(maxError, std::abs(buffer[2 * i + c] - expected));
+            }
+        }
+        n += frames;
+    }
+    printf("  %d Hz, low-band latency %d%s: delay %d frames, max error %d LSB\n",
+           sampleRate, lowLatency, muteLowBand ? ", low band muted" : "", delay, maxError);
+    ASSERT_TRUE(maxError <= (muteLowBand ? 16 : 0));
+}
+
+void test_reconstruction() {
+    printf("\n[TEST 2] Split/merge reconstructs the input\n");
+    checkReconstruction(96000, 0, false);
+    checkReconstruction(192000, 0, false);
+    checkReconstruction(88200, 0, false);
+    checkReconstruction(96000, 37, false);
+    checkReconstruction(96000, 0, true);
+    checkReconstruction(192000, 37, true);
+    checkReconstruction(176400, 11, true);
+}
+
+// Test 3: The converter shifts the audible band at hi-res rates
+void test_converter_band_split() {
+    printf("\n[TEST 3] Converter in band-split mode\n");
+    Audio432HzConverter converter(96000, 2);
+    converter.setPitchShiftSemitones(12.0f * std::log2(432.0f / 440.0f));
+    ASSERT_TRUE(!converter.isBandSplit());
+    converter.setBandSplit(true);
+    ASSERT_TRUE(converter.isBandSplit());
+    ASSERT_TRUE(converter.isBandSplitActive());
+
+    std::vector<int16_t> all;
+    std::vector<int16_t> buffer(2 * 960);
+    for (int block = 0; block < 200; block++) {
+        for (int i = 0; i < 960; i++) {
+            const double t = (block * 960 + i) / 96000.0;
+            const int16_t v = static_cast<int16_t>(10000.0 * std::sin(2.0 * M_PI * 1000.0 * t));
+            buffer[2 * i] = v;
+            buffer[2 * i + 1] = v;
+        }
+        converter.process(buffer.data(), 2 * 960);
+        if (block >= 50) all.insert(all.end(), buffer.begin(), buffer.end());
+    }
+    const double hz = zeroCrossingHz(all, 0, 2, 96000);
+    printf("  1000 Hz in → %.2f Hz out\n", hz);
+    ASSERT_TRUE(std::fabs(hz - 1000.0 * 432.0 / 440.0) < 2.0);
+
+    // not a hi-res rate: remembered but inactive
+    converter.setSampleRate(48000);
+    ASSERT_TRUE(converter.isBandSplit());
+    ASSERT_TRUE(!converter.isBandSplitActive());
+    converter.setSampleRate(192000);
+    ASSERT_TRUE(converter.isBandSplitActive());
+}
+
+// Test 4: Band split brings 192 kHz cost well below full-rate processing
+static double secondsFor(bool bandSplit) {
+    Audio432HzConverter converter(192000, 2);
+    converter.setBandSplit(bandSplit);
+    std::vector<int16_t> input(2 * 192000 * 3);
+    for (size_t i = 0; i < input.size(); i++) input[i] = sampleAt(static_cast<long>(i / 2), 0, 192000);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < input.size(); offset += 2 * 1920) {
+        converter.process(input.data() + offset, 2 * 1920);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void test_band_split_cost() {
+    printf("\n[TEST 4] 192 kHz cost\n");
+    const double full = secondsFor(false);
+    const double split = secondsFor(true);
+    printf("  3 s of 192 kHz stereo: full-rate %.3f s, band-split %.3f s\n", full, split);
+    ASSERT_TRUE(split < full);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Band-Split Tests\n");
+    printf("========================================\n");
+
+    test_base_rates();
+    test_reconstruction();
+    test_converter_band_split();
+    test_band_split_cost();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+#include "batch_convert.h"
+#include "stream_convert.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int RATE = 48000;
+static std::string g_dir;
+
+// Stereo tone starting after 'lead' frames of silence
+static std::vector<int16_t> tone(int frames, int lead, double hz) {
+    std::vector<int16_t> pcm(static_cast<size_t>(frames) * 2, 0);
+    for (int i = lead; i < frames; i++) {
+        pcm[2 * i] = pcm[2 * i + 1] =
+            static_cast<int16_t>(std::lround(10000.0 * std::sin(2.0 * M_PI * hz * i / RATE)));
+    }
+    return pcm;
+}
+
+static std::vector<uint8_t> wav(const std::vector<int16_t>& pcm) {
+    std::vector<uint8_t> file(WAV_HEADER_BYTES);
+    makeWavHeader(file.data(), RATE, 2, pcm.size() / 2);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pcm.data());
+    file.insert(file.end(), bytes, bytes + pcm.size() * sizeof(int16_t));
+    return file;
+}
+
+static std::string path(const std::string& name) {
+    return g_dir + "/" + name;
+}
+
+static void writeFile(const std::string& name, const std::vector<uint8_t>& data) {
+    FILE* f = fopen(path(name).c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+static std::vector<uint8_t> readFile(const std::string& name) {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(path(name).c_str(), "rb");
+    if (!f) return data;
+    uint8_t buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) data.insert(data.end(), buffer, buffer + n);
+    fclose(f);
+    return data;
+}
+
+static BatchJob job(const std::string& in, const std::string& out) {
+    BatchJob j;
+    j.input = path(in);
+    j.output = path(out);
+    return j;
+}
+
+static const int16_t* samples(const std::vector<uint8_t>& file) {
+    return reinterpret_cast<const int16_t*>(file.data() + WAV_HEADER_BYTES);
+}
+
+static double measureHz(const int16_t* pcm, size_t from, size_t to) {
+    long first = -1, last = -1, crossings = 0;
+    for (size_t i = from + 1; i < to; i++) {
+        if (pcm[2 * (i - 1)] < 0 && pcm[2 * i] >= 0) {
+            if (first < 0) first = static_cast<long>(i);
+            last = static_cast<long>(i);
+            crossings++;
+        }
+    }
+    return crossings > 1 ? (crossings - 1) * static_cast<double>(RATE) / (last - first) : 0.0;
+}
+
+// Largest step between neighbouring samples of channel 0 in [from, to)
+static int largestStep(const int16_t* pcm, size_t from, size_t to) {
+    int worst = 0;
+    for (size_t i = from + 1; i < to; i++) {
+        worst = std::max(worst, std::abs(pcm[2 * i] - pcm[2 * (i - 1)]));
+    }
+    return worst;
+}
+
+static bool sameInode(const std::string& a, const std::string& b) {
+    struct stat sa, sb;
+    return stat(a.c_str(), &sa) == 0 && stat(b.c_str(), &sb) == 0 && sa.st_ino == sb.st_ino;
+}
+
+static int countFiles(const std::string& dir, const char* part) {
+    DIR* d = opendir(dir.c_str());
+    int count = 0;
+    while (dirent* e = readdir(d)) {
+        if (strstr(e->d_name, part)) count++;
+    }
+    closedir(d);
+    return count;
+}
+
+// Test 1: A file shorter than a chunk converts exactly as streamConvert() does
+void test_single_chunk() {
+    printf("\n[TEST 1] Single chunk matches the stream converter\n");
+    const std::vector<uint8_t> input = wav(tone(4 * RATE + 77, RATE / 3, 1000.0));
+    writeFile("short.wav", input);
+
+    std::vector<BatchJob> jobs = {job("short.wav", "short.out.wav")};
+    BatchStats stats;
+    ASSERT_TRUE(batchConvert(jobs, BatchOptions(), &stats) == 0);
+    ASSERT_TRUE(jobs[0].status == 0 && !jobs[0].cached);
+    ASSERT_TRUE(stats.converted == 1 && stats.chunks == 1 && stats.failed == 0);
+
+    const int inFd = open(path("short.wav").c_str(), O_RDONLY);
+    const int outFd = open(path("short.stream.wav").c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_TRUE(streamConvert(inFd, outFd, StreamOptions(), nullptr) == 0);
+    close(inFd);
+    close(outFd);
+    const std::vector<uint8_t> batch = readFile("short.out.wav");
+    ASSERT_TRUE(batch.size() == input.size());
+    ASSERT_TRUE(batch == readFile("short.stream.wav"));
+}
+
+// Test 2: Long files split into chunks: seamless, and the same on any thread count
+void test_chunked() {
+    printf("\n[TEST 2] Chunked long files\n");
+    const int frames = 41 * RATE;
+    writeFile("long.wav", wav(tone(frames, RATE / 2, 1000.0)));
+    writeFile("long2.wav", wav(tone(23 * RATE, 0, 440.0)));
+
+    BatchOptions options;
+    options.chunkSeconds = 8.0;
+    options.threads = 1;
+    std::vector<BatchJob> jobs = {job("long.wav", "long.1.wav"), job("long2.wav", "long2.1.wav")};
+    BatchStats one;
+    ASSERT_TRUE(batchConvert(jobs, options, &one) == 0);
+    ASSERT_TRUE(one.converted == 2 && one.chunks == 5 + 3);
+    ASSERT_TRUE(one.steals == 0);
+
+    options.threads = 4;
+    jobs = {job("long.wav", "long.4.wav"), job("long2.wav", "long2.4.wav")};
+    BatchStats four;
+    ASSERT_TRUE(batchConvert(jobs, options, &four) == 0);
+    printf("  1 thread %.0fx real time, 4 threads %.0fx, %llu tasks stolen\n",
+           one.audioSeconds / one.wallSeconds, four.audioSeconds / four.wallSeconds,
+           static_cast<unsigned long long>(four.steals));
+    const std::vector<uint8_t> out = readFile("long.1.wav");
+    ASSERT_TRUE(out == readFile("long.4.wav"));
+    ASSERT_TRUE(readFile("long2.1.wav") == readFile("long2.4.wav"));
+    ASSERT_TRUE(out.size() == WAV_HEADER_BYTES + static_cast<size_t>(frames) * 4);
+
+    // the pitch holds across every seam, and no seam clicks: a 982 Hz tone
+    // at this level never steps more than about 1290 between samples
+    const int16_t* s = samples(out);
+    const double expected = 1000.0 * 432.0 / 440.0;
+    ASSERT_TRUE(std::fabs(measureHz(s, RATE, frames - RATE / 10) - expected) < 0.5);
+    const int chunk = static_cast<int>(options.chunkSeconds * RATE);
+    double worstHz = 0.0;
+    int worstStep = 0;
+    for (int k = 1; k < 5; k++) {
+        worstHz = std::max(worstHz, std::fabs(measureHz(s, k * chunk - RATE / 20, k * chunk + RATE / 20) - expected));
+        worstStep = std::max(worstStep, largestStep(s, k * chunk - RATE / 10, k * chunk + RATE / 10));
+    }
+    printf("  around the seams: worst pitch error %.2f Hz, largest step %d\n", worstHz, worstStep);
+    ASSERT_TRUE(worstHz < 2.0);
+    ASSERT_TRUE(worstStep < 1400);
+    ASSERT_TRUE(largestStep(s, RATE, frames) < 1400);
+}
+
+// Test 3: Re-runs are served from the cache as hard links
+void test_cache() {
+    printf("\n[TEST 3] Content-hash cache\n");
+    writeFile("a.wav", wav(tone(2 * RATE, 0, 500.0)));
+    writeFile("b.wav", wav(tone(3 * RATE, 0, 700.0)));
+    BatchOptions options;
+    options.cacheDir = path("cache");
+    std::vector<BatchJob> jobs = {job("a.wav", "a.out.wav"), job("b.wav", "b.out.wav")};
+
+    BatchStats stats;
+    ASSERT_TRUE(batchConvert(jobs, options, &stats) == 0);
+    ASSERT_TRUE(stats.converted == 2 && stats.cached == 0);
+    ASSERT_TRUE(countFiles(options.cacheDir, ".wav") == 2);
+    const std::vector<uint8_t> a = readFile("a.out.wav");
+    struct stat st;
+    ASSERT_TRUE(stat(path("a.out.wav").c_str(), &st) == 0 && st.st_nlink == 2);
+
+    // outputs already linked: nothing to do
+    ASSERT_TRUE(batchConvert(jobs, options, &stats) == 0);
+    ASSERT_TRUE(stats.converted == 0 && stats.cached == 2 && stats.chunks == 0);
+    ASSERT_TRUE(jobs[0].cached && jobs[1].cached);
+    ASSERT_TRUE(readFile("a.out.wav") == a);
+
+    // a deleted output is linked again; another name for the same content hits too
+    unlink(path("a.out.wav").c_str());
+    jobs.push_back(job("a.wav", "a.copy.wav"));
+    ASSERT_TRUE(batchConvert(jobs, options, &stats) == 0);
+    ASSERT_TRUE(stats.cached == 3 && readFile("a.out.wav") == a);
+    ASSERT_TRUE(sameInode(path("a.out.wav"), path("a.copy.wav")));
+
+    // changed input or changed settings: converted again
+    writeFile("b.wav", wav(tone(3 * RATE, 0, 800.0)));
+    ASSERT_TRUE(batchConvert(jobs, options, &stats) == 0);
+    ASSERT_TRUE(stats.converted == 1 && stats.cached == 2 && !jobs[1].cached);
+    options.pitchSemitones = -1.0f;
+    ASSERT_TRUE(batchConvert(jobs, options, &stats) == 0);
+    // the two jobs of a.wav may share one conversion, depending on timing
+    ASSERT_TRUE(stats.converted >= 2 && stats.converted + stats.cached == 3);
+    ASSERT_TRUE(readFile("a.out.wav") != a);
+    ASSERT_TRUE(countFiles(options.cacheDir, ".wav") == 5);
+}
+
+// Test 4: A failed job reports its error without disturbing the others
+void test_failures() {
+    printf("\n[TEST 4] Failed jobs\n");
+    std::vector<uint8_t> eightBit = wav(tone(100, 0, 1000.0));
+    eightBit[34] = 8;
+    writeFile("eight.wav", eightBit);
+    writeFile("good.wav", wav(tone(RATE, 0, 1000.0)));
+    std::vector<BatchJob> jobs = {job("missing.wav", "missing.out.wav"), job("eight.wav", "eight.out.wav"),
+                                  job("good.wav", "good.out.wav"), job("good.wav", "nodir/good.out.wav")};
+    BatchStats stats;
+    ASSERT_TRUE(batchConvert(jobs, BatchOptions(), &stats) == -ENOENT);
+    ASSERT_TRUE(jobs[0].status == -ENOENT);
+    ASSERT_TRUE(jobs[1].status == -EINVAL);
+    ASSERT_TRUE(jobs[2].status == 0 && readFile("good.out.wav").size() == WAV_HEADER_BYTES + RATE * 4u);
+    ASSERT_TRUE(jobs[3].status == -ENOENT);
+    ASSERT_TRUE(stats.converted == 1 && stats.failed == 3);
+    ASSERT_TRUE(access(path("eight.out.wav").c_str(), F_OK) != 0);
+    ASSERT_TRUE(countFiles(g_dir, ".tmp") == 0);
+
+    BatchOptions options;
+    options.chunkSeconds = 0.0;
+    ASSERT_TRUE(batchConvert(jobs, options, &stats) == -EINVAL);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Batch Conversion Tests\n");
+    printf("========================================\n");
+
+    char dir[] = "/tmp/audioshift_batch_XXXXXX";
+    if (!mkdtemp(dir)) return 1;
+    g_dir = dir;
+
+    test_single_chunk();
+    test_chunked();
+    test_cache();
+    test_failures();
+
+    const std::string cleanup = "rm -rf " + g_dir;
+    if (system(cleanup.c_str()) != 0) fprintf(stderr, "could not remove %s\n", dir);
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
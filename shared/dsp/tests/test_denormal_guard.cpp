@@ -0,0 +1,192 @@
+#include "audio_432hz.h"
+#include "denormal_guard.h"
+#include "effect_core.h"
+#include "soundtouch_backend.h"
+#include "tuning_estimator.h"
+
+#include <algorithm>
+#include <cfenv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int RATE = 48000;
+static const int CHANNELS = 2;
+static const int BLOCK = 480;  // 10 ms
+static const int TONE_BLOCKS = 200;  // 2 s of tone, then the fade
+static const int TOTAL_BLOCKS = 1000;
+
+// Product of a subnormal and 1: zero when subnormals are flushed
+static bool flushing() {
+    volatile float tiny = 1e-39f;
+    volatile float one = 1.0f;
+    return tiny * one == 0.0f;
+}
+
+// 440 Hz at full level for TONE_BLOCKS, then an exponential fade
+// (-87 dB/s) into digital silence: int16 reaches it after about 1 s,
+// 32-bit PCM after 2 s
+static double fadeSample(long frame) {
+    const double t = static_cast<double>(frame) / RATE;
+    const double fadeStart = static_cast<double>(TONE_BLOCKS * BLOCK) / RATE;
+    const double env = t < fadeStart ? 1.0 : std::exp(-(t - fadeStart) / 0.1);
+    return 0.5 * env * std::sin(2.0 * M_PI * 440.0 * t);
+}
+
+static void fillFade(std::vector<int16_t>& buffer, int block) {
+    buffer.resize(static_cast<size_t>(BLOCK) * CHANNELS);
+    for (int i = 0; i < BLOCK; i++) {
+        const int16_t v = static_cast<int16_t>(std::lround(32767.0 * fadeSample(static_cast<long>(block) * BLOCK + i)));
+        for (int c = 0; c < CHANNELS; c++) buffer[static_cast<size_t>(i) * CHANNELS + c] = v;
+    }
+}
+
+static void fillFade(std::vector<int32_t>& buffer, int block) {
+    buffer.resize(static_cast<size_t>(BLOCK) * CHANNELS);
+    for (int i = 0; i < BLOCK; i++) {
+        const int32_t v =
+            static_cast<int32_t>(std::llround(2147483647.0 * fadeSample(static_cast<long>(block) * BLOCK + i)));
+        for (int c = 0; c < CHANNELS; c++) buffer[static_cast<size_t>(i) * CHANNELS + c] = v;
+    }
+}
+
+static double median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+// Runs the fade through 'process' one block per call; returns the median
+// call time of the last second of tone and of the silent tail (last 4 s)
+template <class Sample, class Fn>
+static void timeFade(Fn process, double* tone, double* tail) {
+    std::vector<Sample> buffer;
+    std::vector<double> toneUs, tailUs;
+    for (int b = 0; b < TOTAL_BLOCKS; b++) {
+        fillFade(buffer, b);
+        const auto t0 = std::chrono::steady_clock::now();
+        process(buffer.data());
+        const double us =
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        if (b >= TONE_BLOCKS - 100 && b < TONE_BLOCKS) toneUs.push_back(us);
+        if (b >= TOTAL_BLOCKS - 400) tailUs.push_back(us);
+    }
+    *tone = median(toneUs);
+    *tail = median(tailUs);
+}
+
+// Test 1: The guard flushes while it lives, nests, and restores the mode
+void test_guard_scope() {
+    printf("\n[TEST 1] Guard scope\n");
+    if (!DenormalGuard::supported()) {
+        printf("  (no flush-to-zero control on this target)\n");
+        DenormalGuard guard;
+        ASSERT_TRUE(!flushing());
+        return;
+    }
+    ASSERT_TRUE(!flushing());
+    {
+        DenormalGuard outer;
+        ASSERT_TRUE(flushing());
+        {
+            DenormalGuard inner;
+            ASSERT_TRUE(flushing());
+        }
+        ASSERT_TRUE(flushing());  // the inner guard found it set
+    }
+    ASSERT_TRUE(!flushing());
+}
+
+// Test 2: process() hands back the caller's FP mode: rounding untouched,
+// subnormals neither flushed afterwards nor unflushed for a caller that
+// flushes itself
+void test_caller_mode() {
+    printf("\n[TEST 2] Caller's FP mode survives process()\n");
+    Audio432HzConverter converter(RATE, CHANNELS);
+    converter.setAutoBypass(true);
+    EffectCore<SoundTouchBackend> core;
+    ASSERT_TRUE(core.setFormat(RATE, CHANNELS, PcmFormat::kInt32) == 0);
+    ASSERT_TRUE(core.enable() == 0);
+
+    std::vector<int16_t> pcm16;
+    std::vector<int32_t> pcm32;
+    fillFade(pcm16, 0);
+    fillFade(pcm32, 0);
+
+    ASSERT_TRUE(std::fesetround(FE_TOWARDZERO) == 0);
+    converter.process(pcm16.data(), BLOCK * CHANNELS);
+    ASSERT_TRUE(std::fegetround() == FE_TOWARDZERO && !flushing());
+    core.process(pcm32.data(), pcm32.data(), BLOCK);
+    ASSERT_TRUE(std::fegetround() == FE_TOWARDZERO && !flushing());
+    std::fesetround(FE_TONEAREST);
+
+    if (DenormalGuard::supported()) {
+        DenormalGuard caller;
+        converter.process(pcm16.data(), BLOCK * CHANNELS);
+        core.process(pcm32.data(), pcm32.data(), BLOCK);
+        ASSERT_TRUE(flushing());
+    }
+    ASSERT_TRUE(!flushing());
+}
+
+// Test 3: Benchmark — the silent tail after a fade costs no more than the
+// music before it. Unguarded, the tuning estimator's band-pass rings down
+// into subnormals and stays there; the control run shows what that costs
+// on this host.
+void test_fade_tail() {
+    printf("\n[TEST 3] Exponential fade tail\n");
+    double tone, tail;
+
+    TuningEstimator estimator(RATE);
+    timeFade<int16_t>([&](int16_t* pcm) { estimator.analyze(pcm, BLOCK, CHANNELS); }, &tone, &tail);
+    printf("  control, unguarded tuning estimator: tone %.1f us, tail %.1f us per call (%.1fx)\n", tone,
+           tail, tail / tone);
+
+    Audio432HzConverter converter(RATE, CHANNELS);
+    converter.setAutoBypass(true);
+    timeFade<int16_t>([&](int16_t* pcm) { converter.process(pcm, BLOCK * CHANNELS); }, &tone, &tail);
+    printf("  Audio432HzConverter, int16: tone %.1f us, tail %.1f us per call (%.2fx)\n", tone, tail,
+           tail / tone);
+    if (DenormalGuard::supported()) ASSERT_TRUE(tail < 1.5 * tone);
+
+    EffectCore<SoundTouchBackend> core;
+    core.setFormat(RATE, CHANNELS, PcmFormat::kInt32);
+    core.enable();
+    timeFade<int32_t>([&](int32_t* pcm) { core.process(pcm, pcm, BLOCK); }, &tone, &tail);
+    printf("  EffectCore, 32-bit: tone %.1f us, tail %.1f us per call (%.2fx)\n", tone, tail, tail / tone);
+    if (DenormalGuard::supported()) ASSERT_TRUE(tail < 1.5 * tone);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Denormal Guard Tests\n");
+    printf("========================================\n");
+
+    test_guard_scope();
+    test_caller_mode();
+    test_fade_tail();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+#include "converter_backend.h"
+#include "effect_command.h"
+#include "effect_core.h"
+#include "latency_budget.h"
+#include "soundtouch_backend.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int BLOCK = 480;  // 10 ms at 48 kHz
+
+// Output devices (audio_devices_t)
+static const uint32_t DEVICE_SPEAKER = 0x2;
+static const uint32_t DEVICE_SCO_HEADSET = 0x20;
+static const uint32_t DEVICE_A2DP = 0x80;
+
+// Sentinel: a status the dispatcher never writes
+static const int UNSET = 1;
+
+static effect_config_t makeConfig(uint32_t rate, uint32_t channels, uint32_t format) {
+    effect_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.inputCfg.samplingRate = rate;
+    config.inputCfg.channels = channels;
+    config.inputCfg.format = static_cast<uint8_t>(format);
+    config.outputCfg = config.inputCfg;
+    return config;
+}
+
+// Sends one command the way AudioFlinger does, with room for a status
+// reply. Returns the status, or UNSET if the command was not handled;
+// 'reply' receives what landed in the reply buffer
+template <class Backend>
+static int send(EffectCore<Backend>& core, effect_config_t& config, uint32_t cmdCode,
+                uint32_t cmdSize = 0, void* cmd = nullptr, int* reply = nullptr) {
+    int replyData = UNSET;
+    uint32_t replySize = sizeof(replyData);
+    int status = UNSET;
+    if (!handleEffectCommand(core, config, cmdCode, cmdSize, cmd, &replySize, &replyData, status)) {
+        return UNSET;
+    }
+    if (reply) *reply = replyData;
+    return status;
+}
+
+// 1 kHz sine on every channel through 'seconds' of callbacks; returns the
+// frequency of the last second from its rising zero crossings
+template <class Backend>
+static double runTone(EffectCore<Backend>& core, int rate, double seconds) {
+    const int channels = core.channels();
+    const long total = static_cast<long>(seconds * rate);
+    std::vector<int16_t> buffer(static_cast<size_t>(BLOCK) * channels);
+    long first = -1, last = -1, crossings = 0;
+    int16_t previous = 0;
+    for (long pos = 0; pos + BLOCK <= total; pos += BLOCK) {
+        for (int i = 0; i < BLOCK; i++) {
+            const int16_t v = static_cast<int16_t>(
+                std::lround(10000.0 * std::sin(2.0 * M_PI * 1000.0 * (pos + i) / rate)));
+            for (int c = 0; c < channels; c++) buffer[static_cast<size_t>(i) * channels + c] = v;
+        }
+        core.process(buffer.data(), buffer.data(), BLOCK);
+        for (int i = 0; i < BLOCK; i++) {
+            const int16_t v = buffer[static_cast<size_t>(i) * channels];
+            if (pos + i >= total - rate && previous < 0 && v >= 0) {
+                if (first < 0) first = pos + i;
+                last = pos + i;
+                crossings++;
+            }
+            previous = v;
+        }
+    }
+    return crossings > 1 ? (crossings - 1) * static_cast<double>(rate) / (last - first) : 0.0;
+}
+
+// Test 1: INIT, then SET_CONFIG negotiation and GET_CONFIG
+template <class Backend>
+void test_config(const char* name) {
+    printf("\n[TEST 1] INIT, SET_CONFIG and GET_CONFIG (%s)\n", name);
+    EffectCore<Backend> core;
+    effect_config_t config = makeConfig(48000, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT);
+    int reply = UNSET;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_INIT, 0, nullptr, &reply) == 0 && reply == 0);
+
+    effect_config_t requested = makeConfig(44100, AUDIO_CHANNEL_OUT_MONO, AUDIO_FORMAT_PCM_16_BIT);
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_CONFIG, sizeof(requested), &requested, &reply) == 0);
+    ASSERT_TRUE(reply == 0);
+    ASSERT_TRUE(core.sampleRate() == 44100 && core.channels() == 1);
+    ASSERT_TRUE(memcmp(&config, &requested, sizeof(config)) == 0);
+
+    // output fields left at 0 take the input's
+    requested = makeConfig(48000, AUDIO_CHANNEL_OUT_5POINT1, AUDIO_FORMAT_PCM_24_BIT_PACKED);
+    requested.outputCfg.samplingRate = 0;
+    requested.outputCfg.channels = 0;
+    requested.outputCfg.format = AUDIO_FORMAT_DEFAULT;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_CONFIG, sizeof(requested), &requested) == 0);
+    ASSERT_TRUE(core.sampleRate() == 48000 && core.channels() == 6);
+    ASSERT_TRUE(core.pcmFormat() == PcmFormat::kInt24Packed);
+
+    // refused: float, mismatched output, an unsupported rate, a short
+    // command; the config and the format stay
+    const effect_config_t accepted = config;
+    const effect_config_t refused[] = {
+        makeConfig(48000, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_FLOAT),
+        [] {
+            effect_config_t c = makeConfig(48000, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT);
+            c.outputCfg.samplingRate = 44100;
+            return c;
+        }(),
+        makeConfig(4000, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT),
+    };
+    for (effect_config_t c : refused) {
+        reply = UNSET;
+        ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_CONFIG, sizeof(c), &c, &reply) == -EINVAL);
+        ASSERT_TRUE(reply == -EINVAL);
+    }
+    requested = makeConfig(44100, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT);
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_CONFIG, sizeof(requested) - 1, &requested) == -EINVAL);
+    ASSERT_TRUE(memcmp(&config, &accepted, sizeof(config)) == 0);
+    ASSERT_TRUE(core.sampleRate() == 48000 && core.channels() == 6);
+
+    effect_config_t current;
+    uint32_t replySize = sizeof(current);
+    int status = UNSET;
+    ASSERT_TRUE(handleEffectCommand(core, config, EFFECT_CMD_GET_CONFIG, 0, nullptr, &replySize,
+                                    &current, status));
+    ASSERT_TRUE(status == 0 && memcmp(&current, &accepted, sizeof(current)) == 0);
+    replySize = sizeof(current) - 1;
+    ASSERT_TRUE(handleEffectCommand(core, config, EFFECT_CMD_GET_CONFIG, 0, nullptr, &replySize,
+                                    &current, status));
+    ASSERT_TRUE(status == -EINVAL);
+}
+
+// Test 2: ENABLE allocates the engine and shifts; DISABLE passes through
+template <class Backend>
+void test_enable(const char* name) {
+    printf("\n[TEST 2] ENABLE and DISABLE (%s)\n", name);
+    EffectCore<Backend> core;
+    core.setAutoBypass(false);
+    effect_config_t config = makeConfig(48000, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT);
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_CONFIG, sizeof(config), &config) == 0);
+    ASSERT_TRUE(!core.hasEngine());
+
+    int reply = UNSET;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_ENABLE, 0, nullptr, &reply) == 0 && reply == 0);
+    ASSERT_TRUE(core.isEnabled() && core.hasEngine());
+    const double hz = runTone(core, 48000, 2.0);
+    printf("  %s: 1000 Hz in → %.2f Hz out\n", name, hz);
+    ASSERT_TRUE(std::fabs(hz - 1000.0 * 432.0 / 440.0) < 2.0);
+
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_DISABLE, 0, nullptr, &reply) == 0 && reply == 0);
+    ASSERT_TRUE(!core.isEnabled() && core.hasEngine());
+    ASSERT_TRUE(std::fabs(runTone(core, 48000, 2.0) - 1000.0) < 1.0);
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_RESET) == 0);
+}
+
+// Test 3: SET_DEVICE takes the sink latency from the device and retunes
+// the running engine into the budget
+template <class Backend>
+void test_set_device(const char* name) {
+    printf("\n[TEST 3] SET_DEVICE (%s)\n", name);
+    EffectCore<Backend> core;
+    core.setAutoBypass(false);
+    effect_config_t config = makeConfig(48000, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT);
+    ASSERT_TRUE(core.setLatencyBudget(-1.0f, 40.0f) == 0);
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_ENABLE) == 0);
+
+    uint32_t device = DEVICE_SPEAKER;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_DEVICE, sizeof(device), &device) == 0);
+    ASSERT_TRUE(core.settings().sinkLatencyMs == 0.0f);
+    const float speakerMs = core.latencyMs();
+
+    device = DEVICE_A2DP;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_DEVICE, sizeof(device), &device) == 0);
+    ASSERT_TRUE(core.settings().sinkLatencyMs == deviceSinkLatencyMs(DEVICE_A2DP));
+    ASSERT_TRUE(core.settings().latencyBudgetMs == 40.0f);
+    const float a2dpMs = core.latencyMs();
+    printf("  %s: %.1f ms on the speaker, %.1f ms on A2DP (40 ms budget)\n", name, speakerMs,
+           a2dpMs);
+    ASSERT_TRUE(a2dpMs + core.settings().sinkLatencyMs <= 40.0f);
+    ASSERT_TRUE(a2dpMs < speakerMs);
+    ASSERT_TRUE(std::fabs(runTone(core, 48000, 2.0) - 1000.0 * 432.0 / 440.0) < 2.0);
+
+    device = DEVICE_SCO_HEADSET;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_DEVICE, sizeof(device), &device) == 0);
+    ASSERT_TRUE(core.settings().sinkLatencyMs == deviceSinkLatencyMs(DEVICE_SCO_HEADSET));
+
+    // the status of SET_DEVICE is not echoed into the reply
+    int reply = UNSET;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_DEVICE, 0, &device, &reply) == -EINVAL);
+    ASSERT_TRUE(reply == UNSET);
+    ASSERT_TRUE(core.settings().sinkLatencyMs == deviceSinkLatencyMs(DEVICE_SCO_HEADSET));
+}
+
+// Test 4: SET_AUDIO_MODE puts calls on the voice profile
+template <class Backend>
+void test_audio_mode(const char* name) {
+    printf("\n[TEST 4] SET_AUDIO_MODE (%s)\n", name);
+    EffectCore<Backend> core;
+    effect_config_t config = makeConfig(48000, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT);
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_ENABLE) == 0);
+
+    uint32_t mode = AUDIO_MODE_IN_COMMUNICATION;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_AUDIO_MODE, sizeof(mode), &mode) == 0);
+    ASSERT_TRUE(core.isVoiceCall() && core.engineProfile() == ProcessingProfile::kVoip);
+    mode = AUDIO_MODE_RINGTONE;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_AUDIO_MODE, sizeof(mode), &mode) == 0);
+    ASSERT_TRUE(!core.isVoiceCall() && core.engineProfile() == ProcessingProfile::kMusic);
+    mode = AUDIO_MODE_IN_CALL;
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_AUDIO_MODE, sizeof(mode), &mode) == 0);
+    ASSERT_TRUE(core.isVoiceCall());
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_AUDIO_MODE, 0, nullptr) == -EINVAL);
+    ASSERT_TRUE(core.isVoiceCall());
+}
+
+// Test 5: Missing replies are refused; the effect's own commands fall through
+void test_malformed() {
+    printf("\n[TEST 5] Malformed and unhandled commands\n");
+    EffectCore<SoundTouchBackend> core;
+    effect_config_t config = makeConfig(48000, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT);
+    int status = UNSET;
+    uint32_t replySize = 0;
+    int reply = UNSET;
+    ASSERT_TRUE(handleEffectCommand(core, config, EFFECT_CMD_INIT, 0, nullptr, nullptr, nullptr,
+                                    status));
+    ASSERT_TRUE(status == -EINVAL);
+    ASSERT_TRUE(handleEffectCommand(core, config, EFFECT_CMD_SET_CONFIG, sizeof(config), &config,
+                                    &replySize, &reply, status));
+    ASSERT_TRUE(status == -EINVAL && reply == UNSET);
+
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_PARAM) == UNSET);
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_SET_VOLUME) == UNSET);
+    ASSERT_TRUE(send(core, config, EFFECT_CMD_FIRST_PROPRIETARY) == UNSET);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Effect Command Tests\n");
+    printf("========================================\n");
+
+    test_config<SoundTouchBackend>("soundtouch");
+    test_config<ConverterBackend>("converter");
+    test_enable<SoundTouchBackend>("soundtouch");
+    test_enable<ConverterBackend>("converter");
+    test_set_device<SoundTouchBackend>("soundtouch");
+    test_set_device<ConverterBackend>("converter");
+    test_audio_mode<SoundTouchBackend>("soundtouch");
+    test_audio_mode<ConverterBackend>("converter");
+    test_malformed();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
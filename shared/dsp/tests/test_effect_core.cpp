@@ -0,0 +1,430 @@
+#include "converter_backend.h"
+#include "effect_core.h"
+#include "soundtouch_backend.h"
+#include "stats_page.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int RATE = 48000;
+static const int BLOCK = 480;  // 10 ms
+
+// 1 kHz sine on every channel, continuing from frame 'start'
+static void fillTone(std::vector<int16_t>& buffer, int frames, int channels, long start) {
+    buffer.resize(static_cast<size_t>(frames) * channels);
+    for (int i = 0; i < frames; i++) {
+        const int16_t v = static_cast<int16_t>(
+            std::lround(10000.0 * std::sin(2.0 * M_PI * 1000.0 * (start + i) / RATE)));
+        for (int c = 0; c < channels; c++) {
+            buffer[static_cast<size_t>(i) * channels + c] = v;
+        }
+    }
+}
+
+// Frequency of channel 0 from its rising zero crossings
+static double measureHz(const std::vector<int16_t>& pcm, int channels) {
+    const size_t frames = pcm.size() / channels;
+    long first = -1, last = -1, crossings = 0;
+    for (size_t i = 1; i < frames; i++) {
+        if (pcm[(i - 1) * channels] < 0 && pcm[i * channels] >= 0) {
+            if (first < 0) first = static_cast<long>(i);
+            last = static_cast<long>(i);
+            crossings++;
+        }
+    }
+    return crossings > 1 ? (crossings - 1) * static_cast<double>(RATE) / (last - first) : 0.0;
+}
+
+// Runs 'seconds' of tone through the core in 'block'-frame callbacks and
+// returns the output of the last second; out-of-place unless 'inPlace'
+template <class Backend>
+static std::vector<int16_t> runTone(EffectCore<Backend>& core, double seconds, int block,
+                                    bool inPlace, bool* inputIntact = nullptr) {
+    const int channels = core.channels();
+    const long total = static_cast<long>(seconds * RATE);
+    std::vector<int16_t> in, out(static_cast<size_t>(block) * channels), tail;
+    bool intact = true;
+    for (long pos = 0; pos + block <= total; pos += block) {
+        fillTone(in, block, channels, pos);
+        if (inPlace) {
+            core.process(in.data(), in.data(), block);
+            out = in;
+        } else {
+            const std::vector<int16_t> copy = in;
+            core.process(in.data(), out.data(), block);
+            intact = intact && in == copy;
+        }
+        if (pos >= total - RATE) tail.insert(tail.end(), out.begin(), out.end());
+    }
+    if (inputIntact) *inputIntact = intact;
+    return tail;
+}
+
+// Test 1: Nothing is allocated and audio passes through until enabled
+template <class Backend>
+void test_lazy_pass_through(const char* name) {
+    printf("\n[TEST 1] Pass-through before the first enable (%s)\n", name);
+    EffectCore<Backend> core;
+    ASSERT_TRUE(!core.hasEngine() && !core.isEnabled());
+    ASSERT_TRUE(core.setProfile(ProcessingProfile::kGame) == 0);
+    ASSERT_TRUE(core.memoryUsage().allocatedBytes == 0);
+
+    std::vector<int16_t> in, out(BLOCK * 2, 0);
+    fillTone(in, BLOCK, 2, 0);
+    ASSERT_TRUE(core.process(in.data(), out.data(), BLOCK) == 0);
+    ASSERT_TRUE(out == in);
+    ASSERT_TRUE(core.process(nullptr, out.data(), BLOCK) == -EINVAL);
+    ASSERT_TRUE(!core.hasEngine());
+
+    ASSERT_TRUE(core.enable() == 0 && core.hasEngine());
+    ASSERT_TRUE(core.settings().profile == ProcessingProfile::kGame);
+    core.disable();
+    ASSERT_TRUE(core.hasEngine() && !core.isEnabled());
+}
+
+// Test 2: Formats outside what the engines run are refused
+void test_format_negotiation() {
+    printf("\n[TEST 2] Format negotiation\n");
+    EffectCore<SoundTouchBackend> core;
+    ASSERT_TRUE(core.setFormat(48000, 0) == -EINVAL);
+    ASSERT_TRUE(core.setFormat(48000, EFFECT_MAX_CHANNELS + 1) == -EINVAL);
+    ASSERT_TRUE(core.setFormat(4000, 2) == -EINVAL);
+    ASSERT_TRUE(core.setFormat(384000, 2) == -EINVAL);
+    ASSERT_TRUE(core.sampleRate() == 48000 && core.channels() == 2);
+    ASSERT_TRUE(core.setFormat(44100, 1) == 0);
+    ASSERT_TRUE(core.sampleRate() == 44100 && core.channels() == 1);
+
+    // a running engine follows format changes, including more channels
+    ASSERT_TRUE(core.enable() == 0);
+    ASSERT_TRUE(core.setFormat(48000, 6) == 0 && core.channels() == 6);
+    core.setAutoBypass(false);
+    const std::vector<int16_t> out = runTone(core, 2.0, 4096, false);
+    ASSERT_TRUE(std::fabs(measureHz(out, 6) - 1000.0 * 432.0 / 440.0) < 2.0);
+}
+
+// Test 3: Both backends shift by 432/440, in place or not, bit-identically
+template <class Backend>
+void test_process(const char* name) {
+    printf("\n[TEST 3] 432 Hz shift, in place and out of place (%s)\n", name);
+    EffectCore<Backend> inPlace, outOfPlace;
+    for (EffectCore<Backend>* core : {&inPlace, &outOfPlace}) {
+        core->setAutoBypass(false);
+        ASSERT_TRUE(core->enable() == 0);
+    }
+    bool intact = false;
+    const std::vector<int16_t> a = runTone(inPlace, 3.0, BLOCK, true);
+    const std::vector<int16_t> b = runTone(outOfPlace, 3.0, BLOCK, false, &intact);
+    const double hz = measureHz(b, 2);
+    printf("  %s: %.2f Hz, latency %.1f ms\n", name, hz, outOfPlace.latencyMs());
+    ASSERT_TRUE(std::fabs(hz - 1000.0 * 432.0 / 440.0) < 2.0);
+    ASSERT_TRUE(a == b);
+    ASSERT_TRUE(intact);
+    ASSERT_TRUE(outOfPlace.framesProcessed() == 3 * RATE);
+}
+
+// Test 4: Latency budget and pitch commands reach the backend
+template <class Backend>
+void test_settings(const char* name) {
+    printf("\n[TEST 4] Latency budget and pitch (%s)\n", name);
+    EffectCore<Backend> core;
+    ASSERT_TRUE(core.enable() == 0);
+    const float defaultMs = core.latencyMs();
+    ASSERT_TRUE(core.setLatencyBudget(0.0f, -1.0f) == -EINVAL);
+    ASSERT_TRUE(core.setLatencyBudget(10.0f, 40.0f) == 0);
+    printf("  %s: %.1f ms by default, %.1f ms in a 40 ms budget\n", name, defaultMs,
+           core.latencyMs());
+    ASSERT_TRUE(core.latencyMs() < 30.0f && core.latencyMs() < defaultMs);
+    core.setDevice(0x2u);  // speaker: no sink delay, budget kept
+    ASSERT_TRUE(core.settings().sinkLatencyMs == 0.0f && core.settings().latencyBudgetMs == 40.0f);
+
+    ASSERT_TRUE(core.setPitchRatio(0.0f) == -EINVAL);
+    ASSERT_TRUE(core.setPitchRatio(3.0f) == -EINVAL);
+    ASSERT_TRUE(core.setPitchRatio(432.0f / 440.0f) == 0);
+    ASSERT_TRUE(std::fabs(core.settings().pitchSemitones - PITCH_SEMITONES_432_HZ) < 1e-4f);
+    ASSERT_TRUE(core.setInterpolator(static_cast<Interpolator>(3)) == -EINVAL);
+    ASSERT_TRUE(core.setProfile(static_cast<ProcessingProfile>(-1)) == -EINVAL);
+}
+
+// Test 5: Callbacks land in the shared-memory stats page
+void test_stats() {
+    printf("\n[TEST 5] Statistics page\n");
+    std::unique_ptr<StatsPage> page(StatsPage::create(nullptr));
+    ASSERT_TRUE(page != nullptr);
+    int slot = -1;
+    {
+        EffectCore<SoundTouchBackend> core;
+        core.attachStats(page.get());
+        ASSERT_TRUE(page->global().liveInstances.load() == 1);
+        core.setAutoBypass(false);
+        core.enable();
+        runTone(core, 1.0, BLOCK, true);
+
+        InstanceStats s = {};
+        for (slot = 0; slot < STATS_MAX_INSTANCES && !page->read(slot, s); slot++) {}
+        ASSERT_TRUE(s.callbacks == RATE / BLOCK && s.frames == static_cast<uint64_t>(RATE));
+        ASSERT_TRUE(s.flags == (kStatsEnabled | kStatsEngineAllocated));
+        ASSERT_TRUE(s.sampleRate == RATE && s.channels == 2 && s.latencyMs > 0.0f);
+        ASSERT_TRUE(s.underruns > 0 && s.underruns < s.callbacks);
+
+        const uint32_t id = s.id;
+        core.resetStats();
+        ASSERT_TRUE(page->read(slot, s) && s.id == id && s.callbacks == 0);
+    }
+    InstanceStats s;
+    ASSERT_TRUE(!page->read(slot, s));
+    ASSERT_TRUE(page->global().liveInstances.load() == 0);
+}
+
+// Test 6: Footprint of each backend once enabled
+void test_memory() {
+    printf("\n[TEST 6] Backend memory\n");
+    EffectCore<SoundTouchBackend> bare;
+    EffectCore<ConverterBackend> full;
+    bare.enable();
+    full.enable();
+    runTone(bare, 1.0, BLOCK, true);
+    runTone(full, 1.0, BLOCK, true);
+    const MemoryUsage a = bare.memoryUsage();
+    const MemoryUsage b = full.memoryUsage();
+    printf("  soundtouch: %zu KB allocated, converter: %zu KB allocated\n",
+           a.allocatedBytes / 1024, b.allocatedBytes / 1024);
+    ASSERT_TRUE(a.allocatedBytes > 0 && a.usedBytes <= a.allocatedBytes);
+    ASSERT_TRUE(b.allocatedBytes > 0 && b.usedBytes <= b.allocatedBytes);
+    // Both carry the rate-switch history now; each stays within what its
+    // effect descriptor declares (PATH-C 264 KB, PATH-B 256 KB)
+    ASSERT_TRUE(a.allocatedBytes <= 264 * 1024);
+    ASSERT_TRUE(b.allocatedBytes <= 256 * 1024);
+}
+
+// Test 7: A call switches the backend to the voice engine and back
+template <class Backend>
+void test_voice_call(const char* name) {
+    printf("\n[TEST 7] Voice call mode (%s)\n", name);
+    EffectCore<Backend> core;
+    core.setAutoBypass(false);
+    ASSERT_TRUE(core.enable() == 0);
+    const float musicMs = core.latencyMs();
+
+    core.setVoiceCall(true);
+    ASSERT_TRUE(core.isVoiceCall());
+    ASSERT_TRUE(core.engineProfile() == ProcessingProfile::kVoip);
+    ASSERT_TRUE(core.settings().profile == ProcessingProfile::kMusic);
+    ASSERT_TRUE(core.setProfile(ProcessingProfile::kGame) == 0);
+    ASSERT_TRUE(core.engineProfile() == ProcessingProfile::kVoip);
+    const float callMs = core.latencyMs();
+    const double hz = measureHz(runTone(core, 3.0, BLOCK, true), core.channels());
+    printf("  %s: %.1f ms in a call, %.1f ms otherwise; 1000 Hz in → %.2f Hz out\n", name, callMs,
+           musicMs, hz);
+    ASSERT_TRUE(callMs < 10.0f && callMs < musicMs);
+    ASSERT_TRUE(std::fabs(hz - 1000.0 * 432.0 / 440.0) < 2.0);
+
+    core.setVoiceCall(false);
+    ASSERT_TRUE(core.engineProfile() == ProcessingProfile::kGame);
+    ASSERT_TRUE(core.latencyMs() > callMs);
+}
+
+// Test 8: 24- and 32-bit PCM run natively and match the 16-bit stream to
+// within its rounding. The converter backend is what the ROM effect runs
+template <class Backend>
+void test_hires_formats(const char* name) {
+    printf("\n[TEST 8] Hi-res PCM formats (%s)\n", name);
+    const PcmFormat formats[] = {PcmFormat::kInt24Packed, PcmFormat::kQ8_23, PcmFormat::kInt32};
+    const char* names[] = {"packed 24", "8.24", "32"};
+    const int shifts[] = {8, 8, 16};  // int16 full scale to the format's
+
+    EffectCore<Backend> reference;
+    reference.setAutoBypass(false);
+    ASSERT_TRUE(reference.enable() == 0);
+    const std::vector<int16_t> expected = runTone(reference, 2.0, BLOCK, true);
+
+    for (int f = 0; f < 3; f++) {
+        EffectCore<Backend> core;
+        core.setAutoBypass(false);
+        ASSERT_TRUE(core.setFormat(RATE, 2, formats[f]) == 0 && core.pcmFormat() == formats[f]);
+        ASSERT_TRUE(core.enable() == 0);
+
+        const size_t width = bytesPerSample(formats[f]);
+        std::vector<int16_t> tone;
+        std::vector<uint8_t> buffer(BLOCK * 2 * width);
+        std::vector<float> decoded(BLOCK * 2);
+        double maxDiff = 0.0;
+        bool processed = true;
+        for (long pos = 0; pos + BLOCK <= 2 * RATE; pos += BLOCK) {
+            fillTone(tone, BLOCK, 2, pos);
+            for (size_t i = 0; i < tone.size(); i++) {
+                const int32_t v = static_cast<int32_t>(tone[i]) * (1 << shifts[f]);
+                std::memcpy(&buffer[i * width], &v, width);
+            }
+            processed = processed && core.process(buffer.data(), buffer.data(), BLOCK) == 0;
+            pcmToFloat(buffer.data(), formats[f], decoded.data(), decoded.size());
+            if (pos >= RATE) {
+                const int16_t* ref = &expected[static_cast<size_t>(pos - RATE) * 2];
+                for (size_t i = 0; i < decoded.size(); i++) {
+                    maxDiff = std::fmax(maxDiff, std::fabs(decoded[i] - ref[i] / 32768.0));
+                }
+            }
+        }
+        printf("  %s-bit: max difference to the 16-bit stream %.2f LSB16\n", names[f],
+               maxDiff * 32768.0);
+        ASSERT_TRUE(processed);
+        ASSERT_TRUE(maxDiff < 2.0 / 32768.0);
+    }
+}
+
+// Pass-through backend whose format changes fail as if out of memory
+class RefusingBackend
+{
+public:
+    static RefusingBackend* create(int, int, const EffectSettings&) { return new RefusingBackend(); }
+    bool setFormat(int, int, const EffectSettings&) { return false; }
+    void reset() {}
+    void setPitchSemitones(float) {}
+    bool setInterpolator(Interpolator) { return true; }
+    void setProfile(ProcessingProfile) {}
+    void setOutputLatency(float, float) {}
+    void setAutoBypass(bool) {}
+    static bool supportsFormat(PcmFormat) { return true; }
+    int process(const void* in, void* out, int frames, PcmFormat format) {
+        std::memmove(out, in, static_cast<size_t>(frames) * 2 * bytesPerSample(format));
+        return frames;
+    }
+    bool isBypassed() const { return false; }
+    float referenceHz() const { return 0.0f; }
+    float latencyMs() const { return 0.0f; }
+    void addMemoryUsage(MemoryUsage&) const {}
+    void shrinkToFit() {}
+};
+
+// Test 9: A format change the engine refuses leaves the whole format,
+// sample layout included, as it was: process() keeps to the buffer sizes
+// the host still uses
+void test_refused_format() {
+    printf("\n[TEST 9] Refused format change\n");
+    EffectCore<RefusingBackend> core;
+    ASSERT_TRUE(core.enable() == 0);
+    ASSERT_TRUE(core.setFormat(44100, 2, PcmFormat::kInt32) == -ENOMEM);
+    ASSERT_TRUE(core.sampleRate() == 48000 && core.channels() == 2);
+    ASSERT_TRUE(core.pcmFormat() == PcmFormat::kInt16);
+
+    // 16-bit buffer with a guard zone after it: nothing past it is touched
+    std::vector<int16_t> buffer(BLOCK * 2 + 64, 0x5a5a);
+    ASSERT_TRUE(core.process(buffer.data(), buffer.data(), BLOCK) == 0);
+    bool guardIntact = true;
+    for (size_t i = BLOCK * 2; i < buffer.size(); i++) guardIntact = guardIntact && buffer[i] == 0x5a5a;
+    ASSERT_TRUE(guardIntact);
+
+    // the layout alone still changes without the engine
+    ASSERT_TRUE(core.setFormat(48000, 2, PcmFormat::kInt32) == 0 && core.pcmFormat() == PcmFormat::kInt32);
+
+    // a shadow that cannot follow is stopped; production switches anyway
+    EffectCore<SoundTouchBackend> shadowed;
+    ASSERT_TRUE(shadowed.startShadow<RefusingBackend>(ShadowMode::kInline) == 0);
+    ASSERT_TRUE(shadowed.setFormat(44100, 2) == 0 && shadowed.sampleRate() == 44100);
+    ASSERT_TRUE(!shadowed.hasShadow());
+}
+
+// Test 10: A rate switch on a running effect keeps playing: no startup
+// gap, no click, for both backends
+template <class Backend>
+static void checkRateSwitch(const char* name, int fromRate, int toRate) {
+    EffectCore<Backend> core;
+    core.setAutoBypass(false);
+    ASSERT_TRUE(core.setFormat(fromRate, 2) == 0 && core.enable() == 0);
+
+    // 1 kHz tone that stays continuous in time across the switch
+    std::vector<int16_t> buffer, out;
+    double t = 0.0;
+    int rate = fromRate;
+    for (int block = 0; block < 200; block++) {
+        if (block == 100) {
+            rate = toRate;
+            ASSERT_TRUE(core.setFormat(rate, 2) == 0);
+        }
+        const int frames = rate / 100;
+        buffer.resize(2 * frames);
+        for (int i = 0; i < frames; i++) {
+            buffer[2 * i] = buffer[2 * i + 1] =
+                static_cast<int16_t>(10000.0 * std::sin(2.0 * M_PI * 1000.0 * t));
+            t += 1.0 / rate;
+        }
+        core.process(buffer.data(), buffer.data(), frames);
+        if (block >= 100) {
+            for (int i = 0; i < frames; i++) out.push_back(buffer[2 * i]);
+        }
+    }
+
+    // Envelope over whole periods of the shifted tone for the first 100 ms,
+    // and the largest step over the first 20 ms against the tone's steepest slope
+    const int period = static_cast<int>(std::lround(toRate / (1000.0 * 432.0 / 440.0)));
+    double minRms = 1e9;
+    for (int w = 0; w + period < toRate / 10; w += period / 4) {
+        double energy = 0.0;
+        for (int i = w; i < w + period; i++) energy += static_cast<double>(out[i]) * out[i];
+        minRms = std::min(minRms, std::sqrt(energy / period));
+    }
+    int maxStep = 0;
+    for (int i = 1; i < toRate / 50; i++) maxStep = std::max(maxStep, std::abs(out[i] - out[i - 1]));
+    const double slope = 10000.0 * 2.0 * M_PI * 1000.0 * 432.0 / 440.0 / toRate;
+
+    printf("  %s %d → %d Hz: min RMS %.0f (tone %.0f), max step %d (tone %.0f)\n", name, fromRate,
+           toRate, minRms, 10000.0 / std::sqrt(2.0), maxStep, slope);
+    ASSERT_TRUE(minRms > 0.9 * 10000.0 / std::sqrt(2.0));
+    ASSERT_TRUE(maxStep < 1.1 * slope);
+}
+
+void test_seamless_rate_switch() {
+    printf("\n[TEST 10] Seamless sample-rate switch\n");
+    checkRateSwitch<SoundTouchBackend>("soundtouch", 48000, 44100);
+    checkRateSwitch<SoundTouchBackend>("soundtouch", 44100, 48000);
+    checkRateSwitch<ConverterBackend>("converter", 48000, 44100);
+    checkRateSwitch<ConverterBackend>("converter", 44100, 48000);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Effect Core Tests\n");
+    printf("========================================\n");
+
+    test_lazy_pass_through<SoundTouchBackend>("soundtouch");
+    test_lazy_pass_through<ConverterBackend>("converter");
+    test_format_negotiation();
+    test_process<SoundTouchBackend>("soundtouch");
+    test_process<ConverterBackend>("converter");
+    test_settings<SoundTouchBackend>("soundtouch");
+    test_settings<ConverterBackend>("converter");
+    test_stats();
+    test_memory();
+    test_voice_call<SoundTouchBackend>("soundtouch");
+    test_voice_call<ConverterBackend>("converter");
+    test_hires_formats<SoundTouchBackend>("soundtouch");
+    test_hires_formats<ConverterBackend>("converter");
+    test_refused_format();
+    test_seamless_rate_switch();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
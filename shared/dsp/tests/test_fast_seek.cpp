@@ -0,0 +1,211 @@
+#include "SoundTouch.h"
+#include "TDStretch.h"
+#include "latency_budget.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace soundtouch;
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int RATE = 48000;
+static const int CHANNELS = 2;
+static const double PARTIALS[] = {110.0, 220.0, 330.0, 440.0, 554.4, 659.3};
+
+// Stereo chord with vibrato and a little noise: the kind of signal whose
+// correlation surface has several near-equal peaks
+static std::vector<float> chord(size_t frames, uint32_t seed) {
+    std::vector<float> pcm(frames * CHANNELS);
+    double phase[6] = {0};
+    for (size_t i = 0; i < frames; i++) {
+        double s = 0.0;
+        for (int k = 0; k < 6; k++) {
+            const double f = PARTIALS[k] * (1.0 + 0.004 * std::sin(2.0 * M_PI * 5.0 * i / RATE + k));
+            phase[k] += 2.0 * M_PI * f / RATE;
+            s += 0.12 / (1.0 + 0.3 * k) * std::sin(phase[k]);
+        }
+        for (int c = 0; c < CHANNELS; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            pcm[i * CHANNELS + c] = static_cast<float>(s * (c ? 0.9 : 1.0) + 0.02 * (seed / 4294967296.0 - 0.5));
+        }
+    }
+    return pcm;
+}
+
+// Exposes both overlap searches of the plain C implementation
+class SeekProbe : public TDStretch {
+public:
+    explicit SeekProbe(LatencyTier tier) {
+        const LatencyTierSettings& s = latencyTierSettings(tier);
+        setChannels(CHANNELS);
+        setParameters(RATE, s.sequenceMs, s.seekWindowMs, s.overlapMs);
+    }
+    using TDStretch::seekBestOverlapPositionFull;
+    using TDStretch::seekBestOverlapPositionFast;
+    float* mid() { return pMidBuffer; }
+    int overlap() const { return overlapLength; }
+    int seek() const { return seekLength; }
+    int sequence() const { return seekWindowLength; }
+
+    // What the exact search maximises: normalised correlation, weighted
+    // towards the middle of the range
+    double score(const float* refPos, int offset) {
+        double norm;
+        const double corr = calcCrossCorr(refPos + CHANNELS * offset, pMidBuffer, norm);
+        const double tmp = static_cast<double>(2 * offset - seekLength) / seekLength;
+        return (corr + 0.1) * (1.0 - 0.25 * tmp * tmp);
+    }
+};
+
+// Energy at the shifted partials, relative to the total: splices in the
+// wrong place smear energy away from them
+static double tonalPurity(const std::vector<float>& pcm, size_t from, size_t frames, double ratio) {
+    double total = 0.0;
+    for (size_t i = from; i < from + frames; i++) total += pcm[i * CHANNELS] * pcm[i * CHANNELS];
+    double tonal = 0.0;
+    for (double partial : PARTIALS) {
+        // vibrato spreads each partial: collect ±1% with a comb of Goertzel probes
+        for (double f = partial * ratio * 0.99; f <= partial * ratio * 1.01; f += static_cast<double>(RATE) / frames) {
+            const double coeff = 2.0 * std::cos(2.0 * M_PI * f / RATE);
+            double s1 = 0.0, s2 = 0.0;
+            for (size_t i = from; i < from + frames; i++) {
+                const double s0 = pcm[i * CHANNELS] + coeff * s1 - s2;
+                s2 = s1;
+                s1 = s0;
+            }
+            tonal += (s1 * s1 + s2 * s2 - coeff * s1 * s2) * 2.0 / frames;
+        }
+    }
+    return tonal / total;
+}
+
+static std::vector<float> shift(const std::vector<float>& in, bool fast, double* seconds) {
+    SoundTouch st(0);
+    st.setSampleRate(RATE);
+    st.setChannels(CHANNELS);
+    st.setPitchSemiTones(12.0 * std::log2(432.0 / 440.0));
+    applyLatencyTier(st, LatencyTier::kHighQuality);
+    st.setSetting(SETTING_FAST_SEEK, fast);
+    std::vector<float> out(in.size() + RATE * CHANNELS);
+    const auto start = std::chrono::steady_clock::now();
+    st.putSamples(in.data(), static_cast<uint>(in.size() / CHANNELS));
+    st.flush();
+    const uint got = st.receiveSamples(out.data(), static_cast<uint>(out.size() / CHANNELS));
+    *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    out.resize(static_cast<size_t>(got) * CHANNELS);
+    return out;
+}
+
+// Test 1: The setting reaches the tempo changer and can be read back
+void test_setting() {
+    printf("\n[TEST 1] SETTING_FAST_SEEK\n");
+    SoundTouch st;
+    ASSERT_TRUE(st.getSetting(SETTING_FAST_SEEK) == 0);
+    ASSERT_TRUE(st.setSetting(SETTING_FAST_SEEK, 1));
+    ASSERT_TRUE(st.getSetting(SETTING_FAST_SEEK) == 1);
+    ASSERT_TRUE(st.setSetting(SETTING_FAST_SEEK, 0));
+    ASSERT_TRUE(st.getSetting(SETTING_FAST_SEEK) == 0);
+}
+
+// Test 2: Accuracy envelope of the splice points, per latency tier: how
+// often the fast search picks another offset than the exact one, how far
+// off, and how much worse that offset matches by the exact search's own score
+void test_splice_envelope() {
+    printf("\n[TEST 2] Splice points against the exact search\n");
+    const std::vector<float> signal = chord(20 * RATE, 7);
+    printf("  tier  seeks  same   within 1  mean score  worst score  speedup\n");
+    for (int t = 0; t <= static_cast<int>(LatencyTier::kMinimum); t++) {
+        SeekProbe probe(static_cast<LatencyTier>(t));
+        const size_t span = static_cast<size_t>(probe.sequence() + probe.seek() + probe.overlap());
+        int seeks = 0, same = 0, near = 0;
+        double sumRatio = 0.0, worstRatio = 1.0, exactSeconds = 0.0, fastSeconds = 0.0;
+        for (size_t pos = 0; pos + span < signal.size() / CHANNELS; pos += 1777) {
+            std::memcpy(probe.mid(), &signal[pos * CHANNELS], probe.overlap() * CHANNELS * sizeof(float));
+            const float* refPos = &signal[(pos + probe.sequence()) * CHANNELS];
+            const auto t0 = std::chrono::steady_clock::now();
+            const int exact = probe.seekBestOverlapPositionFull(refPos);
+            const auto t1 = std::chrono::steady_clock::now();
+            const int fast = probe.seekBestOverlapPositionFast(refPos);
+            const auto t2 = std::chrono::steady_clock::now();
+            exactSeconds += std::chrono::duration<double>(t1 - t0).count();
+            fastSeconds += std::chrono::duration<double>(t2 - t1).count();
+
+            const double ratio = probe.score(refPos, fast) / probe.score(refPos, exact);
+            seeks++;
+            same += fast == exact;
+            near += std::abs(fast - exact) <= 1;
+            sumRatio += ratio;
+            worstRatio = std::min(worstRatio, ratio);
+        }
+        const double sameShare = static_cast<double>(same) / seeks;
+        const double nearShare = static_cast<double>(near) / seeks;
+        const double meanRatio = sumRatio / seeks;
+        printf("  %d     %4d   %4.1f%%  %5.1f%%    %.5f     %.4f       %.2fx\n", t, seeks,
+               100.0 * sameShare, 100.0 * nearShare, meanRatio, worstRatio, exactSeconds / fastSeconds);
+
+        ASSERT_TRUE(sameShare >= 0.85);
+        ASSERT_TRUE(nearShare >= 0.90);
+        ASSERT_TRUE(meanRatio >= 0.999);
+        // the shortest tier has the fewest cycles per overlap, and so the
+        // most near-equal peaks for decimation to confuse
+        ASSERT_TRUE(worstRatio >= 0.80);
+    }
+}
+
+// Test 3: Through the whole engine the fast search is as clean as the exact one
+void test_engine_quality() {
+    printf("\n[TEST 3] 432 Hz shift with either search\n");
+    const std::vector<float> in = chord(10 * RATE, 11);
+    double exactSeconds = 0.0, fastSeconds = 0.0;
+    const std::vector<float> exact = shift(in, false, &exactSeconds);
+    const std::vector<float> fast = shift(in, true, &fastSeconds);
+    ASSERT_TRUE(exact.size() == fast.size());
+    ASSERT_TRUE(exact != fast);
+
+    const double ratio = 432.0 / 440.0;
+    const size_t frames = 8 * RATE;
+    const double pExact = tonalPurity(exact, RATE, frames, ratio);
+    const double pFast = tonalPurity(fast, RATE, frames, ratio);
+    printf("  tonal energy: exact %.2f%%, fast %.2f%% (%.3f dB); engine %.2fx faster\n", 100.0 * pExact,
+           100.0 * pFast, 10.0 * std::log10(pFast / pExact), exactSeconds / fastSeconds);
+    ASSERT_TRUE(pExact > 0.95);
+    ASSERT_TRUE(std::fabs(10.0 * std::log10(pFast / pExact)) < 0.1);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Fast Overlap Search Tests\n");
+    printf("========================================\n");
+
+    test_setting();
+    test_splice_envelope();
+    test_engine_quality();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
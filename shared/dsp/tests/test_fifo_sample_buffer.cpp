@@ -0,0 +1,245 @@
+#include "FIFOSampleBuffer.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace soundtouch;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+// Fills 'count' frames with a running ramp starting at 'first'
+static std::vector<float> ramp(uint first, uint count, uint channels) {
+    std::vector<float> v(count * channels);
+    for (uint i = 0; i < count * channels; ++i) {
+        v[i] = static_cast<float>(first * channels + i);
+    }
+    return v;
+}
+
+// Test 1: Mirrored ring is used where the platform supports it
+void test_mirrored_available() {
+    printf("\n[TEST 1] Mirrored ring availability\n");
+    FIFOSampleBuffer fifo(2);
+#ifdef SOUNDTOUCH_ALLOW_MIRRORED_FIFO
+    ASSERT_TRUE(fifo.isMirrored());
+#else
+    ASSERT_TRUE(!fifo.isMirrored());
+#endif
+}
+
+// Test 2: Data survives many wraps of the ring without reordering
+void test_fifo_order_across_wraps() {
+    printf("\n[TEST 2] FIFO order across ring wraps\n");
+    const uint channels = 2;
+    FIFOSampleBuffer fifo(channels);
+
+    uint written = 0;
+    uint read = 0;
+    bool ordered = true;
+    std::vector<float> out(1024 * channels);
+
+    // odd chunk sizes so the read index lands everywhere in the ring
+    for (int iter = 0; iter < 2000; ++iter) {
+        const uint nIn = 97 + (iter * 31) % 211;
+        const std::vector<float> in = ramp(written, nIn, channels);
+        fifo.putSamples(in.data(), nIn);
+        written += nIn;
+
+        const uint nOut = fifo.receiveSamples(out.data(), nIn - 3);
+        for (uint i = 0; i < nOut * channels; ++i) {
+            if (out[i] != static_cast<float>(read * channels + i)) ordered = false;
+        }
+        read += nOut;
+    }
+    ASSERT_TRUE(ordered);
+    ASSERT_TRUE(fifo.numSamples() == written - read);
+}
+
+// Test 3: ptrBegin() window stays contiguous across the wrap point
+void test_direct_access_contiguous() {
+    printf("\n[TEST 3] Direct access window is contiguous\n");
+    const uint channels = 2;
+    FIFOSampleBuffer fifo(channels);
+
+    uint written = 0;
+    uint read = 0;
+    bool ordered = true;
+
+    for (int iter = 0; iter < 500; ++iter) {
+        // write through ptrEnd() the way TDStretch/RateTransposer do
+        const uint nIn = 300;
+        float *dst = fifo.ptrEnd(nIn);
+        for (uint i = 0; i < nIn * channels; ++i) {
+            dst[i] = static_cast<float>(written * channels + i);
+        }
+        fifo.putSamples(nIn);
+        written += nIn;
+
+        const float *src = fifo.ptrBegin();
+        const uint avail = fifo.numSamples();
+        for (uint i = 0; i < avail * channels; ++i) {
+            if (src[i] != static_cast<float>(read * channels + i)) ordered = false;
+        }
+        const uint nOut = avail - 50;
+        fifo.receiveSamples(nOut);
+        read += nOut;
+    }
+    ASSERT_TRUE(ordered);
+}
+
+// Test 4: Growing keeps contents when the ring is partially consumed
+void test_growth_preserves_data() {
+    printf("\n[TEST 4] Growth preserves buffered data\n");
+    const uint channels = 2;
+    FIFOSampleBuffer fifo(channels);
+
+    std::vector<float> in = ramp(0, 400, channels);
+    fifo.putSamples(in.data(), 400);
+    fifo.receiveSamples(350);
+
+    // force several reallocations
+    std::vector<float> big = ramp(400, 20000, channels);
+    fifo.putSamples(big.data(), 20000);
+
+    std::vector<float> out(20050 * channels);
+    const uint n = fifo.receiveSamples(out.data(), 20050);
+    ASSERT_TRUE(n == 20050);
+
+    bool ordered = true;
+    for (uint i = 0; i < n * channels; ++i) {
+        if (out[i] != static_cast<float>(350 * channels + i)) ordered = false;
+    }
+    ASSERT_TRUE(ordered);
+}
+
+// Test 5: Channel count change keeps the raw sample stream intact
+void test_set_channels() {
+    printf("\n[TEST 5] Channel count change\n");
+    FIFOSampleBuffer fifo(2);
+
+    std::vector<float> in = ramp(0, 600, 2);
+    fifo.putSamples(in.data(), 600);
+    fifo.receiveSamples(101);
+
+    fifo.setChannels(1);
+    ASSERT_TRUE(fifo.numSamples() == 499 * 2);
+
+    std::vector<float> out(499 * 2);
+    fifo.receiveSamples(out.data(), 499 * 2);
+    bool ordered = true;
+    for (uint i = 0; i < 499 * 2; ++i) {
+        if (out[i] != static_cast<float>(101 * 2 + i)) ordered = false;
+    }
+    ASSERT_TRUE(ordered);
+
+    // odd channel count: ring size must stay a multiple of the frame size
+    fifo.setChannels(3);
+    uint written = 0;
+    uint read = 0;
+    std::vector<float> out3(512 * 3);
+    for (int iter = 0; iter < 300; ++iter) {
+        std::vector<float> chunk = ramp(written, 257, 3);
+        fifo.putSamples(chunk.data(), 257);
+        written += 257;
+        const uint n = fifo.receiveSamples(out3.data(), 250);
+        for (uint i = 0; i < n * 3; ++i) {
+            if (out3[i] != static_cast<float>(read * 3 + i)) ordered = false;
+        }
+        read += n;
+    }
+    ASSERT_TRUE(ordered);
+}
+
+// Test 6: clear() and addSilent() behave the same in either mode
+void test_clear_and_silence() {
+    printf("\n[TEST 6] clear() and addSilent()\n");
+    FIFOSampleBuffer fifo(2);
+
+    std::vector<float> in = ramp(1, 1000, 2);
+    fifo.putSamples(in.data(), 1000);
+    fifo.receiveSamples(777);
+    fifo.clear();
+    ASSERT_TRUE(fifo.isEmpty());
+
+    fifo.addSilent(900);
+    std::vector<float> out(900 * 2, 1.0f);
+    ASSERT_TRUE(fifo.receiveSamples(out.data(), 900) == 900);
+
+    bool silent = true;
+    for (float v : out) {
+        if (v != 0.0f) silent = false;
+    }
+    ASSERT_TRUE(silent);
+}
+
+// Test 7: Memory accounting and shrinking after a burst
+void test_shrink_after_burst() {
+    printf("\n[TEST 7] Memory usage and shrinkToFit()\n");
+    const uint channels = 2;
+    const ulong frameBytes = channels * sizeof(float);
+    FIFOSampleBuffer fifo(channels);
+
+    std::vector<float> burst = ramp(0, 20000, channels);
+    fifo.putSamples(burst.data(), 20000);
+    fifo.receiveSamples(19900);
+
+    MemoryUsage usage = {};
+    fifo.addMemoryUsage(usage);
+    ASSERT_TRUE(usage.allocated >= 20000 * frameBytes);
+    ASSERT_TRUE(usage.used == 100 * frameBytes);
+    ASSERT_TRUE(usage.peakUsed >= 20000 * frameBytes);
+
+    // The first call keeps what the burst needed and restarts the peak;
+    // the next one releases it
+    fifo.shrinkToFit();
+    MemoryUsage kept = {};
+    fifo.addMemoryUsage(kept);
+    ASSERT_TRUE(kept.allocated >= 20000 * frameBytes);
+    fifo.shrinkToFit();
+    MemoryUsage shrunk = {};
+    fifo.addMemoryUsage(shrunk);
+    printf("  allocated %lu → %lu bytes\n", usage.allocated, shrunk.allocated);
+    ASSERT_TRUE(shrunk.allocated <= 8192);
+    ASSERT_TRUE(shrunk.used == 100 * frameBytes && shrunk.peakUsed == shrunk.used);
+
+    std::vector<float> out(100 * channels);
+    ASSERT_TRUE(fifo.receiveSamples(out.data(), 100) == 100);
+    bool ordered = true;
+    for (uint i = 0; i < 100 * channels; ++i) {
+        if (out[i] != static_cast<float>(19900 * channels + i)) ordered = false;
+    }
+    ASSERT_TRUE(ordered);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("SoundTouch FIFOSampleBuffer Tests\n");
+    printf("========================================\n");
+
+    test_mirrored_available();
+    test_fifo_order_across_wraps();
+    test_direct_access_contiguous();
+    test_growth_preserves_data();
+    test_set_channels();
+    test_clear_and_silence();
+    test_shrink_after_burst();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
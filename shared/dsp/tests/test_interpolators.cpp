@@ -0,0 +1,242 @@
+#include "RateTransposer.h"
+#include "audio_432hz.h"
+#include "cpu_detect.h"
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace soundtouch;
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const uint ALL_X86_EXTENSIONS = 0xffffffff;
+static const double RATE_432 = 432.0 / 440.0;
+static const char* const NAMES[] = {"linear", "cubic", "shannon"};
+static const TransposerBase::ALGORITHM ALGORITHMS[] = {
+    TransposerBase::LINEAR, TransposerBase::CUBIC, TransposerBase::SHANNON};
+
+// Runs 'input' (interleaved) through a transposer in blocks of 'block' frames
+static std::vector<float> transpose(TransposerBase::ALGORITHM algorithm, uint extensions,
+                                    const std::vector<float>& input, int channels,
+                                    double rate, int block) {
+    std::unique_ptr<TransposerBase> t(TransposerBase::newInstance(algorithm, extensions));
+    t->setChannels(channels);
+    t->setRate(rate);
+    FIFOSampleBuffer src(channels);
+    FIFOSampleBuffer dest(channels);
+    std::vector<float> out;
+    out.reserve(static_cast<size_t>(input.size() / rate) + 64);
+    const int frames = static_cast<int>(input.size()) / channels;
+    for (int pos = 0; pos < frames; pos += block) {
+        const int n = std::min(block, frames - pos);
+        src.putSamples(input.data() + static_cast<size_t>(pos) * channels, n);
+        t->transpose(dest, src);
+        out.insert(out.end(), dest.ptrBegin(), dest.ptrBegin() + dest.numSamples() * channels);
+        dest.clear();
+    }
+    return out;
+}
+
+// Stereo/mono tone pair: 'hz' on the left, 1.5 × 'hz' on the right
+static std::vector<float> tone(int frames, int channels, double hz, double sampleRate) {
+    std::vector<float> v(static_cast<size_t>(frames) * channels);
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            v[i * channels + c] = static_cast<float>(
+                0.5 * std::sin(2.0 * M_PI * hz * (c ? 1.5 : 1.0) * i / sampleRate));
+        }
+    }
+    return v;
+}
+
+// SNR in dB of transposed 'tone' output against the exact resampled tone,
+// after removing the best-fit gain (returned in 'gainDb'; Shannon's window is
+// scaled down by 5 % by design). The transposer reads position n * rate for
+// output n, offset by its latency.
+static double toneSnrDb(TransposerBase::ALGORITHM algorithm, uint extensions, double hz,
+                        double& gainDb) {
+    const int channels = 2;
+    const double sampleRate = 48000.0;
+    const std::vector<float> in = tone(48000, channels, hz, sampleRate);
+    const std::vector<float> out = transpose(algorithm, extensions, in, channels, RATE_432, 480);
+    std::unique_ptr<TransposerBase> probe(TransposerBase::newInstance(algorithm, 0));
+    const int latency = probe->getLatency();
+
+    std::vector<double> ideal;
+    std::vector<double> actual;
+    const int frames = static_cast<int>(out.size()) / channels;
+    for (int n = 1000; n < frames - 1000; n++) {
+        const double pos = n * RATE_432 + latency;
+        for (int c = 0; c < channels; c++) {
+            ideal.push_back(0.5 * std::sin(2.0 * M_PI * hz * (c ? 1.5 : 1.0) * pos / sampleRate));
+            actual.push_back(out[n * channels + c]);
+        }
+    }
+
+    double cross = 0.0;
+    double signal = 0.0;
+    for (size_t i = 0; i < ideal.size(); i++) {
+        cross += ideal[i] * actual[i];
+        signal += ideal[i] * ideal[i];
+    }
+    const double gain = cross / signal;
+    double noise = 0.0;
+    for (size_t i = 0; i < ideal.size(); i++) {
+        const double err = actual[i] - gain * ideal[i];
+        noise += err * err;
+    }
+    gainDb = 20.0 * std::log10(gain);
+    return 10.0 * std::log10(gain * gain * signal / std::max(noise, 1e-30));
+}
+
+// Test 1: SSE transposers match the plain C ones
+void test_sse_matches_generic() {
+    printf("\n[TEST 1] SSE interpolators match generic versions\n");
+    const bool sse = (detectCPUextensions() & SUPPORT_SSE) != 0;
+    printf("  SSE %s\n", sse ? "available" : "not available, comparing C with C");
+
+    std::vector<float> noise(2 * 20000);
+    uint32_t seed = 12345;
+    for (float& v : noise) {
+        seed = seed * 1664525u + 1013904223u;
+        v = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+    }
+
+    for (int a = 0; a < 3; a++) {
+        for (int channels = 1; channels <= 2; channels++) {
+            for (double rate : {RATE_432, 1.0 / RATE_432, 0.5}) {
+                std::vector<float> in(noise.begin(), noise.begin() + 20000 * channels);
+                const auto plain = transpose(ALGORITHMS[a], 0, in, channels, rate, 333);
+                const auto fast = transpose(ALGORITHMS[a], ALL_X86_EXTENSIONS, in, channels, rate, 333);
+                float maxDiff = 0.0f;
+                for (size_t i = 0; i < std::min(plain.size(), fast.size()); i++) {
+                    maxDiff = std::fmax(maxDiff, std::fabs(plain[i] - fast[i]));
+                }
+                printf("  %-7s ch=%d rate=%.4f: %zu vs %zu samples, max diff %.2e\n",
+                       NAMES[a], channels, rate, plain.size(), fast.size(), maxDiff);
+                ASSERT_TRUE(plain.size() == fast.size());
+                ASSERT_TRUE(maxDiff < 2e-5f);
+            }
+        }
+    }
+}
+
+// Test 2: Quality and cost of each interpolator at the 432/440 ratio.
+// Prints the table referenced by docs/API_REFERENCE.md.
+static double secondsFor(TransposerBase::ALGORITHM algorithm, uint extensions,
+                         const std::vector<float>& in) {
+    std::unique_ptr<TransposerBase> t(TransposerBase::newInstance(algorithm, extensions));
+    t->setChannels(2);
+    t->setRate(RATE_432);
+    FIFOSampleBuffer src(2);
+    FIFOSampleBuffer dest(2);
+    const int frames = static_cast<int>(in.size()) / 2;
+
+    double best = 1e9;
+    for (int rep = 0; rep < 5; rep++) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int pos = 0; pos + 1024 <= frames; pos += 1024) {
+            src.putSamples(in.data() + 2 * pos, 1024);
+            t->transpose(dest, src);
+            dest.clear();
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+void test_quality_and_cost() {
+    printf("\n[TEST 2] Quality and cost at 432/440 (stereo, 48 kHz)\n");
+    const std::vector<float> in = tone(10 * 48000, 2, 1000.0, 48000.0);
+    printf("  %-8s %-6s %11s %11s %14s %11s\n", "interp", "kernel", "SNR 1 kHz", "SNR 10 kHz",
+           "gain 10 kHz", "ms / 10 s");
+
+    double snr10k[3][2];
+    double seconds[3][2];
+    for (int a = 0; a < 3; a++) {
+        for (int k = 0; k < 2; k++) {
+            const uint ext = k ? ALL_X86_EXTENSIONS : 0;
+            double gain1k = 0.0;
+            double gain10k = 0.0;
+            const double snr1k = toneSnrDb(ALGORITHMS[a], ext, 1000.0, gain1k);
+            snr10k[a][k] = toneSnrDb(ALGORITHMS[a], ext, 10000.0, gain10k);
+            seconds[a][k] = secondsFor(ALGORITHMS[a], ext, in);
+            printf("  %-8s %-6s %8.1f dB %8.1f dB %11.2f dB %11.2f\n", NAMES[a], k ? "simd" : "c",
+                   snr1k, snr10k[a][k], gain10k, seconds[a][k] * 1000.0);
+        }
+    }
+
+    // SIMD keeps the quality of each interpolator, and more taps buy quality
+    for (int a = 0; a < 3; a++) {
+        ASSERT_TRUE(std::fabs(snr10k[a][1] - snr10k[a][0]) < 0.5);
+    }
+    ASSERT_TRUE(snr10k[1][1] > snr10k[0][1]);
+    ASSERT_TRUE(snr10k[2][1] > snr10k[1][1]);
+
+    // Timings are for the benchmark record only: wall-clock comparisons
+    // flake on loaded or single-CPU hosts
+    if (detectCPUextensions() & SUPPORT_SSE) {
+        printf("  cubic: simd %.2fx the cost of c\n", seconds[1][1] / seconds[1][0]);
+    }
+}
+
+// Test 3: Converter setting
+void test_converter_setting() {
+    printf("\n[TEST 3] Converter interpolator setting\n");
+    Audio432HzConverter converter(48000, 2);
+    ASSERT_TRUE(converter.getInterpolator() == Interpolator::kCubic);
+
+    for (Interpolator interp : {Interpolator::kLinear, Interpolator::kShannon, Interpolator::kCubic}) {
+        converter.setInterpolator(interp);
+        ASSERT_TRUE(converter.getInterpolator() == interp);
+
+        // output is produced and has signal in it
+        std::vector<int16_t> buffer(2 * 960);
+        long energy = 0;
+        for (int block = 0; block < 50; block++) {
+            for (int i = 0; i < 960; i++) {
+                const int16_t v = static_cast<int16_t>(
+                    8000.0 * std::sin(2.0 * M_PI * 440.0 * (block * 960 + i) / 48000.0));
+                buffer[2 * i] = buffer[2 * i + 1] = v;
+            }
+            converter.process(buffer.data(), 2 * 960);
+            if (block >= 25) {
+                for (int16_t s : buffer) energy += std::abs(s);
+            }
+        }
+        ASSERT_TRUE(energy > 0);
+    }
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Interpolator Tests\n");
+    printf("========================================\n");
+
+    test_sse_matches_generic();
+    test_quality_and_cost();
+    test_converter_setting();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+#include "audio_432hz.h"
+#include "latency_budget.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const char* tierName(LatencyTier tier) {
+    static const char* const NAMES[] = {"high-quality", "balanced", "low-latency", "minimum"};
+    return NAMES[static_cast<int>(tier)];
+}
+
+// Test 1: The remaining budget goes to the best tier that fits
+void test_choose_tier() {
+    printf("\n[TEST 1] Tier selection from sink latency and budget\n");
+    ASSERT_TRUE(chooseLatencyTier(0.0f, 200.0f) == LatencyTier::kHighQuality);
+    ASSERT_TRUE(chooseLatencyTier(0.0f, 100.0f) == LatencyTier::kBalanced);
+    ASSERT_TRUE(chooseLatencyTier(4.0f, 40.0f) == LatencyTier::kLowLatency);   // aptX Adaptive
+    ASSERT_TRUE(chooseLatencyTier(15.0f, 60.0f) == LatencyTier::kLowLatency);  // SBC
+    ASSERT_TRUE(chooseLatencyTier(15.0f, 40.0f) == LatencyTier::kMinimum);
+    ASSERT_TRUE(chooseLatencyTier(50.0f, 40.0f) == LatencyTier::kMinimum);     // link alone too slow
+
+    // A slower link never buys a better tier
+    bool monotonic = true;
+    for (float budget = 10.0f; budget <= 200.0f; budget += 5.0f) {
+        for (float sink = 0.0f; sink < 40.0f; sink += 1.0f) {
+            monotonic = monotonic && chooseLatencyTier(sink + 1.0f, budget) >= chooseLatencyTier(sink, budget);
+        }
+    }
+    ASSERT_TRUE(monotonic);
+
+    ASSERT_TRUE(effectiveProfile(ProcessingProfile::kMusic, LatencyTier::kBalanced) == ProcessingProfile::kMusic);
+    ASSERT_TRUE(effectiveProfile(ProcessingProfile::kMusic, LatencyTier::kMinimum) == ProcessingProfile::kGame);
+    ASSERT_TRUE(effectiveProfile(ProcessingProfile::kVoip, LatencyTier::kLowLatency) == ProcessingProfile::kVoip);
+}
+
+// Test 2: Sink latency of EFFECT_CMD_SET_DEVICE device types
+void test_device_latency() {
+    printf("\n[TEST 2] Device sink latency\n");
+    ASSERT_TRUE(deviceSinkLatencyMs(0x2) == 0.0f);          // speaker
+    ASSERT_TRUE(deviceSinkLatencyMs(0x8) == 0.0f);          // wired headphone
+    ASSERT_TRUE(deviceSinkLatencyMs(0x4000) == 0.0f);       // USB device
+    ASSERT_TRUE(deviceSinkLatencyMs(0x80) == 15.0f);        // A2DP
+    ASSERT_TRUE(deviceSinkLatencyMs(0x100) == 15.0f);       // A2DP headphones
+    ASSERT_TRUE(deviceSinkLatencyMs(0x20) == 10.0f);        // SCO headset
+    ASSERT_TRUE(deviceSinkLatencyMs(0x20000000) == 10.0f);  // BLE headset
+    ASSERT_TRUE(deviceSinkLatencyMs(0x20000001) == 10.0f);  // BLE speaker, not earpiece
+}
+
+// Test 3: Every tier's engine stays within the latency it was picked for
+void test_tier_latency() {
+    printf("\n[TEST 3] Engine latency per tier\n");
+    const int rates[] = {44100, 48000};
+    for (int rate : rates) {
+        for (int t = 0; t <= static_cast<int>(LatencyTier::kMinimum); t++) {
+            const LatencyTier tier = static_cast<LatencyTier>(t);
+            const LatencyTierSettings& s = latencyTierSettings(tier);
+            Audio432HzConverter converter(rate, 2);
+            converter.setPitchShiftSemitones(12.0f * std::log2(432.0f / 440.0f));
+            converter.setOutputLatency(5.0f, 5.0f + s.latencyMs);
+            printf("  %d Hz %-12s %6.2f ms (budgeted %.0f)\n", rate, tierName(tier),
+                   converter.getLatencyMs(), s.latencyMs);
+            ASSERT_TRUE(converter.getLatencyTier() == tier);
+            ASSERT_TRUE(converter.getLatencyMs() <= s.latencyMs);
+        }
+    }
+
+    Audio432HzConverter converter(48000, 2);
+    const float defaultMs = converter.getLatencyMs();
+    converter.setOutputLatency(15.0f, 40.0f);
+    ASSERT_TRUE(converter.getLatencyMs() < defaultMs);
+    converter.setOutputLatency(0.0f, 0.0f);
+    ASSERT_TRUE(converter.getLatencyTier() == LatencyTier::kBalanced);
+    ASSERT_TRUE(converter.getLatencyMs() == defaultMs);
+}
+
+// Test 4: Retuning a running stream keeps the output flowing
+void test_retune_running_stream() {
+    printf("\n[TEST 4] Retune without restart\n");
+    Audio432HzConverter converter(48000, 2);
+    converter.setPitchShiftSemitones(12.0f * std::log2(432.0f / 440.0f));
+
+    const int frames = 480;
+    std::vector<int16_t> buffer(2 * frames);
+    double t = 0.0;
+    double minRms = 1e9;
+    for (int block = 0; block < 300; block++) {
+        if (block == 100) converter.setOutputLatency(15.0f, 40.0f);   // BT link connects
+        if (block == 200) converter.setOutputLatency(0.0f, 200.0f);   // back to the speaker
+        for (int i = 0; i < frames; i++) {
+            buffer[2 * i] = buffer[2 * i + 1] =
+                    static_cast<int16_t>(10000.0 * std::sin(2.0 * M_PI * 500.0 * t));
+            t += 1.0 / 48000;
+        }
+        converter.process(buffer.data(), 2 * frames);
+        if (block >= 20) {
+            double energy = 0.0;
+            for (int i = 0; i < frames; i++) energy += static_cast<double>(buffer[2 * i]) * buffer[2 * i];
+            minRms = std::min(minRms, std::sqrt(energy / frames));
+        }
+    }
+    printf("  min block RMS %.0f (tone %.0f)\n", minRms, 10000.0 / std::sqrt(2.0));
+    ASSERT_TRUE(converter.getLatencyTier() == LatencyTier::kHighQuality);
+    ASSERT_TRUE(minRms > 0.8 * 10000.0 / std::sqrt(2.0));
+}
+
+// Delay from input to output of a loud burst fed well after the retune
+static double measuredDelayMs(float sinkLatencyMs, float budgetMs) {
+    Audio432HzConverter converter(48000, 2);
+    converter.setPitchShiftSemitones(12.0f * std::log2(432.0f / 440.0f));
+    const int frames = 480;
+    std::vector<int16_t> buffer(2 * frames);
+    long t = 0;
+    long burstOut = -1;
+    for (int block = 0; block < 200 && burstOut < 0; block++) {
+        if (block == 50) converter.setOutputLatency(sinkLatencyMs, budgetMs);
+        for (int i = 0; i < frames; i++, t++) {
+            double v = 2000.0 * std::sin(0.05 * t);
+            if (block == 120 && i < 48) v = 20000.0 * std::sin(0.6 * i);
+            buffer[2 * i] = buffer[2 * i + 1] = static_cast<int16_t>(v);
+        }
+        converter.process(buffer.data(), 2 * frames);
+        for (int i = 0; i < frames && block >= 120; i++) {
+            if (burstOut < 0 && std::abs(buffer[2 * i]) > 8000) burstOut = t - frames + i;
+        }
+    }
+    return (burstOut - 120L * frames) / 48.0;
+}
+
+// Test 5: The stream's actual delay follows the tier
+void test_measured_delay() {
+    printf("\n[TEST 5] Measured delay after retuning\n");
+    const double balanced = measuredDelayMs(0.0f, 0.0f);
+    const double low = measuredDelayMs(0.0f, 40.0f);
+    const double minimum = measuredDelayMs(15.0f, 30.0f);
+    const double high = measuredDelayMs(0.0f, 200.0f);
+    printf("  minimum %.1f ms, low-latency %.1f ms, balanced %.1f ms, high-quality %.1f ms\n",
+           minimum, low, balanced, high);
+    ASSERT_TRUE(minimum < low && low < balanced && balanced < high);
+    ASSERT_TRUE(minimum < 15.0 + 10.0);  // within one 10 ms buffer of the tier
+    ASSERT_TRUE(high < 106.0);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Latency Budget Tests\n");
+    printf("========================================\n");
+
+    test_choose_tier();
+    test_device_latency();
+    test_tier_latency();
+    test_retune_running_stream();
+    test_measured_delay();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
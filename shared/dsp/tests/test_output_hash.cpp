@@ -0,0 +1,76 @@
+#include "output_hash.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+// Test 1: Digests match the reference XXH64 implementation
+void test_reference_vectors() {
+    printf("\n[TEST 1] XXH64 reference vectors\n");
+    ASSERT_TRUE(OutputHash::hash("", 0) == 0xEF46DB3751D8E999ULL);
+    ASSERT_TRUE(OutputHash::hash("a", 1) == 0xD24EC4F1A98C6E5BULL);
+    ASSERT_TRUE(OutputHash::hash("abc", 3) == 0x44BC2CF5AD770999ULL);
+}
+
+// Test 2: Chunked updates give the one-shot digest
+void test_streaming_matches_oneshot() {
+    printf("\n[TEST 2] Streaming matches one-shot\n");
+    std::vector<unsigned char> data(10007);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<unsigned char>((i * 131) ^ (i >> 3));
+    }
+    const uint64_t expected = OutputHash::hash(data.data(), data.size(), 42);
+
+    // chunk sizes around the 32-byte stripe boundary
+    const size_t chunks[] = {1, 7, 31, 32, 33, 480, 4096};
+    for (size_t chunk : chunks) {
+        OutputHash h(42);
+        for (size_t pos = 0; pos < data.size(); pos += chunk) {
+            const size_t n = (data.size() - pos < chunk) ? data.size() - pos : chunk;
+            h.update(data.data() + pos, n);
+        }
+        ASSERT_TRUE(h.digest() == expected);
+    }
+}
+
+// Test 3: Seed and content changes alter the digest
+void test_sensitivity() {
+    printf("\n[TEST 3] Seed and content sensitivity\n");
+    std::vector<unsigned char> data(256, 0x55);
+    const uint64_t base = OutputHash::hash(data.data(), data.size());
+    ASSERT_TRUE(OutputHash::hash(data.data(), data.size(), 1) != base);
+    data[200] ^= 1;
+    ASSERT_TRUE(OutputHash::hash(data.data(), data.size()) != base);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("Output Hash Tests\n");
+    printf("========================================\n");
+
+    test_reference_vectors();
+    test_streaming_matches_oneshot();
+    test_sensitivity();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
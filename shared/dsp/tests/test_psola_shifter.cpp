@@ -0,0 +1,233 @@
+#include "psola_shifter.h"
+#include "audio_432hz.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const double RATIO_432 = 432.0 / 440.0;
+
+// Sustained vowel: harmonics of f0 under three formant resonances (an "a"),
+// with a slow 2% vibrato, band-limited to 4 kHz like call audio
+static std::vector<float> vowel(int sampleRate, int channels, double f0, double seconds) {
+    const double formants[3][2] = {{730.0, 90.0}, {1090.0, 110.0}, {2440.0, 170.0}};
+    const size_t frames = static_cast<size_t>(seconds * sampleRate);
+    std::vector<float> pcm(frames * channels);
+    double phase = 0.0;
+    for (size_t i = 0; i < frames; i++) {
+        const double f = f0 * (1.0 + 0.02 * std::sin(2.0 * M_PI * 4.0 * i / sampleRate));
+        phase += f / sampleRate;
+        double s = 0.0;
+        for (int k = 1; k * f < std::min(4000.0, 0.45 * sampleRate); k++) {
+            double gain = 0.0;
+            for (const auto& formant : formants) {
+                const double d = (k * f - formant[0]) / formant[1];
+                gain += 1.0 / (1.0 + d * d);
+            }
+            s += (0.05 + gain) / k * std::sin(2.0 * M_PI * k * phase);
+        }
+        for (int c = 0; c < channels; c++) pcm[i * channels + c] = static_cast<float>(0.1 * s);
+    }
+    return pcm;
+}
+
+static std::vector<float> noise(size_t samples, float level, uint32_t seed) {
+    std::vector<float> pcm(samples);
+    for (float& v : pcm) {
+        seed = seed * 1664525u + 1013904223u;
+        v = level * static_cast<float>(seed / 4294967296.0 - 0.5);
+    }
+    return pcm;
+}
+
+// Mean period of channel 0 over [from, from + frames) by autocorrelation,
+// searched within ±15% of 'expected' and interpolated
+static double measurePeriod(const std::vector<float>& pcm, int channels, size_t from, int frames,
+                            double expected) {
+    const int lo = static_cast<int>(expected * 0.85);
+    const int hi = static_cast<int>(expected * 1.15) + 1;
+    std::vector<double> r(hi + 2);
+    for (int lag = lo - 1; lag <= hi + 1; lag++) {
+        double ab = 0.0, aa = 0.0, bb = 0.0;
+        for (int i = 0; i < frames; i++) {
+            const double a = pcm[(from + i) * channels];
+            const double b = pcm[(from + i + lag) * channels];
+            ab += a * b;
+            aa += a * a;
+            bb += b * b;
+        }
+        r[lag] = ab / std::sqrt(aa * bb);
+    }
+    int best = lo;
+    for (int lag = lo; lag <= hi; lag++) if (r[lag] > r[best]) best = lag;
+    const double curvature = r[best - 1] - 2.0 * r[best] + r[best + 1];
+    return best + (curvature < 0.0 ? 0.5 * (r[best - 1] - r[best + 1]) / curvature : 0.0);
+}
+
+static double rms(const std::vector<float>& pcm, size_t from, size_t to) {
+    double sum = 0.0;
+    for (size_t i = from; i < to; i++) sum += pcm[i] * pcm[i];
+    return std::sqrt(sum / (to - from));
+}
+
+// Runs 'in' through the shifter in 10 ms callbacks
+static std::vector<float> shift(PsolaShifter& shifter, const std::vector<float>& in) {
+    std::vector<float> out(in.size());
+    const int block = shifter.sampleRate() / 100;
+    const int channels = shifter.channels();
+    const int frames = static_cast<int>(in.size()) / channels;
+    for (int done = 0; done < frames; done += block) {
+        const int n = std::min(block, frames - done);
+        shifter.process(&in[static_cast<size_t>(done) * channels], &out[static_cast<size_t>(done) * channels], n);
+    }
+    return out;
+}
+
+// Test 1: A vowel comes out 432/440 lower at speech and full rates
+void test_voice_shift() {
+    printf("\n[TEST 1] Vowel pitch at 8, 16 and 48 kHz\n");
+    const int rates[] = {8000, 16000, 48000};
+    const double voices[] = {110.0, 220.0};
+    for (int rate : rates) {
+        for (double f0 : voices) {
+            const int channels = rate == 48000 ? 2 : 1;
+            std::unique_ptr<PsolaShifter> shifter(PsolaShifter::create(rate, channels));
+            ASSERT_TRUE(shifter != nullptr);
+            shifter->setPitchSemitones(PITCH_SEMITONES_432_HZ);
+            // The 4 Hz vibrato averages out over the one-second measurement
+            const std::vector<float> in = vowel(rate, channels, f0, 2.0);
+            const std::vector<float> out = shift(*shifter, in);
+
+            const double expected = rate / f0;
+            const double before = measurePeriod(in, channels, rate / 2, rate, expected);
+            const double after = measurePeriod(out, channels, rate / 2, rate, expected / RATIO_432);
+            const double ratio = before / after;
+            const double levelDb = 20.0 * std::log10(rms(out, in.size() / 4, in.size()) /
+                                                     rms(in, in.size() / 4, in.size()));
+            const float latencyMs = 1000.0f * shifter->latencyFrames() / rate;
+            printf("  %5d Hz, f0 %3.0f Hz: tracked %6.1f Hz, ratio %.5f (target %.5f), level %+.2f dB, %.1f ms\n",
+                   rate, f0, shifter->f0Hz(), ratio, RATIO_432, levelDb, latencyMs);
+
+            ASSERT_TRUE(std::fabs(ratio / RATIO_432 - 1.0) < 0.002);
+            ASSERT_TRUE(std::fabs(shifter->f0Hz() / f0 - 1.0) < 0.05);
+            ASSERT_TRUE(std::fabs(levelDb) < 1.0);
+            ASSERT_TRUE(latencyMs < 10.0f);
+        }
+    }
+}
+
+// Test 2: Noise and silence pass through untouched, so the shifter costs
+// next to nothing while nobody speaks
+void test_unvoiced_passthrough() {
+    printf("\n[TEST 2] Unvoiced input passes through\n");
+    const int rate = 16000;
+    std::unique_ptr<PsolaShifter> shifter(PsolaShifter::create(rate, 1));
+    shifter->setPitchSemitones(PITCH_SEMITONES_432_HZ);
+
+    std::vector<float> in = noise(static_cast<size_t>(rate), 0.2f, 3);
+    in.resize(2 * rate, 0.0f);  // a second of silence after the noise
+    const std::vector<float> out = shift(*shifter, in);
+    ASSERT_TRUE(out == in);
+    ASSERT_TRUE(shifter->voicedFrames() == 0);
+    ASSERT_TRUE(shifter->f0Hz() == 0.0f);
+}
+
+// Test 3: Speech with pauses: the pauses stay in place and only the voiced
+// part is resynthesised
+void test_talk_spurts() {
+    printf("\n[TEST 3] Talk spurts\n");
+    const int rate = 48000;
+    std::unique_ptr<PsolaShifter> shifter(PsolaShifter::create(rate, 1));
+    shifter->setPitchSemitones(PITCH_SEMITONES_432_HZ);
+
+    // 0.5 s vowel, 0.5 s pause, ... 4 s in all
+    std::vector<float> in;
+    const std::vector<float> spurt = vowel(rate, 1, 140.0, 0.5);
+    for (int i = 0; i < 4; i++) {
+        in.insert(in.end(), spurt.begin(), spurt.end());
+        in.resize(in.size() + rate / 2, 0.0f);
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::vector<float> out = shift(*shifter, in);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const double voiced = static_cast<double>(shifter->voicedFrames()) / in.size();
+    printf("  voiced share %.1f%%, %.2f%% of real time\n", 100.0 * voiced, 100.0 * seconds / 4.0);
+    ASSERT_TRUE(out.size() == in.size());
+    ASSERT_TRUE(voiced > 0.42 && voiced < 0.52);
+
+    // Every pause is silent again within one period of the vowel's end
+    bool silent = true;
+    for (int i = 0; i < 4; i++) {
+        const size_t pause = static_cast<size_t>(i) * rate + rate / 2;
+        for (size_t k = pause + rate / 140 + 1; k < pause + rate / 2; k++) silent = silent && out[k] == 0.0f;
+    }
+    ASSERT_TRUE(silent);
+}
+
+// Test 4: The VoIP profile runs the voice engine: low latency, same shift
+void test_converter_voip() {
+    printf("\n[TEST 4] Converter VoIP profile\n");
+    const int rates[] = {8000, 16000, 48000};
+    for (int rate : rates) {
+        Audio432HzConverter music(rate, 1);
+        Audio432HzConverter voip(rate, 1);
+        voip.setProcessingProfile(ProcessingProfile::kVoip);
+
+        const std::vector<float> pcm = vowel(rate, 1, 180.0, 2.0);
+        std::vector<int16_t> buffer(pcm.size());
+        for (size_t i = 0; i < pcm.size(); i++) buffer[i] = static_cast<int16_t>(std::lround(32767.0f * pcm[i]));
+        const int block = rate / 50;
+        for (size_t done = 0; done + block <= buffer.size(); done += block) {
+            voip.process(&buffer[done], block);
+        }
+        std::vector<float> out(buffer.size());
+        for (size_t i = 0; i < buffer.size(); i++) out[i] = buffer[i] / 32768.0f;
+
+        const double after = measurePeriod(out, 1, rate / 2, rate, rate / 180.0 / RATIO_432);
+        const double ratio = (rate / 180.0) / after;
+        printf("  %5d Hz: latency %.1f ms (music %.1f ms), ratio %.5f\n", rate, voip.getLatencyMs(),
+               music.getLatencyMs(), ratio);
+        ASSERT_TRUE(voip.getLatencyMs() < 10.0f);
+        ASSERT_TRUE(voip.getLatencyMs() < music.getLatencyMs());
+        ASSERT_TRUE(std::fabs(ratio / RATIO_432 - 1.0) < 0.003);
+    }
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift PSOLA Voice Engine Tests\n");
+    printf("========================================\n");
+
+    test_voice_shift();
+    test_unvoiced_passthrough();
+    test_talk_spurts();
+    test_converter_voip();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
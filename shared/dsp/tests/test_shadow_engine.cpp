@@ -0,0 +1,349 @@
+#include "audio_432hz.h"
+#include "effect_core.h"
+#include "shadow_runner.h"
+#include "soundtouch_backend.h"
+#include "stats_page.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int RATE = 48000;
+static const int CHANNELS = 2;
+static const int BLOCK = 480;    // 10 ms
+static const int BLOCKS = 400;   // 4 s: the lag is found within about one
+static const int PITCH_BLOCKS = 1200;  // 12 s: the tuning estimates need 10
+
+// A4 = 440 chord with a slow tremolo and a little noise, so the outputs
+// correlate at one lag only
+static double sample(long frame, int channel) {
+    uint32_t seed = static_cast<uint32_t>(frame * CHANNELS + channel) * 2654435761u;
+    seed ^= seed >> 15;
+    seed *= 2246822519u;
+    const double noise = (static_cast<double>(seed >> 8) / (1 << 24) - 0.5) * 0.02;
+    const double t = static_cast<double>(frame) / RATE;
+    const double env = 0.6 + 0.4 * std::sin(2.0 * M_PI * 1.3 * t);
+    return env * (0.25 * std::sin(2.0 * M_PI * 440.0 * t) + 0.15 * std::sin(2.0 * M_PI * 554.37 * t + channel) +
+                  0.1 * std::sin(2.0 * M_PI * 659.25 * t)) +
+           noise;
+}
+
+template <class Sample>
+static std::vector<Sample> makeSignal(double fullScale, int blocks = BLOCKS) {
+    std::vector<Sample> pcm(static_cast<size_t>(blocks) * BLOCK * CHANNELS);
+    for (long i = 0; i < static_cast<long>(blocks) * BLOCK; i++) {
+        for (int c = 0; c < CHANNELS; c++) {
+            pcm[static_cast<size_t>(i) * CHANNELS + c] = static_cast<Sample>(std::lround(fullScale * sample(i, c)));
+        }
+    }
+    return pcm;
+}
+
+// Processes the signal in place, one block per call; returns the output.
+// Paced, the calls come every 2 ms, as an audio callback would send them
+// (only faster), so a worker keeps up
+static std::vector<int16_t> runConverter(Audio432HzConverter& converter, const std::vector<int16_t>& signal,
+                                         bool paced = false) {
+    std::vector<int16_t> pcm = signal;
+    const int blocks = static_cast<int>(pcm.size() / (BLOCK * CHANNELS));
+    for (int b = 0; b < blocks; b++) {
+        converter.process(pcm.data() + static_cast<size_t>(b) * BLOCK * CHANNELS, BLOCK * CHANNELS);
+        if (paced) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return pcm;
+}
+
+// Worker metrics settle once the worker has caught up
+template <class Fn>
+static ShadowMetrics settled(Fn metrics) {
+    ShadowMetrics m = metrics();
+    for (int i = 0; i < 200; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        const ShadowMetrics next = metrics();
+        if (next.framesCompared == m.framesCompared && i > 10) break;
+        m = next;
+    }
+    return metrics();
+}
+
+static void printMetrics(const char* name, const ShadowMetrics& m) {
+    printf("  %s: compared %llu, dropped %llu, cost %.2fx, SNR %.1f dB, pitch %.2f cents, lag %d\n", name,
+           static_cast<unsigned long long>(m.framesCompared), static_cast<unsigned long long>(m.dropped),
+           m.costRatio, m.snrDb, m.pitchCents, m.lagFrames);
+}
+
+/** Plays the input back late, at full speed */
+class DelayEngine : public ShadowEngine
+{
+public:
+    explicit DelayEngine(int delayFrames) : line_(static_cast<size_t>(delayFrames) * CHANNELS, 0) {}
+
+    int process(const void* in, void* out, int frames, PcmFormat) override {
+        const int16_t* src = static_cast<const int16_t*>(in);
+        int16_t* dst = static_cast<int16_t*>(out);
+        if (line_.empty()) {
+            std::memmove(dst, src, static_cast<size_t>(frames) * CHANNELS * sizeof(int16_t));
+            return frames;
+        }
+        for (int i = 0; i < frames * CHANNELS; i++) {
+            const int16_t v = src[i];
+            dst[i] = line_[pos_];
+            line_[pos_] = v;
+            pos_ = (pos_ + 1) % line_.size();
+        }
+        return frames;
+    }
+
+    void reset() override {
+        std::fill(line_.begin(), line_.end(), 0);
+        pos_ = 0;
+        resets++;
+    }
+
+    int resets = 0;
+
+private:
+    std::vector<int16_t> line_;
+    size_t pos_ = 0;
+};
+
+/** Takes longer than the audio it is given */
+class SlowEngine : public ShadowEngine
+{
+public:
+    int process(const void*, void* out, int frames, PcmFormat) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::memset(out, 0, static_cast<size_t>(frames) * CHANNELS * sizeof(int16_t));
+        return frames;
+    }
+    void reset() override { resets++; }
+
+    std::atomic<int> resets{0};
+};
+
+// Test 1: The converter's output does not depend on a shadow, inline or on
+// the worker, and an identical shadow matches it exactly
+void test_converter_identical() {
+    printf("\n[TEST 1] Converter: identical shadow, output untouched\n");
+    const std::vector<int16_t> signal = makeSignal<int16_t>(32767.0);
+
+    Audio432HzConverter plain(RATE, CHANNELS);
+    const std::vector<int16_t> reference = runConverter(plain, signal);
+    ASSERT_TRUE(!plain.hasShadow());
+
+    for (ShadowMode mode : {ShadowMode::kInline, ShadowMode::kWorker}) {
+        Audio432HzConverter converter(RATE, CHANNELS);
+        ASSERT_TRUE(converter.setShadow(std::make_unique<Audio432HzConverter>(RATE, CHANNELS), mode));
+        ASSERT_TRUE(converter.hasShadow());
+        const std::vector<int16_t> out = runConverter(converter, signal, mode == ShadowMode::kWorker);
+        ASSERT_TRUE(out == reference);
+
+        const ShadowMetrics m = settled([&] { return converter.getShadowMetrics(); });
+        printMetrics(mode == ShadowMode::kInline ? "inline" : "worker", m);
+        ASSERT_TRUE(m.dropped == 0);
+        ASSERT_TRUE(m.framesCompared > static_cast<uint64_t>(RATE));
+        ASSERT_TRUE(m.lagFrames == 0);
+        ASSERT_TRUE(m.snrDb > 60.0f);
+        ASSERT_TRUE(std::fabs(m.pitchCents) < 1.0f);
+        ASSERT_TRUE(m.costRatio > 0.2f && m.costRatio < 5.0f);
+
+        ASSERT_TRUE(converter.getMemoryUsage().allocatedBytes > plain.getMemoryUsage().allocatedBytes);
+        ASSERT_TRUE(converter.setShadow(nullptr));
+        ASSERT_TRUE(!converter.hasShadow() && converter.getShadowMetrics().framesCompared == 0);
+    }
+
+    Audio432HzConverter converter(RATE, CHANNELS);
+    ASSERT_TRUE(!converter.setShadow(std::make_unique<Audio432HzConverter>(RATE, 1)));
+    ASSERT_TRUE(!converter.hasShadow());
+}
+
+// Test 2: Shadows that differ show up in the metrics: another interpolator
+// moves WSOLA's splice points and costs SNR, another pitch shows as a
+// pitch deviation
+void test_converter_different() {
+    printf("\n[TEST 2] Converter: differing shadows\n");
+    Audio432HzConverter converter(RATE, CHANNELS);
+    auto linear = std::make_unique<Audio432HzConverter>(RATE, CHANNELS);
+    linear->setInterpolator(Interpolator::kLinear);
+    ASSERT_TRUE(converter.setShadow(std::move(linear), ShadowMode::kInline));
+    runConverter(converter, makeSignal<int16_t>(32767.0));
+    ShadowMetrics m = converter.getShadowMetrics();
+    printMetrics("linear interpolation", m);
+    ASSERT_TRUE(m.framesCompared > 0 && m.snrDb < 60.0f);
+
+    // Unshifted, the shadow stays at A4 = 440: 31.8 cents above production.
+    // The outputs no longer correlate, so they are never aligned
+    auto unshifted = std::make_unique<Audio432HzConverter>(RATE, CHANNELS);
+    unshifted->setPitchShiftSemitones(0.0f);
+    ASSERT_TRUE(converter.setShadow(std::move(unshifted), ShadowMode::kInline));
+    runConverter(converter, makeSignal<int16_t>(32767.0, PITCH_BLOCKS));
+    m = converter.getShadowMetrics();
+    printMetrics("unshifted", m);
+    ASSERT_TRUE(std::fabs(m.pitchCents - 1200.0f * std::log2(440.0f / 432.0f)) < 3.0f);
+    ASSERT_TRUE(m.snrDb < 20.0f);
+}
+
+// Test 3: The lag search finds a shadow that runs late
+void test_lag() {
+    printf("\n[TEST 3] Lag between the outputs\n");
+    const std::vector<int16_t> signal = makeSignal<int16_t>(32767.0);
+    for (int delay : {0, 37, 1234, 6000}) {
+        std::unique_ptr<ShadowRunner> runner(
+            ShadowRunner::create(std::make_unique<DelayEngine>(delay), RATE, CHANNELS, ShadowMode::kInline));
+        ASSERT_TRUE(runner != nullptr);
+        for (int b = 0; b < BLOCKS; b++) {
+            const int16_t* block = signal.data() + static_cast<size_t>(b) * BLOCK * CHANNELS;
+            runner->begin(block, BLOCK, PcmFormat::kInt16);
+            runner->end(block, BLOCK, 1000);  // production passes the input through
+        }
+        const ShadowMetrics m = runner->metrics();
+        char name[32];
+        snprintf(name, sizeof(name), "delay %d", delay);
+        printMetrics(name, m);
+        ASSERT_TRUE(m.lagFrames == delay);
+        ASSERT_TRUE(m.snrDb > 60.0f);
+    }
+}
+
+// Test 4: A worker that cannot keep up costs the audio thread nothing:
+// calls it has no room for are dropped and counted, and the shadow
+// restarts after the gap
+void test_worker_starved() {
+    printf("\n[TEST 4] Starved worker\n");
+    const std::vector<int16_t> signal = makeSignal<int16_t>(32767.0);
+    auto engine = std::make_unique<SlowEngine>();
+    SlowEngine* slow = engine.get();
+    std::unique_ptr<ShadowRunner> runner(
+        ShadowRunner::create(std::move(engine), RATE, CHANNELS, ShadowMode::kWorker));
+    ASSERT_TRUE(runner != nullptr);
+
+    const int calls = 100;
+    double worstUs = 0.0;
+    for (int b = 0; b < calls; b++) {
+        const int16_t* block = signal.data() + static_cast<size_t>(b) * BLOCK * CHANNELS;
+        const auto t0 = std::chrono::steady_clock::now();
+        runner->begin(block, BLOCK, PcmFormat::kInt16);
+        runner->end(block, BLOCK, 1000);
+        worstUs = std::max(
+            worstUs, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    runner->drain();
+    const ShadowMetrics m = runner->metrics();
+    printf("  worst begin()+end(): %.1f us, resets %d\n", worstUs, slow->resets.load());
+    printMetrics("slow shadow", m);
+    ASSERT_TRUE(m.dropped > calls / 2);
+    ASSERT_TRUE(m.dropped < static_cast<uint64_t>(calls));
+    ASSERT_TRUE(slow->resets > 0);
+    ASSERT_TRUE(worstUs < 5000.0);  // never waits for a 20 ms shadow call
+
+    // Oversized calls are dropped, not truncated
+    std::vector<int16_t> big(static_cast<size_t>(ShadowRunner::MAX_FRAMES + 1) * CHANNELS, 0);
+    const uint64_t before = runner->metrics().dropped;
+    runner->begin(big.data(), ShadowRunner::MAX_FRAMES + 1, PcmFormat::kInt16);
+    runner->end(big.data(), ShadowRunner::MAX_FRAMES + 1, 1000);
+    ASSERT_TRUE(runner->metrics().dropped == before + 1);
+}
+
+// Test 5: EffectCore: the shadow follows the settings, leaves the output
+// alone and is published to the stats page
+void test_effect_core() {
+    printf("\n[TEST 5] EffectCore shadow\n");
+    const std::vector<int32_t> signal = makeSignal<int32_t>(2147483647.0);
+
+    auto run = [&](EffectCore<SoundTouchBackend>& core, bool paced) {
+        std::vector<int32_t> pcm = signal;
+        for (int b = 0; b < BLOCKS; b++) {
+            int32_t* block = pcm.data() + static_cast<size_t>(b) * BLOCK * CHANNELS;
+            core.process(block, block, BLOCK);
+            if (paced) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return pcm;
+    };
+
+    EffectCore<SoundTouchBackend> plain;
+    plain.setFormat(RATE, CHANNELS, PcmFormat::kInt32);
+    plain.setPitchRatio(std::pow(2.0f, -0.5f / 12.0f));
+    plain.enable();
+    const std::vector<int32_t> reference = run(plain, false);
+
+    std::unique_ptr<StatsPage> page(StatsPage::create(nullptr));
+    ASSERT_TRUE(page != nullptr);
+    for (ShadowMode mode : {ShadowMode::kInline, ShadowMode::kWorker}) {
+        EffectCore<SoundTouchBackend> core;
+        core.attachStats(page.get());
+        ASSERT_TRUE(core.startShadow<SoundTouchBackend>(mode) == 0);
+        ASSERT_TRUE(core.hasShadow());
+        // Set after the shadow started: it must follow
+        ASSERT_TRUE(core.setFormat(RATE, CHANNELS, PcmFormat::kInt32) == 0);
+        ASSERT_TRUE(core.setPitchRatio(std::pow(2.0f, -0.5f / 12.0f)) == 0);
+        ASSERT_TRUE(core.enable() == 0);
+        const std::vector<int32_t> out = run(core, mode == ShadowMode::kWorker);
+        ASSERT_TRUE(out == reference);
+
+        const ShadowMetrics m = settled([&] { return core.shadowMetrics(); });
+        printMetrics(mode == ShadowMode::kInline ? "inline" : "worker", m);
+        ASSERT_TRUE(m.framesCompared > static_cast<uint64_t>(RATE) && m.dropped == 0);
+        ASSERT_TRUE(m.lagFrames == 0 && m.snrDb > 60.0f);
+        ASSERT_TRUE(std::fabs(m.pitchCents) < 1.0f);
+
+        std::vector<int32_t> block(signal.begin(), signal.begin() + BLOCK * CHANNELS);
+        core.process(block.data(), block.data(), BLOCK);  // publishes the settled metrics
+        InstanceStats s = {};
+        for (int slot = 0; slot < STATS_MAX_INSTANCES; slot++) {
+            if (page->read(slot, s) && (s.flags & kStatsShadow)) break;
+        }
+        ASSERT_TRUE(s.flags & kStatsShadow);
+        ASSERT_TRUE(s.shadowSnrDb > 60.0f && s.shadowLag == 0 && s.shadowCost > 0.0f);
+
+        core.stopShadow();
+        ASSERT_TRUE(!core.hasShadow());
+        bool shadowShown = false;
+        for (int slot = 0; slot < STATS_MAX_INSTANCES; slot++) {
+            shadowShown = shadowShown || (page->read(slot, s) && (s.flags & kStatsShadow));
+        }
+        ASSERT_TRUE(!shadowShown);
+    }
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Shadow Engine Tests\n");
+    printf("========================================\n");
+
+    test_converter_identical();
+    test_converter_different();
+    test_lag();
+    test_worker_starved();
+    test_effect_core();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
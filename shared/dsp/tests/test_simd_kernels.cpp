@@ -0,0 +1,295 @@
+#include "FIRFilter.h"
+#include "TDStretch.h"
+#include "cpu_detect.h"
+#include "pcm_convert.h"
+#include <cstdio>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace soundtouch;
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const uint ALL_X86_EXTENSIONS = 0xffffffff;
+
+// Deterministic pseudo-random samples in [-1, 1)
+static std::vector<float> noise(size_t count, uint32_t seed) {
+    std::vector<float> v(count);
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        v[i] = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+    }
+    return v;
+}
+
+static float maxAbsDiff(const float* a, const float* b, size_t n) {
+    float m = 0.0f;
+    for (size_t i = 0; i < n; i++) m = std::fmax(m, std::fabs(a[i] - b[i]));
+    return m;
+}
+
+// Exposes the protected TDStretch kernels of a given implementation
+template <class Base>
+class StretchProbe : public Base {
+public:
+    StretchProbe(int channels) {
+        this->setChannels(channels);
+        this->setParameters(48000, 40, 15, 8);
+    }
+    using Base::calcCrossCorr;
+    using Base::dotProduct;
+    using Base::overlapStereo;
+    using Base::overlapMono;
+    float* mid() { return this->pMidBuffer; }
+    int overlap() const { return this->overlapLength; }
+};
+
+// Test 1: Runtime detection reports AVX2 together with its prerequisites
+void test_detection() {
+    printf("\n[TEST 1] CPU extension detection\n");
+    uint ext = detectCPUextensions();
+    printf("  extensions 0x%x, pcm kernels: %s\n", ext, pcmKernelName());
+    ASSERT_TRUE(!(ext & SUPPORT_AVX2) || (ext & SUPPORT_SSE2));
+
+    disableExtensions(SUPPORT_AVX2);
+    ASSERT_TRUE((detectCPUextensions() & SUPPORT_AVX2) == 0);
+    disableExtensions(0);
+}
+
+// Test 2: Optimized FIR filter matches the plain C version
+void test_fir_matches_generic() {
+    printf("\n[TEST 2] FIR filter matches generic version\n");
+    std::unique_ptr<FIRFilter> fast(FIRFilter::newInstance());
+    disableExtensions(ALL_X86_EXTENSIONS);
+    std::unique_ptr<FIRFilter> plain(FIRFilter::newInstance());
+    disableExtensions(0);
+
+    const uint taps = 64;
+    std::vector<float> coeffs = noise(taps, 7);
+    fast->setCoefficients(coeffs.data(), taps, 5);
+    plain->setCoefficients(coeffs.data(), taps, 5);
+
+    for (uint channels = 1; channels <= 2; channels++) {
+        const uint frames = 1000;
+        std::vector<float> src = noise(frames * channels, 11 + channels);
+        std::vector<float> outFast(frames * channels, 0.0f);
+        std::vector<float> outPlain(frames * channels, 0.0f);
+
+        uint nFast = fast->evaluate(outFast.data(), src.data(), frames, channels);
+        uint nPlain = plain->evaluate(outPlain.data(), src.data(), frames, channels);
+        // SIMD stereo versions return an even count
+        ASSERT_TRUE(nFast > 0 && nFast <= nPlain && nPlain - nFast <= 1);
+        ASSERT_TRUE(maxAbsDiff(outFast.data(), outPlain.data(), nFast * channels) < 1e-5f);
+    }
+}
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+// Test 3: AVX2 cross-correlation and overlap match the plain C version
+void test_stretch_kernels_match_generic() {
+    printf("\n[TEST 3] TDStretch kernels match generic version\n");
+    if (!(detectCPUextensions() & SUPPORT_AVX2) || !(detectCPUextensions() & SUPPORT_FMA)) {
+        printf("  AVX2/FMA not available, skipped\n");
+        return;
+    }
+
+    for (int channels = 1; channels <= 2; channels++) {
+        StretchProbe<TDStretchAVX2> fast(channels);
+        StretchProbe<TDStretch> plain(channels);
+        ASSERT_TRUE(fast.overlap() == plain.overlap());
+
+        const size_t n = static_cast<size_t>(fast.overlap()) * channels;
+        std::vector<float> a = noise(n + 1, 21);
+        std::vector<float> b = noise(n, 22);
+
+        // odd offset: the mixing position is not aligned in general
+        double normFast = 0, normPlain = 0;
+        double cFast = fast.calcCrossCorr(a.data() + 1, b.data(), normFast);
+        double cPlain = plain.calcCrossCorr(a.data() + 1, b.data(), normPlain);
+        ASSERT_TRUE(std::fabs(cFast - cPlain) < 1e-4 * std::fmax(1.0, std::fabs(cPlain)));
+        ASSERT_TRUE(std::fabs(normFast - normPlain) < 1e-4 * normPlain);
+
+        std::vector<float> mid = noise(n, 23);
+        std::copy(mid.begin(), mid.end(), fast.mid());
+        std::copy(mid.begin(), mid.end(), plain.mid());
+
+        std::vector<float> outFast(n), outPlain(n);
+        if (channels == 1) {
+            fast.overlapMono(outFast.data(), a.data());
+            plain.overlapMono(outPlain.data(), a.data());
+        } else {
+            fast.overlapStereo(outFast.data(), a.data());
+            plain.overlapStereo(outPlain.data(), a.data());
+        }
+        ASSERT_TRUE(maxAbsDiff(outFast.data(), outPlain.data(), n) < 1e-5f);
+
+        // the fast-seek dot product is bit-exact, tail included
+        const int odd = static_cast<int>(n) - 5;
+        ASSERT_TRUE(fast.dotProduct(a.data() + 1, b.data(), odd) == plain.dotProduct(a.data() + 1, b.data(), odd));
+    }
+}
+#endif
+
+// Test 4: PCM conversions are bit-exact with the scalar definition
+void test_pcm_conversion_exact() {
+    printf("\n[TEST 4] PCM conversion kernels are exact\n");
+
+    // odd length exercises the scalar tails
+    const int frames = 1031;
+    std::vector<int16_t> pcm(frames * 2);
+    for (int i = 0; i < frames * 2; i++) {
+        pcm[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+    }
+
+    std::vector<float> flat(frames * 2);
+    int16ToFloat(pcm.data(), flat.data(), flat.size());
+    bool exact = true;
+    for (int i = 0; i < frames * 2; i++) {
+        if (flat[i] != pcm[i] / 32768.0f) exact = false;
+    }
+    ASSERT_TRUE(exact);
+
+    PlanarBuffer planar;
+    planar.reserve(2, frames);
+    ASSERT_TRUE(reinterpret_cast<uintptr_t>(planar.channel(1)) % PlanarBuffer::ALIGNMENT == 0);
+    deinterleaveToFloat(pcm.data(), frames, 2, planar);
+    exact = true;
+    for (int i = 0; i < frames; i++) {
+        if (planar.channel(0)[i] != flat[2 * i] || planar.channel(1)[i] != flat[2 * i + 1]) exact = false;
+    }
+    ASSERT_TRUE(exact);
+
+    // include out-of-range values to check saturation
+    for (int i = 0; i < frames; i += 17) {
+        planar.channel(0)[i] = 1.5f;
+        planar.channel(1)[i] = -3.0f;
+    }
+    std::vector<int16_t> back(frames * 2);
+    interleaveToInt16(planar, frames, 2, back.data());
+
+    std::vector<float> interleaved(frames * 2);
+    for (int i = 0; i < frames; i++) {
+        interleaved[2 * i] = planar.channel(0)[i];
+        interleaved[2 * i + 1] = planar.channel(1)[i];
+    }
+    std::vector<int16_t> backFlat(frames * 2);
+    floatToInt16(interleaved.data(), backFlat.data(), backFlat.size());
+
+    exact = true;
+    for (int i = 0; i < frames * 2; i++) {
+        float s = interleaved[i] * 32767.0f;
+        s = std::fmax(-32768.0f, std::fmin(32767.0f, s));
+        const int16_t expected = static_cast<int16_t>(s);
+        if (back[i] != expected || backFlat[i] != expected) exact = false;
+    }
+    ASSERT_TRUE(exact);
+}
+
+// Test 5: Hi-res PCM conversions are bit-exact with the scalar definition
+// and write exactly the samples asked for
+void test_hires_conversion_exact() {
+    printf("\n[TEST 5] Hi-res PCM conversion kernels are exact\n");
+
+    const size_t count = 1031;
+    const float scale24 = 1.0f / 8388608.0f;
+    const float scale32 = 1.0f / 2147483648.0f;
+
+    // Packed 24-bit, every sign and byte pattern mixed in
+    std::vector<uint8_t> packed(count * 3);
+    for (size_t i = 0; i < packed.size(); i++) packed[i] = static_cast<uint8_t>(i * 7919 >> 3);
+    std::vector<float> flat(count);
+    pcmToFloat(packed.data(), PcmFormat::kInt24Packed, flat.data(), count);
+    bool exact = true;
+    for (size_t i = 0; i < count; i++) {
+        int32_t v = packed[3 * i] | packed[3 * i + 1] << 8 | packed[3 * i + 2] << 16;
+        if (v & 0x800000) v -= 0x1000000;
+        if (flat[i] != static_cast<float>(v) * scale24) exact = false;
+    }
+    ASSERT_TRUE(exact);
+
+    // 8.24 and 32-bit read the same words with their own scale; 8.24
+    // keeps values beyond full scale
+    std::vector<int32_t> words(count);
+    for (size_t i = 0; i < count; i++) words[i] = static_cast<int32_t>(i * 2654435761u);
+    std::vector<float> q(count), s32(count);
+    pcmToFloat(words.data(), PcmFormat::kQ8_23, q.data(), count);
+    pcmToFloat(words.data(), PcmFormat::kInt32, s32.data(), count);
+    exact = true;
+    for (size_t i = 0; i < count; i++) {
+        if (q[i] != static_cast<float>(words[i]) * scale24) exact = false;
+        if (s32[i] != static_cast<float>(words[i]) * scale32) exact = false;
+    }
+    ASSERT_TRUE(exact);
+
+    // Back again, with out-of-range values and NaN to check saturation
+    std::vector<float> source = noise(count, 11);
+    for (size_t i = 0; i < count; i += 17) source[i] = (i & 1) ? 1.5f : -3.0f;
+    source[5] = NAN;
+    std::vector<uint8_t> packedOut(count * 3 + 4, 0xA5);
+    std::vector<int32_t> qOut(count), s32Out(count);
+    floatToPcm(source.data(), PcmFormat::kInt24Packed, packedOut.data(), count);
+    floatToPcm(source.data(), PcmFormat::kQ8_23, qOut.data(), count);
+    floatToPcm(source.data(), PcmFormat::kInt32, s32Out.data(), count);
+    exact = true;
+    for (size_t i = 0; i < count; i++) {
+        const float v24 = std::isnan(source[i]) ? 8388607.0f
+            : std::fmax(-8388608.0f, std::fmin(8388607.0f, source[i] * 8388607.0f));
+        const float v32 = std::isnan(source[i]) ? 2147483520.0f
+            : std::fmax(-2147483648.0f, std::fmin(2147483520.0f, source[i] * 2147483648.0f));
+        const int32_t e24 = static_cast<int32_t>(v24);
+        int32_t got24 = packedOut[3 * i] | packedOut[3 * i + 1] << 8 | packedOut[3 * i + 2] << 16;
+        if (got24 & 0x800000) got24 -= 0x1000000;
+        if (got24 != e24 || qOut[i] != e24 || s32Out[i] != static_cast<int32_t>(v32)) exact = false;
+    }
+    ASSERT_TRUE(exact);
+    const uint8_t guard[4] = {0xA5, 0xA5, 0xA5, 0xA5};
+    ASSERT_TRUE(std::memcmp(packedOut.data() + count * 3, guard, 4) == 0);
+
+    // 16-bit content widened to 24 bits converts to the same floats
+    std::vector<int16_t> pcm16(count);
+    for (size_t i = 0; i < count; i++) pcm16[i] = static_cast<int16_t>(i * 7919 % 65536 - 32768);
+    for (size_t i = 0; i < count; i++) {
+        const int32_t v = pcm16[i] * 256;
+        std::memcpy(&packed[3 * i], &v, 3);
+    }
+    std::vector<float> from16(count);
+    pcmToFloat(pcm16.data(), PcmFormat::kInt16, from16.data(), count);
+    pcmToFloat(packed.data(), PcmFormat::kInt24Packed, flat.data(), count);
+    ASSERT_TRUE(from16 == flat);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("SIMD Kernel Tests\n");
+    printf("========================================\n");
+
+    test_detection();
+    test_fir_matches_generic();
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    test_stretch_kernels_match_generic();
+#endif
+    test_pcm_conversion_exact();
+    test_hires_conversion_exact();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
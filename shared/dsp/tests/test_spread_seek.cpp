@@ -0,0 +1,224 @@
+#include "SoundTouch.h"
+#include "TDStretch.h"
+#include "audio_432hz.h"
+#include "latency_budget.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace soundtouch;
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int RATE = 48000;
+static const int CHANNELS = 2;
+static const int CALLBACK = RATE / 200;  // 5 ms
+
+enum Search { kFull, kQuick, kFast };
+static const char* const SEARCH_NAMES[] = {"full", "quick", "fast"};
+
+// Stereo chord with vibrato and a little noise
+static std::vector<float> chord(size_t frames, uint32_t seed) {
+    static const double partials[] = {110.0, 220.0, 330.0, 440.0, 554.4, 659.3};
+    std::vector<float> pcm(frames * CHANNELS);
+    double phase[6] = {0};
+    for (size_t i = 0; i < frames; i++) {
+        double s = 0.0;
+        for (int k = 0; k < 6; k++) {
+            const double f = partials[k] * (1.0 + 0.004 * std::sin(2.0 * M_PI * 5.0 * i / RATE + k));
+            phase[k] += 2.0 * M_PI * f / RATE;
+            s += 0.12 / (1.0 + 0.3 * k) * std::sin(phase[k]);
+        }
+        for (int c = 0; c < CHANNELS; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            pcm[i * CHANNELS + c] = static_cast<float>(s * (c ? 0.9 : 1.0) + 0.02 * (seed / 4294967296.0 - 0.5));
+        }
+    }
+    return pcm;
+}
+
+static void selectSearch(SoundTouch& st, Search search) {
+    st.setSetting(SETTING_USE_QUICKSEEK, search == kQuick);
+    st.setSetting(SETTING_FAST_SEEK, search == kFast);
+}
+
+// Plain C tempo changer that counts the multiply-adds of its overlap search
+class WorkProbe : public TDStretch {
+public:
+    WorkProbe(Search search, bool spread) {
+        const LatencyTierSettings& s = latencyTierSettings(LatencyTier::kBalanced);
+        setChannels(CHANNELS);
+        setParameters(RATE, s.sequenceMs, s.seekWindowMs, s.overlapMs);
+        setTempo(440.0 / 432.0);
+        enableQuickSeek(search == kQuick);
+        enableFastSeek(search == kFast);
+        enableSpreadSeek(spread);
+    }
+    uint64_t work = 0;
+
+protected:
+    double calcCrossCorr(const float* mixingPos, const float* compare, double& norm) override {
+        work += static_cast<uint64_t>(channels) * overlapLength;
+        return TDStretch::calcCrossCorr(mixingPos, compare, norm);
+    }
+    double calcCrossCorrAccumulate(const float* mixingPos, const float* compare, double& norm) override {
+        work += static_cast<uint64_t>(channels) * overlapLength;
+        return TDStretch::calcCrossCorrAccumulate(mixingPos, compare, norm);
+    }
+    float dotProduct(const float* a, const float* b, int length) const override {
+        const_cast<WorkProbe*>(this)->work += static_cast<uint64_t>(length);
+        return TDStretch::dotProduct(a, b, length);
+    }
+};
+
+// Search work per 5 ms callback after the first second: worst / mean
+static double workPeakToMean(Search search, bool spread, const std::vector<float>& in) {
+    WorkProbe probe(search, spread);
+    uint64_t peak = 0, total = 0, calls = 0;
+    std::vector<float> sink(static_cast<size_t>(4 * CALLBACK) * CHANNELS);
+    const size_t frames = in.size() / CHANNELS;
+    for (size_t pos = 0; pos + CALLBACK <= frames; pos += CALLBACK) {
+        probe.work = 0;
+        probe.putSamples(&in[pos * CHANNELS], CALLBACK);
+        while (probe.receiveSamples(sink.data(), 4 * CALLBACK) > 0) {
+        }
+        if (pos < static_cast<size_t>(RATE)) continue;
+        peak = std::max(peak, probe.work);
+        total += probe.work;
+        calls++;
+    }
+    return total ? static_cast<double>(peak) * calls / total : 0.0;
+}
+
+// Test 1: The setting reaches the tempo changer
+void test_setting() {
+    printf("\n[TEST 1] SETTING_SPREAD_SEEK\n");
+    SoundTouch st;
+    ASSERT_TRUE(st.getSetting(SETTING_SPREAD_SEEK) == 0);
+    ASSERT_TRUE(st.setSetting(SETTING_SPREAD_SEEK, 1));
+    ASSERT_TRUE(st.getSetting(SETTING_SPREAD_SEEK) == 1);
+    ASSERT_TRUE(st.setSetting(SETTING_SPREAD_SEEK, 0));
+    ASSERT_TRUE(st.getSetting(SETTING_SPREAD_SEEK) == 0);
+}
+
+// Test 2: Spreading changes when the search runs, never what it finds:
+// every search, tier and callback size gives bit-identical output
+void test_bit_identical() {
+    printf("\n[TEST 2] Same output with and without spreading\n");
+    const std::vector<float> in = chord(3 * RATE, 7);
+    const int blocks[] = {CALLBACK, 2 * CALLBACK + 37, 4096};
+    for (int search = kFull; search <= kFast; search++) {
+        for (int t = 0; t <= static_cast<int>(LatencyTier::kMinimum); t++) {
+            bool identical = true;
+            for (int block : blocks) {
+                std::vector<float> out[2];
+                for (int spread = 0; spread < 2; spread++) {
+                    SoundTouch st;
+                    st.setChannels(CHANNELS);
+                    st.setSampleRate(RATE);
+                    st.setPitchSemiTones(PITCH_SEMITONES_432_HZ);
+                    applyLatencyTier(st, static_cast<LatencyTier>(t));
+                    selectSearch(st, static_cast<Search>(search));
+                    st.setSetting(SETTING_SPREAD_SEEK, spread);
+
+                    std::vector<float> buffer(static_cast<size_t>(block) * CHANNELS);
+                    const size_t frames = in.size() / CHANNELS;
+                    for (size_t pos = 0; pos < frames; pos += block) {
+                        const int n = static_cast<int>(std::min<size_t>(block, frames - pos));
+                        st.putSamples(&in[pos * CHANNELS], n);
+                        uint got;
+                        while ((got = st.receiveSamples(buffer.data(), block)) > 0) {
+                            out[spread].insert(out[spread].end(), buffer.begin(), buffer.begin() + got * CHANNELS);
+                        }
+                    }
+                }
+                identical = identical && !out[0].empty() && out[0] == out[1];
+            }
+            printf("  %-5s search, tier %d: %s\n", SEARCH_NAMES[search], t, identical ? "identical" : "DIFFERENT");
+            ASSERT_TRUE(identical);
+        }
+    }
+}
+
+// Test 3: Spread, every 5 ms callback does about the same search work;
+// otherwise the callback that completes a sequence does all of it
+void test_even_work() {
+    printf("\n[TEST 3] Search work per 5 ms callback\n");
+    const std::vector<float> in = chord(4 * RATE, 11);
+    for (int search = kFull; search <= kFast; search++) {
+        const double lumped = workPeakToMean(static_cast<Search>(search), false, in);
+        const double spread = workPeakToMean(static_cast<Search>(search), true, in);
+        printf("  %-5s search: worst/mean %.2f at sequence end, %.2f spread\n", SEARCH_NAMES[search],
+               lumped, spread);
+        ASSERT_TRUE(spread < 2.0);
+        ASSERT_TRUE(spread * 2.5 < lumped);
+    }
+}
+
+// Test 4: The same on the clock (printed only: timings on a shared machine
+// are too noisy to assert on)
+void test_callback_time() {
+    printf("\n[TEST 4] Callback time, balanced tier\n");
+    const std::vector<float> in = chord(6 * RATE, 5);
+    for (int spread = 0; spread < 2; spread++) {
+        SoundTouch st;
+        st.setChannels(CHANNELS);
+        st.setSampleRate(RATE);
+        st.setPitchSemiTones(PITCH_SEMITONES_432_HZ);
+        st.setSetting(SETTING_USE_AA_FILTER, 1);
+        applyLatencyTier(st, LatencyTier::kBalanced);
+        st.setSetting(SETTING_SPREAD_SEEK, spread);
+
+        std::vector<float> out(static_cast<size_t>(CALLBACK) * CHANNELS);
+        std::vector<double> costs;
+        for (size_t pos = 0; pos + CALLBACK <= in.size() / CHANNELS; pos += CALLBACK) {
+            const auto t0 = std::chrono::steady_clock::now();
+            st.putSamples(&in[pos * CHANNELS], CALLBACK);
+            st.receiveSamples(out.data(), CALLBACK);
+            costs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+        }
+        costs.erase(costs.begin(), costs.begin() + 200);  // first second
+        std::sort(costs.begin(), costs.end());
+        double mean = 0.0;
+        for (double c : costs) mean += c;
+        mean /= costs.size();
+        const double p99 = costs[costs.size() * 99 / 100];
+        printf("  %s: mean %.1f µs, p99 %.1f µs, p99/mean %.2f\n", spread ? "spread" : "lumped", mean, p99,
+               p99 / mean);
+    }
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Spread Overlap Search Tests\n");
+    printf("========================================\n");
+
+    test_setting();
+    test_bit_identical();
+    test_even_work();
+    test_callback_time();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+#include "stats_page.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static std::string tempPath() {
+    char path[] = "/tmp/audioshift_stats_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    return path;
+}
+
+// Test 1: Callback cost histogram buckets
+void test_histogram_buckets() {
+    printf("\n[TEST 1] Histogram buckets\n");
+    ASSERT_TRUE(StatsPage::histogramBucket(0) == 0);
+    ASSERT_TRUE(StatsPage::histogramBucket(15999) == 0);
+    ASSERT_TRUE(StatsPage::histogramBucket(16000) == 1);
+    ASSERT_TRUE(StatsPage::histogramBucket(31999) == 1);
+    ASSERT_TRUE(StatsPage::histogramBucket(32000) == 2);
+    ASSERT_TRUE(StatsPage::histogramBucket(1000000) == 6);  // 1 ms in [512, 1024) µs
+    ASSERT_TRUE(StatsPage::histogramBucket(UINT64_MAX) == STATS_HISTOGRAM_BUCKETS - 1);
+}
+
+// Test 2: Slots as seen by a separate read-only mapping
+void test_slots() {
+    printf("\n[TEST 2] Slot life-cycle through a read-only mapping\n");
+    const std::string path = tempPath();
+    std::unique_ptr<StatsPage> writer(StatsPage::create(path.c_str()));
+    ASSERT_TRUE(writer != nullptr);
+    ASSERT_TRUE(writer->isFileBacked());
+    std::unique_ptr<StatsPage> reader(StatsPage::openReadOnly(path.c_str()));
+    ASSERT_TRUE(reader != nullptr);
+
+    uint32_t id1 = 0;
+    uint32_t id2 = 0;
+    const int slot1 = writer->acquireSlot(id1);
+    const int slot2 = writer->acquireSlot(id2);
+    ASSERT_TRUE(slot1 >= 0 && slot2 >= 0 && slot1 != slot2);
+    ASSERT_TRUE(id1 != 0 && id2 != id1);
+    ASSERT_TRUE(reader->global().liveInstances.load() == 2);
+
+    InstanceStats stats = {};
+    stats.id = id2;
+    stats.flags = kStatsEnabled | kStatsEngineAllocated;
+    stats.profile = 1;
+    stats.callbacks = 1234;
+    stats.histogram[3] = 77;
+    writer->publish(slot2, stats);
+
+    InstanceStats seen;
+    ASSERT_TRUE(reader->read(slot2, seen));
+    ASSERT_TRUE(seen.id == id2 && seen.callbacks == 1234 && seen.histogram[3] == 77);
+    ASSERT_TRUE(seen.profile == 1 && seen.flags == (kStatsEnabled | kStatsEngineAllocated));
+    ASSERT_TRUE(reader->read(slot1, seen) && seen.id == id1 && seen.callbacks == 0);
+
+    // released slots read as free and are handed out again with a new id
+    writer->releaseSlot(slot1);
+    ASSERT_TRUE(!reader->read(slot1, seen));
+    ASSERT_TRUE(reader->global().liveInstances.load() == 1);
+    uint32_t id3 = 0;
+    ASSERT_TRUE(writer->acquireSlot(id3) == slot1);
+    ASSERT_TRUE(id3 != id1 && id3 != id2);
+
+    // a read-only mapping cannot take slots
+    uint32_t none = 1;
+    ASSERT_TRUE(reader->acquireSlot(none) == -1 && none == 0);
+
+    // instances beyond the page run unmonitored
+    int taken = 2;
+    uint32_t id = 0;
+    while (writer->acquireSlot(id) >= 0) taken++;
+    ASSERT_TRUE(taken == STATS_MAX_INSTANCES);
+    ASSERT_TRUE(reader->global().droppedInstances.load() == 1);
+
+    // a fresh writer (audioserver restart) starts from an empty page
+    writer.reset(StatsPage::create(path.c_str()));
+    ASSERT_TRUE(!reader->read(slot2, seen));
+    ASSERT_TRUE(reader->global().liveInstances.load() == 0);
+    unlink(path.c_str());
+}
+
+// Test 3: Readers never see a torn record while the writer publishes
+// continuously. Every field of record n is derived from n.
+void test_no_torn_reads() {
+    printf("\n[TEST 3] Concurrent publish and read\n");
+    const std::string path = tempPath();
+    std::unique_ptr<StatsPage> writer(StatsPage::create(path.c_str()));
+    std::unique_ptr<StatsPage> reader(StatsPage::openReadOnly(path.c_str()));
+    uint32_t id = 0;
+    const int slot = writer->acquireSlot(id);
+
+    std::atomic<bool> done(false);
+    std::thread audio([&] {
+        InstanceStats stats = {};
+        stats.id = id;
+        for (uint64_t n = 1; !done.load(std::memory_order_relaxed); n++) {
+            stats.callbacks = n;
+            stats.frames = n * 480;
+            stats.busyNs = n * 7;
+            stats.dutyCycle = static_cast<float>(n & 0xffff);
+            for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+                stats.histogram[b] = static_cast<uint32_t>(n + b);
+            }
+            writer->publish(slot, stats);
+        }
+    });
+
+    int reads = 0;
+    int torn = 0;
+    uint64_t last = 0;
+    bool monotonic = true;
+    while (reads < 200000) {
+        InstanceStats s;
+        // callbacks == 0 is the record acquireSlot() published
+        if (!reader->read(slot, s) || s.callbacks == 0) continue;
+        reads++;
+        bool ok = s.id == id && s.frames == s.callbacks * 480 && s.busyNs == s.callbacks * 7 &&
+                  s.dutyCycle == static_cast<float>(s.callbacks & 0xffff);
+        for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+            ok = ok && s.histogram[b] == static_cast<uint32_t>(s.callbacks + b);
+        }
+        if (!ok) torn++;
+        monotonic = monotonic && s.callbacks >= last;
+        last = s.callbacks;
+    }
+    done = true;
+    audio.join();
+
+    printf("  %d reads, %d torn, writer reached record %llu\n", reads, torn,
+           static_cast<unsigned long long>(last));
+    ASSERT_TRUE(torn == 0);
+    ASSERT_TRUE(monotonic);
+    ASSERT_TRUE(last > 0);
+    unlink(path.c_str());
+}
+
+// Test 4: Without a usable path the page lives in a memfd
+void test_memfd_fallback() {
+    printf("\n[TEST 4] memfd fallback\n");
+    std::unique_ptr<StatsPage> writer(StatsPage::create("/nonexistent/dir/stats"));
+    ASSERT_TRUE(writer != nullptr);
+    ASSERT_TRUE(!writer->isFileBacked());
+
+    uint32_t id = 0;
+    const int slot = writer->acquireSlot(id);
+    InstanceStats stats = {};
+    stats.id = id;
+    stats.underruns = 5;
+    writer->publish(slot, stats);
+
+    const std::string procPath = "/proc/self/fd/" + std::to_string(writer->fd());
+    std::unique_ptr<StatsPage> reader(StatsPage::openReadOnly(procPath.c_str()));
+    ASSERT_TRUE(reader != nullptr);
+    InstanceStats seen;
+    ASSERT_TRUE(reader && reader->read(slot, seen) && seen.underruns == 5);
+
+    ASSERT_TRUE(StatsPage::openReadOnly("/nonexistent/dir/stats") == nullptr);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Stats Page Tests\n");
+    printf("========================================\n");
+
+    test_histogram_buckets();
+    test_slots();
+    test_no_torn_reads();
+    test_memfd_fallback();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
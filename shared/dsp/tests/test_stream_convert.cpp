@@ -0,0 +1,294 @@
+#include "spsc_queue.h"
+#include "stream_convert.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+static const int RATE = 48000;
+
+// Stereo 1 kHz tone starting after 'lead' frames of silence
+static std::vector<int16_t> tone(int frames, int lead) {
+    std::vector<int16_t> pcm(static_cast<size_t>(frames) * 2, 0);
+    for (int i = lead; i < frames; i++) {
+        pcm[2 * i] = pcm[2 * i + 1] =
+            static_cast<int16_t>(std::lround(10000.0 * std::sin(2.0 * M_PI * 1000.0 * i / RATE)));
+    }
+    return pcm;
+}
+
+static std::vector<uint8_t> wav(const std::vector<int16_t>& pcm, uint32_t dataSize) {
+    std::vector<uint8_t> file(44);
+    auto put32 = [&](size_t at, uint32_t v) { memcpy(&file[at], &v, 4); };
+    auto put16 = [&](size_t at, uint16_t v) { memcpy(&file[at], &v, 2); };
+    memcpy(&file[0], "RIFF", 4);
+    put32(4, dataSize == 0xFFFFFFFFu ? dataSize : dataSize + 36);
+    memcpy(&file[8], "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 1);
+    put16(22, 2);
+    put32(24, RATE);
+    put32(28, RATE * 4);
+    put16(32, 4);
+    put16(34, 16);
+    memcpy(&file[36], "data", 4);
+    put32(40, dataSize);
+    const size_t header = file.size();
+    file.resize(header + pcm.size() * sizeof(int16_t));
+    if (!pcm.empty()) memcpy(&file[header], pcm.data(), pcm.size() * sizeof(int16_t));
+    return file;
+}
+
+static std::vector<uint8_t> readAll(int fd) {
+    std::vector<uint8_t> data;
+    uint8_t buffer[65536];
+    lseek(fd, 0, SEEK_SET);
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) data.insert(data.end(), buffer, buffer + n);
+    return data;
+}
+
+static int tempFile(const std::vector<uint8_t>& contents) {
+    FILE* f = tmpfile();
+    const int fd = dup(fileno(f));
+    fclose(f);
+    if (!contents.empty() && write(fd, contents.data(), contents.size()) < 0) return -1;
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+// Runs a conversion through pipes in both directions, with writes and
+// reads in odd-sized pieces
+static int convertThroughPipes(const std::vector<uint8_t>& input, const StreamOptions& options,
+                               std::vector<uint8_t>& output, StreamStats& stats) {
+    int in[2], out[2];
+    if (pipe(in) || pipe(out)) return -errno;
+    std::thread feeder([&] {
+        for (size_t done = 0; done < input.size();) {
+            const ssize_t n = write(in[1], input.data() + done, std::min<size_t>(777, input.size() - done));
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        close(in[1]);
+    });
+    std::thread drainer([&] {
+        uint8_t buffer[1001];
+        ssize_t n;
+        while ((n = read(out[0], buffer, sizeof(buffer))) > 0) output.insert(output.end(), buffer, buffer + n);
+    });
+    const int err = streamConvert(in[0], out[1], options, &stats);
+    close(out[1]);
+    feeder.join();
+    drainer.join();
+    close(in[0]);
+    close(out[0]);
+    return err;
+}
+
+static const int16_t* samples(const std::vector<uint8_t>& file, size_t header) {
+    return reinterpret_cast<const int16_t*>(file.data() + header);
+}
+
+// First frame of channel 0 above a third of the tone's amplitude
+static int onset(const int16_t* pcm, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        if (std::abs(pcm[2 * i]) > 3000) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+static double measureHz(const int16_t* pcm, size_t from, size_t to) {
+    long first = -1, last = -1, crossings = 0;
+    for (size_t i = from + 1; i < to; i++) {
+        if (pcm[2 * (i - 1)] < 0 && pcm[2 * i] >= 0) {
+            if (first < 0) first = static_cast<long>(i);
+            last = static_cast<long>(i);
+            crossings++;
+        }
+    }
+    return crossings > 1 ? (crossings - 1) * static_cast<double>(RATE) / (last - first) : 0.0;
+}
+
+// Test 1: The queue hands every item over once, in order, across threads
+void test_spsc_queue() {
+    printf("\n[TEST 1] Single-producer single-consumer queue\n");
+    SpscQueue<int> q(5);
+    ASSERT_TRUE(q.capacity() == 8);
+    int v = 0;
+    ASSERT_TRUE(!q.pop(v));
+    for (int i = 0; i < 8; i++) ASSERT_TRUE(q.push(i));
+    ASSERT_TRUE(!q.push(8));
+    ASSERT_TRUE(q.pop(v) && v == 0);
+    ASSERT_TRUE(q.push(8));
+
+    const int count = 200000;
+    SpscQueue<int> shared(64);
+    long long sum = 0;
+    bool ordered = true;
+    std::thread consumer([&] {
+        for (int expected = 0; expected < count;) {
+            int x;
+            if (!shared.pop(x)) {
+                std::this_thread::yield();
+                continue;
+            }
+            ordered = ordered && x == expected;
+            sum += x;
+            expected++;
+        }
+    });
+    for (int i = 0; i < count;) {
+        if (shared.push(i)) i++;
+        else std::this_thread::yield();
+    }
+    consumer.join();
+    ASSERT_TRUE(ordered);
+    ASSERT_TRUE(sum == static_cast<long long>(count) * (count - 1) / 2);
+}
+
+// Test 2: WAV file to file: aligned, same length, sizes in the header
+void test_wav_file() {
+    printf("\n[TEST 2] WAV file to file\n");
+    const int frames = 5 * RATE;
+    const std::vector<int16_t> pcm = tone(frames, RATE / 2);
+    const int inFd = tempFile(wav(pcm, 0xFFFFFFFFu));  // streamed WAV: size unknown
+    const int outFd = tempFile({});
+    StreamStats stats;
+    ASSERT_TRUE(streamConvert(inFd, outFd, StreamOptions(), &stats) == 0);
+    const std::vector<uint8_t> out = readAll(outFd);
+    close(inFd);
+    close(outFd);
+
+    printf("  %.0fx real time, engine busy %.0f%% of the wall time\n",
+           frames / static_cast<double>(RATE) / stats.wallSeconds,
+           100.0 * stats.convertSeconds / stats.wallSeconds);
+    ASSERT_TRUE(stats.sampleRate == RATE && stats.channels == 2);
+    ASSERT_TRUE(stats.framesIn == static_cast<uint64_t>(frames) && stats.framesOut == stats.framesIn);
+    ASSERT_TRUE(out.size() == 44 + pcm.size() * sizeof(int16_t));
+    ASSERT_TRUE(memcmp(out.data(), "RIFF", 4) == 0 && memcmp(out.data() + 36, "data", 4) == 0);
+    uint32_t dataSize = 0;
+    memcpy(&dataSize, out.data() + 40, 4);
+    ASSERT_TRUE(dataSize == pcm.size() * sizeof(int16_t));
+
+    const int16_t* s = samples(out, 44);
+    const int start = onset(s, frames);
+    printf("  onset at frame %d (input %d)\n", start, RATE / 2);
+    ASSERT_TRUE(std::abs(start - RATE / 2) < 100);
+    ASSERT_TRUE(std::fabs(measureHz(s, RATE, frames - RATE / 10) - 1000.0 * 432.0 / 440.0) < 1.0);
+    // no holes: the tone is never silent once it started
+    int zeroRun = 0, worst = 0;
+    for (int i = start; i < frames; i++) {
+        zeroRun = s[2 * i] == 0 ? zeroRun + 1 : 0;
+        worst = std::max(worst, zeroRun);
+    }
+    ASSERT_TRUE(worst < 4);
+}
+
+// Test 3: Pipes, raw PCM and buffer sizes do not change the output
+void test_pipes_and_blocks() {
+    printf("\n[TEST 3] Pipes, raw input, block sizes\n");
+    const int frames = 3 * RATE + 123;
+    const std::vector<int16_t> pcm = tone(frames, 1000);
+    const std::vector<uint8_t> wavIn = wav(pcm, static_cast<uint32_t>(pcm.size() * 2));
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pcm.data());
+    const std::vector<uint8_t> rawIn(bytes, bytes + pcm.size() * 2);
+
+    StreamOptions options;
+    StreamStats stats;
+    std::vector<uint8_t> reference, small, raw;
+    ASSERT_TRUE(convertThroughPipes(wavIn, options, reference, stats) == 0);
+    ASSERT_TRUE(reference.size() == wavIn.size());
+
+    options.blockFrames = 1000;
+    options.queueDepth = 1;
+    ASSERT_TRUE(convertThroughPipes(wavIn, options, small, stats) == 0);
+    ASSERT_TRUE(small == reference);
+
+    options = StreamOptions();
+    options.inputFormat = StreamFormat::kRaw;
+    ASSERT_TRUE(convertThroughPipes(rawIn, options, raw, stats) == 0);
+    ASSERT_TRUE(raw.size() == rawIn.size());
+    ASSERT_TRUE(memcmp(raw.data(), reference.data() + 44, raw.size()) == 0);
+
+    // raw in, WAV out on a pipe: sizes unknown up front
+    std::vector<uint8_t> wavOut;
+    options.outputFormat = StreamFormat::kWav;
+    ASSERT_TRUE(convertThroughPipes(rawIn, options, wavOut, stats) == 0);
+    uint32_t dataSize = 0;
+    memcpy(&dataSize, wavOut.data() + 40, 4);
+    ASSERT_TRUE(dataSize == 0xFFFFFFFFu && wavOut.size() == reference.size());
+}
+
+// Test 4: Malformed and unsupported input is refused
+void test_bad_input() {
+    printf("\n[TEST 4] Unsupported input\n");
+    std::vector<uint8_t> file = wav(tone(100, 0), 400);
+    StreamStats stats;
+    std::vector<uint8_t> out;
+
+    std::vector<uint8_t> eightBit = file;
+    eightBit[34] = 8;
+    ASSERT_TRUE(convertThroughPipes(eightBit, StreamOptions(), out, stats) == -EINVAL);
+
+    std::vector<uint8_t> truncated(file.begin(), file.begin() + 30);
+    ASSERT_TRUE(convertThroughPipes(truncated, StreamOptions(), out, stats) == -EINVAL);
+
+    StreamOptions options;
+    options.inputFormat = StreamFormat::kWav;
+    const std::vector<uint8_t> notWav(100, 1);
+    ASSERT_TRUE(convertThroughPipes(notWav, options, out, stats) == -EINVAL);
+
+    options = StreamOptions();
+    options.channels = 9;
+    ASSERT_TRUE(convertThroughPipes(notWav, options, out, stats) == -EINVAL);
+
+    // a chunk before "fmt " is skipped
+    const char list[] = "LIST\x04\x00\x00\x00INFO";
+    std::vector<uint8_t> listed(file.size() + 12);
+    memcpy(&listed[0], file.data(), 12);
+    memcpy(&listed[12], list, 12);
+    memcpy(&listed[24], file.data() + 12, file.size() - 12);
+    out.clear();
+    ASSERT_TRUE(convertThroughPipes(listed, StreamOptions(), out, stats) == 0);
+    ASSERT_TRUE(stats.framesOut == 100 && out.size() == file.size());
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Stream Conversion Tests\n");
+    printf("========================================\n");
+
+    test_spsc_queue();
+    test_wav_file();
+    test_pipes_and_blocks();
+    test_bad_input();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
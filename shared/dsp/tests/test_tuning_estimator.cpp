@@ -0,0 +1,142 @@
+#include "tuning_estimator.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+// Simple test framework
+static int g_testsRun = 0;
+static int g_testsFailed = 0;
+
+#define ASSERT_TRUE(cond) \
+    do { \
+        g_testsRun++; \
+        if (!(cond)) { \
+            fprintf(stderr, "✗ FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            g_testsFailed++; \
+        } else { \
+            printf("✓ %s\n", #cond); \
+        } \
+    } while(0)
+
+#define ASSERT_NEAR(a, b, eps) \
+    do { \
+        float diff = std::fabs((a) - (b)); \
+        ASSERT_TRUE(diff < (eps)); \
+    } while(0)
+
+// Feeds 'seconds' of an equal-tempered chord progression tuned to 'referenceHz'
+// (three harmonics per note, chord changes every 2 s) in 20 ms stereo buffers
+static void feedMusic(TuningEstimator& estimator, float referenceHz, float seconds,
+                      int sampleRate = 48000) {
+    static const int chords[4][3] = {{0, 4, 7}, {-4, 0, 3}, {-7, -3, 0}, {-2, 2, 5}};
+    const int frames = sampleRate / 50;
+    const int blocks = static_cast<int>(seconds * 50);
+    std::vector<int16_t> buffer(frames * 2);
+
+    for (int block = 0; block < blocks; block++) {
+        const int* chord = chords[(block / 100) % 4];
+        for (int i = 0; i < frames; i++) {
+            const double t = static_cast<double>(block * frames + i) / sampleRate;
+            double v = 0.0;
+            for (int n = 0; n < 3; n++) {
+                const double f0 = referenceHz * std::pow(2.0, chord[n] / 12.0);
+                for (int h = 1; h <= 3; h++) {
+                    v += std::sin(2.0 * M_PI * f0 * h * t + n) / h;
+                }
+            }
+            buffer[2 * i] = static_cast<int16_t>(3000.0 * v);
+            buffer[2 * i + 1] = static_cast<int16_t>(2500.0 * v);
+        }
+        estimator.analyze(buffer.data(), frames, 2);
+    }
+}
+
+// Test 1: Content mastered at 432 Hz is recognised
+void test_detects_432() {
+    printf("\n[TEST 1] Detects A4 = 432 Hz\n");
+    TuningEstimator estimator(48000);
+    feedMusic(estimator, 432.0f, 15.0f);
+    ASSERT_TRUE(estimator.hasEstimate());
+    ASSERT_NEAR(estimator.referenceHz(), 432.0f, 0.5f);
+    ASSERT_TRUE(estimator.confidence() > 0.5f);
+    ASSERT_TRUE(estimator.matchesReference(432.0f, false));
+}
+
+// Test 2: Standard 440 Hz content is not mistaken for 432 Hz
+void test_detects_440() {
+    printf("\n[TEST 2] Detects A4 = 440 Hz\n");
+    TuningEstimator estimator(48000);
+    feedMusic(estimator, 440.0f, 15.0f);
+    ASSERT_NEAR(estimator.referenceHz(), 440.0f, 0.5f);
+    ASSERT_TRUE(!estimator.matchesReference(432.0f, false));
+    ASSERT_TRUE(!estimator.matchesReference(432.0f, true));
+}
+
+// Test 3: No decision before enough material, none on silence
+void test_needs_evidence() {
+    printf("\n[TEST 3] Needs tens of seconds of material\n");
+    TuningEstimator estimator(48000);
+    feedMusic(estimator, 432.0f, 5.0f);
+    ASSERT_TRUE(!estimator.hasEstimate());
+    ASSERT_TRUE(estimator.referenceHz() == 0.0f);
+    ASSERT_TRUE(!estimator.matchesReference(432.0f, false));
+
+    TuningEstimator quiet(48000);
+    std::vector<int16_t> silence(960 * 2, 0);
+    for (int block = 0; block < 1000; block++) {
+        quiet.analyze(silence.data(), 960, 2);
+    }
+    ASSERT_TRUE(quiet.analyzedSeconds() > 19.0f);
+    ASSERT_TRUE(!quiet.hasEstimate());
+}
+
+// Test 4: Hysteresis between entering and leaving the matched state
+void test_hysteresis() {
+    printf("\n[TEST 4] Hysteresis\n");
+    // 434 Hz is ~8 cents above 432: too far to enter, close enough to stay
+    TuningEstimator near(48000);
+    feedMusic(near, 434.0f, 15.0f);
+    ASSERT_TRUE(!near.matchesReference(432.0f, false));
+    ASSERT_TRUE(near.matchesReference(432.0f, true));
+
+    // 437 Hz is ~20 cents above 432: leaves the matched state
+    TuningEstimator far(48000);
+    feedMusic(far, 437.0f, 15.0f);
+    ASSERT_TRUE(!far.matchesReference(432.0f, true));
+}
+
+// Test 5: Other sample rates and reset()
+void test_sample_rates() {
+    printf("\n[TEST 5] 44.1 kHz input and reset\n");
+    TuningEstimator estimator(44100);
+    feedMusic(estimator, 432.0f, 15.0f, 44100);
+    ASSERT_NEAR(estimator.referenceHz(), 432.0f, 0.5f);
+
+    estimator.reset();
+    ASSERT_TRUE(!estimator.hasEstimate());
+    ASSERT_TRUE(estimator.analyzedSeconds() == 0.0f);
+
+    estimator.setSampleRate(96000);
+    feedMusic(estimator, 440.0f, 15.0f, 96000);
+    ASSERT_NEAR(estimator.referenceHz(), 440.0f, 0.5f);
+}
+
+int main() {
+    printf("========================================\n");
+    printf("AudioShift Tuning Estimator Tests\n");
+    printf("========================================\n");
+
+    test_detects_432();
+    test_detects_440();
+    test_needs_evidence();
+    test_hysteresis();
+    test_sample_rates();
+
+    printf("\n========================================\n");
+    printf("Test Results: %d/%d passed\n", g_testsRun - g_testsFailed, g_testsRun);
+    printf("========================================\n");
+
+    return g_testsFailed > 0 ? 1 : 0;
+}
@@ -71,8 +71,17 @@ private:
     /// Current position pointer to the buffer. This pointer is increased when samples are
     /// removed from the pipe so that it's necessary to actually rewind buffer (move data)
     /// only new data when is put to the pipe.
+    ///
+    /// In mirrored mode this is the read index of the ring, always below the capacity.
     uint bufferPos;
 
+    /// Highest capacity requirement, in samples, since the last shrinkToFit.
+    uint peakSamples;
+
+    /// Nonzero if 'buffer' is a double-mapped ring, i.e. the 'sizeInBytes' bytes
+    /// following the buffer alias the same physical pages as the buffer itself.
+    bool mirrored;
+
     /// Rewind the buffer by moving data from position pointed by 'bufferPos' to real
     /// beginning of the buffer.
     void rewind();
@@ -80,6 +89,13 @@ private:
     /// Ensures that the buffer has capacity for at least this many samples.
     void ensureCapacity(uint capacityRequirement);
 
+    /// Replaces the storage with a new one holding at least 'capacityRequirement'
+    /// samples of 'numChannels' channels and moves the current contents over.
+    void reallocate(uint capacityRequirement, uint numChannels);
+
+    /// Releases the current storage, whichever way it was allocated.
+    void releaseBuffer();
+
     /// Returns current capacity.
     uint getCapacity() const;
 
@@ -173,6 +189,20 @@ public:
 
     /// Add silence to end of buffer
     void addSilent(uint nSamples);
+
+    /// Adds the storage of this buffer to 'usage'.
+    void addMemoryUsage(MemoryUsage &usage) const override;
+
+    /// Reallocates to the smallest capacity that holds the peak requirement
+    /// seen since the last call, if that saves memory, and restarts the peak.
+    void shrinkToFit() override;
+
+    /// Returns true if the buffer runs as a double-mapped ring that never
+    /// moves its contents, false if it uses the compacting heap buffer.
+    bool isMirrored() const
+    {
+        return mirrored;
+    }
 };
 
 }
@@ -48,6 +48,20 @@
 namespace soundtouch
 {
 
+/// Memory held by processing stages and their buffers, see
+/// FIFOSamplePipe::addMemoryUsage.
+struct MemoryUsage
+{
+    /// Bytes allocated, including spare buffer capacity
+    ulong allocated;
+
+    /// Bytes holding data: buffered samples, filter tables and state
+    ulong used;
+
+    /// Bytes the sample buffers needed at most since they were last shrunk
+    ulong peakUsed;
+};
+
 /// Abstract base class for FIFO (first-in-first-out) sample processing classes.
 class FIFOSamplePipe
 {
@@ -124,6 +138,20 @@ public:
     /// Returns adjusted amount of samples
     virtual uint adjustAmountOfSamples(uint numSamples) = 0;
 
+    /// Adds the memory held by this pipe, and by the stages and buffers it
+    /// owns, to 'usage'.
+    virtual void addMemoryUsage(MemoryUsage &usage) const
+    {
+        (void)usage;
+    }
+
+    /// Gives back buffer capacity beyond what the buffers needed since the
+    /// last call, e.g. after a burst of large blocks. Allocates; call between
+    /// buffers, never concurrently with processing.
+    virtual void shrinkToFit()
+    {
+    }
+
 };
 
 
@@ -121,6 +121,21 @@ namespace soundtouch
 
     #endif
 
+    #if (defined(__linux__) || defined(__ANDROID__))
+        /// Define this to back FIFOSampleBuffer with a double-mapped ring buffer
+        /// (memfd + two adjacent mmaps of the same pages). The data window then
+        /// stays contiguous across the wrap point, so the buffer never needs to
+        /// move samples to its beginning. If the mapping can't be created at
+        /// runtime the buffer falls back to the plain heap allocation.
+        #define SOUNDTOUCH_ALLOW_MIRRORED_FIFO     1
+
+        /// Allow disabling the mirrored buffer at compile time, e.g. for
+        /// sandboxes that forbid memfd_create
+        #ifdef SOUNDTOUCH_DISABLE_MIRRORED_FIFO
+            #undef SOUNDTOUCH_ALLOW_MIRRORED_FIFO
+        #endif
+    #endif
+
     // If defined, allows the SIMD-optimized routines to skip unevenly aligned
     // memory offsets that can cause performance penalty in some SIMD implementations.
     // Causes slight compromise in sound quality.
@@ -156,6 +171,16 @@ namespace soundtouch
         #ifdef SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS
             // Allow SSE optimizations
             #define SOUNDTOUCH_ALLOW_SSE       1
+
+            #if (defined(__GNUC__) || defined(_MSC_VER))
+                // Allow AVX2/FMA optimizations. These are compiled with per-function
+                // target attributes and chosen at runtime, so the rest of the library
+                // still runs on CPUs without AVX2.
+                #define SOUNDTOUCH_ALLOW_AVX2  1
+            #endif
+            #ifdef SOUNDTOUCH_DISABLE_AVX2
+                #undef SOUNDTOUCH_ALLOW_AVX2
+            #endif
         #endif
 
     #endif  // SOUNDTOUCH_INTEGER_SAMPLES
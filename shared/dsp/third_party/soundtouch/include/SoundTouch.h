@@ -165,6 +165,50 @@ namespace soundtouch
 #define SETTING_INITIAL_LATENCY             8
 
 
+/// Interpolation algorithm of the sample rate transposer: 0 = linear,
+/// 1 = cubic (default), 2 = Shannon (8-tap Kaiser-windowed sinc). SIMD
+/// versions are used where the CPU and the 'allowedExtensions' mask permit.
+///
+/// Notices:
+/// - Changing the algorithm discards the transposer's buffered samples
+/// - Shannon supports mono and stereo only; setSetting returns false for it
+///   with more channels
+#define SETTING_INTERPOLATION               9
+
+
+/// Enable/disable the minimum-phase anti-alias filter (0 = linear phase,
+/// default). The minimum-phase filter delays the signal by a few samples
+/// instead of half its length, which also shows in SETTING_INITIAL_LATENCY.
+/// Changing this discards the rate transposer's buffered samples.
+#define SETTING_AA_FILTER_MINIMUM_PHASE     10
+
+
+/// Enable/disable the approximate overlap search in the tempo changer
+/// (0 = exact search, default). It scores candidate offsets on every second
+/// frame with single-precision sums and an approximate normalizer, roughly
+/// halving the cost of the hottest loop; it occasionally splices a few samples
+/// away from the exact choice, at a nearly equal match. Takes precedence over
+/// SETTING_USE_QUICKSEEK.
+#define SETTING_FAST_SEEK                   11
+
+
+/// Enable/disable spreading the tempo changer's overlap search over the input
+/// as it arrives (0 = search when a sequence is complete, default). Each
+/// putSamples() call then does a share of the search in proportion to the
+/// input it brings, so the per-call cost stays even when the calls are much
+/// shorter than a sequence. The output is the same either way.
+#define SETTING_SPREAD_SEEK                 12
+
+
+/// Enable/disable adapting the tempo changer's sequence length to the content
+/// (0 = fixed lengths, default). On stationary passages an onset detector
+/// trades seek window for sequence length: fewer and cheaper overlap searches
+/// where any splice point fits. Near transients the set lengths apply. The
+/// input needed per sequence, and so the latency, never exceeds that of the
+/// set lengths.
+#define SETTING_ADAPTIVE_SEQUENCE           13
+
+
 class SoundTouch : public FIFOProcessor
 {
 private:
@@ -208,7 +252,13 @@ protected :
     double tempo;
 
 public:
-    SoundTouch();
+    /// Creates the processing chain with the fastest routines the CPU supports.
+    ///
+    /// 'allowedExtensions' restricts the instruction set extensions that may be
+    /// used (bitmask of the SUPPORT_... values in cpu_detect.h). Pass 0 to use
+    /// only the plain C routines: their output is then bit-identical on every
+    /// machine running the same build, at the cost of speed.
+    explicit SoundTouch(uint allowedExtensions = 0xffffffff);
     virtual ~SoundTouch() override;
 
     /// Get SoundTouch library version string
@@ -310,6 +360,19 @@ public:
     /// buffers.
     virtual void clear() override;
 
+    /// Adds the memory held by the rate transposer and the time-stretcher.
+    void addMemoryUsage(MemoryUsage &usage) const override;
+
+    /// Releases buffer capacity that the peak since the previous call did
+    /// not need. Buffered samples are kept.
+    void shrinkToFit() override;
+
+    /// Makes this instance splice its time-stretch sequences at the same positions
+    /// as 'leader', nullptr to unlink. Intended for running the channels of one
+    /// stream through separate mono instances with identical settings; feed the
+    /// leader first with the same number of samples. See TDStretch::setSeekLeader.
+    void setSeekLeader(const SoundTouch *leader);
+
     /// Changes a setting controlling the processing system behaviour. See the
     /// 'SETTING_...' defines for available setting ID's.
     ///
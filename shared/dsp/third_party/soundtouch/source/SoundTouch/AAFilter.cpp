@@ -37,6 +37,9 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <complex>
+#include <vector>
 #include "AAFilter.h"
 #include "FIRFilter.h"
 
@@ -74,10 +77,12 @@ using namespace soundtouch;
  *
  *****************************************************************************/
 
-AAFilter::AAFilter(uint len)
+AAFilter::AAFilter(uint len, uint allowedExtensions)
 {
-    pFIR = FIRFilter::newInstance();
+    pFIR = FIRFilter::newInstance(allowedExtensions);
     cutoffFreq = 0.5;
+    minimumPhase = false;
+    groupDelay = 0;
     setLength(len);
 }
 
@@ -106,6 +111,33 @@ void AAFilter::setLength(uint newLength)
 }
 
 
+// Selects minimum-phase or linear-phase response
+void AAFilter::setMinimumPhase(bool enable)
+{
+    minimumPhase = enable;
+    calculateCoeffs();
+}
+
+
+bool AAFilter::isMinimumPhase() const
+{
+    return minimumPhase;
+}
+
+
+uint AAFilter::getGroupDelay() const
+{
+    return (uint)(groupDelay + 0.5);
+}
+
+
+// The design buffers are temporary; only the FIR instance stays allocated
+uint AAFilter::getMemoryUsage() const
+{
+    return (uint)sizeof(*this) + pFIR->getMemoryUsage();
+}
+
+
 // Calculates coefficients for a low-pass FIR filter using Hamming window
 void AAFilter::calculateCoeffs()
 {
@@ -121,6 +153,14 @@ void AAFilter::calculateCoeffs()
     assert(cutoffFreq >= 0);
     assert(cutoffFreq <= 0.5);
 
+    if (minimumPhase)
+    {
+        calculateMinimumPhaseCoeffs();
+        return;
+    }
+    // the sinc is centred on coefficient length / 2, counted from the oldest sample
+    groupDelay = length - 1 - length / 2;
+
     work = new double[length];
     coeffs = new SAMPLETYPE[length];
 
@@ -182,6 +222,137 @@ void AAFilter::calculateCoeffs()
 }
 
 
+// In-place radix-2 FFT; 'inverse' computes the unscaled inverse transform
+static void fft(std::vector<std::complex<double> > &x, bool inverse)
+{
+    const size_t n = x.size();
+    for (size_t i = 1, j = 0; i < n; i ++)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(x[i], x[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1)
+    {
+        const double angle = (inverse ? TWOPI : -TWOPI) / (double)len;
+        const std::complex<double> step(cos(angle), sin(angle));
+        for (size_t i = 0; i < n; i += len)
+        {
+            std::complex<double> w(1.0, 0.0);
+            for (size_t k = 0; k < len / 2; k ++)
+            {
+                const std::complex<double> u = x[i + k];
+                const std::complex<double> v = x[i + k + len / 2] * w;
+                x[i + k] = u + v;
+                x[i + k + len / 2] = u - v;
+                w *= step;
+            }
+        }
+    }
+}
+
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k ++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+
+// Calculates coefficients for a minimum-phase low-pass FIR filter.
+//
+// A linear-phase Kaiser prototype of 2 * length - 1 taps is turned into a
+// minimum-phase filter of 'length' taps with the square root of its magnitude
+// response (homomorphic method: fold the real cepstrum of the log magnitude
+// onto positive quefrencies). The prototype is designed for twice the stop
+// band attenuation that the square root leaves.
+void AAFilter::calculateMinimumPhaseCoeffs()
+{
+    const double STOPBAND_DB = 2 * 50.0;
+    const uint protoLength = 2 * length - 1;
+    const double center = (double)(length - 1);
+    const double beta = 0.1102 * (STOPBAND_DB - 8.7);
+    const double wc = TWOPI * cutoffFreq;
+
+    // FFT size keeps the cepstral aliasing negligible
+    size_t nfft = 1;
+    while (nfft < 16 * (size_t)(protoLength - 1)) nfft <<= 1;
+
+    std::vector<std::complex<double> > spectrum(nfft, 0.0);
+    for (uint i = 0; i < protoLength; i ++)
+    {
+        const double t = (double)i - center;
+        const double h = (t == 0) ? wc / PI : sin(wc * t) / (PI * t);
+        const double r = t / center;
+        spectrum[i] = h * besselI0(beta * sqrt(1.0 - r * r)) / besselI0(beta);
+    }
+    fft(spectrum, false);
+
+    // half the log magnitude = log of the square root of the magnitude
+    double noiseFloor = 0;
+    for (size_t k = 0; k < nfft; k ++)
+    {
+        noiseFloor = std::max(noiseFloor, std::abs(spectrum[k]));
+    }
+    noiseFloor *= 1e-7;
+    for (size_t k = 0; k < nfft; k ++)
+    {
+        spectrum[k] = 0.5 * log(std::abs(spectrum[k]) + noiseFloor);
+    }
+
+    // real cepstrum, folded onto positive quefrencies
+    fft(spectrum, true);
+    for (size_t k = 0; k < nfft; k ++)
+    {
+        const double weight = (k == 0 || k == nfft / 2) ? 1.0 : (k < nfft / 2) ? 2.0 : 0.0;
+        spectrum[k] = weight * spectrum[k].real() / (double)nfft;
+    }
+    fft(spectrum, false);
+    for (size_t k = 0; k < nfft; k ++)
+    {
+        spectrum[k] = std::exp(spectrum[k]);
+    }
+    fft(spectrum, true);
+
+    std::vector<double> h(length);
+    double sum = 0;
+    double moment = 0;
+    for (uint i = 0; i < length; i ++)
+    {
+        h[i] = spectrum[i].real() / (double)nfft;
+        sum += h[i];
+        moment += i * h[i];
+    }
+    assert(sum > 0);
+    groupDelay = moment / sum;
+
+    // Scale for the divide factor 14 like the linear-phase design. FIRFilter
+    // correlates, i.e. coefficient 0 meets the oldest sample, so the impulse
+    // response is stored time-reversed.
+    std::vector<SAMPLETYPE> coeffs(length);
+    const double scaleCoeff = 16384.0 / sum;
+    for (uint i = 0; i < length; i ++)
+    {
+        double temp = h[i] * scaleCoeff;
+        temp += (temp >= 0) ? 0.5 : -0.5;
+        assert(temp >= -32768 && temp <= 32767);
+        coeffs[length - 1 - i] = (SAMPLETYPE)temp;
+    }
+    pFIR->setCoefficients(coeffs.data(), length, 14);
+
+    _DEBUG_SAVE_AAFIR_COEFFS(coeffs.data(), length);
+}
+
+
 // Applies the filter to the given sequence of samples.
 // Note : The amount of outputted samples is by value of 'filter length'
 // smaller than the amount of input samples.
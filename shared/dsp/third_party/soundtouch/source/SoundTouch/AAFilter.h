@@ -54,10 +54,20 @@ protected:
     /// num of filter taps
     uint length;
 
+    /// Minimum-phase instead of linear-phase response
+    bool minimumPhase;
+
+    /// Group delay at low frequencies, in samples behind the newest input sample
+    double groupDelay;
+
     /// Calculate the FIR coefficients realizing the given cutoff-frequency
     void calculateCoeffs();
+
+    /// Calculate minimum-phase FIR coefficients for the given cutoff-frequency
+    void calculateMinimumPhaseCoeffs();
 public:
-    AAFilter(uint length);
+    /// 'allowedExtensions' limits the SIMD routines used, see FIRFilter::newInstance
+    AAFilter(uint length, uint allowedExtensions = 0xffffffff);
 
     ~AAFilter();
 
@@ -71,6 +81,20 @@ public:
 
     uint getLength() const;
 
+    /// Selects a minimum-phase response. The linear-phase filter delays the
+    /// signal by half its length; the minimum-phase one by only a few samples,
+    /// at the cost of phase linearity near the cut-off.
+    void setMinimumPhase(bool enable);
+
+    bool isMinimumPhase() const;
+
+    /// Returns the filter's group delay at low frequencies in samples,
+    /// rounded to the nearest sample.
+    uint getGroupDelay() const;
+
+    /// Returns the bytes held by this filter and its FIR instance.
+    uint getMemoryUsage() const;
+
     /// Applies the filter to the given sequence of samples.
     /// Note : The amount of outputted samples is by value of 'filter length'
     /// smaller than the amount of input samples.
@@ -43,8 +43,84 @@
 
 #include "FIFOSampleBuffer.h"
 
+#ifdef SOUNDTOUCH_ALLOW_MIRRORED_FIFO
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+
+    #ifndef MFD_CLOEXEC
+        #define MFD_CLOEXEC     0x0001U
+    #endif
+#endif
+
 using namespace soundtouch;
 
+
+#ifdef SOUNDTOUCH_ALLOW_MIRRORED_FIFO
+
+// Greatest common divisor, used for rounding the ring size
+static uint gcd(uint a, uint b)
+{
+    while (b)
+    {
+        uint t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+
+// Creates a ring of at least 'bytes' bytes that is mapped twice back-to-back
+// into the address space, so that reading or writing past the end of the first
+// copy lands at the beginning of the same memory. The size is rounded up so
+// that it is both a multiple of the page size and of 'frameBytes', which keeps
+// every sample frame at the same offset in either copy. Returns nullptr if
+// the platform refuses any of the steps; the caller then uses a heap buffer.
+static SAMPLETYPE *allocMirrored(uint &bytes, uint frameBytes)
+{
+#ifdef SYS_memfd_create
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) return nullptr;
+
+    const uint granule = (uint)page / gcd((uint)page, frameBytes) * frameBytes;
+    const ulong size = ((ulong)bytes + granule - 1) / granule * granule;
+    if (size * 2 > (ulong)(uint)-1) return nullptr;
+
+    int fd = (int)syscall(SYS_memfd_create, "soundtouch-fifo", MFD_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    char *base = nullptr;
+    if (ftruncate(fd, (off_t)size) == 0)
+    {
+        // reserve address space for both copies, then map the file over it
+        void *area = mmap(nullptr, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (area != MAP_FAILED)
+        {
+            base = (char *)area;
+            if ((mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) ||
+                (mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED))
+            {
+                munmap(area, size * 2);
+                base = nullptr;
+            }
+        }
+    }
+    // the mappings keep the memory alive
+    close(fd);
+
+    if (base == nullptr) return nullptr;
+    bytes = (uint)size;
+    return (SAMPLETYPE *)base;
+#else
+    (void)bytes;
+    (void)frameBytes;
+    return nullptr;
+#endif
+}
+
+#endif // SOUNDTOUCH_ALLOW_MIRRORED_FIFO
+
 // Constructor
 FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
 {
@@ -54,6 +130,8 @@ FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
     bufferUnaligned = nullptr;
     samplesInBuffer = 0;
     bufferPos = 0;
+    peakSamples = 0;
+    mirrored = false;
     channels = (uint)numChannels;
     ensureCapacity(32);     // allocate initial capacity
 }
@@ -62,9 +140,23 @@ FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
 // destructor
 FIFOSampleBuffer::~FIFOSampleBuffer()
 {
+    releaseBuffer();
+}
+
+
+// Frees the storage, unmapping both copies of a mirrored ring
+void FIFOSampleBuffer::releaseBuffer()
+{
+#ifdef SOUNDTOUCH_ALLOW_MIRRORED_FIFO
+    if (mirrored)
+    {
+        munmap(buffer, (size_t)sizeInBytes * 2);
+    }
+#endif
     delete[] bufferUnaligned;
     bufferUnaligned = nullptr;
     buffer = nullptr;
+    mirrored = false;
 }
 
 
@@ -76,6 +168,17 @@ void FIFOSampleBuffer::setChannels(int numChannels)
     if (!verifyNumberOfChannels(numChannels)) return;
 
     usedBytes = channels * samplesInBuffer;
+    if (mirrored && ((uint)numChannels != channels))
+    {
+        // the ring size must stay a multiple of the frame size, so move
+        // the contents into a ring laid out for the new channel count
+        reallocate(sizeInBytes / (sizeof(SAMPLETYPE) * (uint)numChannels) + 1, (uint)numChannels);
+    }
+    else
+    {
+        // 'bufferPos' counts frames of the old channel count
+        rewind();
+    }
     channels = (uint)numChannels;
     samplesInBuffer = usedBytes / channels;
 }
@@ -86,6 +189,9 @@ void FIFOSampleBuffer::setChannels(int numChannels)
 // location on to the beginning of the buffer.
 void FIFOSampleBuffer::rewind()
 {
+    // a mirrored ring is always contiguous from 'bufferPos' on
+    if (mirrored) return;
+
     if (buffer && bufferPos)
     {
         memmove(buffer, ptrBegin(), sizeof(SAMPLETYPE) * channels * samplesInBuffer);
@@ -134,7 +240,8 @@ void FIFOSampleBuffer::putSamples(uint nSamples)
 SAMPLETYPE *FIFOSampleBuffer::ptrEnd(uint slackCapacity)
 {
     ensureCapacity(samplesInBuffer + slackCapacity);
-    return buffer + samplesInBuffer * channels;
+    // in a heap buffer 'bufferPos' is zero here after ensureCapacity
+    return buffer + (bufferPos + samplesInBuffer) * channels;
 }
 
 
@@ -158,34 +265,58 @@ SAMPLETYPE *FIFOSampleBuffer::ptrBegin()
 // as well as to round the buffer size up to the virtual memory page size.
 void FIFOSampleBuffer::ensureCapacity(uint capacityRequirement)
 {
-    SAMPLETYPE *tempUnaligned, *temp;
-
+    if (capacityRequirement > peakSamples) peakSamples = capacityRequirement;
     if (capacityRequirement > getCapacity())
     {
-        // enlarge the buffer in 4kbyte steps (round up to next 4k boundary)
-        sizeInBytes = (capacityRequirement * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
-        assert(sizeInBytes % 2 == 0);
-        tempUnaligned = new SAMPLETYPE[sizeInBytes / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
+        reallocate(capacityRequirement, channels);
+    }
+    else
+    {
+        // simply rewind the buffer (if necessary)
+        rewind();
+    }
+}
+
+
+// Allocates new storage for 'capacityRequirement' samples of 'numChannels'
+// channels and copies the current contents to its beginning. A mirrored ring
+// is preferred when available; otherwise the buffer is grown in 4 kilobyte
+// steps on the heap.
+void FIFOSampleBuffer::reallocate(uint capacityRequirement, uint numChannels)
+{
+    SAMPLETYPE *tempUnaligned = nullptr;
+    SAMPLETYPE *temp = nullptr;
+    bool tempMirrored = false;
+    uint newSize;
+
+    // enlarge the buffer in 4kbyte steps (round up to next 4k boundary)
+    newSize = (capacityRequirement * numChannels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
+    assert(newSize % 2 == 0);
+
+#ifdef SOUNDTOUCH_ALLOW_MIRRORED_FIFO
+    temp = allocMirrored(newSize, numChannels * sizeof(SAMPLETYPE));
+    tempMirrored = (temp != nullptr);
+#endif
+    if (temp == nullptr)
+    {
+        tempUnaligned = new SAMPLETYPE[newSize / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
         if (tempUnaligned == nullptr)
         {
             ST_THROW_RT_ERROR("Couldn't allocate memory!\n");
         }
         // Align the buffer to begin at 16byte cache line boundary for optimal performance
         temp = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(tempUnaligned);
-        if (samplesInBuffer)
-        {
-            memcpy(temp, ptrBegin(), samplesInBuffer * channels * sizeof(SAMPLETYPE));
-        }
-        delete[] bufferUnaligned;
-        buffer = temp;
-        bufferUnaligned = tempUnaligned;
-        bufferPos = 0;
     }
-    else
+    if (samplesInBuffer)
     {
-        // simply rewind the buffer (if necessary)
-        rewind();
+        memcpy(temp, ptrBegin(), samplesInBuffer * channels * sizeof(SAMPLETYPE));
     }
+    releaseBuffer();
+    buffer = temp;
+    bufferUnaligned = tempUnaligned;
+    sizeInBytes = newSize;
+    mirrored = tempMirrored;
+    bufferPos = 0;
 }
 
 
@@ -235,6 +366,12 @@ uint FIFOSampleBuffer::receiveSamples(uint maxSamples)
 
     samplesInBuffer -= maxSamples;
     bufferPos += maxSamples;
+    if (mirrored)
+    {
+        // wrap the read index into the first copy of the ring
+        const uint capacity = getCapacity();
+        if (bufferPos >= capacity) bufferPos -= capacity;
+    }
 
     return maxSamples;
 }
@@ -273,3 +410,30 @@ void FIFOSampleBuffer::addSilent(uint nSamples)
     memset(ptrEnd(nSamples), 0, sizeof(SAMPLETYPE) * nSamples * channels);
     samplesInBuffer += nSamples;
 }
+
+
+// A mirrored ring maps its pages twice but holds them once; a heap buffer
+// carries 16 bytes of alignment slack
+void FIFOSampleBuffer::addMemoryUsage(MemoryUsage &usage) const
+{
+    const uint frameBytes = channels * sizeof(SAMPLETYPE);
+    usage.allocated += sizeInBytes + (bufferUnaligned ? 16 : 0);
+    usage.used += samplesInBuffer * frameBytes;
+    usage.peakUsed += peakSamples * frameBytes;
+}
+
+
+// Reallocates down to the peak requirement since the last call. The new
+// size is rounded like any other allocation, so a buffer that never grew
+// beyond its first allocation is left alone.
+void FIFOSampleBuffer::shrinkToFit()
+{
+    uint target = (peakSamples > samplesInBuffer) ? peakSamples : samplesInBuffer;
+    if (target < 32) target = 32;
+    const uint targetBytes = (target * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
+    if (targetBytes < sizeInBytes)
+    {
+        reallocate(target, channels);
+    }
+    peakSamples = samplesInBuffer;
+}
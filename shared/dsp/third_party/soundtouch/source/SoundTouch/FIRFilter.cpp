@@ -242,6 +242,13 @@ uint FIRFilter::getLength() const
 }
 
 
+// Object plus the mono and stereo coefficient tables
+uint FIRFilter::getMemoryUsage() const
+{
+    return (uint)sizeof(*this) + (filterCoeffs ? 3 * length * (uint)sizeof(SAMPLETYPE) : 0);
+}
+
+
 // Applies the filter to the given sequence of samples.
 //
 // Note : The amount of outputted samples is by value of 'filter_length'
@@ -281,11 +288,11 @@ void * FIRFilter::operator new(size_t)
 }
 
 
-FIRFilter * FIRFilter::newInstance()
+FIRFilter * FIRFilter::newInstance(uint allowedExtensions)
 {
     uint uExtensions;
 
-    uExtensions = detectCPUextensions();
+    uExtensions = detectCPUextensions() & allowedExtensions;
     (void)uExtensions;
 
     // Check if MMX/SSE instruction set extensions supported by CPU
@@ -299,6 +306,15 @@ FIRFilter * FIRFilter::newInstance()
     else
 #endif // SOUNDTOUCH_ALLOW_MMX
 
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    if ((uExtensions & SUPPORT_AVX2) && (uExtensions & SUPPORT_FMA))
+    {
+        // AVX2 & FMA support
+        return ::new FIRFilterAVX2;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_AVX2
+
 #ifdef SOUNDTOUCH_ALLOW_SSE
     if (uExtensions & SUPPORT_SSE)
     {
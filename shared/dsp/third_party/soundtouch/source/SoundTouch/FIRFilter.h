@@ -75,7 +75,10 @@ public:
     /// depending on if we've a MMX-capable CPU available or not.
     static void * operator new(size_t s);
 
-    static FIRFilter *newInstance();
+    /// Creates a new instance using the fastest routines that the CPU supports,
+    /// limited to the SUPPORT_... extensions set in 'allowedExtensions'. Pass 0
+    /// to get the plain C routines, whose results don't depend on the CPU.
+    static FIRFilter *newInstance(uint allowedExtensions = 0xffffffff);
 
     /// Applies the filter to the given sequence of samples.
     /// Note : The amount of outputted samples is by value of 'filter_length'
@@ -89,6 +92,9 @@ public:
 
     uint getLength() const;
 
+    /// Returns the bytes held by this instance, coefficient tables included.
+    virtual uint getMemoryUsage() const;
+
     virtual void setCoefficients(const SAMPLETYPE *coeffs,
                                  uint newLength,
                                  uint uResultDivFactor);
@@ -111,6 +117,7 @@ public:
         FIRFilterMMX();
         ~FIRFilterMMX();
 
+        virtual uint getMemoryUsage() const override;
         virtual void setCoefficients(const short *coeffs, uint newLength, uint uResultDivFactor) override;
     };
 
@@ -130,11 +137,25 @@ public:
         FIRFilterSSE();
         ~FIRFilterSSE();
 
+        virtual uint getMemoryUsage() const override;
         virtual void setCoefficients(const float *coeffs, uint newLength, uint uResultDivFactor) override;
     };
 
 #endif // SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    /// Class that implements AVX2/FMA optimized functions exclusive for floating point
+    /// samples type. Uses the coefficient tables of the base class.
+    class FIRFilterAVX2 : public FIRFilter
+    {
+    protected:
+        virtual uint evaluateFilterStereo(float *dest, const float *src, uint numSamples) const override;
+        virtual uint evaluateFilterMono(float *dest, const float *src, uint numSamples) const override;
+    };
+
+#endif // SOUNDTOUCH_ALLOW_AVX2
+
 }
 
 #endif  // FIRFilter_H
@@ -64,6 +64,24 @@ public:
     }
 };
 
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+/// SSE version of the cubic transposer. Evaluates the coefficient polynomials
+/// for four output positions at a time; multichannel audio uses the plain C
+/// routine.
+class InterpolateCubicSSE : public InterpolateCubic
+{
+protected:
+    virtual int transposeMono(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples) override;
+    virtual int transposeStereo(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples) override;
+};
+
+#endif // SOUNDTOUCH_ALLOW_SSE
+
 }
 
 #endif
@@ -93,6 +93,23 @@ public:
     }
 };
 
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+/// SSE version of the floating point linear transposer. Computes four output
+/// positions at a time; multichannel audio uses the plain C routine.
+class InterpolateLinearFloatSSE : public InterpolateLinearFloat
+{
+protected:
+    virtual int transposeMono(SAMPLETYPE *dest,
+                       const SAMPLETYPE *src,
+                       int &srcSamples) override;
+    virtual int transposeStereo(SAMPLETYPE *dest,
+                         const SAMPLETYPE *src,
+                         int &srcSamples) override;
+};
+
+#endif // SOUNDTOUCH_ALLOW_SSE
+
 }
 
 #endif
@@ -69,6 +69,24 @@ public:
     }
 };
 
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+/// SSE version of the windowed-sinc transposer. All eight sinc terms share
+/// one sin(pi * fract), which is evaluated with a polynomial for four output
+/// positions at a time instead of eight sin() calls per output.
+class InterpolateShannonSSE : public InterpolateShannon
+{
+protected:
+    int transposeMono(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples) override;
+    int transposeStereo(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples) override;
+};
+
+#endif // SOUNDTOUCH_ALLOW_SSE
+
 }
 
 #endif
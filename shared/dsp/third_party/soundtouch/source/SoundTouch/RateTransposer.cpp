@@ -40,6 +40,7 @@
 #include "InterpolateCubic.h"
 #include "InterpolateShannon.h"
 #include "AAFilter.h"
+#include "cpu_detect.h"
 
 using namespace soundtouch;
 
@@ -48,7 +49,7 @@ TransposerBase::ALGORITHM TransposerBase::algorithm = TransposerBase::CUBIC;
 
 
 // Constructor
-RateTransposer::RateTransposer() : FIFOProcessor(&outputBuffer)
+RateTransposer::RateTransposer(uint allowedExtensions) : FIFOProcessor(&outputBuffer)
 {
     bUseAAFilter =
 #ifndef SOUNDTOUCH_PREVENT_CLICK_AT_RATE_CROSSOVER
@@ -59,8 +60,10 @@ RateTransposer::RateTransposer() : FIFOProcessor(&outputBuffer)
 #endif
 
     // Instantiates the anti-alias filter
-    pAAFilter = new AAFilter(64);
-    pTransposer = TransposerBase::newInstance();
+    pAAFilter = new AAFilter(64, allowedExtensions);
+    algorithm = TransposerBase::getAlgorithm();
+    extensions = allowedExtensions;
+    pTransposer = TransposerBase::newInstance(algorithm, extensions);
     clear();
 }
 
@@ -90,12 +93,52 @@ bool RateTransposer::isAAFilterEnabled() const
 }
 
 
+/// Selects a minimum-phase or linear-phase anti-alias filter
+void RateTransposer::enableMinimumPhaseAAFilter(bool newMode)
+{
+    pAAFilter->setMinimumPhase(newMode);
+    // the prefill depends on the filter's group delay
+    clear();
+}
+
+
+/// Returns nonzero if the anti-alias filter is minimum-phase.
+bool RateTransposer::isMinimumPhaseAAFilter() const
+{
+    return pAAFilter->isMinimumPhase();
+}
+
+
 AAFilter *RateTransposer::getAAFilter()
 {
     return pAAFilter;
 }
 
 
+/// Selects the interpolation algorithm of this instance
+void RateTransposer::setAlgorithm(TransposerBase::ALGORITHM a)
+{
+    if (a == algorithm) return;
+
+    TransposerBase *newTransposer = TransposerBase::newInstance(a, extensions);
+    newTransposer->setRate(pTransposer->rate);
+    if (pTransposer->numChannels > 0)
+    {
+        newTransposer->setChannels(pTransposer->numChannels);
+    }
+    delete pTransposer;
+    pTransposer = newTransposer;
+    algorithm = a;
+    clear();
+}
+
+
+TransposerBase::ALGORITHM RateTransposer::getAlgorithm() const
+{
+    return algorithm;
+}
+
+
 // Sets new target iRate. Normal iRate = 1.0, smaller values represent slower
 // iRate, larger faster iRates.
 void RateTransposer::setRate(double newRate)
@@ -194,8 +237,15 @@ void RateTransposer::clear()
     inputBuffer.clear();
     pTransposer->resetRegisters();
 
-    // prefill buffer to avoid losing first samples at beginning of stream
-    int prefill = getLatency();
+    // prefill buffer to avoid losing first samples at beginning of stream.
+    // The anti-alias filter holds back its full length but delays the signal
+    // only by its group delay; the rest is prefilled so that the output stays
+    // aligned with the input.
+    int prefill = pTransposer->getLatency();
+    if (bUseAAFilter)
+    {
+        prefill += pAAFilter->getLength() - 1 - pAAFilter->getGroupDelay();
+    }
     inputBuffer.addSilent(prefill);
 }
 
@@ -211,11 +261,30 @@ int RateTransposer::isEmpty() const
 }
 
 
+// The interpolators keep their state in a few registers and allocate
+// nothing, so only the filter and the buffers count.
+void RateTransposer::addMemoryUsage(MemoryUsage &usage) const
+{
+    usage.allocated += sizeof(*this) + pAAFilter->getMemoryUsage();
+    inputBuffer.addMemoryUsage(usage);
+    midBuffer.addMemoryUsage(usage);
+    outputBuffer.addMemoryUsage(usage);
+}
+
+
+void RateTransposer::shrinkToFit()
+{
+    inputBuffer.shrinkToFit();
+    midBuffer.shrinkToFit();
+    outputBuffer.shrinkToFit();
+}
+
+
 /// Return approximate initial input-output latency
 int RateTransposer::getLatency() const
 {
     return pTransposer->getLatency() +
-        ((bUseAAFilter) ? (pAAFilter->getLength() / 2) : 0);
+        ((bUseAAFilter) ? pAAFilter->getGroupDelay() : 0);
 }
 
 
@@ -231,6 +300,12 @@ void TransposerBase::setAlgorithm(TransposerBase::ALGORITHM a)
 }
 
 
+TransposerBase::ALGORITHM TransposerBase::getAlgorithm()
+{
+    return TransposerBase::algorithm;
+}
+
+
 // Transposes the sample rate of the given samples using linear interpolation.
 // Returns the number of samples returned in the "dest" buffer
 int TransposerBase::transpose(FIFOSampleBuffer &dest, FIFOSampleBuffer &src)
@@ -289,12 +364,46 @@ void TransposerBase::setRate(double newRate)
 
 // static factory function
 TransposerBase *TransposerBase::newInstance()
+{
+    return newInstance(algorithm);
+}
+
+
+// static factory function for a given algorithm
+TransposerBase *TransposerBase::newInstance(ALGORITHM a, uint allowedExtensions)
 {
 #ifdef SOUNDTOUCH_INTEGER_SAMPLES
     // Notice: For integer arithmetic support only linear algorithm (due to simplest calculus)
+    (void)a;
+    (void)allowedExtensions;
     return ::new InterpolateLinearInteger;
 #else
-    switch (algorithm)
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    if (detectCPUextensions() & allowedExtensions & SUPPORT_SSE)
+    {
+        // SSE support
+        switch (a)
+        {
+            case LINEAR:
+                return new InterpolateLinearFloatSSE;
+
+            case CUBIC:
+                return new InterpolateCubicSSE;
+
+            case SHANNON:
+                return new InterpolateShannonSSE;
+
+            default:
+                assert(false);
+                return nullptr;
+        }
+    }
+#else
+    (void)allowedExtensions;
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+    switch (a)
     {
         case LINEAR:
             return new InterpolateLinearFloat;
@@ -88,8 +88,15 @@ public:
     // static factory function
     static TransposerBase *newInstance();
 
+    /// Factory for a given algorithm. 'allowedExtensions' limits the SIMD
+    /// routines that may be chosen, see FIRFilter::newInstance
+    static TransposerBase *newInstance(ALGORITHM a, uint allowedExtensions = 0xffffffff);
+
     // static function to set interpolation algorithm
     static void setAlgorithm(ALGORITHM a);
+
+    /// Default algorithm of new transposer instances
+    static ALGORITHM getAlgorithm();
 };
 
 
@@ -114,6 +121,10 @@ protected:
 
     bool bUseAAFilter;
 
+    /// Interpolation algorithm and SIMD mask of 'pTransposer'
+    TransposerBase::ALGORITHM algorithm;
+    uint extensions;
+
 
     /// Transposes sample rate by applying anti-alias filter to prevent folding.
     /// Returns amount of samples returned in the "dest" buffer.
@@ -123,7 +134,9 @@ protected:
                         uint numSamples);
 
 public:
-    RateTransposer();
+    /// 'allowedExtensions' limits the SIMD routines used by the anti-alias
+    /// filter, see FIRFilter::newInstance
+    RateTransposer(uint allowedExtensions = 0xffffffff);
     virtual ~RateTransposer() override;
 
     /// Returns the output buffer object
@@ -138,6 +151,20 @@ public:
     /// Returns nonzero if anti-alias filter is enabled.
     bool isAAFilterEnabled() const;
 
+    /// Selects a minimum-phase (low delay) or linear-phase anti-alias filter.
+    /// Buffered samples are discarded.
+    void enableMinimumPhaseAAFilter(bool newMode);
+
+    /// Returns nonzero if the anti-alias filter is minimum-phase.
+    bool isMinimumPhaseAAFilter() const;
+
+    /// Selects the interpolation algorithm of this instance. Rate and channel
+    /// count are kept; buffered samples are discarded.
+    void setAlgorithm(TransposerBase::ALGORITHM a);
+
+    /// Returns the interpolation algorithm of this instance.
+    TransposerBase::ALGORITHM getAlgorithm() const;
+
     /// Sets new target rate. Normal rate = 1.0, smaller values represent slower
     /// rate, larger faster rates.
     virtual void setRate(double newRate);
@@ -155,6 +182,12 @@ public:
     /// Returns nonzero if there aren't any samples available for outputting.
     int isEmpty() const override;
 
+    /// Adds the sample buffers, the anti-alias filter and the interpolator.
+    void addMemoryUsage(MemoryUsage &usage) const override;
+
+    /// Shrinks the three sample buffers.
+    void shrinkToFit() override;
+
     /// Return approximate initial input-output latency
     int getLatency() const;
 };
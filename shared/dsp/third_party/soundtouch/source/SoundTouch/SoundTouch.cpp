@@ -86,12 +86,12 @@ extern "C" void soundtouch_ac_test()
 }
 
 
-SoundTouch::SoundTouch()
+SoundTouch::SoundTouch(uint allowedExtensions)
 {
     // Initialize rate transposer and tempo changer instances
 
-    pRateTransposer = new RateTransposer();
-    pTDStretch = TDStretch::newInstance();
+    pRateTransposer = new RateTransposer(allowedExtensions);
+    pTDStretch = TDStretch::newInstance(allowedExtensions);
 
     setOutPipe(pTDStretch);
 
@@ -387,6 +387,33 @@ bool SoundTouch::setSetting(int settingId, int value)
             pTDStretch->setParameters(sampleRate, sequenceMs, seekWindowMs, value);
             return true;
 
+        case SETTING_AA_FILTER_MINIMUM_PHASE:
+            // selects minimum-phase / linear-phase anti-alias filter
+            pRateTransposer->enableMinimumPhaseAAFilter((value != 0) ? true : false);
+            return true;
+
+        case SETTING_FAST_SEEK:
+            // enables / disables the approximate overlap search
+            pTDStretch->enableFastSeek((value != 0) ? true : false);
+            return true;
+
+        case SETTING_SPREAD_SEEK:
+            // enables / disables spreading the overlap search over the input
+            pTDStretch->enableSpreadSeek((value != 0) ? true : false);
+            return true;
+
+        case SETTING_ADAPTIVE_SEQUENCE:
+            // enables / disables the content-adaptive sequence length
+            pTDStretch->enableAdaptiveSequence((value != 0) ? true : false);
+            return true;
+
+        case SETTING_INTERPOLATION:
+            // selects the rate transposer's interpolation algorithm
+            if (value < TransposerBase::LINEAR || value > TransposerBase::SHANNON) return false;
+            if (value == TransposerBase::SHANNON && channels > 2) return false;
+            pRateTransposer->setAlgorithm((TransposerBase::ALGORITHM)value);
+            return true;
+
         default :
             return false;
     }
@@ -424,6 +451,21 @@ int SoundTouch::getSetting(int settingId) const
             pTDStretch->getParameters(nullptr, nullptr, nullptr, &temp);
             return temp;
 
+        case SETTING_INTERPOLATION:
+            return (int)pRateTransposer->getAlgorithm();
+
+        case SETTING_AA_FILTER_MINIMUM_PHASE:
+            return (uint)pRateTransposer->isMinimumPhaseAAFilter();
+
+        case SETTING_FAST_SEEK:
+            return (uint)pTDStretch->isFastSeekEnabled();
+
+        case SETTING_SPREAD_SEEK:
+            return (uint)pTDStretch->isSpreadSeekEnabled();
+
+        case SETTING_ADAPTIVE_SEQUENCE:
+            return (uint)pTDStretch->isAdaptiveSequenceEnabled();
+
         case SETTING_NOMINAL_INPUT_SEQUENCE :
         {
             int size = pTDStretch->getInputSampleReq();
@@ -487,6 +529,28 @@ void SoundTouch::clear()
 }
 
 
+void SoundTouch::addMemoryUsage(MemoryUsage &usage) const
+{
+    usage.allocated += sizeof(*this);
+    pRateTransposer->addMemoryUsage(usage);
+    pTDStretch->addMemoryUsage(usage);
+}
+
+
+void SoundTouch::shrinkToFit()
+{
+    pRateTransposer->shrinkToFit();
+    pTDStretch->shrinkToFit();
+}
+
+
+// Links the time-stretch overlap positions of this instance to another instance
+void SoundTouch::setSeekLeader(const SoundTouch *leader)
+{
+    pTDStretch->setSeekLeader(leader ? leader->pTDStretch : nullptr);
+}
+
+
 /// Returns number of samples currently unprocessed.
 uint SoundTouch::numUnprocessedSamples() const
 {
@@ -64,11 +64,27 @@ using namespace soundtouch;
 TDStretch::TDStretch() : FIFOProcessor(&outputBuffer)
 {
     bQuickSeek = false;
+    bFastSeek = false;
+    bSpreadSeek = false;
+    bAdaptiveSeq = false;
+    seqLong = false;
+    seqCount = 0;
+    seekStage = -1;
+    seekDone = 0;
+    seekBase = 0;
     channels = 2;
 
     pMidBuffer = nullptr;
     pMidBufferUnaligned = nullptr;
+    midBufferBytes = 0;
+    pSeekScratch = nullptr;
+    seekScratchSize = 0;
     overlapLength = 0;
+    seekLength = 0;
+    baseSeekLength = 0;
+
+    seekLeader = nullptr;
+    seekSerial = 0;
 
     bAutoSeqSetting = true;
     bAutoSeekSetting = true;
@@ -85,6 +101,7 @@ TDStretch::TDStretch() : FIFOProcessor(&outputBuffer)
 TDStretch::~TDStretch()
 {
     delete[] pMidBufferUnaligned;
+    delete[] pSeekScratch;
 }
 
 
@@ -201,7 +218,15 @@ void TDStretch::clearInput()
     isBeginning = true;
     maxnorm = 0;
     maxnormf = 1e8;
+    if (seqLong)
+    {
+        applySequenceLength(false);
+    }
     skipFract = 0;
+    seekSerial = 0;
+    seqCount = 0;
+    clearFlux();
+    resetSeekJob();
 }
 
 
@@ -213,12 +238,32 @@ void TDStretch::clear()
 }
 
 
+void TDStretch::addMemoryUsage(MemoryUsage &usage) const
+{
+    // the overlap buffer is in use in full from the first sequence on
+    const ulong overlapBytes = (ulong)overlapLength * channels * sizeof(SAMPLETYPE);
+    usage.allocated += sizeof(*this) + midBufferBytes + seekScratchSize * sizeof(float);
+    usage.used += overlapBytes;
+    usage.peakUsed += overlapBytes;
+    inputBuffer.addMemoryUsage(usage);
+    outputBuffer.addMemoryUsage(usage);
+}
+
+
+void TDStretch::shrinkToFit()
+{
+    inputBuffer.shrinkToFit();
+    outputBuffer.shrinkToFit();
+}
+
+
 
 // Enables/disables the quick position seeking algorithm. Zero to disable, nonzero
 // to enable
 void TDStretch::enableQuickSeek(bool enable)
 {
     bQuickSeek = enable;
+    resetSeekJob();
 }
 
 
@@ -229,10 +274,104 @@ bool TDStretch::isQuickSeekEnabled() const
 }
 
 
+// Enables/disables the approximate overlap search
+void TDStretch::enableFastSeek(bool enable)
+{
+    bFastSeek = enable;
+    resetSeekJob();
+}
+
+
+// Returns nonzero if the approximate overlap search is enabled.
+bool TDStretch::isFastSeekEnabled() const
+{
+    return bFastSeek;
+}
+
+
+// Enables/disables spreading the overlap search over the input as it arrives
+void TDStretch::enableSpreadSeek(bool enable)
+{
+    bSpreadSeek = enable;
+    resetSeekJob();
+}
+
+
+// Returns nonzero if the overlap search is spread over the input.
+bool TDStretch::isSpreadSeekEnabled() const
+{
+    return bSpreadSeek;
+}
+
+
+// Enables/disables adapting the sequence length to the content
+void TDStretch::enableAdaptiveSequence(bool enable)
+{
+    bAdaptiveSeq = enable;
+    clearFlux();
+    if (seqLong)
+    {
+        applySequenceLength(false);
+    }
+    resetSeekJob();
+}
+
+
+// Returns nonzero if the sequence length adapts to the content.
+bool TDStretch::isAdaptiveSequenceEnabled() const
+{
+    return bAdaptiveSeq;
+}
+
+
+// Links this instance to reuse overlap positions found by another instance
+void TDStretch::setSeekLeader(const TDStretch *leader)
+{
+    seekLeader = (leader == this) ? nullptr : leader;
+    resetSeekJob();
+}
+
+
+// Returns the overlap position for the next sequence: the one that the seek leader
+// chose for the same sequence if available, else the result of own search. The
+// position is recorded so that this instance can in turn act as a leader.
+int TDStretch::seekLinkedOverlapPosition(const SAMPLETYPE *refPos)
+{
+    int offset;
+    const TDStretch *leader = seekLeader;
+
+    if (leader && (leader->seekSerial > seekSerial) &&
+        (leader->seekSerial - seekSerial <= SEEK_LOG_LENGTH) &&
+        (leader->seekLengthLog[seekSerial % SEEK_LOG_LENGTH] == seekLength))
+    {
+        offset = leader->seekLog[seekSerial % SEEK_LOG_LENGTH];
+    }
+    else if (bSpreadSeek)
+    {
+        // finish the search that ran ahead while the input arrived
+        advanceSeekJob(refPos + channels * seekOrigin, (int)inputBuffer.numSamples() - seekOrigin, INT_MAX);
+        offset = seekOrigin + seekBestOffs;
+    }
+    else
+    {
+        offset = seekOrigin + seekBestOverlapPosition(refPos + channels * seekOrigin);
+    }
+    seekLog[seekSerial % SEEK_LOG_LENGTH] = offset;
+    seekLengthLog[seekSerial % SEEK_LOG_LENGTH] = seekLength;
+    seekSerial ++;
+
+    return offset;
+}
+
+
 // Seeks for the optimal overlap-mixing position.
 int TDStretch::seekBestOverlapPosition(const SAMPLETYPE *refPos)
 {
-    if (bQuickSeek)
+    if (bFastSeek)
+    {
+        return seekBestOverlapPositionFast(refPos);
+    }
+    else if (bQuickSeek)
     {
         return seekBestOverlapPositionQuick(refPos);
     }
@@ -456,6 +595,402 @@ int TDStretch::seekBestOverlapPositionQuick(const SAMPLETYPE *refPos)
 
 
 
+// Approximate 1/sqrt(x) for x > 0: bit-level initial guess and one Newton
+// step, within 0.18 %. Unlike hardware estimate instructions it gives the
+// same result on every CPU, so deterministic mode may use it.
+static inline float rsqrtApprox(float x)
+{
+    uint32_t bits;
+    float y;
+
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5f3759df - (bits >> 1);
+    memcpy(&y, &bits, sizeof(y));
+    return y * (1.5f - 0.5f * x * y * y);
+}
+
+
+// Single-precision dot product over 16 partial sums, reduced in a fixed
+// order. The AVX2 version keeps the same lanes and order, so every CPU
+// returns the same bits and the fast seek stays usable in deterministic mode.
+float TDStretch::dotProduct(const float *a, const float *b, int length) const
+{
+    float part[16] = {0};
+    int i;
+
+    for (i = 0; i + 16 <= length; i += 16)
+    {
+        for (int j = 0; j < 16; j ++)
+        {
+            part[j] += a[i + j] * b[i + j];
+        }
+    }
+    for (int j = 0; i < length; i ++, j ++)
+    {
+        part[j] += a[i] * b[i];
+    }
+    return reduceDotProduct(part);
+}
+
+
+// Approximate seek: scores every offset like the full search, but on every
+// second frame of the overlap, with float sums and rsqrtApprox() as the
+// normalizer. Offsets of the same parity share their decimated frames, so
+// both the reference and the search region are decimated once per seek and
+// each parity keeps a running norm. The winner and its two neighbours are
+// then scored on all frames, which recovers the precision lost to decimation.
+int TDStretch::seekBestOverlapPositionFast(const SAMPLETYPE *refPos)
+{
+    const int half = overlapLength / 2;
+    const int refLength = half * channels;
+    const int regionFrames = seekLength + overlapLength;
+    const int phaseLength = ((regionFrames + 1) / 2) * channels;
+    const int fullLength = overlapLength * channels;
+    int i, c;
+
+    // Sized by reserveSeekScratch(): nothing is allocated on the audio path
+    assert(seekScratchSize >= (uint)(refLength + 2 * max(phaseLength, fullLength)));
+    float *ref = pSeekScratch;
+    float *phase[2] = {ref + refLength, ref + refLength + phaseLength};
+
+    for (i = 0; i < half; i ++)
+    {
+        for (c = 0; c < channels; c ++)
+        {
+            ref[i * channels + c] = (float)pMidBuffer[2 * i * channels + c];
+        }
+    }
+    for (i = 0; i < regionFrames; i ++)
+    {
+        for (c = 0; c < channels; c ++)
+        {
+            phase[i & 1][(i >> 1) * channels + c] = (float)refPos[i * channels + c];
+        }
+    }
+
+    // Running norms in double: they are updated hundreds of times per seek
+    double norm[2];
+    norm[0] = dotProduct(phase[0], phase[0], refLength);
+    norm[1] = dotProduct(phase[1], phase[1], refLength);
+
+    float bestCorr = -FLT_MAX;
+    int bestOffs = 0;
+    for (i = 0; i < seekLength; i ++)
+    {
+        const int p = i & 1;
+        const float *x = phase[p] + (i >> 1) * channels;
+        if (i >= 2)
+        {
+            // drop the frame before this window, add the one that ends it
+            for (c = 0; c < channels; c ++)
+            {
+                norm[p] -= x[c - channels] * x[c - channels];
+                norm[p] += x[refLength - channels + c] * x[refLength - channels + c];
+            }
+        }
+
+        const float n = (norm[p] < 1e-9) ? 1.0f : (float)norm[p];
+        float corr = dotProduct(x, ref, refLength) * rsqrtApprox(n);
+        // same preference for the middle of the range as the full search
+        const float tmp = (float)(2 * i - seekLength) / (float)seekLength;
+        corr = (corr + 0.1f) * (1.0f - 0.25f * tmp * tmp);
+        if (corr > bestCorr)
+        {
+            bestCorr = corr;
+            bestOffs = i;
+        }
+    }
+
+    // Refine on all frames
+    const int first = bestOffs > 0 ? bestOffs - 1 : 0;
+    const int last = bestOffs + 1 < seekLength ? bestOffs + 1 : seekLength - 1;
+    float *full = phase[0];     // the decimated region is no longer needed
+    for (i = 0; i < fullLength; i ++)
+    {
+        full[i] = (float)pMidBuffer[i];
+    }
+    float *candidate = full + fullLength;
+    bestCorr = -FLT_MAX;
+    int refined = bestOffs;
+    for (i = first; i <= last; i ++)
+    {
+        for (c = 0; c < fullLength; c ++)
+        {
+            candidate[c] = (float)refPos[i * channels + c];
+        }
+        const float n = dotProduct(candidate, candidate, fullLength);
+        float corr = dotProduct(candidate, full, fullLength) * rsqrtApprox(n < 1e-9f ? 1.0f : n);
+        const float tmp = (float)(2 * i - seekLength) / (float)seekLength;
+        corr = (corr + 0.1f) * (1.0f - 0.25f * tmp * tmp);
+        if (corr > bestCorr)
+        {
+            bestCorr = corr;
+            refined = i;
+        }
+    }
+
+    return refined;
+}
+
+
+// Drops the search under way. The next one starts from the input now buffered.
+void TDStretch::resetSeekJob()
+{
+    seekStage = -1;
+    seekDone = 0;
+    seekBase = (int)inputBuffer.numSamples();
+}
+
+
+// Number of offsets one search scores, for pacing the spread search
+int TDStretch::seekJobSize() const
+{
+    if (bFastSeek)
+    {
+        return seekLength + 3;
+    }
+    if (bQuickSeek)
+    {
+        return max(0, (seekLength - SCANWIND - 2) / SCANSTEP) + 4 * SCANWIND;
+    }
+    return seekLength;
+}
+
+
+// Scores one offset like seekBestOverlapPositionQuick(). 'keepSecond' tracks
+// the runner-up as the coarse pass does.
+void TDStretch::scoreQuickOffset(const SAMPLETYPE *refPos, int offs, bool keepSecond)
+{
+    double norm;
+    float corr = (float)calcCrossCorr(refPos + channels * offs, pMidBuffer, norm);
+    float tmp = (float)(2 * offs - seekLength - 1) / (float)seekLength;
+    corr = ((corr + 0.1f) * (1.0f - 0.25f * tmp * tmp));
+
+    if (corr > seekBestCorr)
+    {
+        if (keepSecond)
+        {
+            seekBestCorr2 = seekBestCorr;
+            seekBestOffs2 = seekBestOffs;
+        }
+        seekBestCorr = corr;
+        seekBestOffs = offs;
+    }
+    else if (keepSecond && (corr > seekBestCorr2))
+    {
+        seekBestCorr2 = corr;
+        seekBestOffs2 = offs;
+    }
+}
+
+
+// Runs the overlap search of the selected algorithm as a resumable job: scores
+// at most 'budget' more offsets, and only those whose window lies within the
+// first 'available' input frames. The offsets are visited in the same order
+// and scored with the same arithmetic as by the one-shot searches, so the
+// result is identical. Returns true when done, with the result in 'seekBestOffs'.
+bool TDStretch::advanceSeekJob(const SAMPLETYPE *refPos, int available, int budget)
+{
+    const int half = overlapLength / 2;
+    const int refLength = half * channels;
+    const int regionFrames = seekLength + overlapLength;
+    const int phaseLength = ((regionFrames + 1) / 2) * channels;
+    const int fullLength = overlapLength * channels;
+    float *ref = pSeekScratch;
+    float *phase[2] = {ref + refLength, ref + refLength + phaseLength};
+    int i, c;
+
+    if (seekStage < 0)
+    {
+        seekStage = 0;
+        seekBestCorr = seekBestCorr2 = -FLT_MAX;
+        if (bFastSeek)
+        {
+            assert(seekScratchSize >= (uint)(refLength + 2 * max(phaseLength, fullLength)));
+            for (i = 0; i < half; i ++)
+            {
+                for (c = 0; c < channels; c ++)
+                {
+                    ref[i * channels + c] = (float)pMidBuffer[2 * i * channels + c];
+                }
+            }
+            seekDecimated = 0;
+            seekNext = 0;
+            seekEnd = seekLength;
+            seekBestOffs = 0;
+        }
+        else if (bQuickSeek)
+        {
+            seekNext = SCANSTEP;
+            seekEnd = seekLength - SCANWIND - 1;
+            seekBestOffs = seekBestOffs2 = SCANWIND;
+        }
+        else
+        {
+            seekNext = 0;
+            seekEnd = seekLength;
+            seekBestOffs = 0;
+        }
+    }
+
+    while (seekStage < 3)
+    {
+        if (seekNext >= seekEnd)
+        {
+            // next stage
+            if (bFastSeek && (seekStage == 0))
+            {
+                // refine the winner and its neighbours on all frames
+                seekBestOffs2 = seekBestOffs;
+                seekNext = (seekBestOffs > 0) ? seekBestOffs - 1 : 0;
+                seekEnd = (seekBestOffs + 1 < seekLength) ? seekBestOffs + 2 : seekLength;
+                seekBestCorr = -FLT_MAX;
+                for (i = 0; i < fullLength; i ++)
+                {
+                    phase[0][i] = (float)pMidBuffer[i];
+                }
+                seekStage = 1;
+            }
+            else if (bQuickSeek && !bFastSeek && (seekStage < 2))
+            {
+                // scan around the best, then around the second best match
+                const int centre = (seekStage == 0) ? seekBestOffs : seekBestOffs2;
+                seekNext = centre - SCANWIND;
+                seekEnd = _MIN(centre + SCANWIND + 1, seekLength);
+                seekStage ++;
+            }
+            else
+            {
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+                if (!bFastSeek) adaptNormalizer();
+#endif
+                clearCrossCorrState();
+                seekStage = 3;
+            }
+            continue;
+        }
+
+        if ((seekNext + overlapLength > available) || (budget <= 0))
+        {
+            // clear cross correlation routine state if necessary (is so e.g. in MMX routines).
+            clearCrossCorrState();
+            return false;
+        }
+
+        i = seekNext;
+        if (bFastSeek && (seekStage == 0))
+        {
+            // decimate the search region as far as it has arrived
+            const int frames = _MIN(available, regionFrames);
+            for (; seekDecimated < frames; seekDecimated ++)
+            {
+                for (c = 0; c < channels; c ++)
+                {
+                    phase[seekDecimated & 1][(seekDecimated >> 1) * channels + c] =
+                        (float)refPos[seekDecimated * channels + c];
+                }
+            }
+
+            const int p = i & 1;
+            const float *x = phase[p] + (i >> 1) * channels;
+            if (i < 2)
+            {
+                seekNorm[p] = dotProduct(phase[p], phase[p], refLength);
+            }
+            else
+            {
+                for (c = 0; c < channels; c ++)
+                {
+                    seekNorm[p] -= x[c - channels] * x[c - channels];
+                    seekNorm[p] += x[refLength - channels + c] * x[refLength - channels + c];
+                }
+            }
+            const float n = (seekNorm[p] < 1e-9) ? 1.0f : (float)seekNorm[p];
+            float corr = dotProduct(x, ref, refLength) * rsqrtApprox(n);
+            const float tmp = (float)(2 * i - seekLength) / (float)seekLength;
+            corr = (corr + 0.1f) * (1.0f - 0.25f * tmp * tmp);
+            if (corr > seekBestCorr)
+            {
+                seekBestCorr = corr;
+                seekBestOffs = i;
+            }
+        }
+        else if (bFastSeek)
+        {
+            float *full = phase[0];
+            float *candidate = full + fullLength;
+            for (c = 0; c < fullLength; c ++)
+            {
+                candidate[c] = (float)refPos[i * channels + c];
+            }
+            const float n = dotProduct(candidate, candidate, fullLength);
+            float corr = dotProduct(candidate, full, fullLength) * rsqrtApprox(n < 1e-9f ? 1.0f : n);
+            const float tmp = (float)(2 * i - seekLength) / (float)seekLength;
+            corr = (corr + 0.1f) * (1.0f - 0.25f * tmp * tmp);
+            if (corr > seekBestCorr)
+            {
+                seekBestCorr = corr;
+                seekBestOffs = i;
+            }
+        }
+        else if (bQuickSeek)
+        {
+            if (seekStage == 0)
+            {
+                scoreQuickOffset(refPos, i, true);
+            }
+            else if (i != ((seekStage == 1) ? seekBestOffs : seekBestOffs2))
+            {
+                // the centre was already scored
+                scoreQuickOffset(refPos, i, false);
+            }
+        }
+        else if (i == 0)
+        {
+            seekBestCorr = calcCrossCorr(refPos, pMidBuffer, seekNorm[0]);
+            seekBestCorr = (seekBestCorr + 0.1) * 0.75;
+        }
+        else
+        {
+#if defined(_OPENMP) || defined(ST_SIMD_AVOID_UNALIGNED)
+            double corr = calcCrossCorr(refPos + channels * i, pMidBuffer, seekNorm[0]);
+#else
+            double corr = calcCrossCorrAccumulate(refPos + channels * i, pMidBuffer, seekNorm[0]);
+#endif
+            double tmp = (double)(2 * i - seekLength) / (double)seekLength;
+            corr = ((corr + 0.1) * (1.0 - 0.25 * tmp * tmp));
+            if (corr > seekBestCorr)
+            {
+                seekBestCorr = corr;
+                seekBestOffs = i;
+            }
+        }
+
+        seekNext += (bQuickSeek && !bFastSeek && (seekStage == 0)) ? SCANSTEP : 1;
+        seekDone ++;
+        budget --;
+    }
+    return true;
+}
+
+
+// Scores as many offsets of the next search as the input received since the
+// last sequence pays for, so that each call gets an even share of the work.
+void TDStretch::spreadSeek()
+{
+    const int available = (int)inputBuffer.numSamples();
+    const int span = sampleReq - seekBase;
+    const int total = seekJobSize();
+    const int target = (span > 0) ? (int)((long long)total * (available - seekBase) / span) + 1 : total;
+
+    if (target > seekDone)
+    {
+        advanceSeekJob(inputBuffer.ptrBegin() + channels * seekOrigin, available - seekOrigin,
+                       target - seekDone);
+    }
+}
+
+
 /// For integer algorithm: adapt normalization factor divider with music so that
 /// it'll not be pessimistically restrictive that can degrade quality on quieter sections
 /// yet won't cause integer overflows either
@@ -537,6 +1072,7 @@ void TDStretch::calcSeqParameters()
         seekWindowLength = 2 * overlapLength;
     }
     seekLength = (sampleRate * seekWindowMs) / 1000;
+    resetSeekJob();
 }
 
 
@@ -545,12 +1081,29 @@ void TDStretch::calcSeqParameters()
 // tempo, larger faster tempo.
 void TDStretch::setTempo(double newTempo)
 {
-    int intskip;
-
     tempo = newTempo;
 
     // Calculate new sequence duration
     calcSeqParameters();
+    baseWindowLength = seekWindowLength;
+    baseSeekLength = seekLength;
+    setSequenceLengths(seekWindowLength, seekLength);
+    reserveSeekScratch();
+    baseSampleReq = sampleReq;
+    seqLong = false;
+    clearFlux();
+}
+
+
+// Sets the lengths of the next sequence and the skip and input requirement
+// that follow from them
+void TDStretch::setSequenceLengths(int windowLength, int seekLen)
+{
+    int intskip;
+
+    seekWindowLength = windowLength;
+    seekLength = seekLen;
+    seekOrigin = (baseSeekLength - seekLen) / 2;
 
     // Calculate ideal skip length (according to tempo value)
     nominalSkip = tempo * (seekWindowLength - overlapLength);
@@ -559,7 +1112,164 @@ void TDStretch::setTempo(double newTempo)
     // Calculate how many samples are needed in the 'inputBuffer' to
     // process another batch of samples
     //sampleReq = max(intskip + overlapLength, seekWindowLength) + seekLength / 2;
-    sampleReq = max(intskip + overlapLength, seekWindowLength) + seekLength;
+    sampleReq = max(intskip + overlapLength, seekWindowLength) + seekOrigin + seekLength;
+}
+
+
+// Adaptive sequence length: a long sequence searches a third of the seek
+// window, but no less than 5 ms, which still spans half a period of the
+// lowest notes a splice has to line up
+#define ADAPTSEQ_LONG_SEEK_DIV  3
+#define ADAPTSEQ_MIN_SEEK_MS    5
+
+// Onset detector: blocks of 5 ms; an onset is a block 6 dB above the
+// recent average of either band. Stationary means no onset for 200 ms and
+// little energy rise
+#define ADAPTSEQ_BLOCKS_PER_SEC 200
+#define ADAPTSEQ_ONSET_RATIO    4.0
+#define ADAPTSEQ_AVG_K          0.1     // ~50 ms
+#define ADAPTSEQ_MEAN_K         0.05    // ~100 ms
+#define ADAPTSEQ_STEADY_MS      200
+#define ADAPTSEQ_RISE_FLOOR     2.0     // level changes within 3 dB don't count
+#define ADAPTSEQ_STEADY_RISE    0.05
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    #define ADAPTSEQ_SILENCE    10.0    // -70 dBFS mean square
+#else
+    #define ADAPTSEQ_SILENCE    1e-7
+#endif
+
+
+// Sets the lengths of a long sequence or the set ones, see enableAdaptiveSequence()
+void TDStretch::applySequenceLength(bool longSequence)
+{
+    int window = baseWindowLength;
+    int seek = baseSeekLength;
+
+    if (longSequence)
+    {
+        // the narrower window stays centred on the set one, so that the
+        // splices keep their timing; the input it no longer needs at its
+        // end goes to the sequence, as far as the input requirement stays
+        // within that of the set lengths
+        seek = max(baseSeekLength / ADAPTSEQ_LONG_SEEK_DIV, sampleRate * ADAPTSEQ_MIN_SEEK_MS / 1000);
+        seek = (seek < baseSeekLength) ? seek : baseSeekLength;
+        window += (int)((baseSeekLength - seek) / (2 * tempo)) + 1;
+    }
+
+    setSequenceLengths(window, seek);
+    while ((sampleReq > baseSampleReq) && (seekWindowLength > baseWindowLength))
+    {
+        setSequenceLengths(seekWindowLength - 1, seek);
+    }
+    seqLong = longSequence;
+}
+
+
+void TDStretch::clearFlux()
+{
+    fluxBlock = max(16, sampleRate / ADAPTSEQ_BLOCKS_PER_SEC);
+    fluxFill = 0;
+    onsetAge = 0;
+    fluxPrev = 0;
+    fluxEnergy[0] = fluxEnergy[1] = 0;
+    fluxAvg[0] = fluxAvg[1] = 0;
+    fluxMean = 0;
+}
+
+
+// Feeds the onset detector with new input
+void TDStretch::analyseFlux(const SAMPLETYPE *samples, uint nSamples)
+{
+    for (uint i = 0; i < nSamples; i ++)
+    {
+        double mix = 0;
+        for (int c = 0; c < channels; c ++)
+        {
+            mix += samples[i * channels + c];
+        }
+        const double diff = mix - fluxPrev;
+        fluxPrev = mix;
+        fluxEnergy[0] += mix * mix;
+        fluxEnergy[1] += diff * diff;
+        if (++ fluxFill == fluxBlock)
+        {
+            endFluxBlock();
+        }
+    }
+}
+
+
+// Compares a finished block with the averages of the blocks before it. The
+// first difference weighs the highs, where most onsets stand out.
+void TDStretch::endFluxBlock()
+{
+    const double silence = ADAPTSEQ_SILENCE * channels * channels;
+    bool onset = false;
+    double rise = 0;
+
+    for (int b = 0; b < 2; b ++)
+    {
+        const double energy = fluxEnergy[b] / fluxBlock;
+        if ((energy > silence) && (energy > ADAPTSEQ_ONSET_RATIO * fluxAvg[b]))
+        {
+            onset = true;
+        }
+        if (energy > ADAPTSEQ_RISE_FLOOR * fluxAvg[b])
+        {
+            rise += log((energy + silence) / (ADAPTSEQ_RISE_FLOOR * fluxAvg[b] + silence));
+        }
+        fluxAvg[b] += ADAPTSEQ_AVG_K * (energy - fluxAvg[b]);
+        fluxEnergy[b] = 0;
+    }
+    fluxMean += ADAPTSEQ_MEAN_K * (rise - fluxMean);
+    fluxFill = 0;
+
+    if (onset)
+    {
+        onsetAge = 0;
+    }
+    else if (onsetAge < INT_MAX / 2)
+    {
+        onsetAge += fluxBlock;
+    }
+}
+
+
+// True if the input has been stationary up to the beginning of the input
+// buffer, where the next sequence starts, and throughout the buffer: its end
+// is as far as the next overlap search reaches.
+bool TDStretch::isStationary() const
+{
+    const int age = onsetAge - (int)inputBuffer.numSamples();
+
+    return (age > sampleRate * ADAPTSEQ_STEADY_MS / 1000) && (fluxMean < ADAPTSEQ_STEADY_RISE);
+}
+
+
+// Chooses the length of the next sequence. A follower takes the leader's
+// choice for the same sequence so that their overlap searches stay linked.
+void TDStretch::adaptSequence()
+{
+    const TDStretch *leader = seekLeader;
+    bool longSequence = false;
+
+    seqCount ++;
+    if (!leader)
+    {
+        longSequence = isStationary();
+    }
+    else if (leader->bAdaptiveSeq && (leader->seqCount >= seqCount) &&
+             (leader->seqCount - seqCount < SEEK_LOG_LENGTH))
+    {
+        longSequence = leader->seqLongLog[seqCount % SEEK_LOG_LENGTH];
+    }
+    seqLongLog[seqCount % SEEK_LOG_LENGTH] = longSequence;
+
+    if (longSequence != seqLong)
+    {
+        applySequenceLength(longSequence);
+    }
 }
 
 
@@ -639,7 +1349,7 @@ void TDStretch::processSamples()
         {
             // apart from the very beginning of the track,
             // scan for the best overlapping position & do overlap-add
-            offset = seekBestOverlapPosition(inputBuffer.ptrBegin());
+            offset = seekLinkedOverlapPosition(inputBuffer.ptrBegin());
 
             // Mix the samples in the 'inputBuffer' at position of 'offset' with the
             // samples in 'midBuffer' using sliding overlapping
@@ -700,6 +1410,17 @@ void TDStretch::processSamples()
         ovlSkip = (int)skipFract;   // rounded to integer skip
         skipFract -= ovlSkip;       // maintain the fraction part, i.e. real vs. integer skip
         inputBuffer.receiveSamples((uint)ovlSkip);
+        if (bAdaptiveSeq)
+        {
+            adaptSequence();
+        }
+        resetSeekJob();
+    }
+
+    // Not enough input for another sequence: search ahead for the next one
+    if (bSpreadSeek && !isBeginning && !seekLeader)
+    {
+        spreadSeek();
     }
 }
 
@@ -708,6 +1429,23 @@ void TDStretch::processSamples()
 // the input of the object.
 void TDStretch::putSamples(const SAMPLETYPE *samples, uint nSamples)
 {
+    // The onset detector sees the input up to where each sequence starts
+    // and no further, so the choice of lengths doesn't depend on how the
+    // input is split into calls
+    if (bAdaptiveSeq && !seekLeader)
+    {
+        while (nSamples > 0)
+        {
+            const int room = sampleReq - (int)inputBuffer.numSamples();
+            const uint n = (room > 0 && (uint)room < nSamples) ? (uint)room : nSamples;
+            analyseFlux(samples, n);
+            inputBuffer.putSamples(samples, n);
+            processSamples();
+            samples += n * channels;
+            nSamples -= n;
+        }
+        return;
+    }
     // Add the samples into the input buffer
     inputBuffer.putSamples(samples, nSamples);
     // Process the samples in input buffer
@@ -724,17 +1462,40 @@ void TDStretch::acceptNewOverlapLength(int newOverlapLength)
     assert(newOverlapLength >= 0);
     prevOvl = overlapLength;
     overlapLength = newOverlapLength;
+    resetSeekJob();
 
     if (overlapLength > prevOvl)
     {
         delete[] pMidBufferUnaligned;
 
         pMidBufferUnaligned = new SAMPLETYPE[overlapLength * channels + 16 / sizeof(SAMPLETYPE)];
+        midBufferBytes = (uint)((overlapLength * channels + 16 / sizeof(SAMPLETYPE)) * sizeof(SAMPLETYPE));
         // ensure that 'pMidBuffer' is aligned to 16 byte boundary for efficiency
         pMidBuffer = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(pMidBufferUnaligned);
 
         clearMidBuffer();
     }
+    reserveSeekScratch();
+}
+
+
+// Sizes the fast seek's scratch for the longest seek window the current
+// parameters allow. The adaptive sequence length only ever shortens the
+// window below 'baseSeekLength', so the search never needs to grow it.
+// Called from the parameter setters, never from the processing path.
+void TDStretch::reserveSeekScratch()
+{
+    const int longestSeek = max(baseSeekLength, seekLength);
+    const int refLength = (overlapLength / 2) * channels;
+    const int phaseLength = ((longestSeek + overlapLength + 1) / 2) * channels;
+    const int fullLength = overlapLength * channels;
+    const uint needed = (uint)(refLength + 2 * max(phaseLength, fullLength));
+    if (seekScratchSize < needed)
+    {
+        delete[] pSeekScratch;
+        pSeekScratch = new float[needed];
+        seekScratchSize = needed;
+    }
 }
 
 
@@ -748,11 +1509,11 @@ void * TDStretch::operator new(size_t)
 }
 
 
-TDStretch * TDStretch::newInstance()
+TDStretch * TDStretch::newInstance(uint allowedExtensions)
 {
     uint uExtensions;
 
-    uExtensions = detectCPUextensions();
+    uExtensions = detectCPUextensions() & allowedExtensions;
     (void)uExtensions;
 
     // Check if MMX/SSE instruction set extensions supported by CPU
@@ -767,6 +1528,15 @@ TDStretch * TDStretch::newInstance()
 #endif // SOUNDTOUCH_ALLOW_MMX
 
 
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    if ((uExtensions & SUPPORT_AVX2) && (uExtensions & SUPPORT_FMA))
+    {
+        // AVX2 & FMA support
+        return ::new TDStretchAVX2;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_AVX2
+
 #ifdef SOUNDTOUCH_ALLOW_SSE
     if (uExtensions & SUPPORT_SSE)
     {
@@ -97,6 +97,10 @@ namespace soundtouch
 /// Increasing this value increases computational burden & vice versa.
 #define DEFAULT_OVERLAP_MS      8
 
+/// Number of most recent overlap positions that a TDStretch instance remembers
+/// for other instances linked to it with 'setSeekLeader'.
+#define SEEK_LOG_LENGTH         256
+
 
 /// Class that does the time-stretch (tempo change) effect for the processed
 /// sound.
@@ -125,6 +129,9 @@ protected:
     double skipFract;
 
     bool bQuickSeek;
+    bool bFastSeek;
+    bool bSpreadSeek;
+    bool bAdaptiveSeq;
     bool bAutoSeqSetting;
     bool bAutoSeekSetting;
     bool isBeginning;
@@ -132,20 +139,106 @@ protected:
     SAMPLETYPE *pMidBuffer;
     SAMPLETYPE *pMidBufferUnaligned;
 
+    /// Size of the allocation behind 'pMidBuffer'
+    uint midBufferBytes;
+
+    /// Decimated copies of the overlap reference and the search region for
+    /// the fast seek, and their capacity in floats
+    float *pSeekScratch;
+    uint seekScratchSize;
+
+    /// Instance whose overlap positions this one reuses, or nullptr
+    const TDStretch *seekLeader;
+
+    /// Number of overlap positions chosen since the last clear
+    uint seekSerial;
+
+    /// Ring of the latest overlap positions, indexed by 'seekSerial'
+    int seekLog[SEEK_LOG_LENGTH];
+
+    /// Seek window length each of those positions was searched with
+    int seekLengthLog[SEEK_LOG_LENGTH];
+
+    /// Overlap search for the next sequence, run ahead of it while the input
+    /// arrives if 'bSpreadSeek' is set. 'seekStage' is -1 until it starts;
+    /// 'seekNext' is the next offset to score and 'seekEnd' ends the stage.
+    int seekStage;
+    int seekNext;
+    int seekEnd;
+    int seekDone;           ///< offsets scored so far
+    int seekBase;           ///< input samples buffered when the previous sequence ended
+    int seekDecimated;      ///< fast seek: search region frames decimated so far
+    int seekBestOffs;
+    int seekBestOffs2;
+    double seekBestCorr;
+    double seekBestCorr2;
+    double seekNorm[2];
+
+    /// Content-adaptive sequence length, see enableAdaptiveSequence(). The
+    /// parameters set 'baseWindowLength', 'baseSeekLength' and 'baseSampleReq';
+    /// 'seekWindowLength', 'seekLength', 'nominalSkip' and 'sampleReq' then
+    /// hold the lengths of the sequence under way.
+    int baseWindowLength;
+    int baseSeekLength;
+    int baseSampleReq;
+    int seekOrigin;         ///< first offset searched: keeps a narrower window centred on the set one
+    bool seqLong;           ///< the sequence under way is a long one
+    uint seqCount;          ///< sequences completed since the last clear
+    bool seqLongLog[SEEK_LOG_LENGTH];   ///< choice made after each sequence, by 'seqCount'
+
+    /// Onset detector: energy of the mono mix and of its first difference
+    /// over blocks of 'fluxBlock' frames, against their recent averages
+    int fluxBlock;
+    int fluxFill;
+    int onsetAge;           ///< frames since the last onset
+    double fluxPrev;
+    double fluxEnergy[2];
+    double fluxAvg[2];
+    double fluxMean;        ///< smoothed energy rise per block
+
     FIFOSampleBuffer outputBuffer;
     FIFOSampleBuffer inputBuffer;
 
     void acceptNewOverlapLength(int newOverlapLength);
+    void reserveSeekScratch();
 
     virtual void clearCrossCorrState();
     void calculateOverlapLength(int overlapMs);
 
     virtual double calcCrossCorr(const SAMPLETYPE *mixingPos, const SAMPLETYPE *compare, double &norm);
+    virtual float dotProduct(const float *a, const float *b, int length) const;
+
+    /// Sum of the partial sums of dotProduct(), in the order all versions use
+    static inline float reduceDotProduct(const float part[16])
+    {
+        float v[8];
+        for (int j = 0; j < 8; j ++)
+        {
+            v[j] = part[j] + part[j + 8];
+        }
+        return ((v[0] + v[4]) + (v[2] + v[6])) + ((v[1] + v[5]) + (v[3] + v[7]));
+    }
     virtual double calcCrossCorrAccumulate(const SAMPLETYPE *mixingPos, const SAMPLETYPE *compare, double &norm);
 
     virtual int seekBestOverlapPositionFull(const SAMPLETYPE *refPos);
     virtual int seekBestOverlapPositionQuick(const SAMPLETYPE *refPos);
+    int seekBestOverlapPositionFast(const SAMPLETYPE *refPos);
     virtual int seekBestOverlapPosition(const SAMPLETYPE *refPos);
+    int seekLinkedOverlapPosition(const SAMPLETYPE *refPos);
+
+    void resetSeekJob();
+    int seekJobSize() const;
+    void scoreQuickOffset(const SAMPLETYPE *refPos, int offs, bool keepSecond);
+    bool advanceSeekJob(const SAMPLETYPE *refPos, int available, int budget);
+    void spreadSeek();
+
+    void setSequenceLengths(int windowLength, int seekLen);
+    void applySequenceLength(bool longSequence);
+    void clearFlux();
+    void analyseFlux(const SAMPLETYPE *samples, uint nSamples);
+    void endFluxBlock();
+    bool isStationary() const;
+    void adaptSequence();
 
     virtual void overlapStereo(SAMPLETYPE *output, const SAMPLETYPE *input) const;
     virtual void overlapMono(SAMPLETYPE *output, const SAMPLETYPE *input) const;
@@ -174,7 +267,10 @@ public:
     /// Use this function instead of "new" operator to create a new instance of this class.
     /// This function automatically chooses a correct feature set depending on if the CPU
     /// supports MMX/SSE/etc extensions.
-    static TDStretch *newInstance();
+    ///
+    /// 'allowedExtensions' limits the choice to the given SUPPORT_... extensions;
+    /// 0 selects the plain C routines, whose results don't depend on the CPU.
+    static TDStretch *newInstance(uint allowedExtensions = 0xffffffff);
 
     /// Returns the output buffer object
     FIFOSamplePipe *getOutput() { return &outputBuffer; };
@@ -189,6 +285,12 @@ public:
     /// Returns nonzero if there aren't any samples available for outputting.
     virtual void clear() override;
 
+    /// Adds the overlap buffer and the input and output buffers.
+    void addMemoryUsage(MemoryUsage &usage) const override;
+
+    /// Shrinks the input and output buffers.
+    void shrinkToFit() override;
+
     /// Clears the input buffer
     void clearInput();
 
@@ -202,6 +304,51 @@ public:
     /// Returns nonzero if the quick seeking algorithm is enabled.
     bool isQuickSeekEnabled() const;
 
+    /// Enables/disables the approximate overlap search: every offset is scored
+    /// on every second frame with float sums and an approximate normalizer,
+    /// then the best one is refined at full resolution. About half the cost of
+    /// the exact search; takes precedence over the quick seek.
+    void enableFastSeek(bool enable);
+
+    /// Returns nonzero if the approximate overlap search is enabled.
+    bool isFastSeekEnabled() const;
+
+    /// Enables/disables spreading the overlap search over the input as it
+    /// arrives. Without it, the whole search runs in the putSamples() call that
+    /// completes a sequence, so small input blocks alternate between nearly free
+    /// and expensive. With it, each call scores the offsets its share of the
+    /// sequence's input pays for, as far as the input allows, and the call
+    /// that completes the sequence only finishes what is left. The search and
+    /// its result are the same either way, so the output is bit-identical.
+    void enableSpreadSeek(bool enable);
+
+    /// Returns nonzero if the overlap search is spread over the input.
+    bool isSpreadSeekEnabled() const;
+
+    /// Enables/disables adapting the sequence length to the content. A cheap
+    /// onset detector watches the input. Once it has been stationary for a
+    /// while, the seek window shrinks to a third (5 ms at least), centred on
+    /// the set one, and the sequences grow by the input that saves: fewer and
+    /// cheaper searches where any nearby splice point fits. As soon as an onset
+    /// reaches the input buffer, the next sequence has the set lengths again,
+    /// so every splice near a transient gets the full search. A sequence never
+    /// needs more input than with the set lengths, so the latency and the
+    /// output cadence stay within what they were.
+    void enableAdaptiveSequence(bool enable);
+
+    /// Returns nonzero if the sequence length adapts to the content.
+    bool isAdaptiveSequenceEnabled() const;
+
+    /// Makes this instance use the overlap positions chosen by 'leader' instead of
+    /// searching its own, nullptr to search independently again.
+    ///
+    /// Used for processing a multichannel stream as separate planar mono streams:
+    /// all channels then splice at identical positions, which keeps the inter-channel
+    /// phase intact. The leader must be fed the same amount of samples with the same
+    /// settings, and before the followers. If a follower gets ahead of its leader or
+    /// the parameters differ, it falls back to its own search.
+    void setSeekLeader(const TDStretch *leader);
+
     /// Sets routine control parameters. These control are certain time constants
     /// defining how the sound is stretched to the desired duration.
     //
@@ -244,7 +391,7 @@ public:
 	/// return approximate initial input-output latency
 	int getLatency() const
 	{
-		return sampleReq;
+		return baseSampleReq;
 	}
 };
 
@@ -275,5 +422,20 @@ public:
 
 #endif /// SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+    /// Class that implements AVX2/FMA optimized routines for floating point samples type.
+    class TDStretchAVX2 : public TDStretch
+    {
+    protected:
+        double calcCrossCorr(const float *mixingPos, const float *compare, double &norm) override;
+        double calcCrossCorrAccumulate(const float *mixingPos, const float *compare, double &norm) override;
+        virtual void overlapStereo(float *output, const float *input) const override;
+        virtual void overlapMono(float *output, const float *input) const override;
+        float dotProduct(const float *a, const float *b, int length) const override;
+    };
+
+#endif /// SOUNDTOUCH_ALLOW_AVX2
+
 }
 #endif  /// TDStretch_H
@@ -0,0 +1,297 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// AVX2/FMA optimized routines for Haswell, Zen and later x86 CPUs. Like the
+/// SSE routines, all of them are gathered into this single source file.
+///
+/// The functions are compiled with per-function target attributes instead of
+/// global compiler flags, so the library keeps running on older CPUs; the
+/// 'newInstance' factories pick these classes only if 'detectCPUextensions'
+/// reports both AVX2 and FMA.
+///
+/// Author        : Copyright (c) Olli Parviainen
+/// Author e-mail : oparviai 'at' iki.fi
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpu_detect.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#ifdef SOUNDTOUCH_ALLOW_AVX2
+
+// AVX2 routines available only with float sample type
+
+#include <immintrin.h>
+#include <assert.h>
+#include <math.h>
+
+#if defined(__GNUC__)
+    #define ST_AVX2_TARGET  __attribute__((target("avx2,fma")))
+#else
+    // MSVC accepts the intrinsics without target flags
+    #define ST_AVX2_TARGET
+#endif
+
+
+// Sum of the eight floats in 'v'
+ST_AVX2_TARGET static inline float horizontalSum(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+    return _mm_cvtss_f32(s);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of AVX2 optimized functions of class 'TDStretchAVX2'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "TDStretch.h"
+
+// Calculates cross correlation of two buffers
+ST_AVX2_TARGET double TDStretchAVX2::calcCrossCorr(const float *pV1, const float *pV2, double &anorm)
+{
+#ifdef ST_SIMD_AVOID_UNALIGNED
+    // same position rule as in the SSE version, so that both find the same offsets
+    if (((ulongptr)pV1) & 15) return -1e50;
+#endif
+
+    // ensure overlapLength is divisible by 8
+    assert((overlapLength % 8) == 0);
+
+    // Two independent accumulator pairs hide the FMA latency. Same routine for
+    // stereo & mono. Neither input is guaranteed to be 32-byte aligned.
+    const int length = channels * overlapLength;
+    __m256 vSum0 = _mm256_setzero_ps();
+    __m256 vSum1 = _mm256_setzero_ps();
+    __m256 vNorm0 = _mm256_setzero_ps();
+    __m256 vNorm1 = _mm256_setzero_ps();
+    int i;
+
+    for (i = 0; i + 16 <= length; i += 16)
+    {
+        __m256 a0 = _mm256_loadu_ps(pV1 + i);
+        __m256 a1 = _mm256_loadu_ps(pV1 + i + 8);
+        vSum0  = _mm256_fmadd_ps(a0, _mm256_loadu_ps(pV2 + i), vSum0);
+        vSum1  = _mm256_fmadd_ps(a1, _mm256_loadu_ps(pV2 + i + 8), vSum1);
+        vNorm0 = _mm256_fmadd_ps(a0, a0, vNorm0);
+        vNorm1 = _mm256_fmadd_ps(a1, a1, vNorm1);
+    }
+    if (i < length)
+    {
+        // length is a multiple of 8, so at most one vector is left
+        __m256 a0 = _mm256_loadu_ps(pV1 + i);
+        vSum0  = _mm256_fmadd_ps(a0, _mm256_loadu_ps(pV2 + i), vSum0);
+        vNorm0 = _mm256_fmadd_ps(a0, a0, vNorm0);
+    }
+
+    float norm = horizontalSum(_mm256_add_ps(vNorm0, vNorm1));
+    float corr = horizontalSum(_mm256_add_ps(vSum0, vSum1));
+    anorm = norm;
+
+    return (double)corr / sqrt(norm < 1e-9 ? 1.0 : norm);
+}
+
+
+double TDStretchAVX2::calcCrossCorrAccumulate(const float *pV1, const float *pV2, double &norm)
+{
+    // as with SSE, recomputing the norm along with the correlation is cheaper
+    // than the rolling update once the loop is vectorized
+    return calcCrossCorr(pV1, pV2, norm);
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInput'. Processes four
+// stereo frames per vector, with fade gains [k k k+1 k+1 ...] / overlapLength.
+ST_AVX2_TARGET void TDStretchAVX2::overlapStereo(float *pOutput, const float *pInput) const
+{
+    const __m256 vScale = _mm256_set1_ps(1.0f / (float)overlapLength);
+    const __m256 vStep = _mm256_set1_ps(4.0f);
+    const __m256 vOne = _mm256_set1_ps(1.0f);
+    __m256 vIndex = _mm256_setr_ps(0, 0, 1, 1, 2, 2, 3, 3);
+
+    assert((overlapLength % 8) == 0);
+
+    for (int i = 0; i < 2 * overlapLength; i += 8)
+    {
+        __m256 f1 = _mm256_mul_ps(vIndex, vScale);
+        __m256 f2 = _mm256_sub_ps(vOne, f1);
+        __m256 mid = _mm256_mul_ps(_mm256_loadu_ps(pMidBuffer + i), f2);
+        _mm256_storeu_ps(pOutput + i, _mm256_fmadd_ps(_mm256_loadu_ps(pInput + i), f1, mid));
+        vIndex = _mm256_add_ps(vIndex, vStep);
+    }
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInput', mono version
+ST_AVX2_TARGET void TDStretchAVX2::overlapMono(float *pOutput, const float *pInput) const
+{
+    const __m256 vScale = _mm256_set1_ps(1.0f / (float)overlapLength);
+    const __m256 vStep = _mm256_set1_ps(8.0f);
+    const __m256 vOne = _mm256_set1_ps(1.0f);
+    __m256 vIndex = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+
+    assert((overlapLength % 8) == 0);
+
+    for (int i = 0; i < overlapLength; i += 8)
+    {
+        __m256 f1 = _mm256_mul_ps(vIndex, vScale);
+        __m256 f2 = _mm256_sub_ps(vOne, f1);
+        __m256 mid = _mm256_mul_ps(_mm256_loadu_ps(pMidBuffer + i), f2);
+        _mm256_storeu_ps(pOutput + i, _mm256_fmadd_ps(_mm256_loadu_ps(pInput + i), f1, mid));
+        vIndex = _mm256_add_ps(vIndex, vStep);
+    }
+}
+
+
+// Dot product for the fast seek. Separate multiply and add, not FMA: the
+// lanes then round exactly like the plain C version's partial sums
+ST_AVX2_TARGET float TDStretchAVX2::dotProduct(const float *a, const float *b, int length) const
+{
+    __m256 vSum0 = _mm256_setzero_ps();
+    __m256 vSum1 = _mm256_setzero_ps();
+    int i;
+
+    for (i = 0; i + 16 <= length; i += 16)
+    {
+        vSum0 = _mm256_add_ps(vSum0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        vSum1 = _mm256_add_ps(vSum1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+
+    float part[16];
+    _mm256_storeu_ps(part, vSum0);
+    _mm256_storeu_ps(part + 8, vSum1);
+    for (int j = 0; i < length; i ++, j ++)
+    {
+        part[j] += a[i] * b[i];
+    }
+    return reduceDotProduct(part);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of AVX2 optimized functions of class 'FIRFilterAVX2'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "FIRFilter.h"
+
+// AVX2-optimized version of the filter routine for stereo sound. Evaluates two
+// stereo output frames per pass like the SSE version, eight taps at a time.
+ST_AVX2_TARGET uint FIRFilterAVX2::evaluateFilterStereo(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)((numSamples - length) & (uint)-2);
+    int j;
+
+    if (count < 2) return 0;
+
+    assert(source != nullptr);
+    assert(dest != nullptr);
+    assert((length % 8) == 0);
+    assert(filterCoeffsStereo != nullptr);
+
+    #pragma omp parallel for
+    for (j = 0; j < count; j += 2)
+    {
+        const float *pSrc = source + j * 2;
+        const float *pFil = filterCoeffsStereo;
+        __m256 sum1 = _mm256_setzero_ps();
+        __m256 sum2 = _mm256_setzero_ps();
+
+        // 'filterCoeffsStereo' holds each tap twice, matching the L/R layout
+        for (uint i = 0; i < 2 * length; i += 8)
+        {
+            __m256 fil = _mm256_loadu_ps(pFil + i);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + i), fil, sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + i + 2), fil, sum2);
+        }
+
+        // fold to [l r l r] per output frame, then combine as in the SSE version
+        __m128 s1 = _mm_add_ps(_mm256_castps256_ps128(sum1), _mm256_extractf128_ps(sum1, 1));
+        __m128 s2 = _mm_add_ps(_mm256_castps256_ps128(sum2), _mm256_extractf128_ps(sum2, 1));
+        _mm_storeu_ps(dest + j * 2, _mm_add_ps(
+                    _mm_shuffle_ps(s1, s2, _MM_SHUFFLE(1,0,3,2)),
+                    _mm_shuffle_ps(s1, s2, _MM_SHUFFLE(3,2,1,0))));
+    }
+
+    return (uint)count;
+}
+
+
+// AVX2-optimized version of the filter routine for mono sound. Evaluates four
+// outputs per pass so that each coefficient load is shared.
+ST_AVX2_TARGET uint FIRFilterAVX2::evaluateFilterMono(float *dest, const float *source, uint numSamples) const
+{
+    int end = (int)(numSamples - length);
+    int j;
+
+    assert(source != nullptr);
+    assert(dest != nullptr);
+    assert((length % 8) == 0);
+    assert(filterCoeffs != nullptr);
+
+    for (j = 0; j + 4 <= end; j += 4)
+    {
+        const float *pSrc = source + j;
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        __m256 sum2 = _mm256_setzero_ps();
+        __m256 sum3 = _mm256_setzero_ps();
+
+        for (uint i = 0; i < length; i += 8)
+        {
+            __m256 fil = _mm256_loadu_ps(filterCoeffs + i);
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + i), fil, sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + i + 1), fil, sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + i + 2), fil, sum2);
+            sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + i + 3), fil, sum3);
+        }
+        dest[j + 0] = horizontalSum(sum0);
+        dest[j + 1] = horizontalSum(sum1);
+        dest[j + 2] = horizontalSum(sum2);
+        dest[j + 3] = horizontalSum(sum3);
+    }
+
+    for (; j < end; j ++)
+    {
+        const float *pSrc = source + j;
+        __m256 sum = _mm256_setzero_ps();
+
+        for (uint i = 0; i < length; i += 8)
+        {
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + i), _mm256_loadu_ps(filterCoeffs + i), sum);
+        }
+        dest[j] = horizontalSum(sum);
+    }
+
+    return (uint)end;
+}
+
+#endif  // SOUNDTOUCH_ALLOW_AVX2
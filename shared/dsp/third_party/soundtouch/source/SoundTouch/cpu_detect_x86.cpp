@@ -38,10 +38,10 @@
 
 #if defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS)
 
-   #if defined(__GNUC__) && defined(__i386__)
+   #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
        // gcc
        #include "cpuid.h"
-   #elif defined(_M_IX86)
+   #elif defined(_M_IX86) || defined(_M_X64)
        // windows non-gcc
        #include <intrin.h>
    #endif
@@ -49,6 +49,12 @@
    #define bit_MMX     (1 << 23)
    #define bit_SSE     (1 << 25)
    #define bit_SSE2    (1 << 26)
+
+   // cpuid leaf 1 ecx, leaf 7 ebx
+   #define bit_FMA_ECX      (1 << 12)
+   #define bit_OSXSAVE_ECX  (1 << 27)
+   #define bit_AVX_ECX      (1 << 28)
+   #define bit_AVX2_EBX     (1 << 5)
 #endif
 
 
@@ -68,6 +74,50 @@ void disableExtensions(uint dwDisableMask)
 }
 
 
+#if defined(SOUNDTOUCH_ALLOW_AVX2)
+
+/// Checks for AVX2 and FMA support. Besides the cpuid feature bits this
+/// requires that the OS saves the YMM registers on context switch.
+static uint detectAVXextensions(void)
+{
+    uint leaf1[4] = {0};    // eax, ebx, ecx, edx
+    uint leaf7[4] = {0};
+
+#if defined(__GNUC__)
+    if (!__get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3])) return 0;
+    if (__get_cpuid_max(0, nullptr) < 7) return 0;
+    __cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+#else
+    int reg[4] = {0};
+    __cpuid(reg, 0);
+    if (reg[0] < 7) return 0;
+    __cpuid(reg, 1);
+    for (int i = 0; i < 4; i ++) leaf1[i] = (uint)reg[i];
+    __cpuidex(reg, 7, 0);
+    for (int i = 0; i < 4; i ++) leaf7[i] = (uint)reg[i];
+#endif
+
+    if (!(leaf1[2] & bit_OSXSAVE_ECX) || !(leaf1[2] & bit_AVX_ECX)) return 0;
+
+    // XCR0 bits 1 and 2: XMM and YMM state enabled by the OS
+#if defined(__GNUC__)
+    uint xcr0Lo, xcr0Hi;
+    __asm__ __volatile__ ("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+    (void)xcr0Hi;
+#else
+    uint xcr0Lo = (uint)_xgetbv(0);
+#endif
+    if ((xcr0Lo & 0x6) != 0x6) return 0;
+
+    uint res = 0;
+    if (leaf7[1] & bit_AVX2_EBX) res = res | SUPPORT_AVX2;
+    if (leaf1[2] & bit_FMA_ECX)  res = res | SUPPORT_FMA;
+    return res;
+}
+
+#endif // SOUNDTOUCH_ALLOW_AVX2
+
+
 /// Checks which instruction set extensions are supported by the CPU.
 uint detectCPUextensions(void)
 {
@@ -77,7 +127,13 @@ uint detectCPUextensions(void)
 #if ((defined(__GNUC__) && defined(__x86_64__)) \
     || defined(_M_X64))  \
     && defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS)
+#if defined(SOUNDTOUCH_ALLOW_AVX2)
+    // cpuid is slow-ish and the answer never changes, so query it only once
+    static const uint avxExtensions = detectAVXextensions();
+    return (0x19 | avxExtensions) & ~_dwDisabledISA;
+#else
     return 0x19 & ~_dwDisabledISA;
+#endif
 
 /// If building for a 32bit system and the user wants optimizations.
 /// Keep the _dwDisabledISA test (2 more operations, could be eliminated).
@@ -100,6 +156,10 @@ uint detectCPUextensions(void)
     if (edx & bit_SSE)  res = res | SUPPORT_SSE;
     if (edx & bit_SSE2) res = res | SUPPORT_SSE2;
 
+#if defined(SOUNDTOUCH_ALLOW_AVX2)
+    if (res & SUPPORT_SSE2) res = res | detectAVXextensions();
+#endif
+
 #else
     // Window / VS version of cpuid. Notice that Visual Studio 2005 or later required
     // for __cpuid intrinsic support.
@@ -114,6 +174,10 @@ uint detectCPUextensions(void)
     if ((unsigned int)reg[3] & bit_SSE)  res = res | SUPPORT_SSE;
     if ((unsigned int)reg[3] & bit_SSE2) res = res | SUPPORT_SSE2;
 
+#if defined(SOUNDTOUCH_ALLOW_AVX2)
+    if (res & SUPPORT_SSE2) res = res | detectAVXextensions();
+#endif
+
 #endif
 
     return res & ~_dwDisabledISA;
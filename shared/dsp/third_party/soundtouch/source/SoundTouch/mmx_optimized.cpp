@@ -305,6 +305,14 @@ FIRFilterMMX::~FIRFilterMMX()
 }
 
 
+// Base tables plus the rearranged copy for the MMX routine
+uint FIRFilterMMX::getMemoryUsage() const
+{
+    return FIRFilter::getMemoryUsage() + (uint)(sizeof(*this) - sizeof(FIRFilter)) +
+           (filterCoeffsUnalign ? (2 * length + 8) * (uint)sizeof(short) : 0);
+}
+
+
 // (overloaded) Calculates filter coefficients for MMX routine
 void FIRFilterMMX::setCoefficients(const short *coeffs, uint newLength, uint uResultDivFactor)
 {
@@ -208,6 +208,14 @@ FIRFilterSSE::~FIRFilterSSE()
 }
 
 
+// Base tables plus the rearranged copy for the SSE routine
+uint FIRFilterSSE::getMemoryUsage() const
+{
+    return FIRFilter::getMemoryUsage() + (uint)(sizeof(*this) - sizeof(FIRFilter)) +
+           (filterCoeffsUnalign ? (2 * length + 4) * (uint)sizeof(float) : 0);
+}
+
+
 // (overloaded) Calculates filter coefficients for SSE routine
 void FIRFilterSSE::setCoefficients(const float *coeffs, uint newLength, uint uResultDivFactor)
 {
@@ -362,4 +370,334 @@ uint FIRFilterSSE::evaluateFilterStereo(float *dest, const float *source, uint n
     */
 }
 
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SSE optimized functions of the interpolating transposers
+// 'InterpolateLinearFloatSSE', 'InterpolateCubicSSE', 'InterpolateShannonSSE'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "InterpolateLinear.h"
+#include "InterpolateCubic.h"
+#include "InterpolateShannon.h"
+
+// Read positions of up to four outputs. The C transposers advance the position
+// one output at a time, a serial add/truncate/subtract chain that costs more
+// than the interpolation itself; here each lane is offset from the current
+// position independently, and the chain is only walked once per four outputs.
+// Returns the number of outputs that fit before 'srcSampleEnd'. Lanes past that
+// count repeat the last valid position, so the loads they cause stay in bounds.
+static inline int nextPositions(double &fract, double rate, int &srcCount, int srcSampleEnd,
+                                int offset[4], float frac[4])
+{
+    assert(fract < 1.0);
+    int count = 0;
+    for (int k = 0; k < 4; k ++)
+    {
+        const double pos = fract + k * rate;
+        const int whole = (int)pos;
+        if (srcCount + whole >= srcSampleEnd) break;
+        offset[k] = srcCount + whole;
+        frac[k] = (float)(pos - whole);
+        count ++;
+    }
+    for (int k = count; (k < 4) && (count > 0); k ++)
+    {
+        offset[k] = offset[count - 1];
+        frac[k] = frac[count - 1];
+    }
+
+    // advance past the produced outputs
+    const double next = fract + count * rate;
+    const int whole = (int)next;
+    fract = next - whole;
+    srcCount += whole;
+    return count;
+}
+
+
+// Stores the first 'count' lanes of 'v' to 'dest'
+static inline void storeLanes(float *dest, __m128 v, int count)
+{
+    if (count == 4)
+    {
+        _mm_storeu_ps(dest, v);
+    }
+    else
+    {
+        float temp[4];
+        _mm_storeu_ps(temp, v);
+        for (int k = 0; k < count; k ++) dest[k] = temp[k];
+    }
+}
+
+
+// Stereo output of one position: 'a' holds frames 0-1 and 'b' frames 2-3 of the
+// interleaved input, 'c' the four tap weights [w0 w1 w2 w3]. Writes the left
+// and right result to dest[0..1].
+static inline void storeStereo4(float *dest, __m128 a, __m128 b, __m128 c)
+{
+    __m128 sum = _mm_add_ps(_mm_mul_ps(a, _mm_unpacklo_ps(c, c)),
+                            _mm_mul_ps(b, _mm_unpackhi_ps(c, c)));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    _mm_storel_pi((__m64 *)dest, sum);
+}
+
+
+int InterpolateLinearFloatSSE::transposeMono(float *pdest, const float *psrc, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 1;
+    int srcCount = 0;
+    int offset[4];
+    float frac[4];
+    int i = 0;
+    int count;
+
+    while ((count = nextPositions(fract, rate, srcCount, srcSampleEnd, offset, frac)) > 0)
+    {
+        const __m128 x0 = _mm_setr_ps(psrc[offset[0]], psrc[offset[1]], psrc[offset[2]], psrc[offset[3]]);
+        const __m128 x1 = _mm_setr_ps(psrc[offset[0] + 1], psrc[offset[1] + 1],
+                                      psrc[offset[2] + 1], psrc[offset[3] + 1]);
+        const __m128 f = _mm_loadu_ps(frac);
+
+        // (1 - f) * x0 + f * x1
+        storeLanes(pdest + i, _mm_add_ps(x0, _mm_mul_ps(f, _mm_sub_ps(x1, x0))), count);
+        i += count;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+int InterpolateLinearFloatSSE::transposeStereo(float *pdest, const float *psrc, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 1;
+    int srcCount = 0;
+    int offset[4];
+    float frac[4];
+    int i = 0;
+    int count;
+
+    while ((count = nextPositions(fract, rate, srcCount, srcSampleEnd, offset, frac)) > 0)
+    {
+        for (int k = 0; k < count; k ++)
+        {
+            // [L0 R0 L1 R1] * [1-f 1-f f f], then fold the halves
+            const __m128 x = _mm_loadu_ps(psrc + 2 * offset[k]);
+            const __m128 w = _mm_setr_ps(1.0f - frac[k], 1.0f - frac[k], frac[k], frac[k]);
+            __m128 sum = _mm_mul_ps(x, w);
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            _mm_storel_pi((__m64 *)(pdest + 2 * (i + k)), sum);
+        }
+        i += count;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+// Cubic coefficients for four fractions at once, same polynomials as the
+// '_coeffs' table of the plain C version
+static inline void cubicWeights(__m128 x, __m128 &y0, __m128 &y1, __m128 &y2, __m128 &y3)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 x2 = _mm_mul_ps(x, x);
+    const __m128 x3 = _mm_mul_ps(x2, x);
+    const __m128 hx = _mm_mul_ps(half, x);
+    const __m128 hx2 = _mm_mul_ps(half, x2);
+    const __m128 hx3 = _mm_mul_ps(half, x3);
+
+    // y0 = -0.5x^3 + x^2 - 0.5x
+    y0 = _mm_sub_ps(_mm_sub_ps(x2, hx3), hx);
+    // y1 = 1.5x^3 - 2.5x^2 + 1
+    y1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(1.5f), x3), _mm_mul_ps(_mm_set1_ps(2.5f), x2)),
+                    _mm_set1_ps(1.0f));
+    // y2 = -1.5x^3 + 2x^2 + 0.5x
+    y2 = _mm_add_ps(_mm_sub_ps(_mm_add_ps(x2, x2), _mm_mul_ps(_mm_set1_ps(1.5f), x3)), hx);
+    // y3 = 0.5x^3 - 0.5x^2
+    y3 = _mm_sub_ps(hx3, hx2);
+}
+
+
+int InterpolateCubicSSE::transposeMono(float *pdest, const float *psrc, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 4;
+    int srcCount = 0;
+    int offset[4];
+    float frac[4];
+    int i = 0;
+    int count;
+
+    while ((count = nextPositions(fract, rate, srcCount, srcSampleEnd, offset, frac)) > 0)
+    {
+        __m128 y0, y1, y2, y3;
+        cubicWeights(_mm_loadu_ps(frac), y0, y1, y2, y3);
+
+        // rows hold the four taps of one output; transposed, each register
+        // holds one tap of all four outputs
+        __m128 t0 = _mm_loadu_ps(psrc + offset[0]);
+        __m128 t1 = _mm_loadu_ps(psrc + offset[1]);
+        __m128 t2 = _mm_loadu_ps(psrc + offset[2]);
+        __m128 t3 = _mm_loadu_ps(psrc + offset[3]);
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+
+        __m128 out = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y0, t0), _mm_mul_ps(y1, t1)),
+                                _mm_add_ps(_mm_mul_ps(y2, t2), _mm_mul_ps(y3, t3)));
+        storeLanes(pdest + i, out, count);
+        i += count;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+int InterpolateCubicSSE::transposeStereo(float *pdest, const float *psrc, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 4;
+    int srcCount = 0;
+    int offset[4];
+    float frac[4];
+    int i = 0;
+    int count;
+
+    while ((count = nextPositions(fract, rate, srcCount, srcSampleEnd, offset, frac)) > 0)
+    {
+        __m128 y0, y1, y2, y3;
+        cubicWeights(_mm_loadu_ps(frac), y0, y1, y2, y3);
+        // one register of tap weights [y0 y1 y2 y3] per output
+        _MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+        const __m128 weights[4] = { y0, y1, y2, y3 };
+
+        for (int k = 0; k < count; k ++)
+        {
+            const float *src = psrc + 2 * offset[k];
+            storeStereo4(pdest + 2 * (i + k), _mm_loadu_ps(src), _mm_loadu_ps(src + 4), weights[k]);
+        }
+        i += count;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+// Kaiser window of the plain C version with the sign of sin(pi * (k - 3 - f))
+// relative to sin(pi * f) and the 1/pi of the sinc folded in
+static const double _invPi = 1.0 / 3.1415926536;
+static const float _shannonGain[8] =
+{
+    (float)( 0.41778693317814 * _invPi),
+    (float)(-0.64888025049173 * _invPi),
+    (float)( 0.83508562409944 * _invPi),
+    (float)(-0.93887857733412 * _invPi),
+    (float)( 0.93887857733412 * _invPi),
+    (float)(-0.83508562409944 * _invPi),
+    (float)( 0.64888025049173 * _invPi),
+    (float)(-0.41778693317814 * _invPi)
+};
+
+
+// Windowed sinc weights for four fractions at once. With s = sin(pi * f) the
+// tap at distance d = k - 3 - f has sin(pi * d) = (-1)^k * s, so one sine per
+// fraction serves all eight taps.
+static inline void shannonWeights(__m128 f, __m128 w[8])
+{
+    // sin(pi * f) = cos(pi * (f - 0.5)); Taylor series of cos to t^12 on |t| <= pi/2
+    const __m128 t = _mm_mul_ps(_mm_sub_ps(f, _mm_set1_ps(0.5f)), _mm_set1_ps(3.1415926536f));
+    const __m128 t2 = _mm_mul_ps(t, t);
+    __m128 s = _mm_set1_ps(1.0f / 479001600.0f);
+    s = _mm_add_ps(_mm_mul_ps(s, t2), _mm_set1_ps(-1.0f / 3628800.0f));
+    s = _mm_add_ps(_mm_mul_ps(s, t2), _mm_set1_ps(1.0f / 40320.0f));
+    s = _mm_add_ps(_mm_mul_ps(s, t2), _mm_set1_ps(-1.0f / 720.0f));
+    s = _mm_add_ps(_mm_mul_ps(s, t2), _mm_set1_ps(1.0f / 24.0f));
+    s = _mm_add_ps(_mm_mul_ps(s, t2), _mm_set1_ps(-0.5f));
+    s = _mm_add_ps(_mm_mul_ps(s, t2), _mm_set1_ps(1.0f));
+
+    for (int k = 0; k < 8; k ++)
+    {
+        const __m128 d = _mm_sub_ps(_mm_set1_ps((float)(k - 3)), f);
+        w[k] = _mm_div_ps(_mm_mul_ps(_mm_set1_ps(_shannonGain[k]), s), d);
+    }
+
+    // centre tap: sinc(0) = 1 where the fraction is (nearly) zero
+    const __m128 nearZero = _mm_cmplt_ps(f, _mm_set1_ps(1e-5f));
+    w[3] = _mm_or_ps(_mm_and_ps(nearZero, _mm_set1_ps(0.93887857733412f)),
+                     _mm_andnot_ps(nearZero, w[3]));
+}
+
+
+int InterpolateShannonSSE::transposeMono(float *pdest, const float *psrc, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 8;
+    int srcCount = 0;
+    int offset[4];
+    float frac[4];
+    int i = 0;
+    int count;
+
+    while ((count = nextPositions(fract, rate, srcCount, srcSampleEnd, offset, frac)) > 0)
+    {
+        __m128 w[8];
+        shannonWeights(_mm_loadu_ps(frac), w);
+
+        __m128 t0 = _mm_loadu_ps(psrc + offset[0]);
+        __m128 t1 = _mm_loadu_ps(psrc + offset[1]);
+        __m128 t2 = _mm_loadu_ps(psrc + offset[2]);
+        __m128 t3 = _mm_loadu_ps(psrc + offset[3]);
+        __m128 t4 = _mm_loadu_ps(psrc + offset[0] + 4);
+        __m128 t5 = _mm_loadu_ps(psrc + offset[1] + 4);
+        __m128 t6 = _mm_loadu_ps(psrc + offset[2] + 4);
+        __m128 t7 = _mm_loadu_ps(psrc + offset[3] + 4);
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+        _MM_TRANSPOSE4_PS(t4, t5, t6, t7);
+
+        __m128 lo = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[0], t0), _mm_mul_ps(w[1], t1)),
+                               _mm_add_ps(_mm_mul_ps(w[2], t2), _mm_mul_ps(w[3], t3)));
+        __m128 hi = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[4], t4), _mm_mul_ps(w[5], t5)),
+                               _mm_add_ps(_mm_mul_ps(w[6], t6), _mm_mul_ps(w[7], t7)));
+        storeLanes(pdest + i, _mm_add_ps(lo, hi), count);
+        i += count;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+int InterpolateShannonSSE::transposeStereo(float *pdest, const float *psrc, int &srcSamples)
+{
+    int srcSampleEnd = srcSamples - 8;
+    int srcCount = 0;
+    int offset[4];
+    float frac[4];
+    int i = 0;
+    int count;
+
+    while ((count = nextPositions(fract, rate, srcCount, srcSampleEnd, offset, frac)) > 0)
+    {
+        __m128 w[8];
+        shannonWeights(_mm_loadu_ps(frac), w);
+        // per output: taps 0-3 in 'lo', taps 4-7 in 'hi'
+        _MM_TRANSPOSE4_PS(w[0], w[1], w[2], w[3]);
+        _MM_TRANSPOSE4_PS(w[4], w[5], w[6], w[7]);
+
+        for (int k = 0; k < count; k ++)
+        {
+            const float *src = psrc + 2 * offset[k];
+            const __m128 lo = w[k];
+            const __m128 hi = w[k + 4];
+            __m128 sum = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src), _mm_unpacklo_ps(lo, lo)),
+                           _mm_mul_ps(_mm_loadu_ps(src + 4), _mm_unpackhi_ps(lo, lo))),
+                _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + 8), _mm_unpacklo_ps(hi, hi)),
+                           _mm_mul_ps(_mm_loadu_ps(src + 12), _mm_unpackhi_ps(hi, hi))));
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            _mm_storel_pi((__m64 *)(pdest + 2 * (i + k)), sum);
+        }
+        i += count;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
 #endif  // SOUNDTOUCH_ALLOW_SSE
@@ -0,0 +1,227 @@
+/**
+ * audioshift_convert — convert a PCM stream to 432 Hz, stdin to stdout
+ *
+ * For batch jobs in a pipe:
+ *   ffmpeg -i in.mp3 -f wav - | audioshift_convert | flac -o out.flac -
+ *
+ * Reading, conversion and writing run on separate threads (see
+ * src/stream_convert.h), so throughput is bounded by the pitch-shift engine alone.
+ *
+ * For a whole library, on every core (see src/batch_convert.h):
+ *   audioshift_convert -d out -C ~/.cache/audioshift *.wav
+ *
+ * Usage:
+ *   audioshift_convert [-f raw|wav] [-o raw|wav] [-r rate] [-c channels]
+ *                      [-s semitones] [-b frames] [-q depth] [-v]
+ *                      [input [output]]
+ *   audioshift_convert -d outdir [-f raw|wav] [-r rate] [-c channels]
+ *                      [-s semitones] [-j threads] [-k seconds] [-C cachedir]
+ *                      [-v] file...
+ *
+ *   input, output  Files to use instead of stdin / stdout ("-" for either)
+ *   -f             Input format (default: WAV if it has a RIFF header, else raw)
+ *   -o             Output format (default: same as input)
+ *   -r, -c         Sample rate and channels of raw input (default 48000, 2)
+ *   -s semitones   Pitch shift (default 12·log2(432/440))
+ *   -b frames      Frames per buffer (default 16384)
+ *   -q depth       Buffers in flight between stages (default 4)
+ *   -d outdir      Batch mode: convert each file to outdir/<its name>
+ *   -j threads     Batch workers (default: one per CPU)
+ *   -k seconds     Batch chunk length for long files (default 20)
+ *   -C cachedir    Batch cache: unchanged inputs are not converted again
+ *   -v             Report speed and time split on stderr
+ */
+
+#include "batch_convert.h"
+#include "stream_convert.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace audioshift::dsp;
+
+namespace
+{
+
+bool parseFormat(const char* arg, StreamFormat& format)
+{
+    if (strcmp(arg, "raw") == 0) format = StreamFormat::kRaw;
+    else if (strcmp(arg, "wav") == 0) format = StreamFormat::kWav;
+    else return false;
+    return true;
+}
+
+void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-f raw|wav] [-o raw|wav] [-r rate] [-c channels] [-s semitones]\n"
+            "          [-b frames] [-q depth] [-v] [input [output]]\n"
+            "       %s -d outdir [-f raw|wav] [-r rate] [-c channels] [-s semitones]\n"
+            "          [-j threads] [-k seconds] [-C cachedir] [-v] file...\n",
+            argv0, argv0);
+}
+
+const char* describe(int err)
+{
+    return err == -EINVAL ? "unsupported input (16-bit PCM, 8-192 kHz, 1-8 channels)"
+                          : strerror(-err);
+}
+
+int runBatch(const std::string& outDir, const BatchOptions& options, char** files, int count,
+             bool verbose)
+{
+    std::vector<BatchJob> jobs;
+    for (int i = 0; i < count; i++)
+    {
+        const char* slash = strrchr(files[i], '/');
+        BatchJob job;
+        job.input = files[i];
+        job.output = outDir + "/" + (slash ? slash + 1 : files[i]);
+        jobs.push_back(job);
+    }
+
+    BatchStats stats;
+    const int err = batchConvert(jobs, options, &stats);
+    for (const BatchJob& job : jobs)
+    {
+        if (job.status) fprintf(stderr, "%s: %s\n", job.input.c_str(), describe(job.status));
+    }
+
+    if (verbose)
+    {
+        fprintf(stderr,
+                "%d converted, %d cached, %d failed: %llu chunks, %llu stolen, "
+                "%.1f s of audio in %.2f s (%.0fx real time)\n",
+                stats.converted, stats.cached, stats.failed,
+                static_cast<unsigned long long>(stats.chunks),
+                static_cast<unsigned long long>(stats.steals), stats.audioSeconds, stats.wallSeconds,
+                stats.wallSeconds > 0 ? stats.audioSeconds / stats.wallSeconds : 0.0);
+    }
+    return err ? 1 : 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    StreamOptions options;
+    BatchOptions batch;
+    std::string outDir;
+    bool verbose = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:o:r:c:s:b:q:d:j:k:C:vh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            if (!parseFormat(optarg, options.inputFormat)) opt = '?';
+            break;
+        case 'o':
+            if (!parseFormat(optarg, options.outputFormat)) opt = '?';
+            break;
+        case 'r':
+            options.sampleRate = atoi(optarg);
+            break;
+        case 'c':
+            options.channels = atoi(optarg);
+            break;
+        case 's':
+            options.pitchSemitones = static_cast<float>(atof(optarg));
+            break;
+        case 'b':
+            options.blockFrames = atoi(optarg);
+            break;
+        case 'q':
+            options.queueDepth = atoi(optarg);
+            break;
+        case 'd':
+            outDir = optarg;
+            break;
+        case 'j':
+            batch.threads = atoi(optarg);
+            break;
+        case 'k':
+            batch.chunkSeconds = atof(optarg);
+            break;
+        case 'C':
+            batch.cacheDir = optarg;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            break;
+        }
+        if (opt == '?' || opt == 'h')
+        {
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (!outDir.empty())
+    {
+        batch.inputFormat = options.inputFormat;
+        batch.sampleRate = options.sampleRate;
+        batch.channels = options.channels;
+        batch.pitchSemitones = options.pitchSemitones;
+        if (batch.chunkSeconds <= 0.0 || optind == argc)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        return runBatch(outDir, batch, argv + optind, argc - optind, verbose);
+    }
+
+    int inFd = STDIN_FILENO;
+    int outFd = STDOUT_FILENO;
+    if (optind < argc && strcmp(argv[optind], "-") != 0)
+    {
+        inFd = open(argv[optind], O_RDONLY | O_CLOEXEC);
+        if (inFd < 0)
+        {
+            fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+            return 1;
+        }
+    }
+    if (optind + 1 < argc && strcmp(argv[optind + 1], "-") != 0)
+    {
+        outFd = open(argv[optind + 1], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (outFd < 0)
+        {
+            fprintf(stderr, "%s: %s\n", argv[optind + 1], strerror(errno));
+            return 1;
+        }
+    }
+    if (isatty(outFd))
+    {
+        fprintf(stderr, "refusing to write audio to a terminal\n");
+        return 2;
+    }
+
+    StreamStats stats;
+    const int err = streamConvert(inFd, outFd, options, &stats);
+    if (err)
+    {
+        fprintf(stderr, "audioshift_convert: %s\n", describe(err));
+        return 1;
+    }
+
+    if (verbose && stats.sampleRate > 0)
+    {
+        const double audio = static_cast<double>(stats.framesIn) / stats.sampleRate;
+        fprintf(stderr,
+                "%d Hz, %d ch: %.1f s of audio in %.2f s (%.0fx real time), "
+                "engine busy %.0f%%\n",
+                stats.sampleRate, stats.channels, audio, stats.wallSeconds,
+                stats.wallSeconds > 0 ? audio / stats.wallSeconds : 0.0,
+                stats.wallSeconds > 0 ? 100.0 * stats.convertSeconds / stats.wallSeconds : 0.0);
+    }
+    return 0;
+}
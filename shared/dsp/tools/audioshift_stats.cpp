@@ -0,0 +1,152 @@
+/**
+ * audioshift_stats — dump the effect's shared-memory statistics page
+ *
+ * Maps the page published by the effect (see src/stats_page.h) read-only
+ * and prints it, once or periodically. Reading takes no locks and makes no
+ * binder calls, so it can sample at high rates without disturbing audio.
+ *
+ * Usage:
+ *   audioshift_stats [-i interval_ms] [-n count] [path]
+ *
+ *   path          Page to read (default /data/vendor/audioshift/stats, or
+ *                 /proc/<pid>/fd/<n> when the effect fell back to a memfd)
+ *   -i ms         Repeat every 'ms' milliseconds
+ *   -n count      Stop after 'count' samples (default 1, or forever with -i)
+ */
+
+#include "stats_page.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <unistd.h>
+
+using namespace audioshift::dsp;
+
+namespace
+{
+
+const char* const PROFILES[] = {"music", "voip", "game"};
+
+// Upper bound in µs of the histogram bucket holding the given quantile
+unsigned quantileUs(const InstanceStats& s, double q)
+{
+    uint64_t total = 0;
+    for (uint32_t n : s.histogram) total += n;
+    if (total == 0) return 0;
+
+    uint64_t seen = 0;
+    for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++)
+    {
+        seen += s.histogram[b];
+        if (seen >= q * total)
+        {
+            return STATS_HISTOGRAM_BASE_US << b;
+        }
+    }
+    return STATS_HISTOGRAM_BASE_US << (STATS_HISTOGRAM_BUCKETS - 1);
+}
+
+const char* state(const InstanceStats& s)
+{
+    if (!(s.flags & kStatsEnabled)) return "off";
+    if (s.flags & kStatsAutoBypassed) return "bypass";
+    return (s.flags & kStatsEngineAllocated) ? "on" : "no-mem";
+}
+
+// Instances running a shadow engine: its cost and output against the backend's
+void dumpShadows(const StatsPage& page)
+{
+    printf("\nshadow engines:\n%5s %6s %8s %8s %6s %8s\n", "id", "cost", "SNR dB", "pitch ¢", "lag",
+           "dropped");
+    for (int slot = 0; slot < STATS_MAX_INSTANCES; slot++)
+    {
+        InstanceStats s;
+        if (!page.read(slot, s) || !(s.flags & kStatsShadow)) continue;
+        printf("%5u %5.2fx %8.1f %8.1f %6d %8llu\n", s.id, s.shadowCost, s.shadowSnrDb, s.shadowCents,
+               s.shadowLag, static_cast<unsigned long long>(s.shadowDropped));
+    }
+}
+
+void dump(const StatsPage& page)
+{
+    const GlobalStats& g = page.global();
+    printf("instances: %u live, %llu created, %u unmonitored\n",
+           g.liveInstances.load(), static_cast<unsigned long long>(g.instancesCreated.load()),
+           g.droppedInstances.load());
+    printf("%5s %-6s %-5s %6s %2s %10s %8s %6s %6s %6s %7s %8s %8s %7s %8s\n", "id", "state",
+           "prof", "rate", "ch", "callbacks", "underrun", "duty", "last", "max", "max/avg",
+           "p50 µs", "p99 µs", "lat ms", "A4 Hz");
+
+    uint64_t busyNs = 0;
+    uint64_t audioNs = 0;
+    bool shadows = false;
+    for (int slot = 0; slot < STATS_MAX_INSTANCES; slot++)
+    {
+        InstanceStats s;
+        if (!page.read(slot, s)) continue;
+        shadows = shadows || (s.flags & kStatsShadow);
+        busyNs += s.busyNs;
+        audioNs += s.audioNs;
+        const double duty = s.audioNs ? 100.0 * s.busyNs / s.audioNs : 0.0;
+        // Worst callback against the average one: how evenly the engine
+        // spreads its work, whatever the absolute load
+        const double peakToMean = duty > 0.0 ? 100.0 * s.maxDutyCycle / duty : 0.0;
+        printf("%5u %-6s %-5s %6d %2d %10llu %8llu %5.1f%% %5.1f%% %5.1f%% %7.2f %8u %8u %7.2f %8.2f\n",
+               s.id, state(s), s.profile >= 0 && s.profile < 3 ? PROFILES[s.profile] : "?",
+               s.sampleRate, s.channels, static_cast<unsigned long long>(s.callbacks),
+               static_cast<unsigned long long>(s.underruns), duty, 100.0 * s.dutyCycle,
+               100.0 * s.maxDutyCycle, peakToMean, quantileUs(s, 0.5), quantileUs(s, 0.99), s.latencyMs,
+               s.tuningHz);
+    }
+    printf("total duty cycle: %.2f%%\n", audioNs ? 100.0 * busyNs / audioNs : 0.0);
+    if (shadows)
+    {
+        dumpShadows(page);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    int intervalMs = 0;
+    long count = -1;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            intervalMs = atoi(optarg);
+            break;
+        case 'n':
+            count = atol(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-i interval_ms] [-n count] [path]\n", argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    const char* path = optind < argc ? argv[optind] : STATS_PAGE_PATH;
+    if (count < 0) count = intervalMs > 0 ? 0 : 1;
+
+    std::unique_ptr<StatsPage> page(StatsPage::openReadOnly(path));
+    if (!page)
+    {
+        fprintf(stderr, "%s: missing or not an AudioShift stats page\n", path);
+        return 1;
+    }
+
+    for (long n = 0; count == 0 || n < count; n++)
+    {
+        if (n > 0)
+        {
+            usleep(static_cast<useconds_t>(intervalMs) * 1000);
+            printf("\n");
+        }
+        dump(*page);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -19,7 +19,7 @@
  *
  * Struct under test: audioshift::AudioShiftContext  (audioshift_hook.h)
  * UUID table:        AUDIOSHIFT_EFFECT_IMPL_UUID / TYPE_UUID
- * Constants table:   PITCH_RATIO_432_HZ, DEFAULT_*, MAX_*
+ * Constants table:   PITCH_RATIO_432_HZ, DEFAULT_*, MAX_LATENCY_MS
  */
 
 #include <gtest/gtest.h>
@@ -53,10 +53,26 @@ typedef struct
 
 typedef struct
 {
-    uint32_t sample_rate;
-    uint32_t channel_mask;
+    void *getBuffer;
+    void *releaseBuffer;
+    void *cookie;
+} host_buffer_provider_t;
+
+typedef struct
+{
+    host_buffer_provider_t bufferProvider;
+    uint32_t samplingRate;
+    uint32_t channels;
     uint8_t format;
-} host_audio_config_t;
+    uint8_t accessMode;
+    uint16_t mask;
+} host_buffer_config_t;
+
+typedef struct
+{
+    host_buffer_config_t inputCfg;
+    host_buffer_config_t outputCfg;
+} host_effect_config_t;
 
 // ── Replicated AudioShiftContext (must mirror audioshift_hook.h) ─────────
 //
@@ -64,29 +80,28 @@ typedef struct
 //   is a breaking ABI change that must also be reflected in audio_effects_audioshift.xml
 //   and Android's audio_policy_configuration.xml.
 
-constexpr int HOST_MAX_FRAME_SIZE = 8192;
-constexpr int HOST_DEFAULT_CHANNELS = 2;
+//   The shared effect core (dsp::Effect) is opaque here: its layout is the
+//   DSP library's business and never crosses the effect API. Its behaviour
+//   under the effect commands is tested in shared/dsp/tests.
+
+struct HostEffectCore
+{
+    alignas(alignof(void *)) unsigned char opaque[1];
+};
 
 struct HostAudioShiftContext
 {
     const effect_interface_s *itfe; // MUST be first — ABI requirement
-    host_audio_config_t config;
-    bool enabled;
-    float pitchSemitones;
-    void *soundtouch;
-    float floatBuf[HOST_MAX_FRAME_SIZE * HOST_DEFAULT_CHANNELS];
-    float lastLatencyMs;
-    float lastCpuPercent;
-    uint64_t frameCount;
+    host_effect_config_t config;     // last accepted EFFECT_CMD_SET_CONFIG
+    HostEffectCore core;
 };
 
 // ── Replicated constants (must equal audioshift::* from audioshift_hook.h) ──
 
 constexpr float HOST_PITCH_RATIO_432_HZ = 432.0f / 440.0f;
-constexpr float HOST_PITCH_SEMITONES_432_HZ = -0.3164f;
+constexpr float HOST_PITCH_SEMITONES_432_HZ = -0.31767f;
 constexpr int HOST_DEFAULT_SAMPLE_RATE = 48000;
-constexpr int HOST_DEFAULT_CHANNELS_CONST = 2;
-constexpr int HOST_MAX_FRAME_SIZE_CONST = 8192;
+constexpr int HOST_DEFAULT_CHANNELS = 2;
 constexpr float HOST_MAX_LATENCY_MS = 20.0f;
 
 // ── Replicated UUIDs ─────────────────────────────────────────────────────
@@ -124,16 +139,25 @@ TEST_F(EffectContextTest, ItfeIsPointerSized)
 TEST_F(EffectContextTest, ConfigFollowsItfe)
 {
     // config comes directly after itfe; no padding holes allowed on ARM64
-    EXPECT_GE(offsetof(HostAudioShiftContext, config),
+    EXPECT_EQ(offsetof(HostAudioShiftContext, config),
               offsetof(HostAudioShiftContext, itfe) + sizeof(void *));
 }
 
-TEST_F(EffectContextTest, FloatBufSizeMatchesMaxFrames)
+TEST_F(EffectContextTest, ConfigHoldsWholeEffectConfig)
 {
-    // The scratch buffer must hold exactly MAX_FRAME_SIZE * DEFAULT_CHANNELS floats
-    constexpr size_t expected = HOST_MAX_FRAME_SIZE * HOST_DEFAULT_CHANNELS;
-    size_t actual = sizeof(HostAudioShiftContext::floatBuf) / sizeof(float);
-    EXPECT_EQ(actual, expected);
+    // EFFECT_CMD_SET_CONFIG / GET_CONFIG copy a whole effect_config_t:
+    // input and output buffer_config_t, each led by its buffer provider
+    EXPECT_EQ(sizeof(host_effect_config_t), 2 * sizeof(host_buffer_config_t));
+    EXPECT_EQ(offsetof(host_buffer_config_t, samplingRate), 3 * sizeof(void *));
+    EXPECT_GE(sizeof(host_buffer_config_t), 3 * sizeof(void *) + 12);
+}
+
+TEST_F(EffectContextTest, CoreFollowsConfig)
+{
+    // Nothing but the shared core after the configuration; the old
+    // per-context scratch buffer and counters live in the core now
+    EXPECT_EQ(offsetof(HostAudioShiftContext, core),
+              offsetof(HostAudioShiftContext, config) + sizeof(host_effect_config_t));
 }
 
 // ── Pitch constants ────────────────────────────────────────────────────────
@@ -160,9 +184,9 @@ TEST_F(EffectContextTest, PitchSemitonesNegative)
 
 TEST_F(EffectContextTest, PitchSemitonesMatchesFormula)
 {
-    // 12 * log2(432.0 / 440.0) ≈ -0.3164 semitones
+    // 12 * log2(432.0 / 440.0) ≈ -0.31767 semitones
     double formula = 12.0 * std::log2(432.0 / 440.0);
-    EXPECT_NEAR(HOST_PITCH_SEMITONES_432_HZ, static_cast<float>(formula), 0.001f);
+    EXPECT_NEAR(HOST_PITCH_SEMITONES_432_HZ, static_cast<float>(formula), 0.0001f);
 }
 
 TEST_F(EffectContextTest, PitchSemitonesGreaterThanMinusOne)
@@ -180,20 +204,7 @@ TEST_F(EffectContextTest, DefaultSampleRate)
 
 TEST_F(EffectContextTest, DefaultChannels)
 {
-    EXPECT_EQ(HOST_DEFAULT_CHANNELS_CONST, 2);
-}
-
-TEST_F(EffectContextTest, MaxFrameSize)
-{
-    EXPECT_EQ(HOST_MAX_FRAME_SIZE_CONST, 8192);
-}
-
-TEST_F(EffectContextTest, MaxFrameSizeIsPowerOfTwo)
-{
-    // SoundTouch and FFT routines benefit from power-of-2 buffer sizes
-    int n = HOST_MAX_FRAME_SIZE_CONST;
-    EXPECT_GT(n, 0);
-    EXPECT_EQ(n & (n - 1), 0) << HOST_MAX_FRAME_SIZE_CONST << " is not a power of 2";
+    EXPECT_EQ(HOST_DEFAULT_CHANNELS, 2);
 }
 
 TEST_F(EffectContextTest, MaxLatencyMs)
@@ -268,9 +279,10 @@ TEST_F(EffectContextTest, CpuLoadDescriptor)
 
 TEST_F(EffectContextTest, MemoryUsageDescriptor)
 {
-    // memoryUsage is in KB; 32 KB is realistic for two SoundTouch instances
-    constexpr uint16_t expected_mem_kb = 32;
-    EXPECT_EQ(expected_mem_kb, 32);
+    // memoryUsage is in KB: the enabled stereo 48 kHz SoundTouch backend
+    // (see CMD_GET_MEMORY_USAGE)
+    constexpr uint16_t expected_mem_kb = 264;
+    EXPECT_EQ(expected_mem_kb, 264);
 }
 
 // ── Custom command enum values ─────────────────────────────────────────────